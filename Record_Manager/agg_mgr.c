@@ -0,0 +1,843 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#include "agg_mgr.h"
+#include "record_mgr.h"
+#include "hll.h"
+
+// slots of the hash table of a thread when it starts, it doubles whenever
+// half of them are used.
+#define AGG_INITIAL_SLOTS 1024
+
+// the hash table is an array of slots with linear probing. A slot keeps the
+// upper half of the hash of its group next to the index of the group, so a
+// probe goes through the slots of a cache line and reads only the groups
+// that probably hold its key.
+typedef struct AggSlot {
+	unsigned int tag;
+	unsigned int group;		// index of the group + 1, 0 for a free slot
+} AggSlot;
+
+// the groups of one thread. A group is its hash, its key and the state of
+// every aggregate, groups are kept one after the other.
+typedef struct AggTable {
+	char *groups;
+	int numGroups;
+	int capacity;
+	AggSlot *slots;
+	unsigned int mask;
+	char *key;			// key of the record being added
+
+	// column of a page for the aggregates without groups
+	int *positions;
+	char *column;
+	int columnSize;
+	char *row;			// first record of the thread, gathered for initState
+} AggTable;
+
+typedef struct Aggregation {
+	Schema *schema;			// of the table
+	int numGroupBy;
+	int *groupBy;
+	int numAggs;
+	Aggregate *aggs;
+	int keyLen;			// bytes of the group attributes
+	int *stateOffsets;		// of the state of every aggregate in a group
+	int groupSize;
+	int nThreads;
+	AggTable *tables;
+	int next;			// next group returned
+	int emptyRow;			// the row of a table without groups and records
+} Aggregation;
+
+// group attributes are in the key with their size in the schema.
+static int keyOffset(Aggregation *agg, int i) {
+	int offset = 0, j;
+
+	for (j = 0; j < i; j++) {
+		offset += agg->schema->attrSizes[agg->groupBy[j]];
+	}
+	return offset;
+}
+
+// bytes of the state of an aggregate: counts and sums are 8 bytes, an
+// average its sum and count, MIN and MAX the value.
+static int stateSize(Schema *schema, Aggregate *aggregate) {
+	switch (aggregate->function) {
+		case AGG_AVG:
+			return 16;
+		case AGG_MIN:
+		case AGG_MAX:
+			return (schema->attrSizes[aggregate->attr] + 7) / 8 * 8;
+		default:
+			return 8;
+	}
+}
+
+/**
+ * copy the group attributes of a record into key. Strings are copied up to
+ * their terminator and zero padded, floats have one zero, so records of one
+ * group always have equal keys.
+ * @param agg  the aggregation.
+ * @param data the record data.
+ * @param key  receives keyLen bytes.
+ */
+static void groupKey(Aggregation *agg, char *data, char *key) {
+	Schema *schema = agg->schema;
+	int i;
+	float f;
+
+	for (i = 0; i < agg->numGroupBy; i++) {
+		int attr = agg->groupBy[i];
+		char *value = data + schema->attrOffsets[attr];
+
+		memset(key, 0, schema->attrSizes[attr]);
+		switch (schema->dataTypes[attr]) {
+			case DT_STRING:
+				strncpy(key, value, schema->attrSizes[attr]);
+				break;
+			case DT_FLOAT:
+				memcpy(&f, value, sizeof(float));
+				if (f == 0) {
+					f = 0;
+				}
+				memcpy(key, &f, sizeof(float));
+				break;
+			default:
+				memcpy(key, value, schema->attrSizes[attr]);
+				break;
+		}
+		key += schema->attrSizes[attr];
+	}
+}
+
+// start the state of a group with its first record.
+static void initState(Aggregation *agg, char *group, char *data) {
+	Schema *schema = agg->schema;
+	long long count = 1;
+	int i;
+
+	for (i = 0; i < agg->numAggs; i++) {
+		Aggregate *aggregate = &agg->aggs[i];
+		char *state = group + agg->stateOffsets[i];
+		char *value = (aggregate->function != AGG_COUNT) ? data + schema->attrOffsets[aggregate->attr] : NULL;
+		long long sum;
+		double avg;
+		int v;
+		float f;
+
+		switch (aggregate->function) {
+			case AGG_COUNT:
+				memcpy(state, &count, sizeof(long long));
+				break;
+			case AGG_SUM:
+				if (schema->dataTypes[aggregate->attr] == DT_INT) {
+					memcpy(&v, value, sizeof(int));
+					sum = v;
+					memcpy(state, &sum, sizeof(long long));
+				}
+				else {
+					memcpy(&f, value, sizeof(float));
+					avg = f;
+					memcpy(state, &avg, sizeof(double));
+				}
+				break;
+			case AGG_AVG:
+				if (schema->dataTypes[aggregate->attr] == DT_INT) {
+					memcpy(&v, value, sizeof(int));
+					avg = v;
+				}
+				else {
+					memcpy(&f, value, sizeof(float));
+					avg = f;
+				}
+				memcpy(state, &avg, sizeof(double));
+				memcpy(state + 8, &count, sizeof(long long));
+				break;
+			default:
+				memcpy(state, value, schema->attrSizes[aggregate->attr]);
+				break;
+		}
+	}
+}
+
+// whether a is smaller than b, both values of an attribute.
+static int valueLess(Schema *schema, int attr, char *a, char *b) {
+	int x, y;
+	float f, g;
+
+	switch (schema->dataTypes[attr]) {
+		case DT_INT:
+			memcpy(&x, a, sizeof(int));
+			memcpy(&y, b, sizeof(int));
+			return x < y;
+		case DT_FLOAT:
+			memcpy(&f, a, sizeof(float));
+			memcpy(&g, b, sizeof(float));
+			return f < g;
+		default:
+			return strncmp(a, b, schema->attrSizes[attr]) < 0;
+	}
+}
+
+// add a record to the state of its group.
+static void updateState(Aggregation *agg, char *group, char *data) {
+	Schema *schema = agg->schema;
+	int i;
+
+	for (i = 0; i < agg->numAggs; i++) {
+		Aggregate *aggregate = &agg->aggs[i];
+		char *state = group + agg->stateOffsets[i];
+		char *value = (aggregate->function != AGG_COUNT) ? data + schema->attrOffsets[aggregate->attr] : NULL;
+		long long count;
+		double sum;
+		int v;
+		float f;
+
+		switch (aggregate->function) {
+			case AGG_COUNT:
+				memcpy(&count, state, sizeof(long long));
+				count++;
+				memcpy(state, &count, sizeof(long long));
+				break;
+			case AGG_SUM:
+			case AGG_AVG:
+				if (aggregate->function == AGG_SUM && schema->dataTypes[aggregate->attr] == DT_INT) {
+					memcpy(&v, value, sizeof(int));
+					memcpy(&count, state, sizeof(long long));
+					count += v;
+					memcpy(state, &count, sizeof(long long));
+					break;
+				}
+				if (schema->dataTypes[aggregate->attr] == DT_INT) {
+					memcpy(&v, value, sizeof(int));
+					f = 0;
+				}
+				else {
+					memcpy(&f, value, sizeof(float));
+					v = 0;
+				}
+				memcpy(&sum, state, sizeof(double));
+				sum += (schema->dataTypes[aggregate->attr] == DT_INT) ? (double)v : (double)f;
+				memcpy(state, &sum, sizeof(double));
+				if (aggregate->function == AGG_AVG) {
+					memcpy(&count, state + 8, sizeof(long long));
+					count++;
+					memcpy(state + 8, &count, sizeof(long long));
+				}
+				break;
+			case AGG_MIN:
+				if (valueLess(schema, aggregate->attr, value, state)) {
+					memcpy(state, value, schema->attrSizes[aggregate->attr]);
+				}
+				break;
+			case AGG_MAX:
+				if (valueLess(schema, aggregate->attr, state, value)) {
+					memcpy(state, value, schema->attrSizes[aggregate->attr]);
+				}
+				break;
+		}
+	}
+}
+
+// add the state of a group to another one, used to merge the groups of
+// the threads.
+static void mergeState(Aggregation *agg, char *into, char *from) {
+	Schema *schema = agg->schema;
+	int i;
+
+	for (i = 0; i < agg->numAggs; i++) {
+		Aggregate *aggregate = &agg->aggs[i];
+		char *to = into + agg->stateOffsets[i];
+		char *state = from + agg->stateOffsets[i];
+		long long a, b;
+		double x, y;
+
+		switch (aggregate->function) {
+			case AGG_COUNT:
+				memcpy(&a, to, sizeof(long long));
+				memcpy(&b, state, sizeof(long long));
+				a += b;
+				memcpy(to, &a, sizeof(long long));
+				break;
+			case AGG_SUM:
+				if (schema->dataTypes[aggregate->attr] == DT_INT) {
+					memcpy(&a, to, sizeof(long long));
+					memcpy(&b, state, sizeof(long long));
+					a += b;
+					memcpy(to, &a, sizeof(long long));
+				}
+				else {
+					memcpy(&x, to, sizeof(double));
+					memcpy(&y, state, sizeof(double));
+					x += y;
+					memcpy(to, &x, sizeof(double));
+				}
+				break;
+			case AGG_AVG:
+				memcpy(&x, to, sizeof(double));
+				memcpy(&y, state, sizeof(double));
+				memcpy(&a, to + 8, sizeof(long long));
+				memcpy(&b, state + 8, sizeof(long long));
+				x += y;
+				a += b;
+				memcpy(to, &x, sizeof(double));
+				memcpy(to + 8, &a, sizeof(long long));
+				break;
+			case AGG_MIN:
+				if (valueLess(schema, aggregate->attr, state, to)) {
+					memcpy(to, state, schema->attrSizes[aggregate->attr]);
+				}
+				break;
+			case AGG_MAX:
+				if (valueLess(schema, aggregate->attr, to, state)) {
+					memcpy(to, state, schema->attrSizes[aggregate->attr]);
+				}
+				break;
+		}
+	}
+}
+
+// double the slots of a table and put its groups into them again.
+static void growSlots(AggTable *table, int groupSize) {
+	unsigned int numSlots = (table->mask + 1) * 2;
+	int i;
+
+	free(table->slots);
+	table->slots = (AggSlot *)calloc(numSlots, sizeof(AggSlot));
+	table->mask = numSlots - 1;
+	for (i = 0; i < table->numGroups; i++) {
+		unsigned long long hash;
+		unsigned int slot;
+
+		memcpy(&hash, table->groups + (size_t)i * groupSize, sizeof(hash));
+		for (slot = hash & table->mask; table->slots[slot].group != 0; slot = (slot + 1) & table->mask);
+		table->slots[slot].tag = hash >> 32;
+		table->slots[slot].group = i + 1;
+	}
+}
+
+/**
+ * find the group of a key in a table, or add it. A new group has the hash
+ * and key but no state.
+ * @param  agg   the aggregation.
+ * @param  table the table.
+ * @param  hash  hash of the key.
+ * @param  key   the key.
+ * @param  isNew set to 1 if the group was added.
+ * @return       the group.
+ */
+static char *findGroup(Aggregation *agg, AggTable *table, unsigned long long hash, char *key, int *isNew) {
+	unsigned int tag = hash >> 32, slot;
+	char *group;
+
+	for (slot = hash & table->mask; table->slots[slot].group != 0; slot = (slot + 1) & table->mask) {
+		if (table->slots[slot].tag == tag) {
+			group = table->groups + (size_t)(table->slots[slot].group - 1) * agg->groupSize;
+			if (memcmp(group + 8, key, agg->keyLen) == 0) {
+				*isNew = 0;
+				return group;
+			}
+		}
+	}
+
+	if (table->numGroups == table->capacity) {
+		table->capacity *= 2;
+		table->groups = (char *)realloc(table->groups, (size_t)table->capacity * agg->groupSize);
+	}
+	group = table->groups + (size_t)table->numGroups * agg->groupSize;
+	memcpy(group, &hash, sizeof(hash));
+	memcpy(group + 8, key, agg->keyLen);
+	table->slots[slot].tag = tag;
+	table->slots[slot].group = ++table->numGroups;
+	if ((unsigned int)table->numGroups * 2 > table->mask + 1) {
+		growSlots(table, agg->groupSize);
+	}
+	*isNew = 1;
+	return group;
+}
+
+// add a record to the group of its key in the table of the thread, called
+// by startParallelScan.
+static void aggregateRecord(int thread, Record *record, void *context) {
+	Aggregation *agg = (Aggregation *)context;
+	AggTable *table = &agg->tables[thread];
+	unsigned long long hash;
+	char *group;
+	int isNew;
+
+	groupKey(agg, record->data, table->key);
+	hash = hllHash(table->key, agg->keyLen);
+	group = findGroup(agg, table, hash, table->key, &isNew);
+	if (isNew) {
+		initState(agg, group, record->data);
+	}
+	else {
+		updateState(agg, group, record->data);
+	}
+}
+
+/**
+ * add the matching records of a page to the only group of an aggregation
+ * without GROUP BY, called by startParallelBatchScan. The positions of the
+ * matching slots are collected first, then every aggregate copies its
+ * attribute out of them into a column and goes through the column in a
+ * tight loop. A minipage of a PAX page whose slots all match is that
+ * column already.
+ * @param thread    the thread.
+ * @param columns   every attribute of the first slot of the page.
+ * @param strides   bytes between two values of every attribute.
+ * @param numTuples number of slots.
+ * @param selection the matching slots.
+ * @param context   the aggregation.
+ */
+static void aggregateBatch(int thread, char **columns, int *strides, int numTuples, unsigned char *selection,
+		void *context) {
+	Aggregation *agg = (Aggregation *)context;
+	Schema *schema = agg->schema;
+	AggTable *table = &agg->tables[thread];
+	char *group = table->groups;
+	int i, j, n = 0, first = 0, gathered = -1;
+	char *values = NULL;
+
+	if (table->columnSize < numTuples) {
+		free(table->positions);
+		free(table->column);
+		table->positions = (int *)malloc(sizeof(int) * numTuples);
+		table->column = (char *)malloc(sizeof(int) * numTuples);
+		table->columnSize = numTuples;
+	}
+	for (i = 0; i < numTuples; i++) {
+		if (selection[i / 8] & (1 << (i % 8))) {
+			table->positions[n++] = i;
+		}
+	}
+	if (n == 0) {
+		return;
+	}
+
+	// the first record of the thread starts its state
+	if (table->numGroups == 0) {
+		table->row = (char *)calloc(1, schema->recordSize);
+		for (i = 0; i < schema->numAttr; i++) {
+			memcpy(table->row + schema->attrOffsets[i], columns[i] + table->positions[0] * strides[i],
+				schema->attrSizes[i]);
+		}
+		initState(agg, group, table->row);
+		table->numGroups = 1;
+		first = 1;
+	}
+
+	for (i = 0; i < agg->numAggs; i++) {
+		Aggregate *aggregate = &agg->aggs[i];
+		char *state = group + agg->stateOffsets[i];
+		int attr = aggregate->attr;
+		long long count, sum = 0;
+		double fsum = 0;
+
+		if (aggregate->function == AGG_COUNT) {
+			memcpy(&count, state, sizeof(long long));
+			count += n - first;
+			memcpy(state, &count, sizeof(long long));
+			continue;
+		}
+
+		// strings are compared where they are
+		if (schema->dataTypes[attr] == DT_STRING) {
+			for (j = first; j < n; j++) {
+				char *value = columns[attr] + table->positions[j] * strides[attr];
+
+				if ((aggregate->function == AGG_MIN) ? valueLess(schema, attr, value, state)
+						: valueLess(schema, attr, state, value)) {
+					memcpy(state, value, schema->attrSizes[attr]);
+				}
+			}
+			continue;
+		}
+
+		// aggregates of the same attribute share its column
+		if (gathered != attr) {
+			if (n == numTuples && strides[attr] == sizeof(int) && (size_t)columns[attr] % sizeof(int) == 0) {
+				values = columns[attr];
+			}
+			else {
+				for (j = first; j < n; j++) {
+					memcpy(table->column + j * sizeof(int), columns[attr] + table->positions[j] * strides[attr],
+						sizeof(int));
+				}
+				values = table->column;
+			}
+			gathered = attr;
+		}
+		if (schema->dataTypes[attr] == DT_INT) {
+			int *column = (int *)values, v;
+
+			switch (aggregate->function) {
+				case AGG_MIN:
+				case AGG_MAX:
+					memcpy(&v, state, sizeof(int));
+					for (j = first; j < n; j++) {
+						if ((aggregate->function == AGG_MIN) ? column[j] < v : column[j] > v) {
+							v = column[j];
+						}
+					}
+					memcpy(state, &v, sizeof(int));
+					break;
+				default:
+					for (j = first; j < n; j++) {
+						sum += column[j];
+					}
+					fsum = (double)sum;
+					break;
+			}
+		}
+		else {
+			float *column = (float *)values, v;
+
+			switch (aggregate->function) {
+				case AGG_MIN:
+				case AGG_MAX:
+					memcpy(&v, state, sizeof(float));
+					for (j = first; j < n; j++) {
+						if ((aggregate->function == AGG_MIN) ? column[j] < v : column[j] > v) {
+							v = column[j];
+						}
+					}
+					memcpy(state, &v, sizeof(float));
+					break;
+				default:
+					for (j = first; j < n; j++) {
+						fsum += column[j];
+					}
+					break;
+			}
+		}
+
+		if (aggregate->function == AGG_SUM && schema->dataTypes[attr] == DT_INT) {
+			long long total;
+
+			memcpy(&total, state, sizeof(long long));
+			total += sum;
+			memcpy(state, &total, sizeof(long long));
+		}
+		else if (aggregate->function == AGG_SUM || aggregate->function == AGG_AVG) {
+			double total;
+
+			memcpy(&total, state, sizeof(double));
+			total += fsum;
+			memcpy(state, &total, sizeof(double));
+			if (aggregate->function == AGG_AVG) {
+				memcpy(&count, state + 8, sizeof(long long));
+				count += n - first;
+				memcpy(state + 8, &count, sizeof(long long));
+			}
+		}
+	}
+}
+
+// the schema of the results: the group attributes, then the aggregates.
+// Counts and sums of ints are ints, averages and sums of floats floats.
+static Schema *resultSchema(Aggregation *agg) {
+	Schema *schema = agg->schema;
+	int numAttr = agg->numGroupBy + agg->numAggs, i;
+	char **names = (char **)malloc(sizeof(char *) * numAttr);
+	DataType *dataTypes = (DataType *)malloc(sizeof(DataType) * numAttr);
+	int *typeLength = (int *)calloc(numAttr, sizeof(int));
+	int *keys = (int *)malloc(sizeof(int));
+	static char *functionNames[] = { "count", "sum", "min", "max", "avg" };
+
+	for (i = 0; i < agg->numGroupBy; i++) {
+		int attr = agg->groupBy[i];
+
+		names[i] = (char *)malloc(strlen(schema->attrNames[attr]) + 1);
+		strcpy(names[i], schema->attrNames[attr]);
+		dataTypes[i] = schema->dataTypes[attr];
+		typeLength[i] = schema->typeLength[attr];
+	}
+	for (i = 0; i < agg->numAggs; i++) {
+		Aggregate *aggregate = &agg->aggs[i];
+		char *name = (aggregate->function == AGG_COUNT) ? "*" : schema->attrNames[aggregate->attr];
+		int attr = agg->numGroupBy + i;
+
+		names[attr] = (char *)malloc(strlen(name) + 8);
+		sprintf(names[attr], "%s(%s)", functionNames[aggregate->function], name);
+		switch (aggregate->function) {
+			case AGG_COUNT:
+				dataTypes[attr] = DT_INT;
+				break;
+			case AGG_AVG:
+				dataTypes[attr] = DT_FLOAT;
+				break;
+			default:
+				dataTypes[attr] = schema->dataTypes[aggregate->attr];
+				typeLength[attr] = schema->typeLength[aggregate->attr];
+				break;
+		}
+	}
+	return createSchema(numAttr, names, dataTypes, typeLength, 0, keys);
+}
+
+// add the groups of the other threads to those of thread 0.
+static void mergeTables(Aggregation *agg) {
+	AggTable *into = &agg->tables[0];
+	int t, i, isNew;
+
+	for (t = 1; t < agg->nThreads; t++) {
+		AggTable *table = &agg->tables[t];
+
+		for (i = 0; i < table->numGroups; i++) {
+			char *from = table->groups + (size_t)i * agg->groupSize;
+			unsigned long long hash;
+			char *group;
+
+			if (agg->numGroupBy == 0) {
+				if (into->numGroups == 0) {
+					memcpy(into->groups, from, agg->groupSize);
+					into->numGroups = 1;
+				}
+				else {
+					mergeState(agg, into->groups, from);
+				}
+				continue;
+			}
+			memcpy(&hash, from, sizeof(hash));
+			group = findGroup(agg, into, hash, from + 8, &isNew);
+			if (isNew) {
+				memcpy(group, from, agg->groupSize);
+			}
+			else {
+				mergeState(agg, group, from);
+			}
+		}
+	}
+}
+
+/**
+ * start aggregating the records of a table that match cond, grouped by
+ * some attributes like GROUP BY. The table is scanned by nThreads threads
+ * with startParallelScan, every thread adds its records to a hash table of
+ * its own, an array of slots with linear probing, and the tables are merged
+ * at the end. Without GROUP BY the threads use startParallelBatchScan and
+ * go through the attributes of a page at a time as columns. SUM and AVG
+ * take int and float attributes, MIN and MAX also strings. Counts and sums
+ * of ints are added up in 64 bits and returned as ints, nextAggregate
+ * refuses a result that does not fit into one. Without GROUP BY there is
+ * one result even if no record matches, with a count of 0 and all other
+ * aggregates 0. The table must not be changed during the aggregation.
+ * @param  agg        RM_AggHandle, schema is set to the schema of the results.
+ * @param  rel        RM_TableData
+ * @param  cond       scan condition(s), NULL for every record
+ * @param  groupBy    the group attributes.
+ * @param  numGroupBy number of group attributes, 0 for one group.
+ * @param  aggs       the aggregates.
+ * @param  numAggs    number of aggregates.
+ * @param  nThreads   number of threads.
+ * @return            RC_OK | RC_RM_NO_SUCH_ATTR | RC_RM_ATTR_WRONG_DATATYPE | RC_FILE_NOT_FOUND | RC_READ_NON_EXISTING_PAGE
+ */
+RC startAggregate (RM_AggHandle *agg, RM_TableData *rel, Expr *cond, int *groupBy, int numGroupBy,
+		Aggregate *aggs, int numAggs, int nThreads) {
+	Schema *schema = rel->schema;
+	Aggregation *state;
+	int i, offset;
+	RC rc;
+
+	agg->mgmtData = NULL;
+	agg->schema = NULL;
+	if (numGroupBy + numAggs < 1) {
+		THROW(RC_RM_NO_SUCH_ATTR, "an aggregation needs a group attribute or an aggregate");
+	}
+	for (i = 0; i < numGroupBy; i++) {
+		if (groupBy[i] < 0 || groupBy[i] >= schema->numAttr) {
+			THROW(RC_RM_NO_SUCH_ATTR, "group attribute does not exist");
+		}
+	}
+	for (i = 0; i < numAggs; i++) {
+		if (aggs[i].function == AGG_COUNT) {
+			continue;
+		}
+		if (aggs[i].attr < 0 || aggs[i].attr >= schema->numAttr) {
+			THROW(RC_RM_NO_SUCH_ATTR, "aggregate attribute does not exist");
+		}
+		if (schema->dataTypes[aggs[i].attr] == DT_BOOL || (schema->dataTypes[aggs[i].attr] == DT_STRING
+				&& aggs[i].function != AGG_MIN && aggs[i].function != AGG_MAX)) {
+			THROW(RC_RM_ATTR_WRONG_DATATYPE, "aggregate of an attribute of the wrong datatype");
+		}
+	}
+	if (nThreads < 1) {
+		nThreads = 1;
+	}
+
+	state = (Aggregation *)calloc(1, sizeof(Aggregation));
+	state->schema = schema;
+	state->numGroupBy = numGroupBy;
+	state->groupBy = (int *)malloc(sizeof(int) * (numGroupBy > 0 ? numGroupBy : 1));
+	if (numGroupBy > 0) {
+		memcpy(state->groupBy, groupBy, sizeof(int) * numGroupBy);
+	}
+	state->numAggs = numAggs;
+	state->aggs = (Aggregate *)malloc(sizeof(Aggregate) * (numAggs > 0 ? numAggs : 1));
+	memcpy(state->aggs, aggs, sizeof(Aggregate) * numAggs);
+	state->keyLen = keyOffset(state, numGroupBy);
+	state->stateOffsets = (int *)malloc(sizeof(int) * (numAggs > 0 ? numAggs : 1));
+	offset = 8 + (state->keyLen + 7) / 8 * 8;
+	for (i = 0; i < numAggs; i++) {
+		state->stateOffsets[i] = offset;
+		offset += stateSize(schema, &aggs[i]);
+	}
+	state->groupSize = offset;
+	state->nThreads = nThreads;
+	state->tables = (AggTable *)calloc(nThreads, sizeof(AggTable));
+	for (i = 0; i < nThreads; i++) {
+		AggTable *table = &state->tables[i];
+
+		table->capacity = (numGroupBy > 0) ? AGG_INITIAL_SLOTS / 2 : 1;
+		table->groups = (char *)malloc((size_t)table->capacity * state->groupSize);
+		table->slots = (AggSlot *)calloc(AGG_INITIAL_SLOTS, sizeof(AggSlot));
+		table->mask = AGG_INITIAL_SLOTS - 1;
+		table->key = (char *)malloc(state->keyLen > 0 ? state->keyLen : 1);
+	}
+	agg->rel = rel;
+	agg->mgmtData = state;
+
+	if (numGroupBy > 0) {
+		rc = startParallelScan(rel, cond, nThreads, aggregateRecord, state);
+	}
+	else {
+		rc = startParallelBatchScan(rel, cond, nThreads, aggregateBatch, state);
+	}
+	if (rc != RC_OK) {
+		closeAggregate(agg);
+		return rc;
+	}
+	mergeTables(state);
+	state->emptyRow = (numGroupBy == 0 && state->tables[0].numGroups == 0);
+	agg->schema = resultSchema(state);
+	return RC_OK;
+}
+
+/**
+ * the next result of an aggregation: the group attributes and the
+ * aggregates of one group. Groups come in no particular order. A group
+ * with a COUNT or a SUM of ints beyond the range of an int returns
+ * RC_RM_VALUE_OUT_OF_RANGE, the next call goes on with the next group.
+ * @param  agg    RM_AggHandle
+ * @param  record receives the result, made by createRecord with agg->schema.
+ * @return        RC_OK | RC_RM_NO_MORE_TUPLES | RC_RM_VALUE_OUT_OF_RANGE
+ */
+RC nextAggregate (RM_AggHandle *agg, Record *record) {
+	Aggregation *state = (Aggregation *)agg->mgmtData;
+	Schema *result = agg->schema;
+	AggTable *table = &state->tables[0];
+	char *group;
+	RC rc = RC_OK;
+	int i;
+
+	if (state->emptyRow) {
+		state->emptyRow = 0;
+		memset(record->data, 0, getRecordSize(result));
+		record->id.page = -1;
+		record->id.slot = 0;
+		return RC_OK;
+	}
+	if (state->next >= table->numGroups) {
+		return RC_RM_NO_MORE_TUPLES;
+	}
+	group = table->groups + (size_t)state->next * state->groupSize;
+	record->id.page = -1;
+	record->id.slot = state->next++;
+
+	for (i = 0; i < state->numGroupBy; i++) {
+		memcpy(record->data + result->attrOffsets[i], group + 8 + keyOffset(state, i), result->attrSizes[i]);
+	}
+	for (i = 0; i < state->numAggs; i++) {
+		Aggregate *aggregate = &state->aggs[i];
+		char *value = record->data + result->attrOffsets[state->numGroupBy + i];
+		char *groupState = group + state->stateOffsets[i];
+		long long count;
+		double sum;
+		int v;
+		float f;
+
+		switch (aggregate->function) {
+			case AGG_COUNT:
+				memcpy(&count, groupState, sizeof(long long));
+				if (count > INT_MAX) {
+					rc = RC_RM_VALUE_OUT_OF_RANGE;
+				}
+				v = (int)count;
+				memcpy(value, &v, sizeof(int));
+				break;
+			case AGG_SUM:
+				if (state->schema->dataTypes[aggregate->attr] == DT_INT) {
+					memcpy(&count, groupState, sizeof(long long));
+					if (count > INT_MAX || count < INT_MIN) {
+						rc = RC_RM_VALUE_OUT_OF_RANGE;
+					}
+					v = (int)count;
+					memcpy(value, &v, sizeof(int));
+				}
+				else {
+					memcpy(&sum, groupState, sizeof(double));
+					f = (float)sum;
+					memcpy(value, &f, sizeof(float));
+				}
+				break;
+			case AGG_AVG:
+				memcpy(&sum, groupState, sizeof(double));
+				memcpy(&count, groupState + 8, sizeof(long long));
+				f = (float)(sum / count);
+				memcpy(value, &f, sizeof(float));
+				break;
+			default:
+				memcpy(value, groupState, result->attrSizes[state->numGroupBy + i]);
+				break;
+		}
+	}
+	return rc;
+}
+
+/**
+ * end an aggregation and free its results and schema.
+ * @param  agg RM_AggHandle
+ * @return     RC_OK
+ */
+RC closeAggregate (RM_AggHandle *agg) {
+	Aggregation *state = (Aggregation *)agg->mgmtData;
+	int i;
+
+	if (state == NULL) {
+		return RC_OK;
+	}
+	for (i = 0; i < state->nThreads; i++) {
+		free(state->tables[i].groups);
+		free(state->tables[i].slots);
+		free(state->tables[i].key);
+		free(state->tables[i].positions);
+		free(state->tables[i].column);
+		free(state->tables[i].row);
+	}
+	free(state->tables);
+	free(state->groupBy);
+	free(state->aggs);
+	free(state->stateOffsets);
+	free(state);
+	if (agg->schema != NULL) {
+		freeSchema(agg->schema);
+	}
+	agg->schema = NULL;
+	agg->mgmtData = NULL;
+	return RC_OK;
+}
+
+/**
+ * the number of results of an aggregation.
+ * @param  agg RM_AggHandle
+ * @return     the number of groups.
+ */
+int getAggregateGroups (RM_AggHandle *agg) {
+	Aggregation *state = (Aggregation *)agg->mgmtData;
+
+	return (state->numGroupBy == 0) ? 1 : state->tables[0].numGroups;
+}
@@ -0,0 +1,38 @@
+#ifndef AGG_MGR_H
+#define AGG_MGR_H
+
+#include "dberror.h"
+#include "expr.h"
+#include "tables.h"
+
+// aggregate functions, COUNT counts records and takes no attribute
+typedef enum AggFunction {
+  AGG_COUNT = 0,
+  AGG_SUM = 1,
+  AGG_MIN = 2,
+  AGG_MAX = 3,
+  AGG_AVG = 4
+} AggFunction;
+
+typedef struct Aggregate
+{
+  AggFunction function;
+  int attr;
+} Aggregate;
+
+// Bookkeeping for aggregations, schema describes the result records
+typedef struct RM_AggHandle
+{
+  RM_TableData *rel;
+  Schema *schema;
+  void *mgmtData;
+} RM_AggHandle;
+
+// grouping and aggregating the records of a table
+extern RC startAggregate (RM_AggHandle *agg, RM_TableData *rel, Expr *cond, int *groupBy, int numGroupBy,
+			  Aggregate *aggs, int numAggs, int nThreads);
+extern RC nextAggregate (RM_AggHandle *agg, Record *record);
+extern RC closeAggregate (RM_AggHandle *agg);
+extern int getAggregateGroups (RM_AggHandle *agg);
+
+#endif // AGG_MGR_H
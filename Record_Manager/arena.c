@@ -0,0 +1,115 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+// every allocation is aligned for any of the record data types.
+#define ARENA_ALIGN 8
+
+static ArenaBlock *createBlock(size_t size) {
+	ArenaBlock *block;
+
+	if ((block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + size)) == NULL)
+		return NULL;
+
+	block->next = NULL;
+	block->size = size;
+	block->used = 0;
+	return block;
+}
+
+/**
+ * create an arena that allocates blocks of blockSize bytes.
+ * @param  blockSize size of a block, 0 for ARENA_BLOCK_SIZE.
+ * @return           the arena, or NULL if out of memory.
+ */
+Arena *createArena(size_t blockSize) {
+	Arena *arena;
+
+	if ((arena = (Arena *)malloc(sizeof(Arena))) == NULL)
+		return NULL;
+
+	arena->blockSize = (blockSize > 0) ? blockSize : ARENA_BLOCK_SIZE;
+	if ((arena->first = createBlock(arena->blockSize)) == NULL) {
+		free(arena);
+		return NULL;
+	}
+	arena->current = arena->first;
+	return arena;
+}
+
+/**
+ * allocate size bytes from the arena. The memory lives until the arena is
+ * reset or freed and must not be passed to free.
+ * @param  arena the arena.
+ * @param  size  number of bytes.
+ * @return       the memory, or NULL if out of memory.
+ */
+void *arenaAlloc(Arena *arena, size_t size) {
+	ArenaBlock *block = arena->current;
+	void *result;
+
+	size = (size + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+
+	if (block->used + size > block->size) {
+		// blocks after the current one are left over from before the last
+		// reset and can be reused as they are.
+		if (block->next != NULL && block->next->size >= size) {
+			block = block->next;
+		}
+		else {
+			ArenaBlock *newBlock = createBlock(size > arena->blockSize ? size : arena->blockSize);
+			if (newBlock == NULL)
+				return NULL;
+			newBlock->next = block->next;
+			block->next = newBlock;
+			block = newBlock;
+		}
+		block->used = 0;
+		arena->current = block;
+	}
+
+	result = (char *)(block + 1) + block->used;
+	block->used += size;
+	return result;
+}
+
+/**
+ * copy a string into the arena.
+ * @param  arena the arena.
+ * @param  str   the string.
+ * @return       the copy, or NULL if out of memory.
+ */
+char *arenaStrdup(Arena *arena, const char *str) {
+	size_t len = strlen(str) + 1;
+	char *result = (char *)arenaAlloc(arena, len);
+
+	if (result != NULL)
+		memcpy(result, str, len);
+	return result;
+}
+
+/**
+ * release everything allocated from the arena in O(1). The blocks are kept
+ * and reused by later allocations.
+ * @param arena the arena.
+ */
+void resetArena(Arena *arena) {
+	arena->current = arena->first;
+	arena->first->used = 0;
+}
+
+/**
+ * release the arena and all its blocks.
+ * @param arena the arena.
+ */
+void freeArena(Arena *arena) {
+	ArenaBlock *block = arena->first;
+
+	while (block != NULL) {
+		ArenaBlock *next = block->next;
+		free(block);
+		block = next;
+	}
+	free(arena);
+}
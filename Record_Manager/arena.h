@@ -0,0 +1,27 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE 65536
+
+// memory is handed out from large blocks and released all at once.
+typedef struct ArenaBlock {
+	struct ArenaBlock *next;
+	size_t size;
+	size_t used;
+} ArenaBlock;
+
+typedef struct Arena {
+	ArenaBlock *first;
+	ArenaBlock *current;
+	size_t blockSize;
+} Arena;
+
+
+Arena *createArena(size_t blockSize);
+void *arenaAlloc(Arena *arena, size_t size);
+char *arenaStrdup(Arena *arena, const char *str);
+void resetArena(Arena *arena);
+void freeArena(Arena *arena);
+#endif
@@ -0,0 +1,2526 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "dberror.h"
+#include "expr.h"
+#include "record_mgr.h"
+#include "join_mgr.h"
+#include "sort_mgr.h"
+#include "agg_mgr.h"
+#include "btree_mgr.h"
+#include "hash_mgr.h"
+#include "column_codec.h"
+#include "lz_codec.h"
+#include "storage_mgr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+// benchmark methods
+static void benchBulkLoad (int numRecords);
+static void benchBatches (int numRecords);
+static void benchGetAttr (int numRecords);
+static void benchScanArena (int numRecords);
+static void benchPredicates (int numRecords);
+static void benchVectorized (int numRecords);
+static void benchShortCircuit (int numRecords);
+static void benchProjection (int numRecords);
+static void benchParallelScan (int numRecords);
+static void benchBtree (int numRecords);
+static void benchPrimaryKey (int numRecords);
+static void benchHashIndex (int numRecords);
+static void benchSharedScan (int numRecords);
+static void benchStats (int numRecords);
+static void benchZoneMap (int numRecords);
+static void benchHashJoin (int numRecords);
+static void benchSort (int numRecords);
+static void benchAggregate (int numRecords);
+static void benchTopK (int numRecords);
+static void benchPax (int numRecords);
+static void benchCompress (int numRecords);
+static void benchArchive (int numRecords);
+
+// struct for benchmark records
+typedef struct TestRecord {
+  int a;
+  char *b;
+  int c;
+} TestRecord;
+
+// helper methods
+Record *testRecord(Schema *schema, int a, char *b, int c);
+Schema *testSchema (void);
+static Schema *wideSchema (int numAttr);
+static void benchPredicate (char *name, Schema *schema, Record **records, int numRecords, Expr *expr);
+static Expr *compareExpr (int attr, char *value, OpType op);
+static void benchBatchPredicate (char *name, Schema *schema, char *tuples, int numRecords, Expr *expr);
+static char *vectorTuples (Schema *schema, int numRecords);
+static double timeTree (Schema *schema, char *tuples, int numRecords, Expr *expr, int *matches);
+static double timeFilter (ExprFilter *filter, int size, char *tuples, int numRecords, int *matches);
+Record *fromTestRecord (Schema *schema, TestRecord in);
+static double elapsedSeconds (struct timespec *start);
+static void countMatch (int thread, Record *record, void *context);
+static double timeKeyedInserts (int check, Record **records, int numRecords, int batchSize);
+static double timeKeyLookups (RM_TableData *table, int numRecords, int numLookups, double *percentile99);
+static int compareSeconds (const void *a, const void *b);
+static void *scanThread (void *arg);
+static void dropTableCache (char *name);
+static void timeZoneScans (RM_TableData *table, char *name, Expr *cond);
+static void timeHashJoin (RM_TableData *build, RM_TableData *probe, size_t memory);
+static void timeSort (RM_TableData *table, char *name, int *attrList, int numAttrs, size_t memory);
+static void timeAggregate (RM_TableData *table, char *name, int *groupBy, int numGroupBy, Aggregate *aggs,
+			   int numAggs, int threads);
+static void timeTopK (RM_TableData *table, char *name, int attr, int descending);
+static int compareTopKey (const void *a, const void *b);
+static void timeLayout (RM_TableData *table, char *name, char *layout);
+static Schema *ordersSchema (void);
+static void printEncodings (RM_TableData *table, char *name);
+static void timeCompressedScan (RM_TableData *table, char *name, char *layout, char *what, Expr *cond);
+static void timeCompressed (RM_TableData *table, char *name, char *layout);
+static void loadOrders (RM_TableData **tables, int numTables, int numRecords);
+static void timeArchivedScan (RM_TableData *table, char *name, char *what, long long fileSize);
+
+char *testName;
+
+// benchmarks, selected by name on the command line
+typedef struct Benchmark {
+  char *name;
+  void (*run) (int numRecords);
+  int defaultRecords;
+} Benchmark;
+
+static Benchmark benchmarks[] = {
+  {"bulkload", benchBulkLoad, 100000},
+  {"batch", benchBatches, 10000},
+  {"getattr", benchGetAttr, 100000},
+  {"scanarena", benchScanArena, 1000000},
+  {"predicate", benchPredicates, 1000000},
+  {"vector", benchVectorized, 1000000},
+  {"shortcircuit", benchShortCircuit, 1000000},
+  {"projection", benchProjection, 100000},
+  {"parallel", benchParallelScan, 10000000},
+  {"btree", benchBtree, 10000000},
+  {"pkcheck", benchPrimaryKey, 1000000},
+  {"hashindex", benchHashIndex, 1000000},
+  {"sharedscan", benchSharedScan, 1000000},
+  {"stats", benchStats, 10000000},
+  {"zonemap", benchZoneMap, 10000000},
+  {"hashjoin", benchHashJoin, 10000000},
+  {"sort", benchSort, 5000000},
+  {"aggregate", benchAggregate, 10000000},
+  {"topk", benchTopK, 5000000},
+  {"pax", benchPax, 1000000},
+  {"compress", benchCompress, 10000000},
+  {"archive", benchArchive, 10000000},
+};
+
+// main method
+int
+main (int argc, char *argv[])
+{
+  int numBenchmarks = sizeof(benchmarks) / sizeof(Benchmark);
+  char *name = (argc > 1) ? argv[1] : "all";
+  int numRecords = (argc > 2) ? atoi(argv[2]) : 0;
+  int i, found = 0;
+
+  testName = "";
+
+  for(i = 0; i < numBenchmarks; i++)
+    if (strcmp(name, "all") == 0 || strcmp(name, benchmarks[i].name) == 0)
+      {
+        benchmarks[i].run(numRecords > 0 ? numRecords : benchmarks[i].defaultRecords);
+        found = 1;
+      }
+
+  if (!found)
+    {
+      printf("usage: %s [all", argv[0]);
+      for(i = 0; i < numBenchmarks; i++)
+        printf("|%s", benchmarks[i].name);
+      printf("] [numRecords]\n");
+      return 1;
+    }
+  return 0;
+}
+
+// ************************************************************
+// insertRecord per row against one bulkLoad call
+void
+benchBulkLoad (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * numRecords);
+  struct timespec start;
+  double insertTime, loadTime;
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    records[i] = testRecord(schema, i % 10000, "aaaa", i % 10);
+
+  TEST_CHECK(initRecordManager(NULL));
+
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    TEST_CHECK(insertRecord(table, records[i]));
+  insertTime = elapsedSeconds(&start);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+
+  TEST_CHECK(createTable("bench_table",testSchema()));
+  TEST_CHECK(openTable(table, "bench_table"));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(bulkLoad(table, records, numRecords));
+  loadTime = elapsedSeconds(&start);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+
+  TEST_CHECK(shutdownRecordManager());
+
+  printf("bulkload: %d records, insertRecord %.3fs (%.0f rows/s), bulkLoad %.3fs (%.0f rows/s), speedup %.1fx\n",
+	 numRecords, insertTime, numRecords / insertTime, loadTime, numRecords / loadTime, insertTime / loadTime);
+
+  for(i = 0; i < numRecords; i++)
+    freeRecord(records[i]);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// per-row insert/update/delete against batches of 1 to 1000 mutations
+void
+benchBatches (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * numRecords);
+  RID *ids = (RID *) malloc(sizeof(RID) * numRecords);
+  int batchSizes[] = {1, 10, 100, 1000};
+  int numBatchSizes = 4;
+  struct timespec start;
+  double insertTime, updateTime, deleteTime;
+  int b, i;
+
+  for(i = 0; i < numRecords; i++)
+    records[i] = testRecord(schema, i % 10000, "aaaa", i % 10);
+
+  TEST_CHECK(initRecordManager(NULL));
+
+  // baseline: one call per record
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    TEST_CHECK(insertRecord(table, records[i]));
+  insertTime = elapsedSeconds(&start);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    TEST_CHECK(updateRecord(table, records[(i * 7919) % numRecords]));
+  updateTime = elapsedSeconds(&start);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    TEST_CHECK(deleteRecord(table, records[(i * 7919) % numRecords]->id));
+  deleteTime = elapsedSeconds(&start);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  printf("batch: %d records, single calls: insert %.0f/s, update %.0f/s, delete %.0f/s\n",
+	 numRecords, numRecords / insertTime, numRecords / updateTime, numRecords / deleteTime);
+
+  for(b = 0; b < numBatchSizes; b++)
+    {
+      int batchSize = batchSizes[b];
+
+      TEST_CHECK(createTable("bench_table",testSchema()));
+      TEST_CHECK(openTable(table, "bench_table"));
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for(i = 0; i < numRecords; i += batchSize)
+	TEST_CHECK(insertRecords(table, records + i, (numRecords - i < batchSize) ? numRecords - i : batchSize));
+      insertTime = elapsedSeconds(&start);
+
+      // batches touch records spread over the whole table, the ids are
+      // permuted from a copy so that every record keeps a distinct id
+      for(i = 0; i < numRecords; i++)
+	ids[i] = records[(i * 7919) % numRecords]->id;
+      for(i = 0; i < numRecords; i++)
+	records[i]->id = ids[i];
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for(i = 0; i < numRecords; i += batchSize)
+	TEST_CHECK(updateRecords(table, records + i, (numRecords - i < batchSize) ? numRecords - i : batchSize));
+      updateTime = elapsedSeconds(&start);
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      for(i = 0; i < numRecords; i += batchSize)
+	TEST_CHECK(deleteRecords(table, ids + i, (numRecords - i < batchSize) ? numRecords - i : batchSize));
+      deleteTime = elapsedSeconds(&start);
+
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(deleteTable("bench_table"));
+      printf("batch: batch size %4d: insert %.0f/s, update %.0f/s, delete %.0f/s\n",
+	     batchSize, numRecords / insertTime, numRecords / updateTime, numRecords / deleteTime);
+    }
+
+  TEST_CHECK(shutdownRecordManager());
+
+  for(i = 0; i < numRecords; i++)
+    freeRecord(records[i]);
+  free(records);
+  free(ids);
+  free(table);
+}
+
+// ************************************************************
+// getAttr/setAttr on every column of a 32 column record
+void
+benchGetAttr (int numRecords)
+{
+  int numAttr = 32;
+  Schema *schema = wideSchema(numAttr);
+  Record *record;
+  Value *value;
+  Value into;
+  struct timespec start;
+  double getTime, intoTime, setTime;
+  long checksum = 0;
+  int i, j;
+
+  TEST_CHECK(createRecord(&record, schema));
+  for(j = 0; j < numAttr; j++)
+    {
+      switch(schema->dataTypes[j])
+	{
+	case DT_INT:
+	  MAKE_VALUE(value, DT_INT, j);
+	  break;
+	case DT_FLOAT:
+	  MAKE_VALUE(value, DT_FLOAT, j * 0.5f);
+	  break;
+	case DT_BOOL:
+	  MAKE_VALUE(value, DT_BOOL, j % 2);
+	  break;
+	case DT_STRING:
+	  MAKE_STRING_VALUE(value, "abcdefg");
+	  break;
+	}
+      TEST_CHECK(setAttr(record, schema, j, value));
+      freeVal(value);
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    for(j = 0; j < numAttr; j++)
+      {
+	TEST_CHECK(getAttr(record, schema, j, &value));
+	checksum += value->dt;
+	freeVal(value);
+      }
+  getTime = elapsedSeconds(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    for(j = 0; j < numAttr; j++)
+      {
+	TEST_CHECK(getAttrInto(record, schema, j, &into));
+	checksum += into.dt;
+      }
+  intoTime = elapsedSeconds(&start);
+
+  MAKE_VALUE(value, DT_INT, 42);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    for(j = 0; j < numAttr; j += 4)
+      TEST_CHECK(setAttr(record, schema, j, value));
+  setTime = elapsedSeconds(&start);
+  freeVal(value);
+
+  printf("getattr: %d records x %d columns, getAttr %.1f ns/attr (%.0f tuples/s), getAttrInto %.1f ns/attr, setAttr %.1f ns/attr, checksum %ld\n",
+	 numRecords, numAttr, getTime * 1e9 / ((double) numRecords * numAttr), numRecords / getTime,
+	 intoTime * 1e9 / ((double) numRecords * numAttr),
+	 setTime * 1e9 / ((double) numRecords * numAttr / 4), checksum);
+
+  freeRecord(record);
+  freeSchema(schema);
+}
+
+// ************************************************************
+// collect the matching records and one value of each of a full table scan,
+// with malloc/free per object against the scan arena
+void
+benchScanArena (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * numRecords);
+  Record **results = (Record **) malloc(sizeof(Record *) * numRecords);
+  Value **values = (Value **) malloc(sizeof(Value *) * numRecords);
+  RM_ScanHandle sc;
+  Expr *sel, *left, *right;
+  Record *r;
+  struct timespec start;
+  struct timespec release;
+  double mallocTime, arenaTime, mallocRelease, arenaRelease;
+  int i, numResults, numArenaResults;
+
+  for(i = 0; i < numRecords; i++)
+    records[i] = testRecord(schema, i, "aaaa", i % 10);
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  TEST_CHECK(bulkLoad(table, records, numRecords));
+
+  MAKE_CONS(left, stringToValue("i5"));
+  MAKE_ATTRREF(right, 2);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+
+  // every result record and value allocated and freed on its own
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, &sc, sel));
+  for(numResults = 0; next(&sc, r) == RC_OK; numResults++)
+    {
+      TEST_CHECK(createRecord(&results[numResults], schema));
+      memcpy(results[numResults]->data, r->data, getRecordSize(schema));
+      TEST_CHECK(getAttr(r, schema, 1, &values[numResults]));
+    }
+  clock_gettime(CLOCK_MONOTONIC, &release);
+  TEST_CHECK(closeScan(&sc));
+  for(i = 0; i < numResults; i++)
+    {
+      freeRecord(results[i]);
+      freeVal(values[i]);
+    }
+  freeRecord(r);
+  mallocRelease = elapsedSeconds(&release);
+  mallocTime = elapsedSeconds(&start);
+
+  // everything from the scan arena, released by closeScan
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScan(table, &sc, sel));
+  TEST_CHECK(createRecordInArena(&r, schema, getScanArena(&sc)));
+  for(numArenaResults = 0; next(&sc, r) == RC_OK; numArenaResults++)
+    {
+      TEST_CHECK(createRecordInArena(&results[numArenaResults], schema, getScanArena(&sc)));
+      memcpy(results[numArenaResults]->data, r->data, getRecordSize(schema));
+      TEST_CHECK(getAttrInArena(r, schema, 1, &values[numArenaResults], getScanArena(&sc)));
+    }
+  clock_gettime(CLOCK_MONOTONIC, &release);
+  TEST_CHECK(closeScan(&sc));
+  arenaRelease = elapsedSeconds(&release);
+  arenaTime = elapsedSeconds(&start);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  printf("scanarena: %d records, %d results, malloc %.3fs (%.0f rows/s, release %.4fs), arena %.3fs (%.0f rows/s, release %.4fs)\n",
+	 numRecords, numResults, mallocTime, numRecords / mallocTime, mallocRelease,
+	 arenaTime, numRecords / arenaTime, arenaRelease);
+  if (numResults != numArenaResults)
+    printf("scanarena: arena scan returned %d results\n", numArenaResults);
+
+  freeExpr(sel);
+  for(i = 0; i < numRecords; i++)
+    freeRecord(records[i]);
+  free(records);
+  free(results);
+  free(values);
+  free(table);
+}
+
+// ************************************************************
+// startParallelScan from 1 to 16 threads, every thread counting its
+// matches in a counter of its own cache line
+#define BENCH_MAX_THREADS 16
+#define BENCH_LOAD_CHUNK 100000
+
+typedef struct ThreadCount {
+  long count;
+  char pad[64 - sizeof(long)];
+} ThreadCount;
+
+void
+benchParallelScan (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  ThreadCount counts[BENCH_MAX_THREADS];
+  Expr *sel, *left, *right;
+  struct timespec start;
+  double time, oneThread = 0;
+  long matches;
+  int loaded, chunk, i, threads;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	records[i] = testRecord(schema, loaded + i, "aaaa", i % 10);
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+
+  MAKE_ATTRREF(left, 2);
+  MAKE_CONS(right, stringToValue("i5"));
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+
+  for(threads = 1; threads <= BENCH_MAX_THREADS; threads *= 2)
+    {
+      memset(counts, 0, sizeof(counts));
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      TEST_CHECK(startParallelScan(table, sel, threads, countMatch, counts));
+      time = elapsedSeconds(&start);
+      if (threads == 1)
+	oneThread = time;
+
+      for(i = 0, matches = 0; i < threads; i++)
+	matches += counts[i].count;
+      printf("parallel: %d records, %d threads, %ld matches, %.3fs (%.0f rows/s, %.2fx over 1 thread)\n",
+	     numRecords, threads, matches, time, numRecords / time, oneThread / time);
+    }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeExpr(sel);
+  free(records);
+  free(table);
+}
+
+void
+countMatch (int thread, Record *record, void *context)
+{
+  ((ThreadCount *) context)[thread].count++;
+}
+
+// ************************************************************
+// a B+-tree over the key of a table: inserts in random order, point
+// lookups and a scan of the index, against point lookups by table scan
+#define BENCH_LOOKUPS 1000000
+#define BENCH_SCAN_LOOKUPS 3
+
+void
+benchBtree (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  RID *rids = (RID *) malloc(sizeof(RID) * numRecords);
+  int *order = (int *) malloc(sizeof(int) * numRecords);
+  int numLookups = (numRecords < BENCH_LOOKUPS) ? numRecords : BENCH_LOOKUPS;
+  BTreeHandle *tree;
+  BT_ScanHandle *treeScan;
+  RM_ScanHandle sc;
+  Record *r;
+  Expr *sel, *left, *right;
+  Value key;
+  RID rid;
+  struct timespec start;
+  double insertTime, lookupTime, treeScanTime, scanTime;
+  int loaded, chunk, i, j, tmp, numNodes, found, scanned;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	records[i] = testRecord(schema, loaded + i, "aaaa", i % 10);
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	{
+	  rids[loaded + i] = records[i]->id;
+	  freeRecord(records[i]);
+	}
+    }
+
+  // keys in random order
+  srand(42);
+  for(i = 0; i < numRecords; i++)
+    order[i] = i;
+  for(i = numRecords - 1; i > 0; i--)
+    {
+      j = rand() % (i + 1);
+      tmp = order[i];
+      order[i] = order[j];
+      order[j] = tmp;
+    }
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("bench_idx", DT_INT, 0));
+  TEST_CHECK(openBtree(&tree, "bench_idx"));
+  key.dt = DT_INT;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    {
+      key.v.intV = order[i];
+      TEST_CHECK(insertKey(tree, &key, rids[order[i]]));
+    }
+  insertTime = elapsedSeconds(&start);
+  TEST_CHECK(getNumNodes(tree, &numNodes));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0, found = 0; i < numLookups; i++)
+    {
+      key.v.intV = order[((long) i * 7919) % numRecords];
+      TEST_CHECK(findKey(tree, &key, &rid));
+      found += (rid.page == rids[key.v.intV].page && rid.slot == rids[key.v.intV].slot);
+    }
+  lookupTime = elapsedSeconds(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(openTreeScan(tree, &treeScan));
+  for(scanned = 0; nextEntry(treeScan, &rid) == RC_OK; scanned++);
+  TEST_CHECK(closeTreeScan(treeScan));
+  treeScanTime = elapsedSeconds(&start);
+
+  // the same point lookups as table scans with a = key
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < BENCH_SCAN_LOOKUPS; i++)
+    {
+      MAKE_ATTRREF(left, 0);
+      MAKE_CONS(right, stringToValue("i0"));
+      right->expr.cons->v.intV = order[i];
+      MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+      TEST_CHECK(startScan(table, &sc, sel));
+      while (next(&sc, r) == RC_OK);
+      TEST_CHECK(closeScan(&sc));
+      freeExpr(sel);
+    }
+  freeRecord(r);
+  scanTime = elapsedSeconds(&start);
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("bench_idx"));
+  TEST_CHECK(shutdownIndexManager());
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  printf("btree: %d keys, %d nodes, inserts %.0f/s, lookups %.0f/s (%d of %d found), index scan %.0f entries/s, lookups by table scan %.2f/s (%.0fx slower than the index)\n",
+	 numRecords, numNodes, numRecords / insertTime, numLookups / lookupTime, found, numLookups,
+	 scanned / treeScanTime, BENCH_SCAN_LOOKUPS / scanTime,
+	 (scanTime / BENCH_SCAN_LOOKUPS) / (lookupTime / numLookups));
+
+  free(records);
+  free(rids);
+  free(order);
+  free(table);
+}
+
+// ************************************************************
+// inserts with the primary key check off and on, one call per record and in
+// batches, at a tenth of numRecords and at numRecords, and the time to
+// rebuild the key index when a table is opened
+#define BENCH_PK_BATCH 1000
+
+void
+benchPrimaryKey (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * numRecords);
+  Config config;
+  struct timespec start;
+  double offTime, onTime, batchTime, openTime;
+  int sizes[] = {numRecords / 10, numRecords};
+  int s, i, refused;
+
+  for(i = 0; i < numRecords; i++)
+    records[i] = testRecord(schema, i, "aaaa", i % 10);
+
+  for(s = 0; s < 2; s++)
+    {
+      int n = sizes[s];
+
+      offTime = timeKeyedInserts(0, records, n, 1);
+      onTime = timeKeyedInserts(1, records, n, 1);
+      batchTime = timeKeyedInserts(1, records, n, BENCH_PK_BATCH);
+
+      // reopen a full table and try to insert every record again
+      config.primaryKeyCheck = 1;
+      TEST_CHECK(initRecordManager(&config));
+      TEST_CHECK(createTable("bench_table",testSchema()));
+      TEST_CHECK(openTable(table, "bench_table"));
+      TEST_CHECK(bulkLoad(table, records, n));
+      TEST_CHECK(closeTable(table));
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      TEST_CHECK(openTable(table, "bench_table"));
+      openTime = elapsedSeconds(&start);
+      for(i = 0, refused = 0; i < n; i++)
+	if (insertRecord(table, records[i]) == RC_DUPLICATED_PRIMARYKEY)
+	  refused++;
+      TEST_CHECK(closeTable(table));
+      TEST_CHECK(deleteTable("bench_table"));
+      TEST_CHECK(shutdownRecordManager());
+
+      printf("pkcheck: %d records, insertRecord unchecked %.0f/s, checked %.0f/s, insertRecords(%d) checked %.0f/s, index rebuilt on open in %.3fs, %d of %d duplicates refused\n",
+	     n, n / offTime, n / onTime, BENCH_PK_BATCH, n / batchTime, openTime, refused, n);
+    }
+
+  for(i = 0; i < numRecords; i++)
+    freeRecord(records[i]);
+  freeSchema(schema);
+  free(records);
+  free(table);
+}
+
+
+// ************************************************************
+// 1, 4 and 16 concurrent full scans, every one with a condition of its own,
+// each started with startScan and with startSharedScan. The table is dropped
+// from the page cache before every round, so the pages read are read from
+// the disk.
+typedef struct ScanThread {
+  RM_TableData *table;
+  int shared;
+  int c;
+  long matches;
+  int pageReads;
+  pthread_t id;
+} ScanThread;
+
+void
+benchSharedScan (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  ScanThread threads[BENCH_MAX_THREADS];
+  struct timespec start;
+  double time;
+  long matches, pageReads;
+  int loaded, chunk, i, numThreads, shared, numPages;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	records[i] = testRecord(schema, loaded + i, "aaaa", i % 10);
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+  numPages = ((Table_Header *) table->mgmtData)->pageCount;
+
+  for(numThreads = 1; numThreads <= BENCH_MAX_THREADS; numThreads *= 4)
+    for(shared = 0; shared <= 1; shared++)
+      {
+	dropTableCache("bench_table");
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for(i = 0; i < numThreads; i++)
+	  {
+	    threads[i].table = table;
+	    threads[i].shared = shared;
+	    threads[i].c = 1 + i % 10;
+	    if (pthread_create(&threads[i].id, NULL, scanThread, &threads[i]) != 0)
+	      {
+		printf("sharedscan: cannot start thread %d\n", i);
+		exit(1);
+	      }
+	  }
+	for(i = 0, matches = 0, pageReads = 0; i < numThreads; i++)
+	  {
+	    pthread_join(threads[i].id, NULL);
+	    matches += threads[i].matches;
+	    pageReads += threads[i].pageReads;
+	  }
+	time = elapsedSeconds(&start);
+
+	printf("sharedscan: %d records, %d %s scans, %ld matches, %.3fs (%.0f rows/s), %ld of %d pages read (%.2f passes)\n",
+	       numRecords, numThreads, shared ? "shared" : "independent", matches, time,
+	       (double) numThreads * numRecords / time, pageReads, numPages * numThreads, (double) pageReads / numPages);
+      }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// analyzeTable at sampling rates from 0.1% to all pages, against the exact
+// values: a is unique, b takes BENCH_STATS_STRINGS values in turn and c is
+// uniform over BENCH_STATS_VALUES values. The error of the distinct values
+// is relative, the error of the selectivity of c < x and a < x the largest
+// absolute one over nine values of x.
+#define BENCH_STATS_VALUES 100000
+#define BENCH_STATS_STRINGS 10000
+
+void
+benchStats (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  int *counts = (int *) calloc(BENCH_STATS_VALUES, sizeof(int));
+  double rates[] = { 0.001, 0.01, 0.1, 1 };
+  double trueDistinct[3], errDistinct[3], fraction, errA, errC, time;
+  struct timespec start;
+  TableStats *stats;
+  Value value;
+  char b[12];
+  int loaded, chunk, i, r, x, below, distinctC = 0;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	{
+	  int c = (int) (((unsigned) (loaded + i) * 2654435761u) % BENCH_STATS_VALUES);
+	  snprintf(b, sizeof(b), "%04d", (loaded + i) % BENCH_STATS_STRINGS);
+	  records[i] = testRecord(schema, loaded + i, b, c);
+	  distinctC += (counts[c]++ == 0);
+	}
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+  trueDistinct[0] = numRecords;
+  trueDistinct[1] = (numRecords < BENCH_STATS_STRINGS) ? numRecords : BENCH_STATS_STRINGS;
+  trueDistinct[2] = distinctC;
+
+  for(r = 0; r < (int) (sizeof(rates) / sizeof(double)); r++)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      TEST_CHECK(analyzeTable(table, rates[r]));
+      time = elapsedSeconds(&start);
+      stats = getTableStats(table);
+      for(i = 0; i < 3; i++)
+	errDistinct[i] = fabs(stats->attrs[i].distinct - trueDistinct[i]) / trueDistinct[i];
+
+      value.dt = DT_INT;
+      for(x = 1, errA = 0, errC = 0, below = 0, i = 0; x <= 9; x++)
+	{
+	  value.v.intV = (int) ((long) x * numRecords / 10);
+	  TEST_CHECK(estimateSelectivity(table, 0, OP_COMP_SMALLER, &value, &fraction));
+	  errA = fmax(errA, fabs(fraction - x / 10.0));
+
+	  value.v.intV = x * BENCH_STATS_VALUES / 10;
+	  for(; i < value.v.intV; i++)
+	    below += counts[i];
+	  TEST_CHECK(estimateSelectivity(table, 2, OP_COMP_SMALLER, &value, &fraction));
+	  errC = fmax(errC, fabs(fraction - (double) below / numRecords));
+	}
+
+      printf("stats: %d records, %.1f%% of %d pages sampled (%d records) in %.3fs, distinct a %.0f (error %.2f%%), b %.0f (%.2f%%), c %.0f of %.0f (%.2f%%), selectivity error a < x %.4f, c < x %.4f\n",
+	     numRecords, rates[r] * 100, ((Table_Header *) table->mgmtData)->pageCount, stats->sampledTuples, time,
+	     stats->attrs[0].distinct, errDistinct[0] * 100, stats->attrs[1].distinct, errDistinct[1] * 100,
+	     stats->attrs[2].distinct, trueDistinct[2], errDistinct[2] * 100, errA, errC);
+    }
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(counts);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// scans of a range of 1% of the records on a, which grows with the
+// insertion order, and on c, which is uniform over BENCH_ZONE_VALUES values
+// on every page, without and with a zone map of both. Pages read and the
+// median time of BENCH_ZONE_SCANS scans from the file cache, and of one
+// scan after the table is dropped from it.
+#define BENCH_ZONE_VALUES 1000
+#define BENCH_ZONE_SCANS 5
+
+void
+benchZoneMap (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  int zoneAttrs[] = { 0, 2 };
+  struct timespec start;
+  Expr *rangeA, *rangeC, *low, *high;
+  Value *from, *to;
+  int loaded, chunk, i;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	records[i] = testRecord(schema, loaded + i, "aaaa",
+				(int) (((unsigned) (loaded + i) * 2654435761u) % BENCH_ZONE_VALUES));
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+
+  // a in [n / 2, n / 2 + n / 100), c < BENCH_ZONE_VALUES / 100
+  MAKE_VALUE(from, DT_INT, numRecords / 2);
+  MAKE_VALUE(to, DT_INT, numRecords / 2 + numRecords / 100);
+  MAKE_ATTRREF(low, 0);
+  MAKE_CONS(high, from);
+  MAKE_BINOP_EXPR(low, low, high, OP_COMP_GE);
+  MAKE_ATTRREF(high, 0);
+  MAKE_CONS(rangeA, to);
+  MAKE_BINOP_EXPR(high, high, rangeA, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(rangeA, low, high, OP_BOOL_AND);
+  rangeC = compareExpr(2, "i10", OP_COMP_SMALLER);
+
+  timeZoneScans(table, "a, no zone map", rangeA);
+  timeZoneScans(table, "c, no zone map", rangeC);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(buildZoneMap(table, zoneAttrs, 2));
+  printf("zonemap: built for %d pages in %.3fs\n", ((Table_Header *) table->mgmtData)->pageCount,
+	 elapsedSeconds(&start));
+  timeZoneScans(table, "a, zone map", rangeA);
+  timeZoneScans(table, "c, zone map", rangeC);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeExpr(rangeA);
+  freeExpr(rangeC);
+  freeSchema(schema);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// a join of numRecords / 10 records on their unique key a with numRecords
+// records holding random keys, by hash joins with the hash table in memory
+// and split into partitions, against nested scans: for every record of the
+// smaller table the larger one is scanned for a = key. The nested scans
+// are timed for BENCH_JOIN_OUTER records and scaled up to the table.
+#define BENCH_JOIN_MEMORY (256 << 20)
+#define BENCH_JOIN_SMALL_MEMORY (16 << 20)
+#define BENCH_JOIN_OUTER 3
+
+void
+benchHashJoin (int numRecords)
+{
+  RM_TableData *build = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *probe = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  int numBuild = numRecords / 10, loaded, chunk, i, found = 0;
+  struct timespec start;
+  RM_ScanHandle sc;
+  Record *r;
+  double seconds;
+  char value[16];
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(build, "bench_table"));
+  TEST_CHECK(createTable("bench_probe",schema));
+  TEST_CHECK(openTable(probe, "bench_probe"));
+  for(loaded = 0; loaded < numBuild; loaded += chunk)
+    {
+      chunk = (numBuild - loaded < BENCH_LOAD_CHUNK) ? numBuild - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	records[i] = testRecord(schema, loaded + i, "bbbb", loaded + i);
+      TEST_CHECK(bulkLoad(build, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	records[i] = testRecord(schema, (int) (((unsigned) (loaded + i) * 2654435761u) % numBuild), "pppp", loaded + i);
+      TEST_CHECK(bulkLoad(probe, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+
+  timeHashJoin(build, probe, BENCH_JOIN_MEMORY);
+  timeHashJoin(build, probe, BENCH_JOIN_SMALL_MEMORY);
+
+  // nested scans, as a join had to be written before
+  TEST_CHECK(createRecord(&r, schema));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < BENCH_JOIN_OUTER; i++)
+    {
+      Expr *cond;
+
+      sprintf(value, "i%d", i);
+      cond = compareExpr(0, value, OP_COMP_EQUAL);
+      TEST_CHECK(startScan(probe, &sc, cond));
+      while (next(&sc, r) == RC_OK)
+	found++;
+      TEST_CHECK(closeScan(&sc));
+      freeExpr(cond);
+    }
+  seconds = elapsedSeconds(&start);
+  printf("hashjoin: nested scans, %d x %d records, %d pairs for %d records in %.3fs, %.0fs estimated for all of them\n",
+	 numBuild, numRecords, found, BENCH_JOIN_OUTER, seconds, seconds / BENCH_JOIN_OUTER * numBuild);
+  freeRecord(r);
+
+  TEST_CHECK(closeTable(build));
+  TEST_CHECK(closeTable(probe));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(deleteTable("bench_probe"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(records);
+  free(build);
+  free(probe);
+}
+
+// ************************************************************
+// sorts of a table ten times the size of their memory, written to runs and
+// merged, against the same sorts in memory. The key a is an int sorted by
+// radix sort, the key (b, c) is 9 bytes long and sorted by pdqsort.
+#define BENCH_SORT_ALL_MEMORY ((size_t) 2 << 30)
+
+void
+benchSort (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  int byA[] = { 0 }, byBC[] = { 1, 2 };
+  int loaded, chunk, i;
+  size_t memory;
+  char b[8];
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	{
+	  unsigned key = (unsigned) (loaded + i) * 2654435761u;
+
+	  sprintf(b, "%04u", key % 10000);
+	  records[i] = testRecord(schema, (int) (key % numRecords), b, (int) (key >> 8));
+	}
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+
+  memory = (size_t) ((Table_Header *) table->mgmtData)->pageCount * PAGE_SIZE / 10;
+  timeSort(table, "a", byA, 1, memory);
+  timeSort(table, "a", byA, 1, BENCH_SORT_ALL_MEMORY);
+  timeSort(table, "b, c", byBC, 2, memory);
+  timeSort(table, "b, c", byBC, 2, BENCH_SORT_ALL_MEMORY);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// COUNT, SUM, MIN, MAX and AVG of c without GROUP BY, grouped by b with 10
+// values and by a with numRecords / 10 values, on 1 and BENCH_AGG_THREADS
+// threads, against pulling every record out through next() and adding it
+// up in the application, which is how aggregates were computed before.
+#define BENCH_AGG_THREADS 8
+
+void
+benchAggregate (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  Aggregate aggs[] = { { AGG_COUNT, 0 }, { AGG_SUM, 2 }, { AGG_MIN, 2 }, { AGG_MAX, 2 }, { AGG_AVG, 2 } };
+  int byA[] = { 0 }, byB[] = { 1 };
+  int loaded, chunk, i, c, min = 0, max = 0, found = 0;
+  long long sum = 0;
+  struct timespec start;
+  double seconds;
+  RM_ScanHandle sc;
+  Record *r;
+  char b[8];
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	{
+	  unsigned key = (unsigned) (loaded + i) * 2654435761u;
+
+	  sprintf(b, "%04u", key % 10);
+	  records[i] = testRecord(schema, (int) (key % (numRecords / 10)), b, (int) (key % 1000));
+	}
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+
+  // the application reads every record
+  TEST_CHECK(createRecord(&r, schema));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScan(table, &sc, NULL));
+  while (next(&sc, r) == RC_OK)
+    {
+      getIntAttr(r, schema, 2, &c);
+      if (found == 0 || c < min)
+	min = c;
+      if (found == 0 || c > max)
+	max = c;
+      sum += c;
+      found++;
+    }
+  TEST_CHECK(closeScan(&sc));
+  seconds = elapsedSeconds(&start);
+  printf("aggregate: next() in the application, %d records, sum %lld, min %d, max %d in %.3fs (%.0f rows/s)\n",
+	 found, sum, min, max, seconds, found / seconds);
+  freeRecord(r);
+
+  timeAggregate(table, "no GROUP BY", NULL, 0, aggs, 5, 1);
+  timeAggregate(table, "no GROUP BY", NULL, 0, aggs, 5, BENCH_AGG_THREADS);
+  timeAggregate(table, "GROUP BY b", byB, 1, aggs, 5, 1);
+  timeAggregate(table, "GROUP BY b", byB, 1, aggs, 5, BENCH_AGG_THREADS);
+  timeAggregate(table, "GROUP BY a", byA, 1, aggs, 5, 1);
+  timeAggregate(table, "GROUP BY a", byA, 1, aggs, 5, BENCH_AGG_THREADS);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// the first BENCH_TOP_K records with c < 10000 through a LIMIT scan, and the
+// BENCH_TOP_K records with the smallest c, the smallest a and the largest a
+// through ORDER BY ... LIMIT scans, against reading every record through
+// next() and sorting them in the application. a grows with the insertion
+// order and has a zone map, c is spread over the whole table.
+#define BENCH_TOP_K 100
+
+void
+benchTopK (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  int zoneAttrs[] = { 0 };
+  int loaded, chunk, i, found;
+  struct timespec start;
+  double seconds;
+  RM_ScanHandle sc;
+  Expr *cond;
+  Record *r;
+  char b[8];
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	{
+	  unsigned key = (unsigned) (loaded + i) * 2654435761u;
+
+	  sprintf(b, "%04u", key % 10);
+	  records[i] = testRecord(schema, loaded + i, b, (int) (key % 1000000));
+	}
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+  TEST_CHECK(buildZoneMap(table, zoneAttrs, 1));
+
+  // the application stops looking at the records after the first ones but
+  // the scan goes on to the end of the table
+  cond = compareExpr(2, "i10000", OP_COMP_SMALLER);
+  TEST_CHECK(createRecord(&r, schema));
+  dropTableCache("bench_table");
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScan(table, &sc, cond));
+  for(found = 0; next(&sc, r) == RC_OK; )
+    if (found < BENCH_TOP_K)
+      found++;
+  seconds = elapsedSeconds(&start);
+  printf("topk: first %d with c < 10000, next() to the end, %d pages read in %.3fs\n",
+	 found, getScanPageReads(&sc), seconds);
+  TEST_CHECK(closeScan(&sc));
+
+  dropTableCache("bench_table");
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScanLimit(table, &sc, cond, BENCH_TOP_K));
+  for(found = 0; next(&sc, r) == RC_OK; found++);
+  seconds = elapsedSeconds(&start);
+  printf("topk: first %d with c < 10000, LIMIT scan, %d pages read in %.3fs\n",
+	 found, getScanPageReads(&sc), seconds);
+  TEST_CHECK(closeScan(&sc));
+  freeRecord(r);
+  freeExpr(cond);
+
+  timeTopK(table, "c", 2, FALSE);
+  timeTopK(table, "a", 0, FALSE);
+  timeTopK(table, "a", 0, TRUE);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// the same 20 column table in the row layout and in the PAX layout: a cold
+// scan with a condition on one column returning two columns, a scan of
+// whole records, and aggregations without and with GROUP BY
+void
+benchPax (int numRecords)
+{
+  RM_TableData *rows = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *pax = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numAttr = 20;
+  Schema *schema = wideSchema(numAttr);
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  int loaded, chunk, i, j;
+  Value *value = NULL;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(rows, "bench_table"));
+  TEST_CHECK(createTableWithLayout("bench_pax",schema, LAYOUT_PAX));
+  TEST_CHECK(openTable(pax, "bench_pax"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	{
+	  unsigned key = (unsigned) (loaded + i) * 2654435761u;
+
+	  TEST_CHECK(createRecord(&records[i], schema));
+	  for(j = 0; j < numAttr; j++)
+	    {
+	      switch(schema->dataTypes[j])
+		{
+		case DT_INT:
+		  MAKE_VALUE(value, DT_INT, (int) ((key + j) % 1000));
+		  break;
+		case DT_FLOAT:
+		  MAKE_VALUE(value, DT_FLOAT, j * 0.5f);
+		  break;
+		case DT_BOOL:
+		  MAKE_VALUE(value, DT_BOOL, (key >> j) % 2);
+		  break;
+		case DT_STRING:
+		  MAKE_STRING_VALUE(value, "abcdefg");
+		  break;
+		}
+	      TEST_CHECK(setAttr(records[i], schema, j, value));
+	      freeVal(value);
+	    }
+	}
+      TEST_CHECK(bulkLoad(rows, records, chunk));
+      TEST_CHECK(bulkLoad(pax, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+
+  timeLayout(rows, "bench_table", "row");
+  timeLayout(pax, "bench_pax", "PAX");
+
+  TEST_CHECK(closeTable(rows));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(closeTable(pax));
+  TEST_CHECK(deleteTable("bench_pax"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(records);
+  free(rows);
+  free(pax);
+}
+
+// ************************************************************
+// an orders table like the ones of TPC-H, stored as PAX pages and as
+// compressed PAX pages: the size of both, the encodings of the first page,
+// cold scans of whole records, of a dictionary code and of a date range,
+// and an aggregation
+void
+benchCompress (int numRecords)
+{
+  RM_TableData *pax = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *packed = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *tables[2];
+  Schema *schema = ordersSchema();
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTableWithLayout("bench_pax", schema, LAYOUT_PAX));
+  TEST_CHECK(openTable(pax, "bench_pax"));
+  TEST_CHECK(createTableWithLayout("bench_table", schema, LAYOUT_COMPRESSED));
+  TEST_CHECK(openTable(packed, "bench_table"));
+  tables[0] = pax;
+  tables[1] = packed;
+  loadOrders(tables, 2, numRecords);
+
+  printf("compress: %d orders, PAX %d pages, compressed %d pages (%.2fx)\n", numRecords,
+	 ((Table_Header *) pax->mgmtData)->pageCount, ((Table_Header *) packed->mgmtData)->pageCount,
+	 (double) ((Table_Header *) pax->mgmtData)->pageCount / ((Table_Header *) packed->mgmtData)->pageCount);
+  printEncodings(packed, "bench_table");
+
+  timeCompressed(pax, "bench_pax", "PAX");
+  timeCompressed(packed, "bench_table", "compressed");
+
+  TEST_CHECK(closeTable(pax));
+  TEST_CHECK(deleteTable("bench_pax"));
+  TEST_CHECK(closeTable(packed));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(pax);
+  free(packed);
+}
+
+// ************************************************************
+// an orders table in rows and the same table archived with
+// compressPageFile: the size of both and the time to compress, the
+// decompression speed of the codec, and cold scans of both
+#define BENCH_ARCHIVE_PASSES 5
+
+void
+benchArchive (int numRecords)
+{
+  RM_TableData *plain = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *archive = (RM_TableData *) malloc(sizeof(RM_TableData));
+  RM_TableData *tables[2];
+  Schema *schema = ordersSchema();
+  SM_FileHandle fh;
+  struct stat st;
+  struct timespec start;
+  char page[PAGE_SIZE], *extents;
+  int *lengths;
+  long long plainSize, archiveSize, packedSize = 0;
+  double seconds;
+  int numPages, pageNum, pass;
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table", schema));
+  TEST_CHECK(openTable(plain, "bench_table"));
+  TEST_CHECK(createTable("bench_archive", schema));
+  TEST_CHECK(openTable(archive, "bench_archive"));
+  tables[0] = plain;
+  tables[1] = archive;
+  loadOrders(tables, 2, numRecords);
+  TEST_CHECK(closeTable(archive));
+
+  stat("bench_archive", &st);
+  plainSize = st.st_size;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(compressPageFile("bench_archive"));
+  seconds = elapsedSeconds(&start);
+  stat("bench_archive", &st);
+  archiveSize = st.st_size;
+  printf("archive: %d orders, %lld MB in rows, %lld MB archived (%.2fx), compressed in %.3fs (%.0f MB/s)\n",
+	 numRecords, plainSize >> 20, archiveSize >> 20, (double) plainSize / archiveSize, seconds,
+	 plainSize / seconds / 1e6);
+
+  // the codec alone, on every page of the table compressed in memory
+  TEST_CHECK(openPageFile("bench_table", &fh));
+  numPages = fh.totalNumPages;
+  extents = (char *) malloc((size_t) numPages * LZ_BOUND(PAGE_SIZE));
+  lengths = (int *) malloc(sizeof(int) * numPages);
+  for(pageNum = 0; pageNum < numPages; pageNum++)
+    {
+      TEST_CHECK(readBlock(pageNum, &fh, page));
+      lengths[pageNum] = lzCompress(page, PAGE_SIZE, extents + (size_t) pageNum * LZ_BOUND(PAGE_SIZE),
+				    LZ_BOUND(PAGE_SIZE));
+      packedSize += lengths[pageNum];
+    }
+  TEST_CHECK(closePageFile(&fh));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(pass = 0; pass < BENCH_ARCHIVE_PASSES; pass++)
+    for(pageNum = 0; pageNum < numPages; pageNum++)
+      if (lzDecompress(extents + (size_t) pageNum * LZ_BOUND(PAGE_SIZE), lengths[pageNum], page, PAGE_SIZE)
+	  != PAGE_SIZE)
+	printf("archive: page %d does not decompress\n", pageNum);
+  seconds = elapsedSeconds(&start);
+  printf("archive: %d pages, %.2fx in memory, decompressed at %.2f GB/s\n", numPages,
+	 (double) numPages * PAGE_SIZE / packedSize,
+	 (double) numPages * PAGE_SIZE * BENCH_ARCHIVE_PASSES / seconds / 1e9);
+  free(extents);
+  free(lengths);
+
+  TEST_CHECK(openTable(archive, "bench_archive"));
+  timeArchivedScan(plain, "bench_table", "rows", plainSize);
+  timeArchivedScan(archive, "bench_archive", "archived", archiveSize);
+
+  TEST_CHECK(closeTable(plain));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(closeTable(archive));
+  TEST_CHECK(deleteTable("bench_archive"));
+  TEST_CHECK(shutdownRecordManager());
+
+  freeSchema(schema);
+  free(plain);
+  free(archive);
+}
+
+// ************************************************************
+// p50 and p99 latency of getRecordByKey through the persistent hash index,
+// through the in-memory key index of the primary key check, and without an
+// index, where the table is scanned up to the key, against a full scan with
+// a = key as the primary key check did before it had an index
+#define BENCH_HASH_LOOKUPS 100000
+#define BENCH_HASH_SCANS 5
+
+void
+benchHashIndex (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  double *seconds = (double *) malloc(sizeof(double) * BENCH_HASH_SCANS);
+  int numLookups = (numRecords < BENCH_HASH_LOOKUPS) ? numRecords : BENCH_HASH_LOOKUPS;
+  HashHandle *hash;
+  RM_ScanHandle sc;
+  Record *r;
+  Expr *sel, *left, *right;
+  Config config;
+  struct timespec start;
+  double buildTime, hashTime, hash99, keyTime, key99, scanTime, scan99;
+  int loaded, chunk, i, numBuckets;
+
+  config.primaryKeyCheck = 0;
+  TEST_CHECK(initRecordManager(&config));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	records[i] = testRecord(schema, loaded + i, "aaaa", i % 10);
+      TEST_CHECK(bulkLoad(table, records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+
+  // without an index
+  scanTime = timeKeyLookups(table, numRecords, BENCH_HASH_SCANS, &scan99);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(createKeyHash(table));
+  buildTime = elapsedSeconds(&start);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openTable(table, "bench_table"));
+  hashTime = timeKeyLookups(table, numRecords, numLookups, &hash99);
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(openHashIndex(&hash, "bench_table.hash"));
+  TEST_CHECK(getHashNumBuckets(hash, &numBuckets));
+  TEST_CHECK(closeHashIndex(hash));
+  TEST_CHECK(deleteHashIndex("bench_table.hash"));
+  TEST_CHECK(shutdownRecordManager());
+
+  // the key index of the primary key check
+  config.primaryKeyCheck = 1;
+  TEST_CHECK(initRecordManager(&config));
+  TEST_CHECK(openTable(table, "bench_table"));
+  keyTime = timeKeyLookups(table, numRecords, numLookups, &key99);
+
+  // full scans with a = key
+  TEST_CHECK(createRecord(&r, schema));
+  for(i = 0; i < BENCH_HASH_SCANS; i++)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      MAKE_ATTRREF(left, 0);
+      MAKE_CONS(right, stringToValue("i0"));
+      right->expr.cons->v.intV = (int) ((2L * i + 1) * numRecords / (2 * BENCH_HASH_SCANS));
+      MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+      TEST_CHECK(startScan(table, &sc, sel));
+      while (next(&sc, r) == RC_OK);
+      TEST_CHECK(closeScan(&sc));
+      freeExpr(sel);
+      seconds[i] = elapsedSeconds(&start);
+    }
+  freeRecord(r);
+  qsort(seconds, BENCH_HASH_SCANS, sizeof(double), compareSeconds);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  printf("hashindex: %d records, hash index of %d buckets built in %.3fs, getRecordByKey p50/p99: hash index %.1f/%.1fus, key index %.1f/%.1fus, scan without index %.0f/%.0fus (%d lookups), full scan with a = key %.0f/%.0fus (%d scans)\n",
+	 numRecords, numBuckets, buildTime, hashTime * 1e6, hash99 * 1e6, keyTime * 1e6, key99 * 1e6,
+	 scanTime * 1e6, scan99 * 1e6, BENCH_HASH_SCANS,
+	 seconds[BENCH_HASH_SCANS / 2] * 1e6, seconds[BENCH_HASH_SCANS - 1] * 1e6, BENCH_HASH_SCANS);
+
+  freeSchema(schema);
+  free(seconds);
+  free(records);
+  free(table);
+}
+
+// ************************************************************
+// tree evaluation (evalExpr, evalExprInto) against compiled programs for
+// the testScans predicates and a 10 term AND/OR predicate
+void
+benchPredicates (int numRecords)
+{
+  Schema *schema = testSchema();
+  Record **records = (Record **) malloc(sizeof(Record *) * numRecords);
+  char *strings[] = { "aaaa", "bbbb", "cccc", "dddd", "eeee", "ffff", "gggg", "hhhh" };
+  Expr *expr, *term;
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    records[i] = testRecord(schema, i % 1000, strings[i % 8], i % 10);
+
+  // testScans: c = 1
+  expr = compareExpr(2, "i1", OP_COMP_EQUAL);
+  benchPredicate("c = 1", schema, records, numRecords, expr);
+  freeExpr(expr);
+
+  // testScansTwo: b = 'ffff'
+  expr = compareExpr(1, "sffff", OP_COMP_EQUAL);
+  benchPredicate("b = 'ffff'", schema, records, numRecords, expr);
+  freeExpr(expr);
+
+  // testScansTwo: NOT (c < 4)
+  MAKE_UNOP_EXPR(expr, compareExpr(2, "i4", OP_COMP_SMALLER), OP_BOOL_NOT);
+  benchPredicate("NOT c < 4", schema, records, numRecords, expr);
+  freeExpr(expr);
+
+  // (a < 100 AND c = 1) OR (b = 'bbbb' AND c = 2) OR ... five pairs
+  expr = NULL;
+  for(i = 0; i < 5; i++)
+    {
+      char value[16];
+      Expr *left;
+
+      if (i % 2 == 0)
+	{
+	  sprintf(value, "i%d", 100 * (i + 1));
+	  left = compareExpr(0, value, OP_COMP_SMALLER);
+	}
+      else
+	{
+	  sprintf(value, "s%s", strings[i]);
+	  left = compareExpr(1, value, OP_COMP_EQUAL);
+	}
+      sprintf(value, "i%d", i);
+      MAKE_BINOP_EXPR(term, left, compareExpr(2, value, OP_COMP_EQUAL), OP_BOOL_AND);
+      if (expr == NULL)
+	expr = term;
+      else
+	{
+	  Expr *left = expr;
+	  MAKE_BINOP_EXPR(expr, left, term, OP_BOOL_OR);
+	}
+    }
+  benchPredicate("10 term AND/OR", schema, records, numRecords, expr);
+  freeExpr(expr);
+
+  for(i = 0; i < numRecords; i++)
+    freeRecord(records[i]);
+  free(records);
+  freeSchema(schema);
+}
+
+static void
+benchPredicate (char *name, Schema *schema, Record **records, int numRecords, Expr *expr)
+{
+  ExprProgram *program;
+  Value *value;
+  Value into;
+  struct timespec start;
+  double evalTime, intoTime, programTime;
+  int i, result, evalMatches = 0, intoMatches = 0, programMatches = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(evalExpr(records[i], schema, expr, &value));
+      evalMatches += value->v.boolV;
+      freeVal(value);
+    }
+  evalTime = elapsedSeconds(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(evalExprInto(records[i], schema, expr, &into));
+      intoMatches += into.v.boolV;
+    }
+  intoTime = elapsedSeconds(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(compileExpr(expr, schema, &program));
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(evalProgram(program, records[i], &result));
+      programMatches += result;
+    }
+  freeExprProgram(program);
+  programTime = elapsedSeconds(&start);
+
+  printf("predicate: %-16s %d tuples, %d matches, evalExpr %.0f/s, evalExprInto %.0f/s, compiled %.0f/s (%.1fx)\n",
+	 name, numRecords, programMatches, numRecords / evalTime, numRecords / intoTime,
+	 numRecords / programTime, intoTime / programTime);
+  if (evalMatches != programMatches || intoMatches != programMatches)
+    printf("predicate: %s: evalExpr %d and evalExprInto %d matches\n", name, evalMatches, intoMatches);
+}
+
+// ************************************************************
+// evalProgram tuple at a time against evalProgramBatch page at a time on
+// int, float and fixed length string columns
+void
+benchVectorized (int numRecords)
+{
+  Schema *schema = wideSchema(4);
+  char *tuples = vectorTuples(schema, numRecords);
+  Expr *expr, *left, *right;
+
+  expr = compareExpr(0, "i100", OP_COMP_SMALLER);
+  benchBatchPredicate("int <", schema, tuples, numRecords, expr);
+  freeExpr(expr);
+
+  expr = compareExpr(0, "i42", OP_COMP_EQUAL);
+  benchBatchPredicate("int =", schema, tuples, numRecords, expr);
+  freeExpr(expr);
+
+  expr = compareExpr(1, "f5.0", OP_COMP_SMALLER);
+  benchBatchPredicate("float <", schema, tuples, numRecords, expr);
+  freeExpr(expr);
+
+  expr = compareExpr(3, "sffff", OP_COMP_EQUAL);
+  benchBatchPredicate("string =", schema, tuples, numRecords, expr);
+  freeExpr(expr);
+
+  // c0 < 500 AND c1 < 25.0 AND NOT c3 = 'aaaa'
+  MAKE_BINOP_EXPR(left, compareExpr(0, "i500", OP_COMP_SMALLER), compareExpr(1, "f25.0", OP_COMP_SMALLER), OP_BOOL_AND);
+  MAKE_UNOP_EXPR(right, compareExpr(3, "saaaa", OP_COMP_EQUAL), OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(expr, left, right, OP_BOOL_AND);
+  benchBatchPredicate("int AND float AND NOT string", schema, tuples, numRecords, expr);
+  freeExpr(expr);
+
+  free(tuples);
+  freeSchema(schema);
+}
+
+// ************************************************************
+// scans of a 20 column table reading one column: every attribute decoded,
+// the full record returned, only that column returned
+void
+benchProjection (int numRecords)
+{
+  RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+  int numAttr = 20;
+  Schema *schema = wideSchema(numAttr);
+  Record **records = (Record **) malloc(sizeof(Record *) * numRecords);
+  int attrList[] = { 4 };
+  RM_ScanHandle sc;
+  Record *r, projected;
+  Value *value;
+  struct timespec start;
+  double decodeTime, fullTime, projectedTime;
+  long decodeSum = 0, fullSum = 0, projectedSum = 0;
+  int i, j, v;
+
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(createRecord(&records[i], schema));
+      for(j = 0; j < numAttr; j++)
+	{
+	  switch(schema->dataTypes[j])
+	    {
+	    case DT_INT:
+	      MAKE_VALUE(value, DT_INT, i + j);
+	      break;
+	    case DT_FLOAT:
+	      MAKE_VALUE(value, DT_FLOAT, j * 0.5f);
+	      break;
+	    case DT_BOOL:
+	      MAKE_VALUE(value, DT_BOOL, j % 2);
+	      break;
+	    case DT_STRING:
+	      MAKE_STRING_VALUE(value, "abcdefg");
+	      break;
+	    }
+	  TEST_CHECK(setAttr(records[i], schema, j, value));
+	  freeVal(value);
+	}
+    }
+
+  TEST_CHECK(initRecordManager(NULL));
+  TEST_CHECK(createTable("bench_table",schema));
+  TEST_CHECK(openTable(table, "bench_table"));
+  TEST_CHECK(bulkLoad(table, records, numRecords));
+
+  // every attribute of every record decoded into a Value
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, &sc, NULL));
+  while (next(&sc, r) == RC_OK)
+    for(j = 0; j < numAttr; j++)
+      {
+	TEST_CHECK(getAttr(r, schema, j, &value));
+	if (j == 4)
+	  decodeSum += value->v.intV;
+	freeVal(value);
+      }
+  TEST_CHECK(closeScan(&sc));
+  freeRecord(r);
+  decodeTime = elapsedSeconds(&start);
+
+  // the whole record returned, one column read
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(createRecord(&r, schema));
+  TEST_CHECK(startScan(table, &sc, NULL));
+  while (next(&sc, r) == RC_OK)
+    {
+      TEST_CHECK(getIntAttr(r, schema, 4, &v));
+      fullSum += v;
+    }
+  TEST_CHECK(closeScan(&sc));
+  freeRecord(r);
+  fullTime = elapsedSeconds(&start);
+
+  // only the column returned
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScanProjected(table, &sc, NULL, attrList, 1));
+  projected.data = NULL;
+  while (next(&sc, &projected) == RC_OK)
+    {
+      TEST_CHECK(getIntAttr(&projected, getScanSchema(&sc), 0, &v));
+      projectedSum += v;
+    }
+  TEST_CHECK(closeScan(&sc));
+  projectedTime = elapsedSeconds(&start);
+
+  TEST_CHECK(closeTable(table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+
+  printf("projection: %d records of %d attributes, decode all %.0f rows/s, full record %.0f rows/s, projected %.0f rows/s (%.1fx over decode all)\n",
+	 numRecords, numAttr, numRecords / decodeTime, numRecords / fullTime, numRecords / projectedTime,
+	 decodeTime / projectedTime);
+  if (decodeSum != projectedSum || fullSum != projectedSum)
+    printf("projection: sums differ: %ld, %ld, %ld\n", decodeSum, fullSum, projectedSum);
+
+  for(i = 0; i < numRecords; i++)
+    freeRecord(records[i]);
+  free(records);
+  freeSchema(schema);
+  free(table);
+}
+
+// ************************************************************
+// a predicate of an expensive string term and a cheap selective int term
+// written in the worst order, evaluated as a tree, as one program and as a
+// filter that reorders its terms
+void
+benchShortCircuit (int numRecords)
+{
+  Schema *schema = wideSchema(4);
+  int size = getRecordSize(schema);
+  char *tuples = vectorTuples(schema, numRecords);
+  Expr *expensiveFirst, *cheapFirst;
+  ExprFilter *filter;
+  double seconds;
+  int matches;
+
+  // c3 <= 'gggg' passes 7 of 8 tuples, c0 < 10 one in 100
+  MAKE_BINOP_EXPR(expensiveFirst, compareExpr(3, "sgggg", OP_COMP_LE), compareExpr(0, "i10", OP_COMP_SMALLER), OP_BOOL_AND);
+  MAKE_BINOP_EXPR(cheapFirst, compareExpr(0, "i10", OP_COMP_SMALLER), compareExpr(3, "sgggg", OP_COMP_LE), OP_BOOL_AND);
+
+  seconds = timeTree(schema, tuples, numRecords, expensiveFirst, &matches);
+  printf("shortcircuit: tree, expensive term first      %d matches, %.0f tuples/s\n", matches, numRecords / seconds);
+  seconds = timeTree(schema, tuples, numRecords, cheapFirst, &matches);
+  printf("shortcircuit: tree, cheap term first          %d matches, %.0f tuples/s\n", matches, numRecords / seconds);
+
+  // a filter kept in the written order, then one free to reorder
+  TEST_CHECK(compileFilter(expensiveFirst, schema, &filter));
+  filter->terms[0].rank = 0;
+  filter->terms[1].rank = 1;
+  if (filter->terms[0].program->instrs[0].op != BC_LOAD_STRING)
+    {
+      ExprTerm term = filter->terms[0];
+      filter->terms[0] = filter->terms[1];
+      filter->terms[1] = term;
+    }
+  filter->reorderTuples = numRecords + 1;
+  seconds = timeFilter(filter, size, tuples, numRecords, &matches);
+  printf("shortcircuit: batch, expensive term first     %d matches, %.0f tuples/s\n", matches, numRecords / seconds);
+
+  filter->reorderTuples = EXPR_REORDER_TUPLES;
+  seconds = timeFilter(filter, size, tuples, numRecords, &matches);
+  printf("shortcircuit: batch, reordered (%d times)     %d matches, %.0f tuples/s\n",
+	 filter->numReorders, matches, numRecords / seconds);
+  freeExprFilter(filter);
+
+  freeExpr(expensiveFirst);
+  freeExpr(cheapFirst);
+  free(tuples);
+  freeSchema(schema);
+}
+
+static double
+timeTree (Schema *schema, char *tuples, int numRecords, Expr *expr, int *matches)
+{
+  int size = getRecordSize(schema);
+  struct timespec start;
+  Record record;
+  Value result;
+  int i;
+
+  *matches = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    {
+      record.data = tuples + (size_t) i * size;
+      TEST_CHECK(evalExprInto(&record, schema, expr, &result));
+      *matches += result.v.boolV;
+    }
+  return elapsedSeconds(&start);
+}
+
+// evaluate a filter page by page like a scan
+static double
+timeFilter (ExprFilter *filter, int size, char *tuples, int numRecords, int *matches)
+{
+  int perPage = (PAGE_SIZE - 50) / size;
+  unsigned char *selection = (unsigned char *) malloc((perPage + 7) / 8);
+  struct timespec start;
+  double seconds;
+  int i, j;
+
+  *matches = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i += perPage)
+    {
+      int n = (numRecords - i < perPage) ? numRecords - i : perPage;
+      TEST_CHECK(evalFilterBatch(filter, tuples + (size_t) i * size, size, n, selection));
+      for(j = 0; j < (n + 7) / 8; j++)
+	*matches += __builtin_popcount(selection[j]);
+    }
+  seconds = elapsedSeconds(&start);
+  free(selection);
+  return seconds;
+}
+
+// tuples of wideSchema(4) side by side like the slots of a page
+static char *
+vectorTuples (Schema *schema, int numRecords)
+{
+  int size = getRecordSize(schema);
+  char *tuples = (char *) malloc((size_t) size * numRecords);
+  char *strings[] = { "aaaa", "bbbb", "cccc", "dddd", "eeee", "ffff", "gggg", "hhhh" };
+  Record *record;
+  Value *value;
+  int i;
+
+  TEST_CHECK(createRecord(&record, schema));
+  for(i = 0; i < numRecords; i++)
+    {
+      MAKE_VALUE(value, DT_INT, i % 1000);
+      TEST_CHECK(setAttr(record, schema, 0, value));
+      freeVal(value);
+      MAKE_VALUE(value, DT_FLOAT, (i % 100) * 0.5f);
+      TEST_CHECK(setAttr(record, schema, 1, value));
+      freeVal(value);
+      MAKE_VALUE(value, DT_BOOL, i % 2);
+      TEST_CHECK(setAttr(record, schema, 2, value));
+      freeVal(value);
+      MAKE_STRING_VALUE(value, strings[i % 8]);
+      TEST_CHECK(setAttr(record, schema, 3, value));
+      freeVal(value);
+      memcpy(tuples + (size_t) i * size, record->data, size);
+    }
+  freeRecord(record);
+  return tuples;
+}
+
+static void
+benchBatchPredicate (char *name, Schema *schema, char *tuples, int numRecords, Expr *expr)
+{
+  int size = getRecordSize(schema);
+  int perPage = (PAGE_SIZE - 50) / size;
+  unsigned char *selection = (unsigned char *) malloc((perPage + 7) / 8);
+  ExprProgram *program;
+  Record record;
+  struct timespec start;
+  double rowTime, batchTime;
+  int i, j, result, rowMatches = 0, batchMatches = 0;
+
+  TEST_CHECK(compileExpr(expr, schema, &program));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i++)
+    {
+      record.data = tuples + (size_t) i * size;
+      evalProgram(program, &record, &result);
+      rowMatches += result;
+    }
+  rowTime = elapsedSeconds(&start);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i += perPage)
+    {
+      int n = (numRecords - i < perPage) ? numRecords - i : perPage;
+      evalProgramBatch(program, tuples + (size_t) i * size, size, n, selection);
+      for(j = 0; j < (n + 7) / 8; j++)
+	batchMatches += __builtin_popcount(selection[j]);
+    }
+  batchTime = elapsedSeconds(&start);
+
+  printf("vector: %-28s %d tuples, %d matches, tuple at a time %.0f/s, batch %.0f/s (%.1fx)\n",
+	 name, numRecords, batchMatches, numRecords / rowTime, numRecords / batchTime, rowTime / batchTime);
+  if (rowMatches != batchMatches)
+    printf("vector: %s: tuple at a time found %d matches\n", name, rowMatches);
+
+  freeExprProgram(program);
+  free(selection);
+}
+
+static Expr *
+compareExpr (int attr, char *value, OpType op)
+{
+  Expr *result, *left, *right;
+
+  MAKE_ATTRREF(left, attr);
+  MAKE_CONS(right, stringToValue(value));
+  MAKE_BINOP_EXPR(result, left, right, op);
+  return result;
+}
+
+// ************************************************************
+// one scan of benchSharedScan, matching c < thread->c
+static void *
+scanThread (void *arg)
+{
+  ScanThread *thread = (ScanThread *) arg;
+  RM_ScanHandle sc;
+  Record *r;
+  Expr *sel, *left, *right;
+  Value *c;
+
+  MAKE_ATTRREF(left, 2);
+  MAKE_VALUE(c, DT_INT, thread->c);
+  MAKE_CONS(right, c);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+
+  TEST_CHECK(createRecord(&r, thread->table->schema));
+  TEST_CHECK(thread->shared ? startSharedScan(thread->table, &sc, sel) : startScan(thread->table, &sc, sel));
+  for(thread->matches = 0; next(&sc, r) == RC_OK; thread->matches++);
+  thread->pageReads = getScanPageReads(&sc);
+  TEST_CHECK(closeScan(&sc));
+
+  freeRecord(r);
+  freeExpr(sel);
+  return NULL;
+}
+
+// drop the pages of a table file from the page cache
+static void
+dropTableCache (char *name)
+{
+  int fd = open(name, O_RDONLY);
+
+  if (fd >= 0)
+    {
+      fdatasync(fd);
+      posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+      close(fd);
+    }
+}
+
+// ************************************************************
+static double
+elapsedSeconds (struct timespec *start)
+{
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  return (end.tv_sec - start->tv_sec) + (end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+Schema *
+testSchema (void)
+{
+  Schema *result;
+  char *names[] = { "a", "b", "c" };
+  DataType dt[] = { DT_INT, DT_STRING, DT_INT };
+  int sizes[] = { 0, 4, 0 };
+  int keys[] = {0};
+  int i;
+  char **cpNames = (char **) malloc(sizeof(char*) * 3);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 3);
+  int *cpSizes = (int *) malloc(sizeof(int) * 3);
+  int *cpKeys = (int *) malloc(sizeof(int));
+
+  for(i = 0; i < 3; i++)
+    {
+      cpNames[i] = (char *) malloc(2);
+      strcpy(cpNames[i], names[i]);
+    }
+  memcpy(cpDt, dt, sizeof(DataType) * 3);
+  memcpy(cpSizes, sizes, sizeof(int) * 3);
+  memcpy(cpKeys, keys, sizeof(int));
+
+  result = createSchema(3, cpNames, cpDt, cpSizes, 1, cpKeys);
+
+  return result;
+}
+
+// schema cycling through int, float, bool and string(7) columns
+static Schema *
+wideSchema (int numAttr)
+{
+  DataType dt[] = { DT_INT, DT_FLOAT, DT_BOOL, DT_STRING };
+  char **cpNames = (char **) malloc(sizeof(char*) * numAttr);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * numAttr);
+  int *cpSizes = (int *) malloc(sizeof(int) * numAttr);
+  int *cpKeys = (int *) malloc(sizeof(int));
+  int i;
+
+  for(i = 0; i < numAttr; i++)
+    {
+      cpNames[i] = (char *) malloc(12);
+      snprintf(cpNames[i], 12, "c%d", i);
+      cpDt[i] = dt[i % 4];
+      cpSizes[i] = (cpDt[i] == DT_STRING) ? 7 : 0;
+    }
+  cpKeys[0] = 0;
+
+  return createSchema(numAttr, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+Record *
+fromTestRecord (Schema *schema, TestRecord in)
+{
+  return testRecord(schema, in.a, in.b, in.c);
+}
+
+Record *
+testRecord(Schema *schema, int a, char *b, int c)
+{
+  Record *result;
+  Value *value;
+
+  TEST_CHECK(createRecord(&result, schema));
+
+  MAKE_VALUE(value, DT_INT, a);
+  TEST_CHECK(setAttr(result, schema, 0, value));
+  freeVal(value);
+
+  MAKE_STRING_VALUE(value, b);
+  TEST_CHECK(setAttr(result, schema, 1, value));
+  freeVal(value);
+
+  MAKE_VALUE(value, DT_INT, c);
+  TEST_CHECK(setAttr(result, schema, 2, value));
+  freeVal(value);
+
+  return result;
+}
+
+// insert records into a new table with the primary key check on or off
+static double
+timeKeyedInserts (int check, Record **records, int numRecords, int batchSize)
+{
+  RM_TableData table;
+  Config config;
+  struct timespec start;
+  double seconds;
+  int i;
+
+  config.primaryKeyCheck = check;
+  TEST_CHECK(initRecordManager(&config));
+  TEST_CHECK(createTable("bench_table",testSchema()));
+  TEST_CHECK(openTable(&table, "bench_table"));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for(i = 0; i < numRecords; i += batchSize)
+    {
+      int size = (numRecords - i < batchSize) ? numRecords - i : batchSize;
+      TEST_CHECK(size == 1 ? insertRecord(&table, records[i]) : insertRecords(&table, records + i, size));
+    }
+  seconds = elapsedSeconds(&start);
+  TEST_CHECK(closeTable(&table));
+  TEST_CHECK(deleteTable("bench_table"));
+  TEST_CHECK(shutdownRecordManager());
+  return seconds;
+}
+
+// time getRecordByKey for numLookups keys spread evenly over the table,
+// returns the median and sets percentile99
+static double
+timeKeyLookups (RM_TableData *table, int numRecords, int numLookups, double *percentile99)
+{
+  double *seconds = (double *) malloc(sizeof(double) * numLookups);
+  struct timespec start;
+  Record *r;
+  Value key;
+  double median;
+  int i;
+
+  TEST_CHECK(createRecord(&r, table->schema));
+  key.dt = DT_INT;
+  for(i = 0; i < numLookups; i++)
+    {
+      key.v.intV = (int) ((2L * i + 1) * numRecords / (2L * numLookups));
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      TEST_CHECK(getRecordByKey(table, &key, r));
+      seconds[i] = elapsedSeconds(&start);
+    }
+  freeRecord(r);
+
+  qsort(seconds, numLookups, sizeof(double), compareSeconds);
+  median = seconds[numLookups / 2];
+  *percentile99 = seconds[(int) (numLookups * 0.99)];
+  free(seconds);
+  return median;
+}
+
+static int
+compareSeconds (const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+// ************************************************************
+// pages read and time of the scans of benchZoneMap
+static void
+timeZoneScans (RM_TableData *table, char *name, Expr *cond)
+{
+  double seconds[BENCH_ZONE_SCANS], cold = 0;
+  struct timespec start;
+  RM_ScanHandle sc;
+  Record *r;
+  int run, found = 0, pageReads = 0;
+
+  TEST_CHECK(createRecord(&r, table->schema));
+  for(run = 0; run <= BENCH_ZONE_SCANS; run++)
+    {
+      if (run == 0)
+	dropTableCache(table->name);
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      TEST_CHECK(startScan(table, &sc, cond));
+      for(found = 0; next(&sc, r) == RC_OK; found++);
+      pageReads = getScanPageReads(&sc);
+      TEST_CHECK(closeScan(&sc));
+      if (run == 0)
+	cold = elapsedSeconds(&start);
+      else
+	seconds[run - 1] = elapsedSeconds(&start);
+    }
+  qsort(seconds, BENCH_ZONE_SCANS, sizeof(double), compareSeconds);
+  printf("zonemap: %s, %d records, %d of %d pages read, %.4fs from the file cache, %.4fs from disk\n",
+	 name, found, pageReads, ((Table_Header *) table->mgmtData)->pageCount, seconds[BENCH_ZONE_SCANS / 2], cold);
+  freeRecord(r);
+}
+
+// ************************************************************
+// time of a hash join of benchHashJoin
+static void
+timeHashJoin (RM_TableData *build, RM_TableData *probe, size_t memory)
+{
+  RM_JoinHandle join;
+  Record *buildRecord, *probeRecord;
+  struct timespec start;
+  long found = 0;
+  int partitions;
+
+  TEST_CHECK(createRecord(&buildRecord, build->schema));
+  TEST_CHECK(createRecord(&probeRecord, probe->schema));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startHashJoin(&join, build, 0, probe, 0, memory));
+  partitions = getJoinPartitions(&join);
+  while (nextJoin(&join, buildRecord, probeRecord) == RC_OK)
+    found++;
+  TEST_CHECK(closeJoin(&join));
+  printf("hashjoin: %d x %d records, %ld pairs in %.3fs with %zu MB, %d partitions\n",
+	 getNumTuples(build), getNumTuples(probe), found, elapsedSeconds(&start), memory >> 20, partitions);
+  freeRecord(buildRecord);
+  freeRecord(probeRecord);
+}
+
+// ************************************************************
+// time of a sort of benchSort, to its last record
+static void
+timeSort (RM_TableData *table, char *name, int *attrList, int numAttrs, size_t memory)
+{
+  RM_SortHandle sort;
+  Record *r;
+  struct timespec start;
+  double seconds;
+  int found = 0, runs;
+
+  TEST_CHECK(createRecord(&r, table->schema));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startSort(&sort, table, attrList, NULL, numAttrs, memory));
+  runs = getSortRuns(&sort);
+  while (nextSorted(&sort, r) == RC_OK)
+    found++;
+  TEST_CHECK(closeSort(&sort));
+  seconds = elapsedSeconds(&start);
+  printf("sort: on %s, %d records in %.3fs with %.1f MB, %d runs, %.0f records/s\n",
+	 name, found, seconds, memory / 1048576.0, runs, found / seconds);
+  freeRecord(r);
+}
+
+// ************************************************************
+// time of an aggregation of benchAggregate, to its last result
+static void
+timeAggregate (RM_TableData *table, char *name, int *groupBy, int numGroupBy, Aggregate *aggs, int numAggs,
+	       int threads)
+{
+  RM_AggHandle agg;
+  Record *r;
+  struct timespec start;
+  double seconds;
+  int groups = 0;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startAggregate(&agg, table, NULL, groupBy, numGroupBy, aggs, numAggs, threads));
+  TEST_CHECK(createRecord(&r, agg.schema));
+  // a group whose sum does not fit into an int is still a result
+  while (nextAggregate(&agg, r) != RC_RM_NO_MORE_TUPLES)
+    groups++;
+  seconds = elapsedSeconds(&start);
+  freeRecord(r);
+  TEST_CHECK(closeAggregate(&agg));
+  printf("aggregate: %s, %d records, %d groups, %d threads in %.3fs (%.0f rows/s)\n",
+	 name, getNumTuples(table), groups, threads, seconds, getNumTuples(table) / seconds);
+}
+
+// ************************************************************
+// the BENCH_TOP_K records with the smallest or largest int attribute of
+// benchTopK, every record copied out through next() and sorted by qsort
+// against an ORDER BY ... LIMIT scan
+static int topKeyOffset;
+static int topKeyDescending;
+
+static void
+timeTopK (RM_TableData *table, char *name, int attr, int descending)
+{
+  Schema *schema = table->schema;
+  int size = getRecordSize(schema), numTuples = getNumTuples(table);
+  char *all = (char *) malloc((size_t) numTuples * size);
+  int keys[BENCH_TOP_K];
+  int found, key, same;
+  struct timespec start;
+  double seconds;
+  RM_ScanHandle sc;
+  Record *r;
+
+  TEST_CHECK(createRecord(&r, schema));
+  topKeyOffset = schema->attrOffsets[attr];
+  topKeyDescending = descending;
+  dropTableCache("bench_table");
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScan(table, &sc, NULL));
+  for(found = 0; found < numTuples && next(&sc, r) == RC_OK; found++)
+    memcpy(all + (size_t) found * size, r->data, size);
+  TEST_CHECK(closeScan(&sc));
+  qsort(all, found, size, compareTopKey);
+  seconds = elapsedSeconds(&start);
+  for(key = 0; key < BENCH_TOP_K && key < found; key++)
+    memcpy(&keys[key], all + (size_t) key * size + topKeyOffset, sizeof(int));
+  printf("topk: %d by %s%s, next() and qsort of %d records in %.3fs\n",
+	 BENCH_TOP_K, name, descending ? " desc" : "", found, seconds);
+
+  dropTableCache("bench_table");
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScanTopK(table, &sc, NULL, attr, descending, BENCH_TOP_K));
+  for(found = 0, same = 1; next(&sc, r) == RC_OK; found++)
+    {
+      getIntAttr(r, schema, attr, &key);
+      same &= (found < BENCH_TOP_K && key == keys[found]);
+    }
+  seconds = elapsedSeconds(&start);
+  printf("topk: %d by %s%s, ORDER BY ... LIMIT scan, %d pages read in %.3fs%s\n",
+	 found, name, descending ? " desc" : "", getScanPageReads(&sc), seconds,
+	 same ? "" : " (DIFFERENT RESULT)");
+  TEST_CHECK(closeScan(&sc));
+  freeRecord(r);
+  free(all);
+}
+
+static int
+compareTopKey (const void *a, const void *b)
+{
+  int x, y;
+
+  memcpy(&x, (const char *) a + topKeyOffset, sizeof(int));
+  memcpy(&y, (const char *) b + topKeyOffset, sizeof(int));
+  return topKeyDescending ? (y > x) - (y < x) : (x > y) - (x < y);
+}
+
+// ************************************************************
+// scans and aggregations of benchPax on a table of one layout
+static void
+timeLayout (RM_TableData *table, char *name, char *layout)
+{
+  Aggregate sums[] = { { AGG_COUNT, 0 }, { AGG_SUM, 4 }, { AGG_SUM, 8 } };
+  int attrList[] = { 4, 8 };
+  int byC2[] = { 2 };
+  RM_ScanHandle sc;
+  Record *r, projected;
+  Expr *cond;
+  struct timespec start;
+  double seconds;
+  long sum = 0;
+  int found, v;
+
+  cond = compareExpr(0, "i100", OP_COMP_SMALLER);
+  dropTableCache(name);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScanProjected(table, &sc, cond, attrList, 2));
+  projected.data = NULL;
+  for(found = 0; next(&sc, &projected) == RC_OK; found++)
+    {
+      TEST_CHECK(getIntAttr(&projected, getScanSchema(&sc), 1, &v));
+      sum += v;
+    }
+  TEST_CHECK(closeScan(&sc));
+  seconds = elapsedSeconds(&start);
+  freeExpr(cond);
+  printf("pax: %s layout, cold scan c0 < 100 of c4 and c8, %d of %d records, sum %ld in %.3fs (%.0f rows/s)\n",
+	 layout, found, getNumTuples(table), sum, seconds, getNumTuples(table) / seconds);
+
+  sum = 0;
+  TEST_CHECK(createRecord(&r, table->schema));
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScan(table, &sc, NULL));
+  for(found = 0; next(&sc, r) == RC_OK; found++)
+    {
+      TEST_CHECK(getIntAttr(r, table->schema, 4, &v));
+      sum += v;
+    }
+  TEST_CHECK(closeScan(&sc));
+  seconds = elapsedSeconds(&start);
+  freeRecord(r);
+  printf("pax: %s layout, whole records, %d records, sum %ld in %.3fs (%.0f rows/s)\n",
+	 layout, found, sum, seconds, found / seconds);
+
+  printf("pax: %s layout, ", layout);
+  timeAggregate(table, "SUM c4, c8, no GROUP BY", NULL, 0, sums, 3, 1);
+  printf("pax: %s layout, ", layout);
+  timeAggregate(table, "SUM c4, c8, GROUP BY c2", byC2, 1, sums, 3, 1);
+}
+
+// ************************************************************
+// orderkey, custkey, status, priority, shipdate, quantity, price in cents
+// and shipmode of benchCompress
+static Schema *
+ordersSchema (void)
+{
+  char *names[] = { "orderkey", "custkey", "status", "priority", "shipdate", "quantity", "price", "shipmode" };
+  DataType dt[] = { DT_INT, DT_INT, DT_STRING, DT_STRING, DT_INT, DT_INT, DT_INT, DT_STRING };
+  int sizes[] = { 0, 0, 1, 8, 0, 0, 0, 7 };
+  char **cpNames = (char **) malloc(sizeof(char*) * 8);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 8);
+  int *cpSizes = (int *) malloc(sizeof(int) * 8);
+  int *cpKeys = (int *) malloc(sizeof(int));
+  int i;
+
+  for(i = 0; i < 8; i++)
+    {
+      cpNames[i] = (char *) malloc(strlen(names[i]) + 1);
+      strcpy(cpNames[i], names[i]);
+    }
+  memcpy(cpDt, dt, sizeof(DataType) * 8);
+  memcpy(cpSizes, sizes, sizeof(int) * 8);
+  cpKeys[0] = 0;
+
+  return createSchema(8, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+// the encoding every attribute got on the first page of a compressed table
+static void
+printEncodings (RM_TableData *table, char *name)
+{
+  char *encodings[] = { "plain", "FOR", "RLE", "dictionary" };
+  char page[PAGE_SIZE];
+  SM_FileHandle fh;
+  int numSlots, i;
+
+  TEST_CHECK(openPageFile(name, &fh));
+  TEST_CHECK(readBlock(1, &fh, page));
+  TEST_CHECK(closePageFile(&fh));
+  memcpy(&numSlots, page + 52, sizeof(int));
+  printf("compress: page 1 holds %d records,", numSlots);
+  for(i = 0; i < table->schema->numAttr; i++)
+    printf(" %s %s", table->schema->attrNames[i],
+	   encodings[columnEncoding(table->schema, page + 56, numSlots, i)]);
+  printf("\n");
+}
+
+// a cold scan of benchCompress, with the pages it read and decoded
+static void
+timeCompressedScan (RM_TableData *table, char *name, char *layout, char *what, Expr *cond)
+{
+  RM_ScanHandle sc;
+  Record *r;
+  struct timespec start;
+  double seconds;
+  long sum = 0;
+  int found, v, pageReads, decoded;
+
+  TEST_CHECK(createRecord(&r, table->schema));
+  dropTableCache(name);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScan(table, &sc, cond));
+  for(found = 0; next(&sc, r) == RC_OK; found++)
+    {
+      TEST_CHECK(getIntAttr(r, table->schema, 6, &v));
+      sum += v;
+    }
+  pageReads = getScanPageReads(&sc);
+  decoded = getScanDecodedPages(&sc);
+  TEST_CHECK(closeScan(&sc));
+  seconds = elapsedSeconds(&start);
+  freeRecord(r);
+  printf("compress: %s layout, cold scan %s, %d records, sum %ld, %d pages read, %d decoded in %.3fs (%.0f rows/s)\n",
+	 layout, what, found, sum, pageReads, decoded, seconds, getNumTuples(table) / seconds);
+}
+
+// scans and an aggregation of benchCompress on a table of one layout
+static void
+timeCompressed (RM_TableData *table, char *name, char *layout)
+{
+  Aggregate sums[] = { { AGG_COUNT, 0 }, { AGG_SUM, 5 }, { AGG_SUM, 6 } };
+  Expr *cond, *low, *high;
+
+  timeCompressedScan(table, name, layout, "of whole records", NULL);
+
+  cond = compareExpr(7, "sMAIL", OP_COMP_EQUAL);
+  timeCompressedScan(table, name, layout, "shipmode = MAIL", cond);
+  freeExpr(cond);
+
+  // one month of ship dates
+  low = compareExpr(4, "i9400", OP_COMP_GE);
+  high = compareExpr(4, "i9430", OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(cond, low, high, OP_BOOL_AND);
+  timeCompressedScan(table, name, layout, "shipdate in a month", cond);
+  freeExpr(cond);
+
+  dropTableCache(name);
+  printf("compress: %s layout, cold ", layout);
+  timeAggregate(table, "SUM quantity, price", NULL, 0, sums, 3, 1);
+}
+
+// ************************************************************
+// load the same numRecords orders into every table
+static void
+loadOrders (RM_TableData **tables, int numTables, int numRecords)
+{
+  char *modes[] = { "AIR", "RAIL", "SHIP", "TRUCK", "MAIL", "FOB", "REG AIR" };
+  char *priorities[] = { "1-URGENT", "2-HIGH", "3-MEDIUM", "4-NOTSPE", "5-LOW" };
+  char *statuses[] = { "F", "O", "P" };
+  Schema *schema = tables[0]->schema;
+  Record **records = (Record **) malloc(sizeof(Record *) * BENCH_LOAD_CHUNK);
+  int loaded, chunk, i, t;
+  Value *value;
+
+  for(loaded = 0; loaded < numRecords; loaded += chunk)
+    {
+      chunk = (numRecords - loaded < BENCH_LOAD_CHUNK) ? numRecords - loaded : BENCH_LOAD_CHUNK;
+      for(i = 0; i < chunk; i++)
+	{
+	  int key = loaded + i;
+	  unsigned hash = (unsigned) key * 2654435761u;
+
+	  // orders come in key order, dates grow with them over seven years
+	  TEST_CHECK(createRecord(&records[i], schema));
+	  MAKE_VALUE(value, DT_INT, key);
+	  TEST_CHECK(setAttr(records[i], schema, 0, value));
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_INT, (int) (hash % 150000));
+	  TEST_CHECK(setAttr(records[i], schema, 1, value));
+	  freeVal(value);
+	  MAKE_STRING_VALUE(value, statuses[(hash >> 3) % 7 == 0 ? 2 : (hash >> 5) % 2]);
+	  TEST_CHECK(setAttr(records[i], schema, 2, value));
+	  freeVal(value);
+	  MAKE_STRING_VALUE(value, priorities[(hash >> 7) % 5]);
+	  TEST_CHECK(setAttr(records[i], schema, 3, value));
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_INT, 8036 + (int) ((long long) key * 2555 / numRecords) + (int) ((hash >> 11) % 30));
+	  TEST_CHECK(setAttr(records[i], schema, 4, value));
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_INT, 1 + (int) ((hash >> 13) % 50));
+	  TEST_CHECK(setAttr(records[i], schema, 5, value));
+	  freeVal(value);
+	  MAKE_VALUE(value, DT_INT, 90000 + (int) ((hash >> 4) % 10000000));
+	  TEST_CHECK(setAttr(records[i], schema, 6, value));
+	  freeVal(value);
+	  MAKE_STRING_VALUE(value, modes[(hash >> 17) % 7]);
+	  TEST_CHECK(setAttr(records[i], schema, 7, value));
+	  freeVal(value);
+	}
+      for(t = 0; t < numTables; t++)
+	TEST_CHECK(bulkLoad(tables[t], records, chunk));
+      for(i = 0; i < chunk; i++)
+	freeRecord(records[i]);
+    }
+  free(records);
+}
+
+// a cold scan of benchArchive, with the bytes it had to read from the file
+static void
+timeArchivedScan (RM_TableData *table, char *name, char *what, long long fileSize)
+{
+  RM_ScanHandle sc;
+  Record *r;
+  struct timespec start;
+  double seconds;
+  long sum = 0;
+  int found, v;
+
+  TEST_CHECK(createRecord(&r, table->schema));
+  dropTableCache(name);
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  TEST_CHECK(startScan(table, &sc, NULL));
+  for(found = 0; next(&sc, r) == RC_OK; found++)
+    {
+      TEST_CHECK(getIntAttr(r, table->schema, 6, &v));
+      sum += v;
+    }
+  TEST_CHECK(closeScan(&sc));
+  seconds = elapsedSeconds(&start);
+  freeRecord(r);
+  printf("archive: %s, cold scan of %d records, sum %ld, %lld MB read in %.3fs (%.0f rows/s)\n",
+	 what, found, sum, fileSize >> 20, seconds, found / seconds);
+}
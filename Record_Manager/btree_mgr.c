@@ -0,0 +1,952 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "btree_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+#include "dberror.h"
+
+
+// frames of the buffer pool of an open tree.
+#define BTREE_POOL_PAGES 1024
+
+// deepest path a tree can have, far more than 2^32 keys need.
+#define BTREE_MAX_DEPTH 48
+
+// page 0 of an index file holds the tree information, every other page is a
+// node or a free page.
+#define BTREE_META_PAGE 0
+
+// a node starts with this header, then its keys, then (aligned to an int)
+// the RIDs of a leaf or the child pages of an inner node.
+typedef struct NodeHeader {
+	int isLeaf;	// 1 leaf, 0 inner node, -1 free page
+	int numKeys;
+	int next;	// right sibling of a leaf, next free page of a free page
+	int unused;
+} NodeHeader;
+
+// the tree information stored in page 0.
+typedef struct TreeMeta {
+	int keyType;
+	int keyLength;
+	int n;
+	int root;
+	int numNodes;
+	int numEntries;
+	int numPages;
+	int freePage;
+} TreeMeta;
+
+// bookkeeping of an open tree.
+typedef struct BTreeInfo {
+	BM_BufferPool *bm;
+	TreeMeta meta;
+	int keySize;		// bytes of a key in a node
+	int valuesOffset;	// offset of the RIDs or children in a node
+	char *key;		// the key being searched, inserted or deleted
+	char *sepKey;		// separator passed up by a split
+	char *scratchKeys;	// the n + 1 keys of a node being split
+	char *scratchValues;	// the n + 1 RIDs or n + 2 children of that node
+	int path[BTREE_MAX_DEPTH];	// pages from the root to the current leaf
+	int pathIndex[BTREE_MAX_DEPTH];	// child taken in every page of path
+} BTreeInfo;
+
+// position of a tree scan, its leaf stays pinned between calls.
+typedef struct TreeScan {
+	BM_PageHandle leaf;	// pageNum is -1 when the scan is done
+	int slot;
+	int hasHigh;
+	char *high;
+} TreeScan;
+
+static RC createTree(char *idxId, DataType keyType, int keyLength, int n);
+static int keySizeOf(DataType keyType, int keyLength);
+static int valuesOffsetOf(int keySize, int n);
+static RC serializeKey(BTreeInfo *info, DataType keyType, Value *key, char *result);
+static int compareKeys(BTreeInfo *info, char *left, char *right);
+static char *keyToString(BTreeInfo *info, DataType keyType, char *key);
+static char *pinNode(BTreeInfo *info, BM_PageHandle *h, int page);
+static void unpinNode(BTreeInfo *info, BM_PageHandle *h, int dirty);
+static char *nodeKey(BTreeInfo *info, char *node, int i);
+static RID *nodeRIDs(BTreeInfo *info, char *node);
+static int *nodeChildren(BTreeInfo *info, char *node);
+static int lowerBound(BTreeInfo *info, char *node, char *key);
+static int upperBound(BTreeInfo *info, char *node, char *key);
+static int descend(BTreeInfo *info, char *key);
+static int allocNode(BTreeInfo *info, BM_PageHandle *h, int isLeaf);
+static void freeNode(BTreeInfo *info, int page);
+static void insertIntoParent(BTreeInfo *info, int level, int right);
+static void rebalance(BTreeInfo *info, int level);
+static void writeMeta(BTreeInfo *info);
+
+
+// init and shutdown index manager
+RC initIndexManager (void *mgmtData) {
+	return RC_OK;
+}
+
+RC shutdownIndexManager () {
+	return RC_OK;
+}
+
+/**
+ * create an index of int, float or bool keys with at most n keys in a node.
+ * n = 0 takes as many keys as fit into a page.
+ * @param  idxId   name of the index file
+ * @param  keyType type of the keys
+ * @param  n       keys per node
+ * @return         RC_OK | RC_IM_N_TO_LAGE | RC_RM_UNKOWN_DATATYPE
+ */
+RC createBtree (char *idxId, DataType keyType, int n) {
+	if (keyType == DT_STRING) {
+		THROW(RC_RM_UNKOWN_DATATYPE, "string keys need a length, use createStringBtree");
+	}
+	return createTree(idxId, keyType, 0, n);
+}
+
+/**
+ * create an index of strings of up to keyLength characters, longer keys are
+ * cut to keyLength.
+ * @param  idxId     name of the index file
+ * @param  keyLength characters of a key
+ * @param  n         keys per node, 0 for as many as fit into a page
+ * @return           RC_OK | RC_IM_N_TO_LAGE
+ */
+RC createStringBtree (char *idxId, int keyLength, int n) {
+	return createTree(idxId, DT_STRING, keyLength, n);
+}
+
+/**
+ * open an index, its nodes are read and written through a buffer pool of
+ * BTREE_POOL_PAGES frames.
+ * @param  tree  the opened tree
+ * @param  idxId name of the index file
+ * @return       RC_OK | RC_FILE_NOT_FOUND
+ */
+RC openBtree (BTreeHandle **tree, char *idxId) {
+	BTreeInfo *info = (BTreeInfo *)malloc(sizeof(BTreeInfo));
+	BM_PageHandle h;
+	int valuesSize;
+
+	info->bm = MAKE_POOL();
+	if (initBufferPool(info->bm, idxId, BTREE_POOL_PAGES, RS_LRU, NULL) != RC_OK) {
+		free(info->bm);
+		free(info);
+		THROW(RC_FILE_NOT_FOUND, "index file does not exist");
+	}
+	pinPage(info->bm, &h, BTREE_META_PAGE);
+	memcpy(&info->meta, h.data, sizeof(TreeMeta));
+	unpinPage(info->bm, &h);
+
+	info->keySize = keySizeOf(info->meta.keyType, info->meta.keyLength);
+	info->valuesOffset = valuesOffsetOf(info->keySize, info->meta.n);
+	valuesSize = (info->meta.n + 2) * sizeof(RID);
+	info->key = (char *)malloc(info->keySize);
+	info->sepKey = (char *)malloc(info->keySize);
+	info->scratchKeys = (char *)malloc((info->meta.n + 1) * info->keySize);
+	info->scratchValues = (char *)malloc(valuesSize);
+
+	*tree = (BTreeHandle *)malloc(sizeof(BTreeHandle));
+	(*tree)->keyType = info->meta.keyType;
+	(*tree)->idxId = idxId;
+	(*tree)->mgmtData = info;
+	return RC_OK;
+}
+
+/**
+ * write the tree information and every changed node, then release the tree.
+ * @param  tree BTreeHandle
+ * @return      RC_OK | RC_CANNOT_SHUTDOWN if a scan is still open
+ */
+RC closeBtree (BTreeHandle *tree) {
+	BTreeInfo *info = (BTreeInfo *)tree->mgmtData;
+	RC rc;
+
+	writeMeta(info);
+	if ((rc = shutdownBufferPool(info->bm)) != RC_OK) {
+		return rc;
+	}
+	free(info->bm);
+	free(info->key);
+	free(info->sepKey);
+	free(info->scratchKeys);
+	free(info->scratchValues);
+	free(info);
+	free(tree);
+	return RC_OK;
+}
+
+RC deleteBtree (char *idxId) {
+	return destroyPageFile(idxId);
+}
+
+// access information about a b-tree
+RC getNumNodes (BTreeHandle *tree, int *result) {
+	*result = ((BTreeInfo *)tree->mgmtData)->meta.numNodes;
+	return RC_OK;
+}
+
+RC getNumEntries (BTreeHandle *tree, int *result) {
+	*result = ((BTreeInfo *)tree->mgmtData)->meta.numEntries;
+	return RC_OK;
+}
+
+RC getKeyType (BTreeHandle *tree, DataType *result) {
+	*result = tree->keyType;
+	return RC_OK;
+}
+
+/**
+ * find the RID of a key.
+ * @param  tree   BTreeHandle
+ * @param  key    the key
+ * @param  result its RID
+ * @return        RC_OK | RC_IM_KEY_NOT_FOUND
+ */
+RC findKey (BTreeHandle *tree, Value *key, RID *result) {
+	BTreeInfo *info = (BTreeInfo *)tree->mgmtData;
+	BM_PageHandle h;
+	char *node;
+	int depth, pos;
+	RC rc;
+
+	if ((rc = serializeKey(info, tree->keyType, key, info->key)) != RC_OK) {
+		return rc;
+	}
+	depth = descend(info, info->key);
+	node = pinNode(info, &h, info->path[depth]);
+	pos = lowerBound(info, node, info->key);
+	if (pos == ((NodeHeader *)node)->numKeys || compareKeys(info, nodeKey(info, node, pos), info->key) != 0) {
+		unpinNode(info, &h, 0);
+		return RC_IM_KEY_NOT_FOUND;
+	}
+	*result = nodeRIDs(info, node)[pos];
+	unpinNode(info, &h, 0);
+	return RC_OK;
+}
+
+/**
+ * insert a key. A full leaf is split in two and the first key of the right
+ * half is added to the parent, which is split the same way when it is full;
+ * a split of the root adds a new root.
+ * @param  tree BTreeHandle
+ * @param  key  the key
+ * @param  rid  its RID
+ * @return      RC_OK | RC_IM_KEY_ALREADY_EXISTS
+ */
+RC insertKey (BTreeHandle *tree, Value *key, RID rid) {
+	BTreeInfo *info = (BTreeInfo *)tree->mgmtData;
+	int n = info->meta.n;
+	BM_PageHandle h, rh;
+	char *node, *right;
+	RID *rids;
+	int depth, pos, numKeys, left, newPage;
+	RC rc;
+
+	if ((rc = serializeKey(info, tree->keyType, key, info->key)) != RC_OK) {
+		return rc;
+	}
+	depth = descend(info, info->key);
+	node = pinNode(info, &h, info->path[depth]);
+	numKeys = ((NodeHeader *)node)->numKeys;
+	rids = nodeRIDs(info, node);
+	pos = lowerBound(info, node, info->key);
+	if (pos < numKeys && compareKeys(info, nodeKey(info, node, pos), info->key) == 0) {
+		unpinNode(info, &h, 0);
+		return RC_IM_KEY_ALREADY_EXISTS;
+	}
+	info->meta.numEntries++;
+
+	if (numKeys < n) {
+		memmove(nodeKey(info, node, pos + 1), nodeKey(info, node, pos), (numKeys - pos) * info->keySize);
+		memmove(rids + pos + 1, rids + pos, (numKeys - pos) * sizeof(RID));
+		memcpy(nodeKey(info, node, pos), info->key, info->keySize);
+		rids[pos] = rid;
+		((NodeHeader *)node)->numKeys++;
+		unpinNode(info, &h, 1);
+		return RC_OK;
+	}
+
+	// the n + 1 entries are split, the left leaf keeps the larger half.
+	RID *scratch = (RID *)info->scratchValues;
+	memcpy(info->scratchKeys, nodeKey(info, node, 0), pos * info->keySize);
+	memcpy(info->scratchKeys + pos * info->keySize, info->key, info->keySize);
+	memcpy(info->scratchKeys + (pos + 1) * info->keySize, nodeKey(info, node, pos), (n - pos) * info->keySize);
+	memcpy(scratch, rids, pos * sizeof(RID));
+	scratch[pos] = rid;
+	memcpy(scratch + pos + 1, rids + pos, (n - pos) * sizeof(RID));
+	left = n + 1 - (n + 1) / 2;
+
+	newPage = allocNode(info, &rh, 1);
+	right = rh.data;
+	memcpy(nodeKey(info, node, 0), info->scratchKeys, left * info->keySize);
+	memcpy(rids, scratch, left * sizeof(RID));
+	((NodeHeader *)node)->numKeys = left;
+	memcpy(nodeKey(info, right, 0), info->scratchKeys + left * info->keySize, (n + 1 - left) * info->keySize);
+	memcpy(nodeRIDs(info, right), scratch + left, (n + 1 - left) * sizeof(RID));
+	((NodeHeader *)right)->numKeys = n + 1 - left;
+	((NodeHeader *)right)->next = ((NodeHeader *)node)->next;
+	((NodeHeader *)node)->next = newPage;
+
+	memcpy(info->sepKey, nodeKey(info, right, 0), info->keySize);
+	unpinNode(info, &rh, 1);
+	unpinNode(info, &h, 1);
+	insertIntoParent(info, depth - 1, newPage);
+	return RC_OK;
+}
+
+/**
+ * delete a key. A node left with less than half of its keys borrows one
+ * from a sibling with more than half, otherwise it is merged with the
+ * sibling and the separator is removed from the parent, which may in turn
+ * be left with too few keys. A root without keys is replaced by its child.
+ * @param  tree BTreeHandle
+ * @param  key  the key
+ * @return      RC_OK | RC_IM_KEY_NOT_FOUND
+ */
+RC deleteKey (BTreeHandle *tree, Value *key) {
+	BTreeInfo *info = (BTreeInfo *)tree->mgmtData;
+	BM_PageHandle h;
+	char *node;
+	RID *rids;
+	int depth, pos, numKeys;
+	RC rc;
+
+	if ((rc = serializeKey(info, tree->keyType, key, info->key)) != RC_OK) {
+		return rc;
+	}
+	depth = descend(info, info->key);
+	node = pinNode(info, &h, info->path[depth]);
+	numKeys = ((NodeHeader *)node)->numKeys;
+	pos = lowerBound(info, node, info->key);
+	if (pos == numKeys || compareKeys(info, nodeKey(info, node, pos), info->key) != 0) {
+		unpinNode(info, &h, 0);
+		return RC_IM_KEY_NOT_FOUND;
+	}
+
+	rids = nodeRIDs(info, node);
+	memmove(nodeKey(info, node, pos), nodeKey(info, node, pos + 1), (numKeys - pos - 1) * info->keySize);
+	memmove(rids + pos, rids + pos + 1, (numKeys - pos - 1) * sizeof(RID));
+	((NodeHeader *)node)->numKeys--;
+	info->meta.numEntries--;
+	unpinNode(info, &h, 1);
+
+	rebalance(info, depth);
+	return RC_OK;
+}
+
+/**
+ * scan every entry of the tree in key order.
+ * @param  tree   BTreeHandle
+ * @param  handle the scan
+ * @return        RC_OK
+ */
+RC openTreeScan (BTreeHandle *tree, BT_ScanHandle **handle) {
+	return openTreeRangeScan(tree, NULL, NULL, handle);
+}
+
+/**
+ * scan the entries with low <= key <= high in key order. The scan starts at
+ * the leaf of low and follows the links between leaves; NULL leaves that
+ * end of the range open.
+ * @param  tree   BTreeHandle
+ * @param  low    smallest key, NULL for the first key of the tree
+ * @param  high   largest key, NULL for the last key of the tree
+ * @param  handle the scan
+ * @return        RC_OK | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+RC openTreeRangeScan (BTreeHandle *tree, Value *low, Value *high, BT_ScanHandle **handle) {
+	BTreeInfo *info = (BTreeInfo *)tree->mgmtData;
+	TreeScan *scan = (TreeScan *)malloc(sizeof(TreeScan));
+	BM_PageHandle h;
+	char *node;
+	int page = info->meta.root;
+	RC rc;
+
+	scan->high = (char *)malloc(info->keySize);
+	scan->hasHigh = (high != NULL);
+	if ((high != NULL && (rc = serializeKey(info, tree->keyType, high, scan->high)) != RC_OK)
+			|| (low != NULL && (rc = serializeKey(info, tree->keyType, low, info->key)) != RC_OK)) {
+		free(scan->high);
+		free(scan);
+		return rc;
+	}
+
+	if (low != NULL) {
+		page = info->path[descend(info, info->key)];
+	}
+	else {
+		// the first leaf is reached through the first child of every node
+		node = pinNode(info, &h, page);
+		while (!((NodeHeader *)node)->isLeaf) {
+			page = nodeChildren(info, node)[0];
+			unpinNode(info, &h, 0);
+			node = pinNode(info, &h, page);
+		}
+		unpinNode(info, &h, 0);
+	}
+
+	node = pinNode(info, &scan->leaf, page);
+	scan->slot = (low != NULL) ? lowerBound(info, node, info->key) : 0;
+
+	*handle = (BT_ScanHandle *)malloc(sizeof(BT_ScanHandle));
+	(*handle)->tree = tree;
+	(*handle)->mgmtData = scan;
+	return RC_OK;
+}
+
+/**
+ * the RID of the next entry of a scan.
+ * @param  handle the scan
+ * @param  result the RID
+ * @return        RC_OK | RC_IM_NO_MORE_ENTRIES
+ */
+RC nextEntry (BT_ScanHandle *handle, RID *result) {
+	BTreeInfo *info = (BTreeInfo *)handle->tree->mgmtData;
+	TreeScan *scan = (TreeScan *)handle->mgmtData;
+	char *node;
+	int next;
+
+	while (scan->leaf.pageNum != NO_PAGE) {
+		node = scan->leaf.data;
+		if (scan->slot < ((NodeHeader *)node)->numKeys) {
+			if (scan->hasHigh && compareKeys(info, nodeKey(info, node, scan->slot), scan->high) > 0) {
+				break;
+			}
+			*result = nodeRIDs(info, node)[scan->slot++];
+			return RC_OK;
+		}
+
+		// the leaf is used up, go on with its right sibling
+		next = ((NodeHeader *)node)->next;
+		unpinNode(info, &scan->leaf, 0);
+		scan->leaf.pageNum = NO_PAGE;
+		if (next != NO_PAGE) {
+			pinNode(info, &scan->leaf, next);
+			scan->slot = 0;
+		}
+	}
+
+	if (scan->leaf.pageNum != NO_PAGE) {
+		unpinNode(info, &scan->leaf, 0);
+		scan->leaf.pageNum = NO_PAGE;
+	}
+	return RC_IM_NO_MORE_ENTRIES;
+}
+
+RC closeTreeScan (BT_ScanHandle *handle) {
+	TreeScan *scan = (TreeScan *)handle->mgmtData;
+
+	if (scan->leaf.pageNum != NO_PAGE) {
+		unpinNode((BTreeInfo *)handle->tree->mgmtData, &scan->leaf, 0);
+	}
+	free(scan->high);
+	free(scan);
+	free(handle);
+	return RC_OK;
+}
+
+/**
+ * the nodes of the tree in depth first order, an inner node as
+ * (page)[child,key,child,...,child], a leaf as
+ * (page)[rid.page.rid.slot,key,...,next leaf].
+ * @param  tree BTreeHandle
+ * @return      the string, freed by the caller
+ */
+char *printTree (BTreeHandle *tree) {
+	BTreeInfo *info = (BTreeInfo *)tree->mgmtData;
+	size_t capacity = 256, length = 0;
+	int top = 0, i;
+	char *result = (char *)malloc(capacity);
+	int *stack = (int *)malloc(sizeof(int) * (info->meta.numNodes + 1));
+	BM_PageHandle h;
+	char *node;
+
+	result[0] = '\0';
+	stack[top++] = info->meta.root;
+	while (top > 0) {
+		int page = stack[--top];
+		node = pinNode(info, &h, page);
+		NodeHeader *header = (NodeHeader *)node;
+
+		// children are pushed last to first so that the first is printed first
+		if (!header->isLeaf) {
+			for (i = header->numKeys; i >= 0; i--) {
+				stack[top++] = nodeChildren(info, node)[i];
+			}
+		}
+
+		for (i = 0; i <= header->numKeys; i++) {
+			char item[64];
+			char *keyString = NULL;
+
+			if (i < header->numKeys) {
+				keyString = keyToString(info, tree->keyType, nodeKey(info, node, i));
+			}
+			if (!header->isLeaf) {
+				snprintf(item, sizeof(item), "%d", nodeChildren(info, node)[i]);
+			}
+			else if (i < header->numKeys) {
+				snprintf(item, sizeof(item), "%d.%d", nodeRIDs(info, node)[i].page, nodeRIDs(info, node)[i].slot);
+			}
+			else {
+				snprintf(item, sizeof(item), "%d", header->next);
+			}
+
+			while (length + strlen(item) + (keyString ? strlen(keyString) : 0) + 32 > capacity) {
+				capacity *= 2;
+				result = (char *)realloc(result, capacity);
+			}
+			if (i == 0) {
+				length += sprintf(result + length, "(%d)[", page);
+			}
+			length += sprintf(result + length, "%s", item);
+			if (keyString != NULL) {
+				length += sprintf(result + length, ",%s,", keyString);
+				free(keyString);
+			}
+		}
+		length += sprintf(result + length, "]\n");
+		unpinNode(info, &h, 0);
+	}
+
+	free(stack);
+	return result;
+}
+
+/**
+ * create the index file: page 0 with the tree information and page 1 with
+ * an empty leaf, the root.
+ */
+static RC createTree(char *idxId, DataType keyType, int keyLength, int n) {
+	int keySize = keySizeOf(keyType, keyLength);
+	int maxN = (PAGE_SIZE - sizeof(NodeHeader) - sizeof(int)) / (keySize + sizeof(RID)) - 1;
+	BM_BufferPool *bm;
+	BM_PageHandle h;
+	NodeHeader *root;
+	TreeMeta meta;
+	RC rc;
+
+	if (n == 0) {
+		n = maxN;
+	}
+	if (n < 2 || n > maxN) {
+		THROW(RC_IM_N_TO_LAGE, "a node has to hold from 2 keys to as many as fit into a page");
+	}
+
+	if ((rc = createPageFile(idxId)) != RC_OK) {
+		return rc;
+	}
+	bm = MAKE_POOL();
+	initBufferPool(bm, idxId, 2, RS_FIFO, NULL);
+
+	meta.keyType = keyType;
+	meta.keyLength = keyLength;
+	meta.n = n;
+	meta.root = 1;
+	meta.numNodes = 1;
+	meta.numEntries = 0;
+	meta.numPages = 2;
+	meta.freePage = NO_PAGE;
+	pinPage(bm, &h, BTREE_META_PAGE);
+	memset(h.data, 0, PAGE_SIZE);
+	memcpy(h.data, &meta, sizeof(TreeMeta));
+	markDirty(bm, &h);
+	unpinPage(bm, &h);
+
+	pinPage(bm, &h, meta.root);
+	memset(h.data, 0, PAGE_SIZE);
+	root = (NodeHeader *)h.data;
+	root->isLeaf = 1;
+	root->numKeys = 0;
+	root->next = NO_PAGE;
+	markDirty(bm, &h);
+	unpinPage(bm, &h);
+
+	shutdownBufferPool(bm);
+	free(bm);
+	return RC_OK;
+}
+
+// bytes of a key: strings are stored without their terminating '\0'.
+static int keySizeOf(DataType keyType, int keyLength) {
+	return (keyType == DT_STRING) ? keyLength : (int)sizeof(int);
+}
+
+// RIDs and children start at the first int boundary after n keys.
+static int valuesOffsetOf(int keySize, int n) {
+	int offset = sizeof(NodeHeader) + n * keySize;
+	return (offset + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+}
+
+// a key in the form it is stored in a node, bools as ints and strings
+// padded with '\0' to keyLength.
+static RC serializeKey(BTreeInfo *info, DataType keyType, Value *key, char *result) {
+	int b;
+
+	if (key->dt != keyType) {
+		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "key has a different type than the index");
+	}
+	switch (keyType) {
+	case DT_INT:
+		memcpy(result, &key->v.intV, sizeof(int));
+		break;
+	case DT_FLOAT:
+		memcpy(result, &key->v.floatV, sizeof(float));
+		break;
+	case DT_BOOL:
+		b = key->v.boolV ? 1 : 0;
+		memcpy(result, &b, sizeof(int));
+		break;
+	case DT_STRING:
+		strncpy(result, key->v.stringV, info->meta.keyLength);
+		break;
+	}
+	return RC_OK;
+}
+
+// a stored key as serializeValue prints it.
+static char *keyToString(BTreeInfo *info, DataType keyType, char *key) {
+	Value value;
+	int i;
+
+	value.dt = keyType;
+	switch (keyType) {
+	case DT_INT:
+		memcpy(&value.v.intV, key, sizeof(int));
+		return serializeValue(&value);
+	case DT_FLOAT:
+		memcpy(&value.v.floatV, key, sizeof(float));
+		return serializeValue(&value);
+	case DT_BOOL:
+		memcpy(&i, key, sizeof(int));
+		value.v.boolV = (bool)i;
+		return serializeValue(&value);
+	default:
+		value.v.stringV = (char *)malloc(info->meta.keyLength + 1);
+		memcpy(value.v.stringV, key, info->meta.keyLength);
+		value.v.stringV[info->meta.keyLength] = '\0';
+		char *result = serializeValue(&value);
+		free(value.v.stringV);
+		return result;
+	}
+}
+
+static int compareKeys(BTreeInfo *info, char *left, char *right) {
+	int l, r;
+	float lf, rf;
+
+	switch (info->meta.keyType) {
+	case DT_FLOAT:
+		memcpy(&lf, left, sizeof(float));
+		memcpy(&rf, right, sizeof(float));
+		return (lf > rf) - (lf < rf);
+	case DT_STRING:
+		return strncmp(left, right, info->meta.keyLength);
+	default:
+		memcpy(&l, left, sizeof(int));
+		memcpy(&r, right, sizeof(int));
+		return (l > r) - (l < r);
+	}
+}
+
+static char *pinNode(BTreeInfo *info, BM_PageHandle *h, int page) {
+	pinPage(info->bm, h, page);
+	return h->data;
+}
+
+static void unpinNode(BTreeInfo *info, BM_PageHandle *h, int dirty) {
+	if (dirty) {
+		markDirty(info->bm, h);
+	}
+	unpinPage(info->bm, h);
+}
+
+static char *nodeKey(BTreeInfo *info, char *node, int i) {
+	return node + sizeof(NodeHeader) + i * info->keySize;
+}
+
+static RID *nodeRIDs(BTreeInfo *info, char *node) {
+	return (RID *)(node + info->valuesOffset);
+}
+
+static int *nodeChildren(BTreeInfo *info, char *node) {
+	return (int *)(node + info->valuesOffset);
+}
+
+// the first key of a node that is not smaller than key.
+static int lowerBound(BTreeInfo *info, char *node, char *key) {
+	int low = 0, high = ((NodeHeader *)node)->numKeys;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (compareKeys(info, nodeKey(info, node, mid), key) < 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+// the first key of a node that is larger than key, the child of an inner
+// node that holds key.
+static int upperBound(BTreeInfo *info, char *node, char *key) {
+	int low = 0, high = ((NodeHeader *)node)->numKeys;
+
+	while (low < high) {
+		int mid = (low + high) / 2;
+		if (compareKeys(info, nodeKey(info, node, mid), key) <= 0) {
+			low = mid + 1;
+		}
+		else {
+			high = mid;
+		}
+	}
+	return low;
+}
+
+/**
+ * follow key from the root to its leaf, the pages passed and the children
+ * taken are kept in info->path and info->pathIndex.
+ * @return the depth of the leaf, its page is info->path[depth]
+ */
+static int descend(BTreeInfo *info, char *key) {
+	BM_PageHandle h;
+	char *node;
+	int depth = 0, page = info->meta.root;
+
+	while (1) {
+		node = pinNode(info, &h, page);
+		info->path[depth] = page;
+		if (((NodeHeader *)node)->isLeaf) {
+			unpinNode(info, &h, 0);
+			return depth;
+		}
+		info->pathIndex[depth] = upperBound(info, node, key);
+		page = nodeChildren(info, node)[info->pathIndex[depth]];
+		unpinNode(info, &h, 0);
+		depth++;
+	}
+}
+
+// a new node, pinned, taken from the free pages or added to the file.
+static int allocNode(BTreeInfo *info, BM_PageHandle *h, int isLeaf) {
+	NodeHeader *header;
+	int page;
+
+	if (info->meta.freePage != NO_PAGE) {
+		page = info->meta.freePage;
+		pinNode(info, h, page);
+		info->meta.freePage = ((NodeHeader *)h->data)->next;
+	}
+	else {
+		page = info->meta.numPages++;
+		pinNode(info, h, page);
+	}
+	header = (NodeHeader *)h->data;
+	header->isLeaf = isLeaf;
+	header->numKeys = 0;
+	header->next = NO_PAGE;
+	info->meta.numNodes++;
+	return page;
+}
+
+// add a node that is no longer used to the free pages.
+static void freeNode(BTreeInfo *info, int page) {
+	BM_PageHandle h;
+	NodeHeader *header = (NodeHeader *)pinNode(info, &h, page);
+
+	header->isLeaf = -1;
+	header->numKeys = 0;
+	header->next = info->meta.freePage;
+	info->meta.freePage = page;
+	info->meta.numNodes--;
+	unpinNode(info, &h, 1);
+}
+
+/**
+ * add info->sepKey and the new node right after the child taken at level,
+ * splitting full inner nodes up to the root.
+ */
+static void insertIntoParent(BTreeInfo *info, int level, int right) {
+	int n = info->meta.n;
+	BM_PageHandle h, rh;
+	char *node, *newNode;
+	int *children, *scratch = (int *)info->scratchValues;
+	int pos, numKeys, mid, newPage;
+
+	for (; level >= 0; level--) {
+		node = pinNode(info, &h, info->path[level]);
+		numKeys = ((NodeHeader *)node)->numKeys;
+		children = nodeChildren(info, node);
+		pos = info->pathIndex[level];
+
+		if (numKeys < n) {
+			memmove(nodeKey(info, node, pos + 1), nodeKey(info, node, pos), (numKeys - pos) * info->keySize);
+			memmove(children + pos + 2, children + pos + 1, (numKeys - pos) * sizeof(int));
+			memcpy(nodeKey(info, node, pos), info->sepKey, info->keySize);
+			children[pos + 1] = right;
+			((NodeHeader *)node)->numKeys++;
+			unpinNode(info, &h, 1);
+			return;
+		}
+
+		// the middle of the n + 1 keys moves up, the halves around it stay
+		memcpy(info->scratchKeys, nodeKey(info, node, 0), pos * info->keySize);
+		memcpy(info->scratchKeys + pos * info->keySize, info->sepKey, info->keySize);
+		memcpy(info->scratchKeys + (pos + 1) * info->keySize, nodeKey(info, node, pos), (n - pos) * info->keySize);
+		memcpy(scratch, children, (pos + 1) * sizeof(int));
+		scratch[pos + 1] = right;
+		memcpy(scratch + pos + 2, children + pos + 1, (n - pos) * sizeof(int));
+		mid = (n + 1) / 2;
+
+		newPage = allocNode(info, &rh, 0);
+		newNode = rh.data;
+		memcpy(nodeKey(info, node, 0), info->scratchKeys, mid * info->keySize);
+		memcpy(children, scratch, (mid + 1) * sizeof(int));
+		((NodeHeader *)node)->numKeys = mid;
+		memcpy(nodeKey(info, newNode, 0), info->scratchKeys + (mid + 1) * info->keySize, (n - mid) * info->keySize);
+		memcpy(nodeChildren(info, newNode), scratch + mid + 1, (n - mid + 1) * sizeof(int));
+		((NodeHeader *)newNode)->numKeys = n - mid;
+		memcpy(info->sepKey, info->scratchKeys + mid * info->keySize, info->keySize);
+
+		unpinNode(info, &rh, 1);
+		unpinNode(info, &h, 1);
+		right = newPage;
+	}
+
+	// the root was split, the tree grows by a new root
+	newPage = allocNode(info, &rh, 0);
+	memcpy(nodeKey(info, rh.data, 0), info->sepKey, info->keySize);
+	nodeChildren(info, rh.data)[0] = info->meta.root;
+	nodeChildren(info, rh.data)[1] = right;
+	((NodeHeader *)rh.data)->numKeys = 1;
+	unpinNode(info, &rh, 1);
+	info->meta.root = newPage;
+}
+
+/**
+ * restore the minimum number of keys of the node at level after a delete,
+ * from the leaf up. Leaves keep (n + 1) / 2 keys, inner nodes n / 2.
+ */
+static void rebalance(BTreeInfo *info, int level) {
+	int n = info->meta.n;
+	BM_PageHandle h, ph, sh;
+	char *node, *parent, *sibling, *left, *right;
+	int isLeaf, minKeys, pos, sep, leftKeys, rightKeys;
+	int *parentChildren;
+
+	for (; level > 0; level--) {
+		node = pinNode(info, &h, info->path[level]);
+		isLeaf = ((NodeHeader *)node)->isLeaf;
+		minKeys = isLeaf ? (n + 1) / 2 : n / 2;
+		if (((NodeHeader *)node)->numKeys >= minKeys) {
+			unpinNode(info, &h, 0);
+			return;
+		}
+
+		// the sibling is the left one unless the node is the first child
+		parent = pinNode(info, &ph, info->path[level - 1]);
+		parentChildren = nodeChildren(info, parent);
+		pos = info->pathIndex[level - 1];
+		sep = (pos > 0) ? pos - 1 : 0;
+		sibling = pinNode(info, &sh, parentChildren[(pos > 0) ? pos - 1 : 1]);
+		left = (pos > 0) ? sibling : node;
+		right = (pos > 0) ? node : sibling;
+		leftKeys = ((NodeHeader *)left)->numKeys;
+		rightKeys = ((NodeHeader *)right)->numKeys;
+
+		if (((NodeHeader *)sibling)->numKeys > minKeys) {
+			// borrow one entry from the sibling through the separator
+			if (left == sibling) {
+				memmove(nodeKey(info, right, 1), nodeKey(info, right, 0), rightKeys * info->keySize);
+				if (isLeaf) {
+					memmove(nodeRIDs(info, right) + 1, nodeRIDs(info, right), rightKeys * sizeof(RID));
+					memcpy(nodeKey(info, right, 0), nodeKey(info, left, leftKeys - 1), info->keySize);
+					nodeRIDs(info, right)[0] = nodeRIDs(info, left)[leftKeys - 1];
+					memcpy(nodeKey(info, parent, sep), nodeKey(info, right, 0), info->keySize);
+				}
+				else {
+					memmove(nodeChildren(info, right) + 1, nodeChildren(info, right), (rightKeys + 1) * sizeof(int));
+					memcpy(nodeKey(info, right, 0), nodeKey(info, parent, sep), info->keySize);
+					nodeChildren(info, right)[0] = nodeChildren(info, left)[leftKeys];
+					memcpy(nodeKey(info, parent, sep), nodeKey(info, left, leftKeys - 1), info->keySize);
+				}
+				((NodeHeader *)left)->numKeys--;
+				((NodeHeader *)right)->numKeys++;
+			}
+			else {
+				if (isLeaf) {
+					memcpy(nodeKey(info, left, leftKeys), nodeKey(info, right, 0), info->keySize);
+					nodeRIDs(info, left)[leftKeys] = nodeRIDs(info, right)[0];
+					memmove(nodeRIDs(info, right), nodeRIDs(info, right) + 1, (rightKeys - 1) * sizeof(RID));
+					memmove(nodeKey(info, right, 0), nodeKey(info, right, 1), (rightKeys - 1) * info->keySize);
+					memcpy(nodeKey(info, parent, sep), nodeKey(info, right, 0), info->keySize);
+				}
+				else {
+					memcpy(nodeKey(info, left, leftKeys), nodeKey(info, parent, sep), info->keySize);
+					nodeChildren(info, left)[leftKeys + 1] = nodeChildren(info, right)[0];
+					memcpy(nodeKey(info, parent, sep), nodeKey(info, right, 0), info->keySize);
+					memmove(nodeChildren(info, right), nodeChildren(info, right) + 1, rightKeys * sizeof(int));
+					memmove(nodeKey(info, right, 0), nodeKey(info, right, 1), (rightKeys - 1) * info->keySize);
+				}
+				((NodeHeader *)left)->numKeys++;
+				((NodeHeader *)right)->numKeys--;
+			}
+			unpinNode(info, &sh, 1);
+			unpinNode(info, &ph, 1);
+			unpinNode(info, &h, 1);
+			return;
+		}
+
+		// merge the right node into the left one, an inner node takes the
+		// separator down with it
+		if (isLeaf) {
+			memcpy(nodeKey(info, left, leftKeys), nodeKey(info, right, 0), rightKeys * info->keySize);
+			memcpy(nodeRIDs(info, left) + leftKeys, nodeRIDs(info, right), rightKeys * sizeof(RID));
+			((NodeHeader *)left)->numKeys = leftKeys + rightKeys;
+			((NodeHeader *)left)->next = ((NodeHeader *)right)->next;
+		}
+		else {
+			memcpy(nodeKey(info, left, leftKeys), nodeKey(info, parent, sep), info->keySize);
+			memcpy(nodeKey(info, left, leftKeys + 1), nodeKey(info, right, 0), rightKeys * info->keySize);
+			memcpy(nodeChildren(info, left) + leftKeys + 1, nodeChildren(info, right), (rightKeys + 1) * sizeof(int));
+			((NodeHeader *)left)->numKeys = leftKeys + rightKeys + 1;
+		}
+		int rightPage = parentChildren[sep + 1];
+		int parentKeys = ((NodeHeader *)parent)->numKeys;
+		memmove(nodeKey(info, parent, sep), nodeKey(info, parent, sep + 1), (parentKeys - sep - 1) * info->keySize);
+		memmove(parentChildren + sep + 1, parentChildren + sep + 2, (parentKeys - sep - 1) * sizeof(int));
+		((NodeHeader *)parent)->numKeys--;
+
+		unpinNode(info, &sh, 1);
+		unpinNode(info, &ph, 1);
+		unpinNode(info, &h, 1);
+		freeNode(info, rightPage);
+	}
+
+	// a root without keys is replaced by its only child
+	node = pinNode(info, &h, info->meta.root);
+	if (!((NodeHeader *)node)->isLeaf && ((NodeHeader *)node)->numKeys == 0) {
+		int oldRoot = info->meta.root;
+		info->meta.root = nodeChildren(info, node)[0];
+		unpinNode(info, &h, 0);
+		freeNode(info, oldRoot);
+		return;
+	}
+	unpinNode(info, &h, 0);
+}
+
+// store the tree information in page 0.
+static void writeMeta(BTreeInfo *info) {
+	BM_PageHandle h;
+
+	pinPage(info->bm, &h, BTREE_META_PAGE);
+	memcpy(h.data, &info->meta, sizeof(TreeMeta));
+	markDirty(info->bm, &h);
+	unpinPage(info->bm, &h);
+}
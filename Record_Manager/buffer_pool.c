@@ -13,22 +13,37 @@
 
 
 
-// Init buffer storage.
+// Init buffer storage, NULL if the page file cannot be opened.
 Buffer_Storage *initBufferStorage(char *pageFileName, int capacity) {
-  SM_FileHandle *fh;
-  Queue *pool = createQueue(capacity);
   Buffer_Storage *bs;
   bs = (Buffer_Storage *)malloc(sizeof(Buffer_Storage));
-  bs->pool = pool;
-
-  //Init hash, it's important when tesing in server end.
-  int i;
-  for (i = 0; i < 65535; i++) {
-    bs->mapping[i] = NULL;
+  if (openPageFile(pageFileName, &bs->fh) != RC_OK) {
+    free(bs);
+    return NULL;
   }
+  bs->pool = createQueue(capacity);
+
+  // the mapping grows with the largest page number pinned.
+  bs->mappingSize = 64;
+  bs->mapping = (Page_Frame **)calloc(bs->mappingSize, sizeof(Page_Frame *));
   return bs;
 }
 
+// grow the mapping so that it has an entry for pageNum.
+void ensureMapping(Buffer_Storage *bs, int pageNum) {
+  int size = bs->mappingSize;
+
+  if (pageNum < size) {
+    return;
+  }
+  while (size <= pageNum) {
+    size *= 2;
+  }
+  bs->mapping = (Page_Frame **)realloc(bs->mapping, sizeof(Page_Frame *) * size);
+  memset(bs->mapping + bs->mappingSize, 0, sizeof(Page_Frame *) * (size - bs->mappingSize));
+  bs->mappingSize = size;
+}
+
 Queue *createQueue(int capacity) {
 
   // printf("queue size %d\n", capacity);
@@ -55,6 +70,7 @@ Page_Frame* newPageFrame( int pageNum , BM_PageHandle *page)
     temp->is_dirty = FALSE;
     temp->fix_count = 1;
     temp->lastUsed = 0;
+    temp->index = 0;
     return temp;
 }
 
@@ -70,59 +86,20 @@ int isPoolFull(BM_BufferPool *bm) {
   }
 }
 
-int ReplacementFIFO(Queue *queue, Page_Frame **mapping, Page_Frame *removed, Page_Frame *added){
-    // If all frames are full, remove the page at the rear
-    if (queue->count == queue->q_capacity){
-
-      int replaced;
-      enQueue(queue, added);
-      replaced = deQueue(queue);
-      int index = mapping[replaced]->index;
-      added->index = index;
-      return replaced;
-    }
-
-    else {
-      enQueue(queue, added);
-    }
-    return -1;
-}
-
-
-int ReplacementLRU(Queue *queue, Page_Frame **mapping, Page_Frame *removed, Page_Frame *added) {
-
-    if (queue->count >= queue->q_capacity){
-
-      int replaced;
-      enQueue(queue, added);
-      replaced = deQueue(queue);
-      int index = mapping[replaced]->index;
-      added->index = index;
-      return replaced;
-    }
-
-    else {
-      enQueue(queue, added);
-    }
-    return -1;
-
-}
-
-
+// append a frame at the rear of the queue, frames keep their index (the
+// frame slot reported by the statistics functions).
 int enQueue(Queue *queue, Page_Frame *added) {
 
+  added->next = NULL;
   if (queue->count == 0) {
     // printf("queue is empty\n");
+    added->prev = NULL;
     queue->rear = queue->front = added;
-    added->index = 0;
   }
   else {
     queue->rear->next = added;
     added->prev = queue->rear;
     queue->rear = added;
-    if (queue->count < queue->q_capacity){
-      added->index = queue->count;
-    }
   }
   queue->count++;
   return 1;
@@ -179,56 +156,36 @@ int isRear(Queue *queue, Page_Frame *pf) {
   return 0;
 }
 
+// unlink a frame from the queue, the frame itself is kept.
 void removeFromQueue(Queue *queue, Page_Frame *pf) {
   if (isFront(queue, pf)){
-    // printf("remove node from front, it's %d\n", pf->pageHandle->pageNum);
-
-    queue->front = queue->front->next;
+    queue->front = pf->next;
   }
-  else if (isRear(queue, pf)){
-    // printf("remove node from rear\n");
-    queue->rear = queue->rear->prev;
+  else {
+    pf->prev->next = pf->next;
+  }
+  if (isRear(queue, pf)){
+    queue->rear = pf->prev;
   }
   else {
-    // printf("removed node from middle\n");
-    Page_Frame *temp = pf;
-
-    temp->prev->next = pf->next;
-    temp->next->prev = pf->prev;
-
-    free(temp);
-
+    pf->next->prev = pf->prev;
   }
+  pf->prev = pf->next = NULL;
 }
 
-int deQueue( Queue *queue )
+// take the first frame that is not pinned out of the queue, NULL if every
+// frame is pinned (the buffer pool is busy).
+Page_Frame *deQueue( Queue *queue )
 {
-    int removed;
     // queue is empty.
     if(queue->count == 0)
-        return -1;
+        return NULL;
 
-    // if the none of elements in queue has fix_count=0,
-    // then buffer pool is busy, we can not replace elements.
     Page_Frame *removedPF;
     removedPF = checkRemoved(queue);
-    if (removedPF == NULL) {
-      printf("buffer is busy\n");
-      return RC_BUFFER_BUSY;
-    }
-    else {
-    // If this is the only node in list, then change front
-      if (queue->count == 1) {
-          removed = queue->rear->pageHandle->pageNum;
-          //empty a queue.
-          queue->front = NULL;
-          queue->rear = NULL;
-      }
-      else
-        removeFromQueue(queue, removedPF);
-      // free(temp);
+    if (removedPF != NULL) {
+      removeFromQueue(queue, removedPF);
       queue->count--;
-      return removedPF->pageHandle->pageNum;
-  }
-
+    }
+    return removedPF;
 }
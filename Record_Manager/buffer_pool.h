@@ -3,6 +3,7 @@
 
 #include <stdbool.h>
 #include "buffer_mgr.h"
+#include "storage_mgr.h"
 
 
 typedef struct Page_Frame {
@@ -35,23 +36,24 @@ typedef struct Hash
 
 
 typedef struct Buffer_Storage {
-	Page_Frame *mapping[65535];
+	Page_Frame **mapping;	// frame of every page number, NULL if not in the pool
+	int mappingSize;
 	Queue *pool;
+	SM_FileHandle fh;	// the page file, open until shutdownBufferPool
 } Buffer_Storage;
 
 
 Buffer_Storage *initBufferStorage(char *pageFileName, int capacity);
+void ensureMapping(Buffer_Storage *bs, int pageNum);
 Queue *createQueue(int capacity);
 Hash *createHash(int totalNumPages);
 Page_Frame* newPageFrame(int pageNum, BM_PageHandle *page);
 
 int enQueue(Queue *queue, Page_Frame *added);
-int deQueue(Queue *queue);
+Page_Frame *deQueue(Queue *queue);
 int isFront(Queue *queue, Page_Frame *pf);
 void removeFromQueue(Queue *queue, Page_Frame *pf);
 int printQueueElement(Queue *queue);
 int isPoolFull(BM_BufferPool *bm);
-int ReplacementFIFO(Queue *queue, Page_Frame **mapping, Page_Frame *removed, Page_Frame *added);
-int ReplacementLRU(Queue *queue, Page_Frame **mapping, Page_Frame *removed, Page_Frame *added);
 
 #endif
@@ -0,0 +1,635 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "column_codec.h"
+#include "hll.h"
+
+// values packed into a stream of bits, the first value in the lowest bits of
+// the first byte.
+typedef struct BitWriter {
+	unsigned char *out;
+	unsigned long long acc;
+	int avail;
+} BitWriter;
+
+typedef struct BitReader {
+	unsigned char *in;
+	unsigned long long acc;
+	int avail;
+} BitReader;
+
+static void writeBits(BitWriter *writer, unsigned int value, int bits) {
+	writer->acc |= (unsigned long long)value << writer->avail;
+	writer->avail += bits;
+	while (writer->avail >= 8) {
+		*writer->out++ = (unsigned char)writer->acc;
+		writer->acc >>= 8;
+		writer->avail -= 8;
+	}
+}
+
+static void flushBits(BitWriter *writer) {
+	if (writer->avail > 0) {
+		*writer->out++ = (unsigned char)writer->acc;
+	}
+	writer->acc = 0;
+	writer->avail = 0;
+}
+
+static unsigned int readBits(BitReader *reader, int bits) {
+	unsigned int value;
+
+	if (bits == 0) {
+		return 0;
+	}
+	while (reader->avail < bits) {
+		reader->acc |= (unsigned long long)*reader->in++ << reader->avail;
+		reader->avail += 8;
+	}
+	value = (unsigned int)(reader->acc & ((1ULL << bits) - 1));
+	reader->acc >>= bits;
+	reader->avail -= bits;
+	return value;
+}
+
+// bits needed to write every value up to max.
+static int bitWidth(unsigned int max) {
+	return (max == 0) ? 0 : 32 - __builtin_clz(max);
+}
+
+static long packedBytes(int numValues, int bits) {
+	return ((long)numValues * bits + 7) / 8;
+}
+
+// bytes of a column after its header.
+static long payloadBytes(ColumnEncoding encoding, int width, int numValues, int bits, int count) {
+	switch (encoding) {
+		case ENC_FOR:
+			return sizeof(int) + packedBytes(numValues, bits);
+		case ENC_RLE:
+			return (long)count * (width + sizeof(int));
+		case ENC_DICTIONARY:
+			return (long)count * width + packedBytes(numValues, bits);
+		case ENC_PLAIN:
+		default:
+			return (long)numValues * width;
+	}
+}
+
+static void initStats(ColumnStats *stats, DataType type, int width, int capacity) {
+	memset(stats, 0, sizeof(ColumnStats));
+	stats->last = (char *)malloc(width);
+	if (type == DT_STRING) {
+		int numSlots = 2;
+
+		while (numSlots < 2 * capacity) {
+			numSlots *= 2;
+		}
+		stats->values = (char *)malloc((size_t)capacity * width);
+		stats->hashSlots = (int *)calloc(numSlots, sizeof(int));
+		stats->mask = numSlots - 1;
+	}
+}
+
+static void clearStats(ColumnStats *stats) {
+	stats->numValues = 0;
+	stats->runs = 0;
+	stats->distinct = 0;
+	if (stats->hashSlots != NULL) {
+		memset(stats->hashSlots, 0, sizeof(int) * (stats->mask + 1));
+	}
+}
+
+static void freeStats(ColumnStats *stats) {
+	free(stats->last);
+	free(stats->values);
+	free(stats->hashSlots);
+}
+
+// the index of a string among the distinct values of a column, added if
+// add is set, -1 if it is not there.
+static int findValue(ColumnStats *stats, int width, char *value, int add) {
+	unsigned int slot = (unsigned int)hllHash(value, width) & stats->mask;
+
+	while (stats->hashSlots[slot] != 0) {
+		int index = stats->hashSlots[slot] - 1;
+
+		if (memcmp(stats->values + (size_t)index * width, value, width) == 0) {
+			return index;
+		}
+		slot = (slot + 1) & stats->mask;
+	}
+	if (!add) {
+		return -1;
+	}
+	memcpy(stats->values + (size_t)stats->distinct * width, value, width);
+	stats->hashSlots[slot] = ++stats->distinct;
+	return stats->distinct - 1;
+}
+
+static void statsAdd(ColumnStats *stats, DataType type, int width, char *value) {
+	if (stats->numValues == 0 || memcmp(stats->last, value, width) != 0) {
+		stats->runs++;
+		memcpy(stats->last, value, width);
+	}
+	if (type == DT_INT) {
+		int v;
+
+		memcpy(&v, value, sizeof(int));
+		if (stats->numValues == 0 || v < stats->min) {
+			stats->min = v;
+		}
+		if (stats->numValues == 0 || v > stats->max) {
+			stats->max = v;
+		}
+	}
+	else if (type == DT_STRING) {
+		findValue(stats, width, value, 1);
+	}
+	stats->numValues++;
+}
+
+// the smallest encoding of a column and its size with the header. FOR and
+// dictionaries win ties since they are evaluated without going through
+// runs, runs win them over plain values.
+static long columnBytes(DataType type, int width, ColumnStats *stats, ColumnEncoding *encoding, int *bits) {
+	int n = stats->numValues, w;
+	long best, bytes;
+
+	*encoding = ENC_PLAIN;
+	*bits = 0;
+	best = payloadBytes(ENC_PLAIN, width, n, 0, 0);
+	if (n == 0) {
+		return COLUMN_HEADER_SIZE + best;
+	}
+	if ((bytes = payloadBytes(ENC_RLE, width, n, 0, stats->runs)) <= best) {
+		*encoding = ENC_RLE;
+		best = bytes;
+	}
+	if (type == DT_INT) {
+		w = bitWidth((unsigned int)stats->max - (unsigned int)stats->min);
+		if ((bytes = payloadBytes(ENC_FOR, width, n, w, 0)) <= best) {
+			*encoding = ENC_FOR;
+			*bits = w;
+			best = bytes;
+		}
+	}
+	if (type == DT_STRING) {
+		w = bitWidth(stats->distinct - 1);
+		if ((bytes = payloadBytes(ENC_DICTIONARY, width, n, w, stats->distinct)) <= best) {
+			*encoding = ENC_DICTIONARY;
+			*bits = w;
+			best = bytes;
+		}
+	}
+	return COLUMN_HEADER_SIZE + best;
+}
+
+// sort the indices in order by the values they point to.
+static void sortValues(char *values, int width, int *order, int *scratch, int count) {
+	int half = count / 2, i = 0, j = half, k = 0;
+
+	if (count < 2) {
+		return;
+	}
+	sortValues(values, width, order, scratch, half);
+	sortValues(values, width, order + half, scratch, count - half);
+	while (i < half && j < count) {
+		if (memcmp(values + (size_t)order[j] * width, values + (size_t)order[i] * width, width) < 0) {
+			scratch[k++] = order[j++];
+		}
+		else {
+			scratch[k++] = order[i++];
+		}
+	}
+	while (i < half) {
+		scratch[k++] = order[i++];
+	}
+	while (j < count) {
+		scratch[k++] = order[j++];
+	}
+	memcpy(order, scratch, sizeof(int) * count);
+}
+
+// write a column of numValues values in the encoding columnBytes chose for
+// it.
+static void writeColumn(char *out, int width, char *column, int numValues, ColumnStats *stats,
+		ColumnEncoding encoding, int bits) {
+	char *payload = out + COLUMN_HEADER_SIZE;
+	BitWriter writer = { NULL, 0, 0 };
+	int count = 0, i, v;
+
+	switch (encoding) {
+		case ENC_PLAIN:
+			memcpy(payload, column, (size_t)numValues * width);
+			break;
+		case ENC_FOR:
+			memcpy(payload, &stats->min, sizeof(int));
+			writer.out = (unsigned char *)payload + sizeof(int);
+			for (i = 0; i < numValues; i++) {
+				memcpy(&v, column + (size_t)i * width, sizeof(int));
+				writeBits(&writer, (unsigned int)v - (unsigned int)stats->min, bits);
+			}
+			flushBits(&writer);
+			break;
+		case ENC_RLE: {
+			char *ends = payload + (size_t)stats->runs * width;
+
+			for (i = 0; i < numValues; i++) {
+				if (i > 0 && memcmp(column + (size_t)i * width, column + (size_t)(i - 1) * width, width) == 0) {
+					continue;
+				}
+				if (count > 0) {
+					memcpy(ends + (count - 1) * sizeof(int), &i, sizeof(int));
+				}
+				memcpy(payload + (size_t)count * width, column + (size_t)i * width, width);
+				count++;
+			}
+			memcpy(ends + (count - 1) * sizeof(int), &numValues, sizeof(int));
+			break;
+		}
+		case ENC_DICTIONARY: {
+			int *order = (int *)malloc(sizeof(int) * stats->distinct);
+			int *rank = (int *)malloc(sizeof(int) * stats->distinct);
+
+			count = stats->distinct;
+			for (i = 0; i < count; i++) {
+				order[i] = i;
+			}
+			sortValues(stats->values, width, order, rank, count);
+			for (i = 0; i < count; i++) {
+				memcpy(payload + (size_t)i * width, stats->values + (size_t)order[i] * width, width);
+				rank[order[i]] = i;
+			}
+			writer.out = (unsigned char *)payload + (size_t)count * width;
+			for (i = 0; i < numValues; i++) {
+				writeBits(&writer, rank[findValue(stats, width, column + (size_t)i * width, 0)], bits);
+			}
+			flushBits(&writer);
+			free(order);
+			free(rank);
+			break;
+		}
+	}
+
+	if (encoding == ENC_RLE) {
+		count = stats->runs;
+	}
+	out[0] = (char)encoding;
+	out[1] = (char)bits;
+	out[2] = out[3] = 0;
+	memcpy(out + 4, &count, sizeof(int));
+}
+
+/**
+ * create a sizer of a compressed page of a table, no slot is added.
+ * @param  schema   schema of the table.
+ * @param  capacity most slots a page holds.
+ * @return          the sizer.
+ */
+PageSizer *createPageSizer(Schema *schema, int capacity) {
+	PageSizer *sizer = (PageSizer *)malloc(sizeof(PageSizer));
+	int attr;
+
+	sizer->schema = schema;
+	sizer->capacity = capacity;
+	sizer->columns = (ColumnStats *)malloc(sizeof(ColumnStats) * (schema->numAttr > 0 ? schema->numAttr : 1));
+	for (attr = 0; attr < schema->numAttr; attr++) {
+		initStats(&sizer->columns[attr], schema->dataTypes[attr], schema->attrSizes[attr], capacity);
+	}
+	return sizer;
+}
+
+/**
+ * forget the slots added to a sizer, to size the next page.
+ * @param sizer the sizer.
+ */
+void resetPageSizer(PageSizer *sizer) {
+	int attr;
+
+	for (attr = 0; attr < sizer->schema->numAttr; attr++) {
+		clearStats(&sizer->columns[attr]);
+	}
+}
+
+/**
+ * add the record of the next slot to a sizer.
+ * @param  sizer the sizer.
+ * @param  data  the record.
+ * @return       bytes the columns of the slots added so far take encoded,
+ *               as encodeColumns writes them.
+ */
+int pageSizerAdd(PageSizer *sizer, char *data) {
+	Schema *schema = sizer->schema;
+	ColumnEncoding encoding;
+	long bytes = 0;
+	int attr, bits;
+
+	for (attr = 0; attr < schema->numAttr; attr++) {
+		statsAdd(&sizer->columns[attr], schema->dataTypes[attr], schema->attrSizes[attr],
+			data + schema->attrOffsets[attr]);
+		bytes += columnBytes(schema->dataTypes[attr], schema->attrSizes[attr], &sizer->columns[attr], &encoding,
+			&bits);
+	}
+	return (int)bytes;
+}
+
+void freePageSizer(PageSizer *sizer) {
+	int attr;
+
+	if (sizer == NULL) {
+		return;
+	}
+	for (attr = 0; attr < sizer->schema->numAttr; attr++) {
+		freeStats(&sizer->columns[attr]);
+	}
+	free(sizer->columns);
+	free(sizer);
+}
+
+/**
+ * encode the minipages of the first numSlots slots of a PAX page, every
+ * attribute in its smallest encoding: dictionaries for strings, frame of
+ * reference with bit packing for ints, runs or the plain values.
+ * @param  schema    schema of the table.
+ * @param  minipages the minipages.
+ * @param  capacity  values in every minipage.
+ * @param  numSlots  slots to encode.
+ * @param  out       receives the columns.
+ * @param  size      bytes out has.
+ * @return           bytes written, -1 if the columns do not fit.
+ */
+int encodeColumns(Schema *schema, char *minipages, int capacity, int numSlots, char *out, int size) {
+	ColumnStats stats;
+	ColumnEncoding encoding;
+	long offset = 0, bytes;
+	int attr, i, bits;
+
+	for (attr = 0; attr < schema->numAttr; attr++) {
+		DataType type = schema->dataTypes[attr];
+		int width = schema->attrSizes[attr];
+		char *column = minipages + (size_t)capacity * schema->attrOffsets[attr];
+
+		initStats(&stats, type, width, numSlots > 0 ? numSlots : 1);
+		for (i = 0; i < numSlots; i++) {
+			statsAdd(&stats, type, width, column + (size_t)i * width);
+		}
+		bytes = columnBytes(type, width, &stats, &encoding, &bits);
+		if (offset + bytes > size) {
+			freeStats(&stats);
+			return -1;
+		}
+		writeColumn(out + offset, width, column, numSlots, &stats, encoding, bits);
+		freeStats(&stats);
+		offset += bytes;
+	}
+	return (int)offset;
+}
+
+/**
+ * decode the columns written by encodeColumns into minipages.
+ * @param schema    schema of the table.
+ * @param in        the columns.
+ * @param numSlots  slots encoded.
+ * @param minipages receives the minipages.
+ * @param capacity  values in every minipage.
+ */
+void decodeColumns(Schema *schema, char *in, int numSlots, char *minipages, int capacity) {
+	int attr, i, j;
+
+	for (attr = 0; attr < schema->numAttr; attr++) {
+		int width = schema->attrSizes[attr];
+		char *column = minipages + (size_t)capacity * schema->attrOffsets[attr];
+		ColumnEncoding encoding = (ColumnEncoding)in[0];
+		int bits = in[1], count;
+		char *payload = in + COLUMN_HEADER_SIZE;
+		BitReader reader = { NULL, 0, 0 };
+
+		memcpy(&count, in + 4, sizeof(int));
+		switch (encoding) {
+			case ENC_PLAIN:
+				memcpy(column, payload, (size_t)numSlots * width);
+				break;
+			case ENC_FOR: {
+				int *values = (int *)column, base;
+
+				memcpy(&base, payload, sizeof(int));
+				reader.in = (unsigned char *)payload + sizeof(int);
+				for (i = 0; i < numSlots; i++) {
+					values[i] = (int)((unsigned int)base + readBits(&reader, bits));
+				}
+				break;
+			}
+			case ENC_RLE: {
+				char *ends = payload + (size_t)count * width;
+				int start = 0, end;
+
+				for (j = 0; j < count; j++, start = end) {
+					memcpy(&end, ends + j * sizeof(int), sizeof(int));
+					for (i = start; i < end; i++) {
+						memcpy(column + (size_t)i * width, payload + (size_t)j * width, width);
+					}
+				}
+				break;
+			}
+			case ENC_DICTIONARY:
+				reader.in = (unsigned char *)payload + (size_t)count * width;
+				for (i = 0; i < numSlots; i++) {
+					memcpy(column + (size_t)i * width, payload + (size_t)readBits(&reader, bits) * width, width);
+				}
+				break;
+		}
+		in += COLUMN_HEADER_SIZE + payloadBytes(encoding, width, numSlots, bits, count);
+	}
+}
+
+// a value of an int or string attribute against a bound of a range.
+static int compareBound(DataType type, int width, char *value, Value *bound) {
+	if (type == DT_INT) {
+		int v;
+
+		memcpy(&v, value, sizeof(int));
+		return (v < bound->v.intV) ? -1 : (v > bound->v.intV);
+	}
+	return strncmp(value, bound->v.stringV, width);
+}
+
+static int belowLow(DataType type, int width, char *value, ExprRange *range) {
+	int cmp;
+
+	if (!range->hasLow || range->low.dt != type) {
+		return 0;
+	}
+	cmp = compareBound(type, width, value, &range->low);
+	return cmp < 0 || (cmp == 0 && !range->lowInclusive);
+}
+
+static int aboveHigh(DataType type, int width, char *value, ExprRange *range) {
+	int cmp;
+
+	if (!range->hasHigh || range->high.dt != type) {
+		return 0;
+	}
+	cmp = compareBound(type, width, value, &range->high);
+	return cmp > 0 || (cmp == 0 && !range->highInclusive);
+}
+
+// drop the slots whose codes, read from a bit stream, are outside [low, high].
+static void selectCodes(unsigned char *packed, int bits, int numSlots, long long low, long long high,
+		unsigned char *selection) {
+	BitReader reader = { packed, 0, 0 };
+	int i;
+
+	for (i = 0; i < numSlots; i++) {
+		long long code = readBits(&reader, bits);
+
+		if (code < low || code > high) {
+			selection[i / 8] &= ~(1 << (i % 8));
+		}
+	}
+}
+
+// drop the slots of a column outside the range of its attribute, looking at
+// the encoded values: a FOR column compares the offsets of its values to the
+// range moved by its base, a dictionary compares the codes to the codes of
+// the entries inside the range, runs are compared once.
+static void selectColumn(char *in, DataType type, int width, int numSlots, ExprRange *range,
+		unsigned char *selection) {
+	ColumnEncoding encoding = (ColumnEncoding)in[0];
+	int bits = in[1], count, i, j;
+	char *payload = in + COLUMN_HEADER_SIZE;
+
+	memcpy(&count, in + 4, sizeof(int));
+	switch (encoding) {
+		case ENC_PLAIN:
+			for (i = 0; i < numSlots; i++) {
+				char *value = payload + (size_t)i * width;
+
+				if (belowLow(type, width, value, range) || aboveHigh(type, width, value, range)) {
+					selection[i / 8] &= ~(1 << (i % 8));
+				}
+			}
+			break;
+		case ENC_RLE: {
+			char *ends = payload + (size_t)count * width;
+			int start = 0, end;
+
+			for (j = 0; j < count; j++, start = end) {
+				char *value = payload + (size_t)j * width;
+
+				memcpy(&end, ends + j * sizeof(int), sizeof(int));
+				if (belowLow(type, width, value, range) || aboveHigh(type, width, value, range)) {
+					for (i = start; i < end; i++) {
+						selection[i / 8] &= ~(1 << (i % 8));
+					}
+				}
+			}
+			break;
+		}
+		case ENC_FOR: {
+			long long low = 0, high = (1LL << bits) - 1;
+			int base;
+
+			memcpy(&base, payload, sizeof(int));
+			if (range->hasLow && range->low.dt == DT_INT) {
+				long long bound = (long long)range->low.v.intV + (range->lowInclusive ? 0 : 1) - base;
+				low = (bound > low) ? bound : low;
+			}
+			if (range->hasHigh && range->high.dt == DT_INT) {
+				long long bound = (long long)range->high.v.intV - (range->highInclusive ? 0 : 1) - base;
+				high = (bound < high) ? bound : high;
+			}
+			if (low > 0 || high < (1LL << bits) - 1) {
+				selectCodes((unsigned char *)payload + sizeof(int), bits, numSlots, low, high, selection);
+			}
+			break;
+		}
+		case ENC_DICTIONARY: {
+			int low = 0, high = count, first, middle;
+
+			// the entries are in order, those inside the range are a run of codes
+			while (low < high) {
+				middle = (low + high) / 2;
+				if (belowLow(type, width, payload + (size_t)middle * width, range)) {
+					low = middle + 1;
+				}
+				else {
+					high = middle;
+				}
+			}
+			for (first = low, high = count; low < high; ) {
+				middle = (low + high) / 2;
+				if (aboveHigh(type, width, payload + (size_t)middle * width, range)) {
+					high = middle;
+				}
+				else {
+					low = middle + 1;
+				}
+			}
+			if (first > 0 || high < count) {
+				selectCodes((unsigned char *)payload + (size_t)count * width, bits, numSlots, first, high - 1,
+					selection);
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * find the slots of a compressed page that may be inside the ranges of
+ * their int and string attributes, without decoding the page.
+ * @param  schema    schema of the table.
+ * @param  in        the columns written by encodeColumns.
+ * @param  numSlots  slots encoded.
+ * @param  ranges    a range for every attribute, ignored where it has no
+ *                   bounds or bounds of another datatype.
+ * @param  selection receives the bitmap of the slots left.
+ * @return           number of slots left.
+ */
+int selectEncoded(Schema *schema, char *in, int numSlots, ExprRange *ranges, unsigned char *selection) {
+	int numBytes = (numSlots + 7) / 8;
+	int attr, i, count = 0;
+
+	memset(selection, 0xFF, numBytes);
+	if (numSlots % 8 != 0) {
+		selection[numBytes - 1] = (1 << (numSlots % 8)) - 1;
+	}
+
+	for (attr = 0; attr < schema->numAttr; attr++) {
+		DataType type = schema->dataTypes[attr];
+		int width = schema->attrSizes[attr], entries;
+		ExprRange *range = &ranges[attr];
+
+		memcpy(&entries, in + 4, sizeof(int));
+		if (range->empty) {
+			memset(selection, 0, numBytes);
+		}
+		else if ((range->hasLow || range->hasHigh) && (type == DT_INT || type == DT_STRING)) {
+			selectColumn(in, type, width, numSlots, range, selection);
+		}
+		in += COLUMN_HEADER_SIZE + payloadBytes((ColumnEncoding)in[0], width, numSlots, in[1], entries);
+	}
+
+	for (i = 0; i < numBytes; i++) {
+		count += __builtin_popcount(selection[i]);
+	}
+	return count;
+}
+
+/**
+ * the encoding of an attribute on a compressed page.
+ * @param  schema   schema of the table.
+ * @param  in       the columns written by encodeColumns.
+ * @param  numSlots slots encoded.
+ * @param  attr     the attribute.
+ * @return          its encoding.
+ */
+ColumnEncoding columnEncoding(Schema *schema, char *in, int numSlots, int attr) {
+	int i, count;
+
+	for (i = 0; i < attr; i++) {
+		memcpy(&count, in + 4, sizeof(int));
+		in += COLUMN_HEADER_SIZE + payloadBytes((ColumnEncoding)in[0], schema->attrSizes[i], numSlots, in[1], count);
+	}
+	return (ColumnEncoding)in[0];
+}
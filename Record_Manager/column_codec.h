@@ -0,0 +1,51 @@
+#ifndef __COLUMN_CODEC_H__
+#define __COLUMN_CODEC_H__
+
+#include "dberror.h"
+#include "expr.h"
+#include "tables.h"
+
+// how the values of an attribute are stored on a compressed page. Every
+// column starts with a header of COLUMN_HEADER_SIZE bytes: its encoding,
+// its bit width and its number of runs or dictionary entries.
+typedef enum ColumnEncoding {
+	ENC_PLAIN = 0,		// the values as they are in the minipage
+	ENC_FOR = 1,		// ints: the smallest value, then every value minus it in bits bits
+	ENC_RLE = 2,		// runs of equal values: their values, then the slot after every run
+	ENC_DICTIONARY = 3	// strings: the distinct values in order, then the code of every value in bits bits
+} ColumnEncoding;
+
+#define COLUMN_HEADER_SIZE 8
+
+// what the values of an attribute added so far look like, enough to know
+// the size of every encoding of them.
+typedef struct ColumnStats {
+	int numValues;
+	int min;		// ints
+	int max;
+	int runs;
+	int distinct;		// strings
+	char *last;		// the value added last
+	char *values;		// the distinct strings in the order they came
+	int *hashSlots;		// index + 1 into values, 0 for a free slot
+	int mask;
+} ColumnStats;
+
+// the size a compressed page of the slots added to it would take, kept as
+// the slots are added in order.
+typedef struct PageSizer {
+	Schema *schema;
+	int capacity;
+	ColumnStats *columns;
+} PageSizer;
+
+
+PageSizer *createPageSizer(Schema *schema, int capacity);
+void resetPageSizer(PageSizer *sizer);
+int pageSizerAdd(PageSizer *sizer, char *data);
+void freePageSizer(PageSizer *sizer);
+int encodeColumns(Schema *schema, char *minipages, int capacity, int numSlots, char *out, int size);
+void decodeColumns(Schema *schema, char *in, int numSlots, char *minipages, int capacity);
+int selectEncoded(Schema *schema, char *in, int numSlots, ExprRange *ranges, unsigned char *selection);
+ColumnEncoding columnEncoding(Schema *schema, char *in, int numSlots, int attr);
+#endif
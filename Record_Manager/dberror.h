@@ -23,11 +23,18 @@ typedef int RC;
 #define RC_RM_NO_MORE_TUPLES 203
 #define RC_RM_NO_PRINT_FOR_DATATYPE 204
 #define RC_RM_UNKOWN_DATATYPE 205
+#define RC_RM_ATTR_WRONG_DATATYPE 206
+#define RC_RM_NO_SUCH_ATTR 207
+#define RC_RM_NO_STATS 208
+#define RC_RM_INVALID_LIMIT 209
+#define RC_RM_PAGE_FULL 210
+#define RC_RM_VALUE_OUT_OF_RANGE 211
 
 #define RC_IM_KEY_NOT_FOUND 300
 #define RC_IM_KEY_ALREADY_EXISTS 301
 #define RC_IM_N_TO_LAGE 302
 #define RC_IM_NO_MORE_ENTRIES 303
+#define RC_IM_COMPOSITE_KEY 304
 
 
 #define RC_BUFFER_BUSY 401
@@ -1,11 +1,25 @@
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #include "dberror.h"
 #include "record_mgr.h"
 #include "expr.h"
 #include "tables.h"
 
+// return the error of a failed step to the caller
+#define CHECK_RETURN(code)			\
+  do {						\
+    RC rc_return = (code);			\
+    if (rc_return != RC_OK)			\
+      return rc_return;			\
+  } while (0)
+
 // implementations
 RC 
 valueEquals (Value *left, Value *right, Value *result)
@@ -50,6 +64,7 @@ valueSmaller (Value *left, Value *right, Value *result)
     break;
   case DT_BOOL:
     result->v.boolV = (left->v.boolV < right->v.boolV);
+    break;
   case DT_STRING:
     result->v.boolV = (strcmp(left->v.stringV, right->v.stringV) < 0);
     break;
@@ -58,6 +73,114 @@ valueSmaller (Value *left, Value *right, Value *result)
   return RC_OK;
 }
 
+// order two values of the same datatype, *cmp is negative, zero or
+// positive like strcmp. Booleans order false before true.
+static RC
+compareValues (Value *left, Value *right, int *cmp)
+{
+  if(left->dt != right->dt)
+    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+
+  switch(left->dt) {
+  case DT_INT:
+    *cmp = (left->v.intV > right->v.intV) - (left->v.intV < right->v.intV);
+    break;
+  case DT_FLOAT:
+    *cmp = (left->v.floatV > right->v.floatV) - (left->v.floatV < right->v.floatV);
+    break;
+  case DT_BOOL:
+    *cmp = (left->v.boolV != 0) - (right->v.boolV != 0);
+    break;
+  case DT_STRING:
+    *cmp = strcmp(left->v.stringV, right->v.stringV);
+    break;
+  }
+
+  return RC_OK;
+}
+
+RC
+valueGreater (Value *left, Value *right, Value *result)
+{
+  int cmp;
+
+  CHECK_RETURN(compareValues(left, right, &cmp));
+  result->dt = DT_BOOL;
+  result->v.boolV = (cmp > 0);
+
+  return RC_OK;
+}
+
+RC
+valueSmallerOrEqual (Value *left, Value *right, Value *result)
+{
+  int cmp;
+
+  CHECK_RETURN(compareValues(left, right, &cmp));
+  result->dt = DT_BOOL;
+  result->v.boolV = (cmp <= 0);
+
+  return RC_OK;
+}
+
+RC
+valueGreaterOrEqual (Value *left, Value *right, Value *result)
+{
+  int cmp;
+
+  CHECK_RETURN(compareValues(left, right, &cmp));
+  result->dt = DT_BOOL;
+  result->v.boolV = (cmp >= 0);
+
+  return RC_OK;
+}
+
+// low <= input <= high
+RC
+valueBetween (Value *input, Value *low, Value *high, Value *result)
+{
+  int cmpLow, cmpHigh;
+
+  CHECK_RETURN(compareValues(input, low, &cmpLow));
+  CHECK_RETURN(compareValues(input, high, &cmpHigh));
+  result->dt = DT_BOOL;
+  result->v.boolV = (cmpLow >= 0 && cmpHigh <= 0);
+
+  return RC_OK;
+}
+
+RC
+valueIn (Value *input, ValueSet *set, Value *result)
+{
+  if (set == NULL || (set->numValues > 0 && set->dt != input->dt))
+    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "IN requires a set of values of the same datatype");
+  result->dt = DT_BOOL;
+  result->v.boolV = valueSetContains(set, input);
+
+  return RC_OK;
+}
+
+static int
+hasPrefix (char *string, char *prefix)
+{
+  while (*prefix)
+    if (*string++ != *prefix++)
+      return 0;
+  return 1;
+}
+
+// input LIKE 'prefix%'
+RC
+valueHasPrefix (Value *input, Value *prefix, Value *result)
+{
+  if (input->dt != DT_STRING || prefix->dt != DT_STRING)
+    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "prefix match requires strings");
+  result->dt = DT_BOOL;
+  result->v.boolV = hasPrefix(input->v.stringV, prefix->v.stringV);
+
+  return RC_OK;
+}
+
 RC 
 boolNot (Value *input, Value *result)
 {
@@ -74,6 +197,7 @@ boolAnd (Value *left, Value *right, Value *result)
 {
   if (left->dt != DT_BOOL || right->dt != DT_BOOL)
     THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean AND requires boolean inputs");
+  result->dt = DT_BOOL;
   result->v.boolV = (left->v.boolV && right->v.boolV);
 
   return RC_OK;
@@ -84,6 +208,7 @@ boolOr (Value *left, Value *right, Value *result)
 {
   if (left->dt != DT_BOOL || right->dt != DT_BOOL)
     THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean OR requires boolean inputs");
+  result->dt = DT_BOOL;
   result->v.boolV = (left->v.boolV || right->v.boolV);
 
   return RC_OK;
@@ -92,81 +217,1370 @@ boolOr (Value *left, Value *right, Value *result)
 RC
 evalExpr (Record *record, Schema *schema, Expr *expr, Value **result)
 {
-  Value *lIn;
-  Value *rIn;
-  MAKE_VALUE(*result, DT_INT, -1);
+  Value value;
+  Value *in = &value;
+
+  CHECK(evalExprInto(record, schema, expr, &value));
+
+  *result = (Value *) malloc(sizeof(Value));
+  CPVAL(*result, in);
+
+  return RC_OK;
+}
+
+// number of arguments of an operator
+static int
+numArgs (OpType type)
+{
+  switch(type)
+    {
+    case OP_BOOL_NOT:
+    case OP_IN:
+      return 1;
+    case OP_BETWEEN:
+      return 3;
+    default:
+      return 2;
+    }
+}
+
+// evaluate into a Value owned by the caller without allocating. A string
+// result points into the record or into a constant of the expression.
+RC
+evalExprInto (Record *record, Schema *schema, Expr *expr, Value *result)
+{
+  Value lIn;
+  Value rIn;
+  Value hIn;
+
+  result->dt = DT_INT;
+  result->v.intV = -1;
 
   switch(expr->type)
     {
     case EXPR_OP:
       {
       Operator *op = expr->expr.op;
-      bool twoArgs = (op->type != OP_BOOL_NOT);
-      //      lIn = (Value *) malloc(sizeof(Value));
-      //    rIn = (Value *) malloc(sizeof(Value));
-      
-      CHECK(evalExpr(record, schema, op->args[0], &lIn));
-      if (twoArgs)
-	CHECK(evalExpr(record, schema, op->args[1], &rIn));
+      int args = numArgs(op->type);
+
+      CHECK(evalExprInto(record, schema, op->args[0], &lIn));
+      // AND and OR do not evaluate their right side once the left decides
+      if ((op->type == OP_BOOL_AND || op->type == OP_BOOL_OR) && lIn.dt == DT_BOOL
+	  && (lIn.v.boolV != 0) == (op->type == OP_BOOL_OR))
+	{
+	  result->dt = DT_BOOL;
+	  result->v.boolV = (op->type == OP_BOOL_OR);
+	  return RC_OK;
+	}
+      if (args > 1)
+	CHECK(evalExprInto(record, schema, op->args[1], &rIn));
+      if (args > 2)
+	CHECK(evalExprInto(record, schema, op->args[2], &hIn));
 
       switch(op->type) 
 	{
 	case OP_BOOL_NOT:
-	  CHECK(boolNot(lIn, *result));
+	  CHECK(boolNot(&lIn, result));
 	  break;
 	case OP_BOOL_AND:
-	  CHECK(boolAnd(lIn, rIn, *result));
+	  CHECK(boolAnd(&lIn, &rIn, result));
 	  break;
 	case OP_BOOL_OR:
-	  CHECK(boolOr(lIn, rIn, *result));
+	  CHECK(boolOr(&lIn, &rIn, result));
 	  break;
 	case OP_COMP_EQUAL:
-	  CHECK(valueEquals(lIn, rIn, *result));
+	  CHECK(valueEquals(&lIn, &rIn, result));
 	  break;
 	case OP_COMP_SMALLER:
-	  CHECK(valueSmaller(lIn, rIn, *result));
+	  CHECK(valueSmaller(&lIn, &rIn, result));
 	  break;
-	default:
+	case OP_COMP_GREATER:
+	  CHECK(valueGreater(&lIn, &rIn, result));
+	  break;
+	case OP_COMP_LE:
+	  CHECK(valueSmallerOrEqual(&lIn, &rIn, result));
+	  break;
+	case OP_COMP_GE:
+	  CHECK(valueGreaterOrEqual(&lIn, &rIn, result));
+	  break;
+	case OP_BETWEEN:
+	  CHECK(valueBetween(&lIn, &rIn, &hIn, result));
+	  break;
+	case OP_IN:
+	  CHECK(valueIn(&lIn, op->set, result));
+	  break;
+	case OP_LIKE_PREFIX:
+	  CHECK(valueHasPrefix(&lIn, &rIn, result));
 	  break;
 	}
-
-      // cleanup
-      freeVal(lIn);
-      if (twoArgs)
-	freeVal(rIn);
       }
       break;
     case EXPR_CONST:
-      CPVAL(*result,expr->expr.cons);
+      *result = *(expr->expr.cons);
       break;
     case EXPR_ATTRREF:
-      free(*result);
-      CHECK(getAttr(record, schema, expr->expr.attrRef, result));
+      CHECK(getAttrInto(record, schema, expr->expr.attrRef, result));
       break;
     }
 
   return RC_OK;
 }
 
-RC
-freeExpr (Expr *expr)
+// count the registers of an expression, every node gets one and BETWEEN
+// two more for its comparisons.
+static int
+countNodes (Expr *expr)
 {
-  switch(expr->type) 
+  Operator *op;
+  int i, count;
+
+  if (expr->type != EXPR_OP)
+    return 1;
+  op = expr->expr.op;
+  count = (op->type == OP_BETWEEN) ? 3 : 1;
+  for(i = 0; i < numArgs(op->type); i++)
+    count += countNodes(op->args[i]);
+  return count;
+}
+
+static void
+emit (ExprProgram *program, ExprOpCode op, int dst, int left, int right)
+{
+  ExprInstr *instr = &program->instrs[program->numInstrs++];
+  instr->op = op;
+  instr->dst = dst;
+  instr->left = left;
+  instr->right = right;
+}
+
+// emit a comparison of two registers of datatype dt. a > b is compiled as
+// b < a and a >= b as b <= a, bools compare as ints.
+static void
+emitCompare (ExprProgram *program, OpType type, DataType dt, int dst, int left, int right)
+{
+  ExprOpCode op;
+
+  if (type == OP_COMP_GREATER || type == OP_COMP_GE)
+    {
+      int tmp = left;
+      left = right;
+      right = tmp;
+      type = (type == OP_COMP_GREATER) ? OP_COMP_SMALLER : OP_COMP_LE;
+    }
+
+  op = (type == OP_COMP_EQUAL) ? BC_EQUAL_INT
+    : (type == OP_COMP_SMALLER) ? BC_SMALLER_INT : BC_SMALLER_EQUAL_INT;
+  // the int, float and string variants of an opcode are consecutive
+  if (dt == DT_FLOAT)
+    op += 1;
+  else if (dt == DT_STRING)
+    op += 2;
+  emit(program, op, dst, left, right);
+}
+
+// compile a node into the register *reg, its datatype is returned in *dt.
+static RC
+compileNode (Expr *expr, Schema *schema, ExprProgram *program, int *reg, DataType *dt)
+{
+  int r = program->numRegs++;
+  *reg = r;
+
+  switch(expr->type)
     {
+    case EXPR_CONST:
+      {
+      Value *cons = expr->expr.cons;
+      *dt = cons->dt;
+      switch(cons->dt)
+	{
+	case DT_INT:
+	  program->regs[r].intV = cons->v.intV;
+	  break;
+	case DT_FLOAT:
+	  program->regs[r].floatV = cons->v.floatV;
+	  break;
+	case DT_BOOL:
+	  program->regs[r].intV = (cons->v.boolV != 0);
+	  break;
+	case DT_STRING:
+	  program->regs[r].stringV = cons->v.stringV;
+	  break;
+	}
+      }
+      break;
+    case EXPR_ATTRREF:
+      {
+      int attr = expr->expr.attrRef;
+      int offset = schema->attrOffsets[attr];
+      *dt = schema->dataTypes[attr];
+      switch(*dt)
+	{
+	case DT_INT:
+	  emit(program, BC_LOAD_INT, r, offset, schema->attrSizes[attr]);
+	  break;
+	case DT_FLOAT:
+	  emit(program, BC_LOAD_FLOAT, r, offset, schema->attrSizes[attr]);
+	  break;
+	case DT_BOOL:
+	  emit(program, BC_LOAD_BOOL, r, offset, schema->attrSizes[attr]);
+	  break;
+	case DT_STRING:
+	  emit(program, BC_LOAD_STRING, r, offset, schema->attrSizes[attr]);
+	  break;
+	}
+      }
+      break;
     case EXPR_OP:
       {
       Operator *op = expr->expr.op;
-      switch(op->type) 
+      int args = numArgs(op->type);
+      int lReg, rReg = 0, hReg = 0, jump = -1;
+      DataType lDt, rDt = DT_BOOL, hDt = DT_BOOL;
+
+      CHECK_RETURN(compileNode(op->args[0], schema, program, &lReg, &lDt));
+      // AND and OR jump over their right side once the left decides
+      if (op->type == OP_BOOL_AND || op->type == OP_BOOL_OR)
+	{
+	  jump = program->numInstrs;
+	  emit(program, (op->type == OP_BOOL_AND) ? BC_JUMP_FALSE : BC_JUMP_TRUE, r, lReg, 0);
+	}
+      if (args > 1)
+	CHECK_RETURN(compileNode(op->args[1], schema, program, &rReg, &rDt));
+      if (args > 2)
+	CHECK_RETURN(compileNode(op->args[2], schema, program, &hReg, &hDt));
+
+      *dt = DT_BOOL;
+      switch(op->type)
 	{
 	case OP_BOOL_NOT:
-	  freeExpr(op->args[0]);
+	case OP_BOOL_AND:
+	case OP_BOOL_OR:
+	  if (lDt != DT_BOOL || rDt != DT_BOOL)
+	    THROW(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, "boolean operators require boolean inputs");
+	  emit(program, (op->type == OP_BOOL_NOT) ? BC_NOT : (op->type == OP_BOOL_AND) ? BC_AND : BC_OR,
+	       r, lReg, rReg);
+	  if (jump >= 0)
+	    program->instrs[jump].right = program->numInstrs;
+	  break;
+	case OP_COMP_EQUAL:
+	case OP_COMP_SMALLER:
+	case OP_COMP_GREATER:
+	case OP_COMP_LE:
+	case OP_COMP_GE:
+	  if (lDt != rDt)
+	    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "comparison only supported for values of the same datatype");
+	  emitCompare(program, op->type, lDt, r, lReg, rReg);
+	  break;
+	case OP_BETWEEN:
+	  {
+	  int lowReg = program->numRegs++;
+	  int highReg = program->numRegs++;
+	  if (lDt != rDt || lDt != hDt)
+	    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "BETWEEN only supported for values of the same datatype");
+	  program->regTypes[lowReg] = DT_BOOL;
+	  program->regTypes[highReg] = DT_BOOL;
+	  emitCompare(program, OP_COMP_LE, lDt, lowReg, rReg, lReg);
+	  emitCompare(program, OP_COMP_LE, lDt, highReg, lReg, hReg);
+	  emit(program, BC_AND, r, lowReg, highReg);
+	  }
+	  break;
+	case OP_IN:
+	  if (op->set == NULL || (op->set->numValues > 0 && op->set->dt != lDt))
+	    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "IN requires a set of values of the same datatype");
+	  program->sets[program->numSets] = op->set;
+	  emit(program, BC_IN, r, lReg, program->numSets++);
+	  break;
+	case OP_LIKE_PREFIX:
+	  if (lDt != DT_STRING || rDt != DT_STRING)
+	    THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "prefix match requires strings");
+	  emit(program, BC_PREFIX, r, lReg, rReg);
+	  break;
+	default:
+	  THROW(RC_RM_UNKOWN_DATATYPE, "operator cannot be compiled");
+	}
+      }
+      break;
+    }
+
+  program->regTypes[r] = *dt;
+  return RC_OK;
+}
+
+// compile an expression into a program. The expression has to outlive the
+// program, string constants are not copied.
+RC
+compileExpr (Expr *expr, Schema *schema, ExprProgram **program)
+{
+  int numNodes = countNodes(expr);
+  ExprProgram *p = (ExprProgram *) malloc(sizeof(ExprProgram));
+  DataType dt;
+  RC rc;
+
+  // one instruction per node and a jump per AND or OR at most
+  p->instrs = (ExprInstr *) malloc(sizeof(ExprInstr) * 2 * numNodes);
+  p->regs = (ExprRegister *) calloc(numNodes, sizeof(ExprRegister));
+  p->regTypes = (DataType *) calloc(numNodes, sizeof(DataType));
+  p->sets = (ValueSet **) malloc(sizeof(ValueSet *) * numNodes);
+  p->numSets = 0;
+  p->vectors = NULL;
+  p->vectorData = NULL;
+  p->numInstrs = 0;
+  p->numRegs = 0;
+
+  if ((rc = compileNode(expr, schema, p, &p->result, &dt)) == RC_OK && dt != DT_BOOL)
+    {
+      RC_message = "expression result is not boolean";
+      rc = RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN;
+    }
+  if (rc != RC_OK)
+    {
+      freeExprProgram(p);
+      *program = NULL;
+      return rc;
+    }
+
+  *program = p;
+  return RC_OK;
+}
+
+// look up a register of the datatype of the set
+static int
+registerInSet (ValueSet *set, ExprRegister *reg)
+{
+  Value value;
+
+  value.dt = set->dt;
+  switch(set->dt)
+    {
+    case DT_INT:
+      value.v.intV = reg->intV;
+      break;
+    case DT_FLOAT:
+      value.v.floatV = reg->floatV;
+      break;
+    case DT_BOOL:
+      value.v.boolV = reg->intV;
+      break;
+    case DT_STRING:
+      value.v.stringV = reg->stringV;
+      break;
+    }
+  return valueSetContains(set, &value);
+}
+
+// evaluate a program on a record, nothing is allocated.
+RC
+evalProgram (ExprProgram *program, Record *record, int *result)
+{
+  ExprRegister *regs = program->regs;
+  ExprInstr *instr = program->instrs;
+  ExprInstr *end = instr + program->numInstrs;
+  char *data = record->data;
+
+  for(; instr < end; instr++)
+    switch(instr->op)
+      {
+      case BC_LOAD_INT:
+	memcpy(&regs[instr->dst].intV, data + instr->left, sizeof(int));
+	break;
+      case BC_LOAD_FLOAT:
+	memcpy(&regs[instr->dst].floatV, data + instr->left, sizeof(float));
+	break;
+      case BC_LOAD_BOOL:
+	regs[instr->dst].intV = (data[instr->left] != 0);
+	break;
+      case BC_LOAD_STRING:
+	regs[instr->dst].stringV = data + instr->left;
+	break;
+      case BC_EQUAL_INT:
+	regs[instr->dst].intV = (regs[instr->left].intV == regs[instr->right].intV);
+	break;
+      case BC_EQUAL_FLOAT:
+	regs[instr->dst].intV = (regs[instr->left].floatV == regs[instr->right].floatV);
+	break;
+      case BC_EQUAL_STRING:
+	regs[instr->dst].intV = (strcmp(regs[instr->left].stringV, regs[instr->right].stringV) == 0);
+	break;
+      case BC_SMALLER_INT:
+	regs[instr->dst].intV = (regs[instr->left].intV < regs[instr->right].intV);
+	break;
+      case BC_SMALLER_FLOAT:
+	regs[instr->dst].intV = (regs[instr->left].floatV < regs[instr->right].floatV);
+	break;
+      case BC_SMALLER_STRING:
+	regs[instr->dst].intV = (strcmp(regs[instr->left].stringV, regs[instr->right].stringV) < 0);
+	break;
+      case BC_SMALLER_EQUAL_INT:
+	regs[instr->dst].intV = (regs[instr->left].intV <= regs[instr->right].intV);
+	break;
+      case BC_SMALLER_EQUAL_FLOAT:
+	regs[instr->dst].intV = (regs[instr->left].floatV <= regs[instr->right].floatV);
+	break;
+      case BC_SMALLER_EQUAL_STRING:
+	regs[instr->dst].intV = (strcmp(regs[instr->left].stringV, regs[instr->right].stringV) <= 0);
+	break;
+      case BC_IN:
+	regs[instr->dst].intV = registerInSet(program->sets[instr->right], &regs[instr->left]);
+	break;
+      case BC_PREFIX:
+	regs[instr->dst].intV = hasPrefix(regs[instr->left].stringV, regs[instr->right].stringV);
+	break;
+      case BC_AND:
+	regs[instr->dst].intV = (regs[instr->left].intV && regs[instr->right].intV);
+	break;
+      case BC_OR:
+	regs[instr->dst].intV = (regs[instr->left].intV || regs[instr->right].intV);
+	break;
+      case BC_NOT:
+	regs[instr->dst].intV = !regs[instr->left].intV;
+	break;
+      case BC_JUMP_FALSE:
+	if (!regs[instr->left].intV)
+	  {
+	    regs[instr->dst].intV = 0;
+	    instr = program->instrs + instr->right - 1;
+	  }
+	break;
+      case BC_JUMP_TRUE:
+	if (regs[instr->left].intV)
+	  {
+	    regs[instr->dst].intV = 1;
+	    instr = program->instrs + instr->right - 1;
+	  }
+	break;
+      }
+
+  *result = regs[program->result].intV;
+  return RC_OK;
+}
+
+// batch evaluation: every register holds a column vector of
+// EXPR_BATCH_SIZE values, booleans are bitmaps with bit i of byte i / 8 set
+// for tuple i. Vectors are evaluated in groups of 8 tuples, the bits of a
+// partial last group are cleared from the result.
+#define BATCH_BITMAP_SIZE (EXPR_BATCH_SIZE / 8)
+
+static void
+allocVectors (ExprProgram *program)
+{
+  int *isLoaded = (int *) calloc(program->numRegs, sizeof(int));
+  size_t size = 0;
+  int i, j;
+
+  for(i = 0; i < program->numInstrs; i++)
+    isLoaded[program->instrs[i].dst] = 1;
+
+  for(i = 0; i < program->numRegs; i++)
+    switch(program->regTypes[i])
+      {
+      case DT_INT:
+      case DT_FLOAT:
+	size += EXPR_BATCH_SIZE * sizeof(int);
+	break;
+      case DT_STRING:
+	size += EXPR_BATCH_SIZE * sizeof(char *);
+	break;
+      case DT_BOOL:
+	size += BATCH_BITMAP_SIZE;
+	break;
+      }
+
+  program->vectors = (char **) malloc(sizeof(char *) * program->numRegs);
+  program->vectorData = (char *) calloc(1, size);
+
+  // string vectors first, they need the strictest alignment
+  size = 0;
+  for(i = 0; i < program->numRegs; i++)
+    if (program->regTypes[i] == DT_STRING)
+      {
+	program->vectors[i] = program->vectorData + size;
+	size += EXPR_BATCH_SIZE * sizeof(char *);
+      }
+  for(i = 0; i < program->numRegs; i++)
+    if (program->regTypes[i] == DT_INT || program->regTypes[i] == DT_FLOAT)
+      {
+	program->vectors[i] = program->vectorData + size;
+	size += EXPR_BATCH_SIZE * sizeof(int);
+      }
+  for(i = 0; i < program->numRegs; i++)
+    if (program->regTypes[i] == DT_BOOL)
+      {
+	program->vectors[i] = program->vectorData + size;
+	size += BATCH_BITMAP_SIZE;
+      }
+
+  // constants are broadcast once
+  for(i = 0; i < program->numRegs; i++)
+    {
+      if (isLoaded[i])
+	continue;
+      for(j = 0; j < EXPR_BATCH_SIZE; j++)
+	switch(program->regTypes[i])
+	  {
+	  case DT_INT:
+	    ((int *) program->vectors[i])[j] = program->regs[i].intV;
+	    break;
+	  case DT_FLOAT:
+	    ((float *) program->vectors[i])[j] = program->regs[i].floatV;
+	    break;
+	  case DT_STRING:
+	    ((char **) program->vectors[i])[j] = program->regs[i].stringV;
+	    break;
+	  case DT_BOOL:
+	    if (j < BATCH_BITMAP_SIZE)
+	      program->vectors[i][j] = program->regs[i].intV ? 0xFF : 0;
+	    break;
+	  }
+    }
+
+  free(isLoaded);
+}
+
+// values stride bytes apart from values on, a column of ints or floats is
+// copied at once.
+static void
+loadVector (char *vector, char *values, int stride, int numTuples)
+{
+  int i;
+
+  if (stride == sizeof(int))
+    {
+      memcpy(vector, values, numTuples * sizeof(int));
+      return;
+    }
+  for(i = 0; i < numTuples; i++)
+    memcpy(vector + i * sizeof(int), values + i * stride, sizeof(int));
+}
+
+static void
+loadBitmap (unsigned char *bits, char *values, int stride, int numTuples)
+{
+  int i;
+
+  memset(bits, 0, BATCH_BITMAP_SIZE);
+  for(i = 0; i < numTuples; i++)
+    if (values[i * stride])
+      bits[i / 8] |= 1 << (i % 8);
+}
+
+// compare two int vectors, every group of 8 tuples gives one bitmap byte.
+// l <= r is computed as NOT (l > r).
+static void
+compareInts (ExprOpCode op, int *left, int *right, unsigned char *bits, int numGroups)
+{
+  int g;
+
+  for(g = 0; g < numGroups; g++, left += 8, right += 8)
+    {
+#if defined(__AVX2__)
+      __m256i l = _mm256_loadu_si256((__m256i *) left);
+      __m256i r = _mm256_loadu_si256((__m256i *) right);
+      switch(op)
+	{
+	case BC_EQUAL_INT:
+	  bits[g] = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(l, r)));
+	  break;
+	case BC_SMALLER_INT:
+	  bits[g] = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(r, l)));
+	  break;
+	default:
+	  bits[g] = ~_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(l, r)));
+	  break;
+	}
+#elif defined(__SSE2__)
+      __m128i l0 = _mm_loadu_si128((__m128i *) left);
+      __m128i r0 = _mm_loadu_si128((__m128i *) right);
+      __m128i l1 = _mm_loadu_si128((__m128i *) (left + 4));
+      __m128i r1 = _mm_loadu_si128((__m128i *) (right + 4));
+      __m128i c0, c1;
+      switch(op)
+	{
+	case BC_EQUAL_INT:
+	  c0 = _mm_cmpeq_epi32(l0, r0);
+	  c1 = _mm_cmpeq_epi32(l1, r1);
+	  break;
+	case BC_SMALLER_INT:
+	  c0 = _mm_cmplt_epi32(l0, r0);
+	  c1 = _mm_cmplt_epi32(l1, r1);
 	  break;
 	default:
-	  freeExpr(op->args[0]);
-	  freeExpr(op->args[1]);
+	  c0 = _mm_cmpgt_epi32(l0, r0);
+	  c1 = _mm_cmpgt_epi32(l1, r1);
 	  break;
 	}
+      bits[g] = _mm_movemask_ps(_mm_castsi128_ps(c0)) | (_mm_movemask_ps(_mm_castsi128_ps(c1)) << 4);
+      if (op == BC_SMALLER_EQUAL_INT)
+	bits[g] = ~bits[g];
+#else
+      int i;
+      unsigned char b = 0;
+      for(i = 0; i < 8; i++)
+	if ((op == BC_EQUAL_INT) ? (left[i] == right[i])
+	    : (op == BC_SMALLER_INT) ? (left[i] < right[i]) : (left[i] <= right[i]))
+	  b |= 1 << i;
+      bits[g] = b;
+#endif
+    }
+}
+
+static void
+compareFloats (ExprOpCode op, float *left, float *right, unsigned char *bits, int numGroups)
+{
+  int g;
+
+  for(g = 0; g < numGroups; g++, left += 8, right += 8)
+    {
+#if defined(__AVX2__)
+      __m256 l = _mm256_loadu_ps(left);
+      __m256 r = _mm256_loadu_ps(right);
+      __m256 cmp = (op == BC_EQUAL_FLOAT) ? _mm256_cmp_ps(l, r, _CMP_EQ_OQ)
+	: (op == BC_SMALLER_FLOAT) ? _mm256_cmp_ps(l, r, _CMP_LT_OQ) : _mm256_cmp_ps(l, r, _CMP_LE_OQ);
+      bits[g] = _mm256_movemask_ps(cmp);
+#elif defined(__SSE2__)
+      __m128 l0 = _mm_loadu_ps(left);
+      __m128 r0 = _mm_loadu_ps(right);
+      __m128 l1 = _mm_loadu_ps(left + 4);
+      __m128 r1 = _mm_loadu_ps(right + 4);
+      __m128 c0 = (op == BC_EQUAL_FLOAT) ? _mm_cmpeq_ps(l0, r0)
+	: (op == BC_SMALLER_FLOAT) ? _mm_cmplt_ps(l0, r0) : _mm_cmple_ps(l0, r0);
+      __m128 c1 = (op == BC_EQUAL_FLOAT) ? _mm_cmpeq_ps(l1, r1)
+	: (op == BC_SMALLER_FLOAT) ? _mm_cmplt_ps(l1, r1) : _mm_cmple_ps(l1, r1);
+      bits[g] = _mm_movemask_ps(c0) | (_mm_movemask_ps(c1) << 4);
+#else
+      int i;
+      unsigned char b = 0;
+      for(i = 0; i < 8; i++)
+	if ((op == BC_EQUAL_FLOAT) ? (left[i] == right[i])
+	    : (op == BC_SMALLER_FLOAT) ? (left[i] < right[i]) : (left[i] <= right[i]))
+	  b |= 1 << i;
+      bits[g] = b;
+#endif
+    }
+}
+
+// look up every live tuple in a set, booleans are read from their bitmap
+static void
+vectorInSet (ValueSet *set, DataType dt, char *vector, unsigned char *bits, int numTuples,
+	     unsigned char *live)
+{
+  ExprRegister reg;
+  int i;
+
+  memset(bits, 0, BATCH_BITMAP_SIZE);
+  for(i = 0; i < numTuples; i++)
+    {
+      if (!((live[i / 8] >> (i % 8)) & 1))
+	continue;
+      switch(dt)
+	{
+	case DT_INT:
+	  reg.intV = ((int *) vector)[i];
+	  break;
+	case DT_FLOAT:
+	  reg.floatV = ((float *) vector)[i];
+	  break;
+	case DT_BOOL:
+	  reg.intV = (vector[i / 8] >> (i % 8)) & 1;
+	  break;
+	case DT_STRING:
+	  reg.stringV = ((char **) vector)[i];
+	  break;
+	}
+      if (registerInSet(set, &reg))
+	bits[i / 8] |= 1 << (i % 8);
+    }
+}
+
+// strings are compared one live tuple at a time
+static void
+compareStrings (ExprOpCode op, char **left, char **right, unsigned char *bits, int numTuples,
+		unsigned char *live)
+{
+  int i;
+
+  memset(bits, 0, BATCH_BITMAP_SIZE);
+  for(i = 0; i < numTuples; i++)
+    {
+      int match;
+      if (!((live[i / 8] >> (i % 8)) & 1))
+	continue;
+      if (op == BC_PREFIX)
+	match = hasPrefix(left[i], right[i]);
+      else
+	{
+	  int cmp = strcmp(left[i], right[i]);
+	  match = (op == BC_EQUAL_STRING) ? (cmp == 0) : (op == BC_SMALLER_STRING) ? (cmp < 0) : (cmp <= 0);
+	}
+      if (match)
+	bits[i / 8] |= 1 << (i % 8);
+    }
+}
+
+// true if bits has the given value for all live tuples of a batch
+static int
+bitmapDecided (unsigned char *bits, unsigned char *live, int numGroups, int value)
+{
+  int i;
+
+  for(i = 0; i < numGroups; i++)
+    if (((value ? ~bits[i] : bits[i]) & live[i]) != 0)
+      return 0;
+  return 1;
+}
+
+// evaluate a program on numTuples tuples stored stride bytes apart and set
+// bit i of selection (byte i / 8) if tuple i matches. With masked set, only
+// tuples whose bit is already set are live: tuple at a time kernels skip
+// the others and batches without live tuples are not evaluated. With a
+// capacity the tuples are in minipages instead: the attribute at offset o
+// of a record has its values one after the other from tuples + o * capacity.
+static void
+evalBatch (ExprProgram *program, char *tuples, int stride, int capacity, int numTuples,
+	   unsigned char *selection, int masked)
+{
+  unsigned char live[BATCH_BITMAP_SIZE];
+  char **vec;
+  int start, i;
+
+  if (program->vectors == NULL)
+    allocVectors(program);
+  vec = program->vectors;
+
+  for(start = 0; start < numTuples; start += EXPR_BATCH_SIZE)
+    {
+      int n = (numTuples - start < EXPR_BATCH_SIZE) ? numTuples - start : EXPR_BATCH_SIZE;
+      int numGroups = (n + 7) / 8;
+      char *batch = tuples + start * stride;
+      ExprInstr *instr = program->instrs;
+      ExprInstr *end = instr + program->numInstrs;
+      unsigned char *out = selection + start / 8;
+
+      if (masked)
+	memcpy(live, out, numGroups);
+      else
+	memset(live, 0xFF, numGroups);
+      if (n % 8 != 0)
+	live[numGroups - 1] &= (1 << (n % 8)) - 1;
+      if (masked && bitmapDecided(live, live, numGroups, 0))
+	continue;
+
+      for(; instr < end; instr++)
+	{
+	  unsigned char *dst = (unsigned char *) vec[instr->dst];
+	  unsigned char *l = NULL, *r = NULL;
+	  char *values = NULL;
+	  int step = 0;
+
+	  // loads keep the attribute offset in left, BC_IN a set and jumps
+	  // an instruction in right, loads the size of the attribute
+	  if (instr->op > BC_LOAD_STRING)
+	    {
+	      l = (unsigned char *) vec[instr->left];
+	      if (instr->op != BC_IN && instr->op != BC_JUMP_FALSE && instr->op != BC_JUMP_TRUE)
+		r = (unsigned char *) vec[instr->right];
+	    }
+	  else if (capacity > 0)
+	    {
+	      values = tuples + instr->left * capacity + start * instr->right;
+	      step = instr->right;
+	    }
+	  else
+	    {
+	      values = batch + instr->left;
+	      step = stride;
+	    }
+
+	  switch(instr->op)
+	    {
+	    case BC_LOAD_INT:
+	    case BC_LOAD_FLOAT:
+	      loadVector((char *) dst, values, step, n);
+	      break;
+	    case BC_LOAD_BOOL:
+	      loadBitmap(dst, values, step, n);
+	      break;
+	    case BC_LOAD_STRING:
+	      for(i = 0; i < n; i++)
+		((char **) dst)[i] = values + i * step;
+	      break;
+	    case BC_EQUAL_INT:
+	    case BC_SMALLER_INT:
+	    case BC_SMALLER_EQUAL_INT:
+	      // booleans are compared as bitmaps
+	      if (program->regTypes[instr->left] == DT_BOOL)
+		{
+		  for(i = 0; i < numGroups; i++)
+		    dst[i] = (instr->op == BC_EQUAL_INT) ? ~(l[i] ^ r[i])
+		      : (instr->op == BC_SMALLER_INT) ? (~l[i] & r[i]) : (~l[i] | r[i]);
+		}
+	      else
+		compareInts(instr->op, (int *) l, (int *) r, dst, numGroups);
+	      break;
+	    case BC_EQUAL_FLOAT:
+	    case BC_SMALLER_FLOAT:
+	    case BC_SMALLER_EQUAL_FLOAT:
+	      compareFloats(instr->op, (float *) l, (float *) r, dst, numGroups);
+	      break;
+	    case BC_EQUAL_STRING:
+	    case BC_SMALLER_STRING:
+	    case BC_SMALLER_EQUAL_STRING:
+	    case BC_PREFIX:
+	      compareStrings(instr->op, (char **) l, (char **) r, dst, n, live);
+	      break;
+	    case BC_IN:
+	      vectorInSet(program->sets[instr->right], program->regTypes[instr->left],
+			  vec[instr->left], dst, n, live);
+	      break;
+	    case BC_AND:
+	      for(i = 0; i < numGroups; i++)
+		dst[i] = l[i] & r[i];
+	      break;
+	    case BC_OR:
+	      for(i = 0; i < numGroups; i++)
+		dst[i] = l[i] | r[i];
+	      break;
+	    case BC_NOT:
+	      for(i = 0; i < numGroups; i++)
+		dst[i] = ~l[i];
+	      break;
+	    case BC_JUMP_FALSE:
+	    case BC_JUMP_TRUE:
+	      // only skips when the left side decides every live tuple
+	      if (bitmapDecided(l, live, numGroups, instr->op == BC_JUMP_TRUE))
+		{
+		  memset(dst, (instr->op == BC_JUMP_TRUE) ? 0xFF : 0, numGroups);
+		  instr = program->instrs + instr->right - 1;
+		}
+	      break;
+	    }
+	}
+
+      for(i = 0; i < numGroups; i++)
+	out[i] = vec[program->result][i] & live[i];
+    }
+}
+
+RC
+evalProgramBatch (ExprProgram *program, char *tuples, int stride, int numTuples,
+		  unsigned char *selection)
+{
+  evalBatch(program, tuples, stride, 0, numTuples, selection, 0);
+  return RC_OK;
+}
+
+// filters: the top level conjuncts of a condition, each compiled on its
+// own and evaluated only on the tuples the terms before it let through.
+static int
+countConjuncts (Expr *expr)
+{
+  if (expr->type == EXPR_OP && expr->expr.op->type == OP_BOOL_AND)
+    return countConjuncts(expr->expr.op->args[0]) + countConjuncts(expr->expr.op->args[1]);
+  return 1;
+}
+
+static RC
+compileConjuncts (Expr *expr, Schema *schema, ExprFilter *filter)
+{
+  ExprTerm *term;
+  int i;
+
+  if (expr->type == EXPR_OP && expr->expr.op->type == OP_BOOL_AND)
+    {
+      CHECK_RETURN(compileConjuncts(expr->expr.op->args[0], schema, filter));
+      return compileConjuncts(expr->expr.op->args[1], schema, filter);
+    }
+
+  term = &filter->terms[filter->numTerms];
+  CHECK_RETURN(compileExpr(expr, schema, &term->program));
+  filter->numTerms++;
+
+  // until the term has been measured, string and set lookups are guessed
+  // to cost four times a comparison of numbers and half the tuples to pass
+  term->rank = 0;
+  for(i = 0; i < term->program->numInstrs; i++)
+    switch(term->program->instrs[i].op)
+      {
+      case BC_EQUAL_STRING:
+      case BC_SMALLER_STRING:
+      case BC_SMALLER_EQUAL_STRING:
+      case BC_PREFIX:
+      case BC_IN:
+	term->rank += 8;
+	break;
+      default:
+	term->rank += 2;
+	break;
+      }
+  term->nanos = 0;
+  term->evaluated = 0;
+  term->passed = 0;
+
+  return RC_OK;
+}
+
+static void
+sortTerms (ExprFilter *filter)
+{
+  int i, j;
+
+  for(i = 1; i < filter->numTerms; i++)
+    {
+      ExprTerm term = filter->terms[i];
+      for(j = i; j > 0 && filter->terms[j - 1].rank > term.rank; j--)
+	filter->terms[j] = filter->terms[j - 1];
+      filter->terms[j] = term;
+    }
+}
+
+// rank every measured term by its cost per tuple divided by the fraction
+// of tuples it rejects, the usual order for independent filters. The
+// counters are halved so the order follows changes in the data.
+static void
+reorderTerms (ExprFilter *filter)
+{
+  int i;
+
+  for(i = 0; i < filter->numTerms; i++)
+    {
+      ExprTerm *term = &filter->terms[i];
+      double rejected;
+
+      if (term->evaluated == 0)
+	continue;
+      rejected = 1 - term->passed / term->evaluated;
+      term->rank = (term->nanos / term->evaluated) / (rejected > 0.001 ? rejected : 0.001);
+      term->nanos /= 2;
+      term->evaluated /= 2;
+      term->passed /= 2;
+    }
+  sortTerms(filter);
+  filter->sinceReorder = 0;
+  filter->numReorders++;
+}
+
+// compile a condition into a filter, fails like compileExpr.
+RC
+compileFilter (Expr *expr, Schema *schema, ExprFilter **filter)
+{
+  ExprFilter *f = (ExprFilter *) malloc(sizeof(ExprFilter));
+  RC rc;
+
+  f->terms = (ExprTerm *) malloc(sizeof(ExprTerm) * countConjuncts(expr));
+  f->numTerms = 0;
+  f->reorderTuples = EXPR_REORDER_TUPLES;
+  f->sinceReorder = 0;
+  f->numReorders = 0;
+
+  if ((rc = compileConjuncts(expr, schema, f)) != RC_OK)
+    {
+      freeExprFilter(f);
+      *filter = NULL;
+      return rc;
+    }
+  sortTerms(f);
+
+  *filter = f;
+  return RC_OK;
+}
+
+static int
+countBits (unsigned char *bits, int numBytes)
+{
+  int i, count = 0;
+
+  for(i = 0; i < numBytes; i++)
+    count += __builtin_popcount(bits[i]);
+  return count;
+}
+
+// evaluate a filter on tuples stored like evalBatch takes them, measuring
+// the terms as they go. A masked evaluation starts from the tuples already
+// in selection.
+static void
+evalFilter (ExprFilter *filter, char *tuples, int stride, int capacity, int numTuples,
+	    unsigned char *selection, int masked)
+{
+  int numBytes = (numTuples + 7) / 8;
+  int live = numTuples;
+  int i;
+
+  if (masked)
+    live = countBits(selection, numBytes);
+  else
+    {
+      memset(selection, 0xFF, numBytes);
+      if (numTuples % 8 != 0)
+	selection[numBytes - 1] = (1 << (numTuples % 8)) - 1;
+    }
+
+  for(i = 0; i < filter->numTerms && live > 0; i++)
+    {
+      ExprTerm *term = &filter->terms[i];
+      struct timespec start, end;
+
+      clock_gettime(CLOCK_MONOTONIC, &start);
+      evalBatch(term->program, tuples, stride, capacity, numTuples, selection, 1);
+      clock_gettime(CLOCK_MONOTONIC, &end);
+
+      term->nanos += (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+      term->evaluated += live;
+      live = countBits(selection, numBytes);
+      term->passed += live;
+    }
+
+  filter->sinceReorder += numTuples;
+  if (filter->numTerms > 1 && filter->sinceReorder >= filter->reorderTuples)
+    reorderTerms(filter);
+}
+
+// evaluate a filter like evalProgramBatch
+RC
+evalFilterBatch (ExprFilter *filter, char *tuples, int stride, int numTuples,
+		 unsigned char *selection)
+{
+  evalFilter(filter, tuples, stride, 0, numTuples, selection, 0);
+  return RC_OK;
+}
+
+// evaluate a filter on tuples stored in minipages of capacity values each,
+// one per attribute in the order of the record: the attribute at offset o
+// of a record has the value of tuple i at minipages + o * capacity + i * its
+// size.
+RC
+evalFilterColumns (ExprFilter *filter, char *minipages, int capacity, int numTuples,
+		   unsigned char *selection)
+{
+  evalFilter(filter, minipages, 0, capacity, numTuples, selection, 0);
+  return RC_OK;
+}
+
+// evaluate a filter like evalFilterColumns on the tuples whose bits are set
+// in selection, the others stay cleared
+RC
+evalFilterSelected (ExprFilter *filter, char *minipages, int capacity, int numTuples,
+		    unsigned char *selection)
+{
+  evalFilter(filter, minipages, 0, capacity, numTuples, selection, 1);
+  return RC_OK;
+}
+
+RC
+freeExprFilter (ExprFilter *filter)
+{
+  int i;
+
+  for(i = 0; i < filter->numTerms; i++)
+    freeExprProgram(filter->terms[i].program);
+  free(filter->terms);
+  free(filter);
+
+  return RC_OK;
+}
+
+RC
+freeExprProgram (ExprProgram *program)
+{
+  free(program->instrs);
+  free(program->regs);
+  free(program->regTypes);
+  free(program->sets);
+  free(program->vectors);
+  free(program->vectorData);
+  free(program);
+
+  return RC_OK;
+}
+
+static unsigned int
+hashValue (Value *value)
+{
+  unsigned int hash = 2166136261u;
+  char *c;
+  float f;
+
+  switch(value->dt)
+    {
+    case DT_INT:
+      return (unsigned int) value->v.intV * 2654435761u;
+    case DT_BOOL:
+      return value->v.boolV != 0;
+    case DT_FLOAT:
+      // 0.0 and -0.0 are equal
+      f = (value->v.floatV == 0) ? 0 : value->v.floatV;
+      memcpy(&hash, &f, sizeof(float));
+      return hash * 2654435761u;
+    case DT_STRING:
+      for(c = value->v.stringV; *c; c++)
+	hash = (hash ^ (unsigned char) *c) * 16777619u;
+      return hash;
+    }
+  return 0;
+}
+
+static int
+setValuesEqual (Value *left, Value *right)
+{
+  switch(left->dt)
+    {
+    case DT_INT:
+      return left->v.intV == right->v.intV;
+    case DT_FLOAT:
+      return left->v.floatV == right->v.floatV;
+    case DT_BOOL:
+      return (left->v.boolV != 0) == (right->v.boolV != 0);
+    case DT_STRING:
+      return strcmp(left->v.stringV, right->v.stringV) == 0;
+    }
+  return 0;
+}
+
+// build the constant set of an IN operator, the values are copied. Returns
+// NULL if the values are not all of one datatype.
+ValueSet *
+createValueSet (Value **values, int numValues)
+{
+  ValueSet *set;
+  int size = 4, i;
+
+  for(i = 1; i < numValues; i++)
+    if (values[i]->dt != values[0]->dt)
+      return NULL;
+
+  while (size < 2 * numValues)
+    size *= 2;
+
+  set = (ValueSet *) malloc(sizeof(ValueSet));
+  set->dt = (numValues > 0) ? values[0]->dt : DT_INT;
+  set->numValues = 0;
+  set->mask = size - 1;
+  set->slots = (Value *) malloc(sizeof(Value) * size);
+  set->used = (char *) calloc(size, 1);
+
+  for(i = 0; i < numValues; i++)
+    {
+      unsigned int slot = hashValue(values[i]) & set->mask;
+
+      while (set->used[slot] && !setValuesEqual(&set->slots[slot], values[i]))
+	slot = (slot + 1) & set->mask;
+      if (set->used[slot])
+	continue;
+
+      set->used[slot] = 1;
+      set->slots[slot].dt = values[i]->dt;
+      set->slots[slot].v = values[i]->v;
+      if (values[i]->dt == DT_STRING)
+	{
+	  set->slots[slot].v.stringV = (char *) malloc(strlen(values[i]->v.stringV) + 1);
+	  strcpy(set->slots[slot].v.stringV, values[i]->v.stringV);
+	}
+      set->numValues++;
+    }
+
+  return set;
+}
+
+// value has to be of the datatype of the set
+int
+valueSetContains (ValueSet *set, Value *value)
+{
+  unsigned int slot;
+
+  if (set->numValues == 0)
+    return 0;
+
+  slot = hashValue(value) & set->mask;
+  while (set->used[slot])
+    {
+      if (setValuesEqual(&set->slots[slot], value))
+	return 1;
+      slot = (slot + 1) & set->mask;
+    }
+  return 0;
+}
+
+void
+freeValueSet (ValueSet *set)
+{
+  int i;
+
+  if (set->dt == DT_STRING)
+    for(i = 0; i <= set->mask; i++)
+      if (set->used[i])
+	free(set->slots[i].v.stringV);
+  free(set->slots);
+  free(set->used);
+  free(set);
+}
+
+// narrow a range by one bound, bounds of another datatype are ignored
+static void
+addBound (ExprRange *range, Value *value, int isLow, int inclusive)
+{
+  int cmp;
+
+  if (isLow)
+    {
+      if (range->hasLow)
+	{
+	  if (range->low.dt != value->dt)
+	    return;
+	  compareValues(value, &range->low, &cmp);
+	  if (cmp < 0 || (cmp == 0 && inclusive))
+	    return;
+	}
+      range->hasLow = 1;
+      range->low = *value;
+      range->lowInclusive = inclusive;
+    }
+  else
+    {
+      if (range->hasHigh)
+	{
+	  if (range->high.dt != value->dt)
+	    return;
+	  compareValues(value, &range->high, &cmp);
+	  if (cmp > 0 || (cmp == 0 && inclusive))
+	    return;
+	}
+      range->hasHigh = 1;
+      range->high = *value;
+      range->highInclusive = inclusive;
+    }
+}
+
+static int
+isAttr (Expr *expr, int attrNum)
+{
+  return expr->type == EXPR_ATTRREF && expr->expr.attrRef == attrNum;
+}
+
+static void
+collectRange (Expr *expr, int attrNum, ExprRange *range)
+{
+  Operator *op;
+
+  if (expr->type != EXPR_OP)
+    return;
+  op = expr->expr.op;
+
+  switch(op->type)
+    {
+    case OP_BOOL_AND:
+      collectRange(op->args[0], attrNum, range);
+      collectRange(op->args[1], attrNum, range);
+      break;
+    case OP_COMP_EQUAL:
+    case OP_COMP_SMALLER:
+    case OP_COMP_GREATER:
+    case OP_COMP_LE:
+    case OP_COMP_GE:
+      {
+      OpType type = op->type;
+      Value *cons;
+
+      // 5 < a is a > 5
+      if (isAttr(op->args[0], attrNum) && op->args[1]->type == EXPR_CONST)
+	cons = op->args[1]->expr.cons;
+      else if (isAttr(op->args[1], attrNum) && op->args[0]->type == EXPR_CONST)
+	{
+	  cons = op->args[0]->expr.cons;
+	  type = (type == OP_COMP_SMALLER) ? OP_COMP_GREATER : (type == OP_COMP_GREATER) ? OP_COMP_SMALLER
+	    : (type == OP_COMP_LE) ? OP_COMP_GE : (type == OP_COMP_GE) ? OP_COMP_LE : type;
+	}
+      else
+	break;
+
+      if (type == OP_COMP_EQUAL || type == OP_COMP_GREATER || type == OP_COMP_GE)
+	addBound(range, cons, 1, type != OP_COMP_GREATER);
+      if (type == OP_COMP_EQUAL || type == OP_COMP_SMALLER || type == OP_COMP_LE)
+	addBound(range, cons, 0, type != OP_COMP_SMALLER);
+      }
+      break;
+    case OP_BETWEEN:
+      if (isAttr(op->args[0], attrNum) && op->args[1]->type == EXPR_CONST && op->args[2]->type == EXPR_CONST)
+	{
+	  addBound(range, op->args[1]->expr.cons, 1, 1);
+	  addBound(range, op->args[2]->expr.cons, 0, 1);
+	}
+      break;
+    case OP_IN:
+      if (isAttr(op->args[0], attrNum) && op->set != NULL)
+	{
+	  ValueSet *set = op->set;
+	  Value *min = NULL, *max = NULL;
+	  int i, cmp;
+
+	  for(i = 0; i <= set->mask; i++)
+	    {
+	      if (!set->used[i])
+		continue;
+	      if (min == NULL)
+		{
+		  min = max = &set->slots[i];
+		  continue;
+		}
+	      compareValues(&set->slots[i], min, &cmp);
+	      if (cmp < 0)
+		min = &set->slots[i];
+	      compareValues(&set->slots[i], max, &cmp);
+	      if (cmp > 0)
+		max = &set->slots[i];
+	    }
+	  if (min == NULL)
+	    range->empty = 1;
+	  else
+	    {
+	      addBound(range, min, 1, 1);
+	      addBound(range, max, 0, 1);
+	    }
+	}
+      break;
+    case OP_LIKE_PREFIX:
+      if (isAttr(op->args[0], attrNum) && op->args[1]->type == EXPR_CONST)
+	addBound(range, op->args[1]->expr.cons, 1, 1);
+      break;
+    default:
+      // OR and NOT do not bound a single attribute
+      break;
+    }
+}
+
+// compute the bounds a condition implies for attribute attrNum, looking at
+// comparisons with constants joined by AND. A range scan reads only the
+// pages and keys inside the bounds, an empty range matches nothing.
+RC
+getExprRange (Expr *expr, int attrNum, ExprRange *range)
+{
+  int cmp;
+
+  memset(range, 0, sizeof(ExprRange));
+  collectRange(expr, attrNum, range);
+
+  if (range->hasLow && range->hasHigh && range->low.dt == range->high.dt)
+    {
+      compareValues(&range->low, &range->high, &cmp);
+      if (cmp > 0 || (cmp == 0 && !(range->lowInclusive && range->highInclusive)))
+	range->empty = 1;
+    }
+
+  return RC_OK;
+}
+
+RC
+freeExpr (Expr *expr)
+{
+  switch(expr->type) 
+    {
+    case EXPR_OP:
+      {
+      Operator *op = expr->expr.op;
+      int i;
+      for(i = 0; i < numArgs(op->type); i++)
+	freeExpr(op->args[i]);
+      if (op->set != NULL)
+	freeValueSet(op->set);
       free(op->args);
+      free(op);
       }
       break;
     case EXPR_CONST:
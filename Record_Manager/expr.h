@@ -26,22 +26,151 @@ typedef enum OpType {
   OP_BOOL_OR,
   OP_BOOL_NOT,
   OP_COMP_EQUAL,
-  OP_COMP_SMALLER
+  OP_COMP_SMALLER,
+  OP_COMP_GREATER,
+  OP_COMP_LE,
+  OP_COMP_GE,
+  OP_BETWEEN,           // args[1] <= args[0] <= args[2]
+  OP_IN,                // args[0] is in the constant set of the operator
+  OP_LIKE_PREFIX        // args[0] LIKE 'args[1]%'
 } OpType;
 
+// the constants of an IN operator, hashed with open addressing
+typedef struct ValueSet {
+  DataType dt;
+  int numValues;
+  int mask;             // number of slots - 1, a power of two
+  Value *slots;
+  char *used;
+} ValueSet;
+
 typedef struct Operator {
   OpType type;
   Expr **args;
+  ValueSet *set;        // OP_IN only
 } Operator;
 
+// bounds on one attribute implied by a condition, the values point into
+// the constants of the expression.
+typedef struct ExprRange {
+  int empty;            // no value satisfies the condition
+  int hasLow;
+  int lowInclusive;
+  Value low;
+  int hasHigh;
+  int highInclusive;
+  Value high;
+} ExprRange;
+
+// compiled expressions: a flat program over registers, attribute offsets
+// and types are resolved against the schema at compile time.
+typedef enum ExprOpCode {
+  BC_LOAD_INT,
+  BC_LOAD_FLOAT,
+  BC_LOAD_BOOL,
+  BC_LOAD_STRING,
+  BC_EQUAL_INT,
+  BC_EQUAL_FLOAT,
+  BC_EQUAL_STRING,
+  BC_SMALLER_INT,
+  BC_SMALLER_FLOAT,
+  BC_SMALLER_STRING,
+  BC_SMALLER_EQUAL_INT,
+  BC_SMALLER_EQUAL_FLOAT,
+  BC_SMALLER_EQUAL_STRING,
+  BC_IN,                // right is an index into the sets of the program
+  BC_PREFIX,
+  BC_AND,
+  BC_OR,
+  BC_NOT,
+  BC_JUMP_FALSE,        // dst = false and jump to instruction right if
+  BC_JUMP_TRUE          // left is false (true), AND and OR skip their right side
+} ExprOpCode;
+
+typedef struct ExprInstr {
+  ExprOpCode op;
+  int dst;
+  int left;             // register, or attribute offset for loads
+  int right;            // register, or attribute size for loads
+} ExprInstr;
+
+typedef union ExprRegister {
+  int intV;             // ints, bools and comparison results
+  float floatV;
+  char *stringV;
+} ExprRegister;
+
+// tuples evaluated per pass of evalProgramBatch
+#define EXPR_BATCH_SIZE 256
+
+typedef struct ExprProgram {
+  ExprInstr *instrs;
+  int numInstrs;
+  ExprRegister *regs;   // constants are loaded once by compileExpr
+  int numRegs;
+  int result;           // register holding the result
+  DataType *regTypes;
+  ValueSet **sets;      // sets of OP_IN, owned by the expression
+  int numSets;
+  char **vectors;       // column vector or bitmap of every register for
+  char *vectorData;     // evalProgramBatch, allocated on first use
+} ExprProgram;
+
+// tuples between two reorderings of the terms of a filter
+#define EXPR_REORDER_TUPLES 4096
+
+// one conjunct of a filter with what it cost and let through since the
+// last reordering
+typedef struct ExprTerm {
+  ExprProgram *program;
+  double rank;          // cost per tuple / fraction of tuples rejected
+  double nanos;
+  double evaluated;
+  double passed;
+} ExprTerm;
+
+// a condition split at its top level ANDs. Terms are evaluated cheapest
+// and most selective first, the order adapts to the tuples seen.
+typedef struct ExprFilter {
+  ExprTerm *terms;
+  int numTerms;
+  int reorderTuples;
+  int sinceReorder;
+  int numReorders;
+} ExprFilter;
+
 // expression evaluation methods
 extern RC valueEquals (Value *left, Value *right, Value *result);
 extern RC valueSmaller (Value *left, Value *right, Value *result);
+extern RC valueGreater (Value *left, Value *right, Value *result);
+extern RC valueSmallerOrEqual (Value *left, Value *right, Value *result);
+extern RC valueGreaterOrEqual (Value *left, Value *right, Value *result);
+extern RC valueBetween (Value *input, Value *low, Value *high, Value *result);
+extern RC valueIn (Value *input, ValueSet *set, Value *result);
+extern RC valueHasPrefix (Value *input, Value *prefix, Value *result);
 extern RC boolNot (Value *input, Value *result);
 extern RC boolAnd (Value *left, Value *right, Value *result);
 extern RC boolOr (Value *left, Value *right, Value *result);
 extern RC evalExpr (Record *record, Schema *schema, Expr *expr, Value **result);
+extern RC evalExprInto (Record *record, Schema *schema, Expr *expr, Value *result);
 extern RC freeExpr (Expr *expr);
+extern RC getExprRange (Expr *expr, int attrNum, ExprRange *range);
+extern ValueSet *createValueSet (Value **values, int numValues);
+extern int valueSetContains (ValueSet *set, Value *value);
+extern void freeValueSet (ValueSet *set);
+extern RC compileExpr (Expr *expr, Schema *schema, ExprProgram **program);
+extern RC evalProgram (ExprProgram *program, Record *record, int *result);
+extern RC evalProgramBatch (ExprProgram *program, char *tuples, int stride, int numTuples,
+			    unsigned char *selection);
+extern RC freeExprProgram (ExprProgram *program);
+extern RC compileFilter (Expr *expr, Schema *schema, ExprFilter **filter);
+extern RC evalFilterBatch (ExprFilter *filter, char *tuples, int stride, int numTuples,
+			   unsigned char *selection);
+extern RC evalFilterColumns (ExprFilter *filter, char *minipages, int capacity, int numTuples,
+			     unsigned char *selection);
+extern RC evalFilterSelected (ExprFilter *filter, char *minipages, int capacity, int numTuples,
+			      unsigned char *selection);
+extern RC freeExprFilter (ExprFilter *filter);
 extern void freeVal(Value *val);
 
 
@@ -54,7 +183,7 @@ extern void freeVal(Value *val);
       (_result)->v.intV = _input->v.intV;					\
       break;								\
     case DT_STRING:							\
-      (_result)->v.stringV = (char *) malloc(strlen(_input->v.stringV));	\
+      (_result)->v.stringV = (char *) malloc(strlen(_input->v.stringV) + 1);	\
       strcpy((_result)->v.stringV, _input->v.stringV);			\
       break;								\
     case DT_FLOAT:							\
@@ -69,24 +198,57 @@ extern void freeVal(Value *val);
 #define MAKE_BINOP_EXPR(_result,_left,_right,_optype)			\
     do {								\
       Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+      Expr *_l = _left, *_r = _right;					\
       _result = (Expr *) malloc(sizeof(Expr));				\
       _result->type = EXPR_OP;						\
       _result->expr.op = _op;						\
       _op->type = _optype;						\
       _op->args = (Expr **) malloc(2 * sizeof(Expr*));			\
-      _op->args[0] = _left;						\
-      _op->args[1] = _right;						\
+      _op->args[0] = _l;						\
+      _op->args[1] = _r;						\
+      _op->set = NULL;							\
     } while (0)
 
 #define MAKE_UNOP_EXPR(_result,_input,_optype)				\
   do {									\
     Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+    Expr *_in = _input;							\
     _result = (Expr *) malloc(sizeof(Expr));				\
     _result->type = EXPR_OP;						\
     _result->expr.op = _op;						\
     _op->type = _optype;						\
     _op->args = (Expr **) malloc(sizeof(Expr*));			\
-    _op->args[0] = _input;						\
+    _op->args[0] = _in;							\
+    _op->set = NULL;							\
+  } while (0)
+
+#define MAKE_BETWEEN_EXPR(_result,_input,_low,_high)			\
+  do {									\
+    Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+    Expr *_in = _input, *_l = _low, *_h = _high;				\
+    _result = (Expr *) malloc(sizeof(Expr));				\
+    _result->type = EXPR_OP;						\
+    _result->expr.op = _op;						\
+    _op->type = OP_BETWEEN;						\
+    _op->args = (Expr **) malloc(3 * sizeof(Expr*));			\
+    _op->args[0] = _in;							\
+    _op->args[1] = _l;							\
+    _op->args[2] = _h;							\
+    _op->set = NULL;							\
+  } while (0)
+
+// the values are copied into the set, they stay owned by the caller
+#define MAKE_IN_EXPR(_result,_input,_values,_numValues)			\
+  do {									\
+    Operator *_op = (Operator *) malloc(sizeof(Operator));		\
+    Expr *_in = _input;							\
+    _result = (Expr *) malloc(sizeof(Expr));				\
+    _result->type = EXPR_OP;						\
+    _result->expr.op = _op;						\
+    _op->type = OP_IN;							\
+    _op->args = (Expr **) malloc(sizeof(Expr*));			\
+    _op->args[0] = _in;							\
+    _op->set = createValueSet(_values, _numValues);			\
   } while (0)
 
 #define MAKE_ATTRREF(_result,_attr)					\
@@ -0,0 +1,656 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_mgr.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
+#include "dberror.h"
+
+
+// frames of the buffer pool of an open index.
+#define HASH_POOL_PAGES 1024
+
+// most hash bits the directory uses. A full bucket at this depth is not
+// split any more but gets overflow pages.
+#define HASH_MAX_DEPTH 20
+
+// page 0 of an index file holds the index information, the other pages are
+// buckets, overflow pages and the directory.
+#define HASH_META_PAGE 0
+
+// a bucket starts with this header, then its entries.
+typedef struct BucketHeader {
+	int localDepth;	// hash bits shared by all keys of the bucket
+	int numEntries;
+	int next;	// overflow page, NO_PAGE if none
+	int unused;
+} BucketHeader;
+
+// an entry of a bucket, followed by its key.
+typedef struct BucketEntry {
+	unsigned int hash;
+	RID id;
+} BucketEntry;
+
+// the index information stored in page 0.
+typedef struct HashMeta {
+	int keyType;
+	int keyLength;
+	int globalDepth;
+	int numBuckets;
+	int numEntries;
+	int numPages;
+	int dirPage;	// first page of the directory
+	int dirPages;	// pages reserved for the directory
+} HashMeta;
+
+// bookkeeping of an open index.
+typedef struct HashInfo {
+	BM_BufferPool *bm;
+	HashMeta meta;
+	int *directory;	// bucket of every value of the low globalDepth hash bits
+	int keySize;	// bytes of a key in an entry
+	int entrySize;	// bytes of an entry with its key
+	int capacity;	// entries of a bucket page
+	char *key;	// the key being searched, inserted or deleted
+} HashInfo;
+
+// a key of a batch insert, sorted by its reversed hash.
+typedef struct HashOrder {
+	unsigned int hash;
+	unsigned int reversed;
+	int key;	// position of the key in the batch
+} HashOrder;
+
+static RC createIndex(char *idxId, DataType keyType, int keyLength);
+static int keySizeOf(DataType keyType, int keyLength);
+static int entrySizeOf(int keySize);
+static RC serializeKey(HashInfo *info, DataType keyType, Value *key, char *result);
+static unsigned int hashOf(HashInfo *info, char *key);
+static BucketEntry *bucketEntry(HashInfo *info, char *page, int i);
+static void initBucket(char *page, int localDepth);
+static int findEntry(HashInfo *info, unsigned int hash, BM_PageHandle *h);
+static void insertEntry(HashInfo *info, unsigned int hash, RID rid);
+static unsigned int reverseBits(unsigned int hash);
+static int compareHashOrder(const void *a, const void *b);
+static void addEntry(HashInfo *info, char *page, unsigned int hash, RID rid);
+static void addOverflowEntry(HashInfo *info, BM_PageHandle *h, unsigned int hash, RID rid);
+static void doubleDirectory(HashInfo *info);
+static void splitBucket(HashInfo *info, BM_PageHandle *h, unsigned int hash);
+static void writeDirectory(HashInfo *info);
+static void writeMeta(HashInfo *info);
+
+
+/**
+ * create an index of int, float or bool keys.
+ * @param  idxId   name of the index file
+ * @param  keyType type of the keys
+ * @return         RC_OK | RC_RM_UNKOWN_DATATYPE
+ */
+RC createHashIndex (char *idxId, DataType keyType) {
+	if (keyType == DT_STRING) {
+		THROW(RC_RM_UNKOWN_DATATYPE, "string keys need a length, use createStringHashIndex");
+	}
+	return createIndex(idxId, keyType, 0);
+}
+
+/**
+ * create an index of strings of up to keyLength characters, longer keys are
+ * cut to keyLength.
+ * @param  idxId     name of the index file
+ * @param  keyLength characters of a key
+ * @return           RC_OK | RC_IM_N_TO_LAGE
+ */
+RC createStringHashIndex (char *idxId, int keyLength) {
+	return createIndex(idxId, DT_STRING, keyLength);
+}
+
+/**
+ * open an index. The directory is kept in memory while the index is open,
+ * the buckets are read and written through a buffer pool of
+ * HASH_POOL_PAGES frames.
+ * @param  index the opened index
+ * @param  idxId name of the index file
+ * @return       RC_OK | RC_FILE_NOT_FOUND
+ */
+RC openHashIndex (HashHandle **index, char *idxId) {
+	HashInfo *info = (HashInfo *)malloc(sizeof(HashInfo));
+	BM_PageHandle h;
+	int size, offset, page;
+
+	info->bm = MAKE_POOL();
+	if (initBufferPool(info->bm, idxId, HASH_POOL_PAGES, RS_LRU, NULL) != RC_OK) {
+		free(info->bm);
+		free(info);
+		THROW(RC_FILE_NOT_FOUND, "index file does not exist");
+	}
+	pinPage(info->bm, &h, HASH_META_PAGE);
+	memcpy(&info->meta, h.data, sizeof(HashMeta));
+	unpinPage(info->bm, &h);
+
+	size = (1 << info->meta.globalDepth) * sizeof(int);
+	info->directory = (int *)malloc(size);
+	for (offset = 0, page = info->meta.dirPage; offset < size; offset += PAGE_SIZE, page++) {
+		pinPage(info->bm, &h, page);
+		memcpy((char *)info->directory + offset, h.data, (size - offset < PAGE_SIZE) ? size - offset : PAGE_SIZE);
+		unpinPage(info->bm, &h);
+	}
+
+	info->keySize = keySizeOf(info->meta.keyType, info->meta.keyLength);
+	info->entrySize = entrySizeOf(info->keySize);
+	info->capacity = (PAGE_SIZE - sizeof(BucketHeader)) / info->entrySize;
+	info->key = (char *)malloc(info->keySize);
+
+	*index = (HashHandle *)malloc(sizeof(HashHandle));
+	(*index)->keyType = info->meta.keyType;
+	(*index)->idxId = idxId;
+	(*index)->mgmtData = info;
+	return RC_OK;
+}
+
+/**
+ * write the directory, the index information and every changed bucket, then
+ * release the index.
+ * @param  index HashHandle
+ * @return       RC_OK
+ */
+RC closeHashIndex (HashHandle *index) {
+	HashInfo *info = (HashInfo *)index->mgmtData;
+	RC rc;
+
+	writeDirectory(info);
+	writeMeta(info);
+	if ((rc = shutdownBufferPool(info->bm)) != RC_OK) {
+		return rc;
+	}
+	free(info->bm);
+	free(info->directory);
+	free(info->key);
+	free(info);
+	free(index);
+	return RC_OK;
+}
+
+RC deleteHashIndex (char *idxId) {
+	return destroyPageFile(idxId);
+}
+
+// access information about a hash index
+RC getHashNumBuckets (HashHandle *index, int *result) {
+	*result = ((HashInfo *)index->mgmtData)->meta.numBuckets;
+	return RC_OK;
+}
+
+RC getHashNumEntries (HashHandle *index, int *result) {
+	*result = ((HashInfo *)index->mgmtData)->meta.numEntries;
+	return RC_OK;
+}
+
+RC getHashGlobalDepth (HashHandle *index, int *result) {
+	*result = ((HashInfo *)index->mgmtData)->meta.globalDepth;
+	return RC_OK;
+}
+
+/**
+ * find the RID of a key. Only the bucket of the key and its overflow pages
+ * are read.
+ * @param  index  HashHandle
+ * @param  key    the key
+ * @param  result RID of the key
+ * @return        RC_OK | RC_IM_KEY_NOT_FOUND | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+RC findHashKey (HashHandle *index, Value *key, RID *result) {
+	HashInfo *info = (HashInfo *)index->mgmtData;
+	BM_PageHandle h;
+	int slot;
+	RC rc;
+
+	if ((rc = serializeKey(info, index->keyType, key, info->key)) != RC_OK) {
+		return rc;
+	}
+	if ((slot = findEntry(info, hashOf(info, info->key), &h)) < 0) {
+		return RC_IM_KEY_NOT_FOUND;
+	}
+	*result = bucketEntry(info, h.data, slot)->id;
+	unpinPage(info->bm, &h);
+	return RC_OK;
+}
+
+/**
+ * insert a key. A full bucket is split on the next hash bit, doubling the
+ * directory when the bucket already uses all of its bits.
+ * @param  index HashHandle
+ * @param  key   the key
+ * @param  rid   RID of the key
+ * @return       RC_OK | RC_IM_KEY_ALREADY_EXISTS | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+RC insertHashKey (HashHandle *index, Value *key, RID rid) {
+	HashInfo *info = (HashInfo *)index->mgmtData;
+	BM_PageHandle h;
+	unsigned int hash;
+	RC rc;
+
+	if ((rc = serializeKey(info, index->keyType, key, info->key)) != RC_OK) {
+		return rc;
+	}
+	hash = hashOf(info, info->key);
+	if (findEntry(info, hash, &h) >= 0) {
+		unpinPage(info->bm, &h);
+		return RC_IM_KEY_ALREADY_EXISTS;
+	}
+	insertEntry(info, hash, rid);
+	return RC_OK;
+}
+
+/**
+ * insert a batch of keys. The keys are inserted in the order of their hash
+ * bits from the lowest one up, so that the keys of a bucket follow each
+ * other and a bucket is read once per batch rather than once per key. Keys
+ * that exist are skipped, the other keys are inserted.
+ * @param  index   HashHandle
+ * @param  keys    the keys
+ * @param  rids    RID of every key
+ * @param  numKeys number of keys
+ * @return         RC_OK | RC_IM_KEY_ALREADY_EXISTS if a key was skipped | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+RC insertHashKeys (HashHandle *index, Value *keys, RID *rids, int numKeys) {
+	HashInfo *info = (HashInfo *)index->mgmtData;
+	char *serialized = (char *)malloc((size_t)numKeys * info->keySize);
+	HashOrder *order = (HashOrder *)malloc(sizeof(HashOrder) * numKeys);
+	BM_PageHandle h;
+	RC rc = RC_OK;
+	int i;
+
+	for (i = 0; i < numKeys && rc == RC_OK; i++) {
+		rc = serializeKey(info, index->keyType, &keys[i], serialized + (size_t)i * info->keySize);
+		order[i].hash = hashOf(info, serialized + (size_t)i * info->keySize);
+		order[i].reversed = reverseBits(order[i].hash);
+		order[i].key = i;
+	}
+	if (rc != RC_OK) {
+		free(serialized);
+		free(order);
+		return rc;
+	}
+	qsort(order, numKeys, sizeof(HashOrder), compareHashOrder);
+
+	for (i = 0; i < numKeys; i++) {
+		memcpy(info->key, serialized + (size_t)order[i].key * info->keySize, info->keySize);
+		if (findEntry(info, order[i].hash, &h) >= 0) {
+			unpinPage(info->bm, &h);
+			rc = RC_IM_KEY_ALREADY_EXISTS;
+			continue;
+		}
+		insertEntry(info, order[i].hash, rids[order[i].key]);
+	}
+	free(serialized);
+	free(order);
+	return rc;
+}
+
+/**
+ * delete a key. The last entry of its page takes its place; buckets are not
+ * merged and the directory does not shrink.
+ * @param  index HashHandle
+ * @param  key   the key
+ * @return       RC_OK | RC_IM_KEY_NOT_FOUND | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+RC deleteHashKey (HashHandle *index, Value *key) {
+	HashInfo *info = (HashInfo *)index->mgmtData;
+	BM_PageHandle h;
+	BucketHeader *header;
+	int slot;
+	RC rc;
+
+	if ((rc = serializeKey(info, index->keyType, key, info->key)) != RC_OK) {
+		return rc;
+	}
+	if ((slot = findEntry(info, hashOf(info, info->key), &h)) < 0) {
+		return RC_IM_KEY_NOT_FOUND;
+	}
+	header = (BucketHeader *)h.data;
+	header->numEntries--;
+	if (slot != header->numEntries) {
+		memcpy(bucketEntry(info, h.data, slot), bucketEntry(info, h.data, header->numEntries), info->entrySize);
+	}
+	markDirty(info->bm, &h);
+	unpinPage(info->bm, &h);
+	info->meta.numEntries--;
+	return RC_OK;
+}
+
+/**
+ * insert info->key, which is not in the index, see insertHashKey.
+ * @param info HashInfo
+ * @param hash hash of info->key
+ * @param rid  RID of the key
+ */
+static void insertEntry(HashInfo *info, unsigned int hash, RID rid) {
+	BM_PageHandle h;
+	BucketHeader *header;
+
+	info->meta.numEntries++;
+	for (;;) {
+		int bucket = info->directory[hash & ((1u << info->meta.globalDepth) - 1)];
+
+		pinPage(info->bm, &h, bucket);
+		header = (BucketHeader *)h.data;
+		if (header->numEntries < info->capacity) {
+			addEntry(info, h.data, hash, rid);
+			markDirty(info->bm, &h);
+			unpinPage(info->bm, &h);
+			return;
+		}
+		if (header->localDepth == HASH_MAX_DEPTH) {
+			addOverflowEntry(info, &h, hash, rid);
+			return;
+		}
+		if (header->localDepth == info->meta.globalDepth) {
+			doubleDirectory(info);
+		}
+		splitBucket(info, &h, hash);
+	}
+}
+
+// the bits of a hash in reverse order, sorting by them groups the keys of
+// every bucket whatever the depth of the directory.
+static unsigned int reverseBits(unsigned int hash) {
+	unsigned int result = 0;
+	int i;
+
+	for (i = 0; i < 32; i++) {
+		result = (result << 1) | (hash & 1);
+		hash >>= 1;
+	}
+	return result;
+}
+
+static int compareHashOrder(const void *a, const void *b) {
+	unsigned int x = ((const HashOrder *)a)->reversed, y = ((const HashOrder *)b)->reversed;
+	return (x > y) - (x < y);
+}
+
+/**
+ * create an index file with one empty bucket and a directory of one entry.
+ * @param  idxId     name of the index file
+ * @param  keyType   type of the keys
+ * @param  keyLength characters of a string key, 0 otherwise
+ * @return           RC_OK | RC_IM_N_TO_LAGE
+ */
+static RC createIndex(char *idxId, DataType keyType, int keyLength) {
+	int keySize = keySizeOf(keyType, keyLength);
+	BM_BufferPool *bm;
+	BM_PageHandle h;
+	HashMeta meta;
+	RC rc;
+
+	if (keySize < 1 || (PAGE_SIZE - (int)sizeof(BucketHeader)) / entrySizeOf(keySize) < 2) {
+		THROW(RC_IM_N_TO_LAGE, "a bucket has to hold at least 2 keys");
+	}
+
+	if ((rc = createPageFile(idxId)) != RC_OK) {
+		return rc;
+	}
+	bm = MAKE_POOL();
+	initBufferPool(bm, idxId, 3, RS_FIFO, NULL);
+
+	meta.keyType = keyType;
+	meta.keyLength = keyLength;
+	meta.globalDepth = 0;
+	meta.numBuckets = 1;
+	meta.numEntries = 0;
+	meta.numPages = 3;
+	meta.dirPage = 2;
+	meta.dirPages = 1;
+	pinPage(bm, &h, HASH_META_PAGE);
+	memset(h.data, 0, PAGE_SIZE);
+	memcpy(h.data, &meta, sizeof(HashMeta));
+	markDirty(bm, &h);
+	unpinPage(bm, &h);
+
+	pinPage(bm, &h, 1);
+	initBucket(h.data, 0);
+	markDirty(bm, &h);
+	unpinPage(bm, &h);
+
+	pinPage(bm, &h, meta.dirPage);
+	memset(h.data, 0, PAGE_SIZE);
+	((int *)h.data)[0] = 1;
+	markDirty(bm, &h);
+	unpinPage(bm, &h);
+
+	shutdownBufferPool(bm);
+	free(bm);
+	return RC_OK;
+}
+
+// bytes of a key of the given type in an entry.
+static int keySizeOf(DataType keyType, int keyLength) {
+	return (keyType == DT_STRING) ? keyLength : (int)sizeof(int);
+}
+
+// bytes of an entry, keys are padded so that every entry is int aligned.
+static int entrySizeOf(int keySize) {
+	return sizeof(BucketEntry) + (keySize + sizeof(int) - 1) / sizeof(int) * sizeof(int);
+}
+
+/**
+ * write a key the way it is stored in an entry. Equal keys give equal bytes:
+ * bools are 0 or 1, -0.0 is stored as 0.0 and strings are zero padded.
+ * @param  info    HashInfo
+ * @param  keyType type of the index
+ * @param  key     the key
+ * @param  result  receives keySize bytes
+ * @return         RC_OK | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+static RC serializeKey(HashInfo *info, DataType keyType, Value *key, char *result) {
+	float f;
+	int b;
+
+	if (key->dt != keyType) {
+		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "key has a different type than the index");
+	}
+	switch (keyType) {
+	case DT_INT:
+		memcpy(result, &key->v.intV, sizeof(int));
+		break;
+	case DT_FLOAT:
+		f = (key->v.floatV == 0) ? 0 : key->v.floatV;
+		memcpy(result, &f, sizeof(float));
+		break;
+	case DT_BOOL:
+		b = key->v.boolV ? 1 : 0;
+		memcpy(result, &b, sizeof(int));
+		break;
+	case DT_STRING:
+		strncpy(result, key->v.stringV, info->meta.keyLength);
+		break;
+	}
+	return RC_OK;
+}
+
+// FNV-1a over the key bytes, mixed so that the low bits used by the
+// directory depend on every byte.
+static unsigned int hashOf(HashInfo *info, char *key) {
+	unsigned int hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < info->keySize; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 16777619u;
+	}
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+static BucketEntry *bucketEntry(HashInfo *info, char *page, int i) {
+	return (BucketEntry *)(page + sizeof(BucketHeader) + i * info->entrySize);
+}
+
+static void initBucket(char *page, int localDepth) {
+	BucketHeader *header = (BucketHeader *)page;
+
+	memset(page, 0, PAGE_SIZE);
+	header->localDepth = localDepth;
+	header->numEntries = 0;
+	header->next = NO_PAGE;
+}
+
+/**
+ * find info->key in its bucket and the overflow pages of the bucket.
+ * @param  info HashInfo
+ * @param  hash hash of info->key
+ * @param  h    receives the pinned page holding the key if it is found
+ * @return      slot of the key in that page, -1 if it is not found
+ */
+static int findEntry(HashInfo *info, unsigned int hash, BM_PageHandle *h) {
+	int page = info->directory[hash & ((1u << info->meta.globalDepth) - 1)];
+	char *entry;
+	int i, numEntries;
+
+	while (page != NO_PAGE) {
+		pinPage(info->bm, h, page);
+		numEntries = ((BucketHeader *)h->data)->numEntries;
+		entry = h->data + sizeof(BucketHeader);
+		for (i = 0; i < numEntries; i++, entry += info->entrySize) {
+			if (((BucketEntry *)entry)->hash == hash
+					&& memcmp(entry + sizeof(BucketEntry), info->key, info->keySize) == 0) {
+				return i;
+			}
+		}
+		page = ((BucketHeader *)h->data)->next;
+		unpinPage(info->bm, h);
+	}
+	return -1;
+}
+
+// append info->key to a page that has room for it.
+static void addEntry(HashInfo *info, char *page, unsigned int hash, RID rid) {
+	BucketHeader *header = (BucketHeader *)page;
+	BucketEntry *entry = bucketEntry(info, page, header->numEntries++);
+
+	entry->hash = hash;
+	entry->id = rid;
+	memcpy(entry + 1, info->key, info->keySize);
+}
+
+/**
+ * add info->key to the first overflow page of a full bucket that has room,
+ * appending a new overflow page if none has.
+ * @param info HashInfo
+ * @param h    the pinned bucket, unpinned on return
+ * @param hash hash of info->key
+ * @param rid  RID of the key
+ */
+static void addOverflowEntry(HashInfo *info, BM_PageHandle *h, unsigned int hash, RID rid) {
+	BucketHeader *header = (BucketHeader *)h->data;
+	int next;
+
+	while (header->numEntries == info->capacity) {
+		if ((next = header->next) == NO_PAGE) {
+			next = header->next = info->meta.numPages++;
+			markDirty(info->bm, h);
+			unpinPage(info->bm, h);
+			pinPage(info->bm, h, next);
+			initBucket(h->data, HASH_MAX_DEPTH);
+		}
+		else {
+			unpinPage(info->bm, h);
+			pinPage(info->bm, h, next);
+		}
+		header = (BucketHeader *)h->data;
+	}
+	addEntry(info, h->data, hash, rid);
+	markDirty(info->bm, h);
+	unpinPage(info->bm, h);
+}
+
+// double the directory, both halves point to the same buckets.
+static void doubleDirectory(HashInfo *info) {
+	int size = 1 << info->meta.globalDepth;
+
+	info->directory = (int *)realloc(info->directory, 2 * size * sizeof(int));
+	memcpy(info->directory + size, info->directory, size * sizeof(int));
+	info->meta.globalDepth++;
+}
+
+/**
+ * split a full bucket on its next hash bit: entries with the bit set move to
+ * a new bucket and the directory entries with the bit set point to it.
+ * @param info HashInfo
+ * @param h    the pinned bucket, unpinned on return
+ * @param hash a hash of the bucket, its low localDepth bits select the
+ *             directory entries of the bucket
+ */
+static void splitBucket(HashInfo *info, BM_PageHandle *h, unsigned int hash) {
+	BucketHeader *header = (BucketHeader *)h->data;
+	unsigned int bit = 1u << header->localDepth;
+	unsigned int i, size = 1u << info->meta.globalDepth;
+	int newPage = info->meta.numPages++;
+	BM_PageHandle nh;
+	BucketEntry *entry;
+	int kept = 0, j;
+
+	pinPage(info->bm, &nh, newPage);
+	initBucket(nh.data, header->localDepth + 1);
+	for (j = 0; j < header->numEntries; j++) {
+		entry = bucketEntry(info, h->data, j);
+		if (entry->hash & bit) {
+			BucketHeader *newHeader = (BucketHeader *)nh.data;
+			memcpy(bucketEntry(info, nh.data, newHeader->numEntries++), entry, info->entrySize);
+		}
+		else {
+			if (kept != j) {
+				memcpy(bucketEntry(info, h->data, kept), entry, info->entrySize);
+			}
+			kept++;
+		}
+	}
+	header->numEntries = kept;
+	header->localDepth++;
+
+	for (i = (hash & (bit - 1)) | bit; i < size; i += bit << 1) {
+		info->directory[i] = newPage;
+	}
+	info->meta.numBuckets++;
+
+	markDirty(info->bm, &nh);
+	unpinPage(info->bm, &nh);
+	markDirty(info->bm, h);
+	unpinPage(info->bm, h);
+}
+
+// write the directory to its pages, moving it to the end of the file when
+// it outgrew them.
+static void writeDirectory(HashInfo *info) {
+	int size = (1 << info->meta.globalDepth) * sizeof(int);
+	int pages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	BM_PageHandle h;
+	int offset, page;
+
+	if (pages > info->meta.dirPages) {
+		info->meta.dirPage = info->meta.numPages;
+		info->meta.dirPages = pages;
+		info->meta.numPages += pages;
+	}
+	for (offset = 0, page = info->meta.dirPage; offset < size; offset += PAGE_SIZE, page++) {
+		pinPage(info->bm, &h, page);
+		memcpy(h.data, (char *)info->directory + offset, (size - offset < PAGE_SIZE) ? size - offset : PAGE_SIZE);
+		markDirty(info->bm, &h);
+		unpinPage(info->bm, &h);
+	}
+}
+
+static void writeMeta(HashInfo *info) {
+	BM_PageHandle h;
+
+	pinPage(info->bm, &h, HASH_META_PAGE);
+	memcpy(h.data, &info->meta, sizeof(HashMeta));
+	markDirty(info->bm, &h);
+	unpinPage(info->bm, &h);
+}
@@ -0,0 +1,32 @@
+#ifndef HASH_MGR_H
+#define HASH_MGR_H
+
+#include "dberror.h"
+#include "tables.h"
+
+// structure for accessing hash indexes
+typedef struct HashHandle {
+  DataType keyType;
+  char *idxId;
+  void *mgmtData;
+} HashHandle;
+
+// create, destroy, open, and close a hash index
+extern RC createHashIndex (char *idxId, DataType keyType);
+extern RC createStringHashIndex (char *idxId, int keyLength);
+extern RC openHashIndex (HashHandle **index, char *idxId);
+extern RC closeHashIndex (HashHandle *index);
+extern RC deleteHashIndex (char *idxId);
+
+// access information about a hash index
+extern RC getHashNumBuckets (HashHandle *index, int *result);
+extern RC getHashNumEntries (HashHandle *index, int *result);
+extern RC getHashGlobalDepth (HashHandle *index, int *result);
+
+// index access
+extern RC findHashKey (HashHandle *index, Value *key, RID *result);
+extern RC insertHashKey (HashHandle *index, Value *key, RID rid);
+extern RC insertHashKeys (HashHandle *index, Value *keys, RID *rids, int numKeys);
+extern RC deleteHashKey (HashHandle *index, Value *key);
+
+#endif // HASH_MGR_H
@@ -0,0 +1,78 @@
+#include <math.h>
+#include <string.h>
+
+#include "hll.h"
+
+/**
+ * 64 bit hash of some bytes: FNV-1a, mixed so every bit of the result
+ * depends on every byte.
+ * @param  data the bytes.
+ * @param  len  number of bytes.
+ * @return      the hash.
+ */
+unsigned long long hllHash(const char *data, int len) {
+	unsigned long long hash = 14695981039346656037ULL;
+	int i;
+
+	for (i = 0; i < len; i++) {
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ULL;
+	}
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+/**
+ * start counting with no value seen.
+ * @param hll the sketch.
+ */
+void hllInit(HyperLogLog *hll) {
+	memset(hll->registers, 0, HLL_REGISTERS);
+}
+
+/**
+ * count the value of a hash. The register of the top HLL_BITS bits keeps
+ * the longest run of leading zeros seen in the other bits, plus one.
+ * @param hll  the sketch.
+ * @param hash hash of the value, see hllHash.
+ */
+void hllAdd(HyperLogLog *hll, unsigned long long hash) {
+	unsigned int index = (unsigned int)(hash >> (64 - HLL_BITS));
+	unsigned long long rest = hash << HLL_BITS;
+	unsigned char rank = 1;
+
+	while (rank <= 64 - HLL_BITS && !(rest & (1ULL << 63))) {
+		rest <<= 1;
+		rank++;
+	}
+	if (rank > hll->registers[index]) {
+		hll->registers[index] = rank;
+	}
+}
+
+/**
+ * estimate the number of distinct values counted. Small counts, while
+ * registers are still empty, are estimated by linear counting.
+ * @param  hll the sketch.
+ * @return     the estimate.
+ */
+double hllEstimate(HyperLogLog *hll) {
+	double m = HLL_REGISTERS;
+	double sum = 0, estimate;
+	int i, empty = 0;
+
+	for (i = 0; i < HLL_REGISTERS; i++) {
+		sum += 1.0 / (double)(1ULL << hll->registers[i]);
+		empty += (hll->registers[i] == 0);
+	}
+	estimate = (0.7213 / (1 + 1.079 / m)) * m * m / sum;
+
+	if (estimate <= 2.5 * m && empty > 0) {
+		estimate = m * log(m / empty);
+	}
+	return estimate;
+}
@@ -0,0 +1,815 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "join_mgr.h"
+#include "record_mgr.h"
+#include "storage_mgr.h"
+#include "sort_mgr.h"
+#include "arena.h"
+#include "hll.h"
+
+// a hash join that does not fit into its memory splits both tables into at
+// most this many partitions.
+#define HASH_JOIN_MAX_PARTITIONS 256
+
+// a record of the build side in the hash table.
+typedef struct JoinEntry {
+	struct JoinEntry *next;		// entries in the order they were added
+	unsigned long long hash;	// hash of the key
+	RID id;
+	char tuple[];			// the key, then the record
+} JoinEntry;
+
+// the hash table is an array of slots with linear probing. A slot keeps the
+// upper half of the hash of its entry next to it, so a probe goes through
+// the slots of a few cache lines and reads only the entries that probably
+// hold its key.
+typedef struct JoinSlot {
+	unsigned int tag;
+	JoinEntry *entry;		// NULL for a free slot
+} JoinSlot;
+
+// the records of one side of a partition in a temporary page file. Every
+// page starts with the number of records on it, a record is its RID and
+// data.
+typedef struct SpillFile {
+	char *name;			// NULL once the file is deleted
+	SM_FileHandle fh;
+	char *page;			// the page being filled
+	int count;			// records on page
+	int numPages;			// pages written
+} SpillFile;
+
+// the state of a join starts with its type.
+typedef enum JoinType {
+	JOIN_HASH,
+	JOIN_MERGE
+} JoinType;
+
+typedef struct HashJoin {
+	JoinType type;
+	Schema *buildSchema;
+	Schema *probeSchema;
+	int buildAttr;
+	int probeAttr;
+	int keyLen;
+	int buildSize;			// bytes of a record of the build side
+	int probeSize;
+	size_t memory;
+	int done;
+
+	// the hash table of the build side or of a partition of it
+	Arena *arena;
+	JoinEntry *entries;
+	JoinEntry *lastEntry;
+	int numEntries;
+	size_t used;			// bytes of entries and slots
+	JoinSlot *slots;
+	unsigned long long mask;
+
+	// the probe record and the next slot to compare it with
+	char *probeKey;
+	char *probeData;
+	RID probeId;
+	unsigned int probeTag;
+	unsigned long long slot;
+	int probing;
+
+	// without partitions the probe side is scanned
+	RM_ScanHandle scan;
+	int scanning;
+	Record *scanRecord;
+
+	// with partitions it is read from the probe file of the partition
+	int numPartitions;
+	int partitionBits;
+	int partition;
+	SpillFile *buildFiles;
+	SpillFile *probeFiles;
+	char *page;
+	int pageNum;
+	int pageCount;
+	int recordNum;
+} HashJoin;
+
+typedef struct MergeJoin {
+	JoinType type;
+	RM_SortHandle left;
+	RM_SortHandle right;
+	int leftSize;			// bytes of a record of the left table
+	int rightSize;
+
+	// the next record of both sides, in the order of their keys
+	Record *leftRecord;
+	Record *rightRecord;
+	int haveLeft;
+	int haveRight;
+	char *leftKey;
+	int leftKeyLen;
+	char *rightKey;
+	int rightKeyLen;
+
+	// the left records with the key of groupKey, every one is its RID and
+	// data, and the next one to return with the right record
+	char *group;
+	int groupCount;
+	int groupCapacity;
+	char *groupKey;
+	int groupPos;
+	int matching;
+	int done;
+} MergeJoin;
+
+// bytes of an entry of the hash table, with its two slots.
+static size_t entrySize(HashJoin *hj) {
+	size_t size = sizeof(JoinEntry) + hj->keyLen + hj->buildSize;
+
+	return (size + 7) / 8 * 8 + 2 * sizeof(JoinSlot);
+}
+
+// records on a page of a spill file.
+static int spillRecords(int size) {
+	return (int)((PAGE_SIZE - sizeof(int)) / (sizeof(RID) + size));
+}
+
+/**
+ * copy the join attribute of a record into key. Strings are copied up to
+ * their terminator and zero padded, floats have one zero, so equal values
+ * always have equal bytes.
+ * @param schema Schema of the record.
+ * @param attr   the join attribute.
+ * @param data   the record data.
+ * @param key    receives keyLen bytes.
+ * @param keyLen size of a key.
+ */
+static void joinKey(Schema *schema, int attr, char *data, char *key, int keyLen) {
+	char *value = data + schema->attrOffsets[attr];
+	float f;
+
+	memset(key, 0, keyLen);
+	switch (schema->dataTypes[attr]) {
+		case DT_STRING:
+			strncpy(key, value, schema->attrSizes[attr] < keyLen ? schema->attrSizes[attr] : keyLen);
+			break;
+		case DT_FLOAT:
+			memcpy(&f, value, sizeof(float));
+			if (f == 0) {
+				f = 0;
+			}
+			memcpy(key, &f, sizeof(float));
+			break;
+		default:
+			memcpy(key, value, schema->attrSizes[attr]);
+			break;
+	}
+}
+
+// add a record of the build side to the entries, the slots are made once
+// all of them are added.
+static void addEntry(HashJoin *hj, RID id, char *key, unsigned long long hash, char *data) {
+	JoinEntry *entry = (JoinEntry *)arenaAlloc(hj->arena, sizeof(JoinEntry) + hj->keyLen + hj->buildSize);
+
+	entry->next = NULL;
+	entry->hash = hash;
+	entry->id = id;
+	memcpy(entry->tuple, key, hj->keyLen);
+	memcpy(entry->tuple + hj->keyLen, data, hj->buildSize);
+	if (hj->lastEntry == NULL) {
+		hj->entries = entry;
+	}
+	else {
+		hj->lastEntry->next = entry;
+	}
+	hj->lastEntry = entry;
+	hj->numEntries++;
+	hj->used += entrySize(hj);
+}
+
+// put every entry into a slot, the slots are at most half full.
+static RC buildSlots(HashJoin *hj) {
+	unsigned long long numSlots = 16;
+	JoinEntry *entry;
+
+	while (numSlots < 2 * (unsigned long long)hj->numEntries) {
+		numSlots *= 2;
+	}
+	if ((hj->slots = (JoinSlot *)calloc(numSlots, sizeof(JoinSlot))) == NULL) {
+		return RC_WRITE_FAILED;
+	}
+	hj->mask = numSlots - 1;
+
+	for (entry = hj->entries; entry != NULL; entry = entry->next) {
+		unsigned long long slot = entry->hash & hj->mask;
+
+		while (hj->slots[slot].entry != NULL) {
+			slot = (slot + 1) & hj->mask;
+		}
+		hj->slots[slot].tag = (unsigned int)(entry->hash >> 32);
+		hj->slots[slot].entry = entry;
+	}
+	return RC_OK;
+}
+
+// empty the hash table for the next partition.
+static void resetTable(HashJoin *hj) {
+	resetArena(hj->arena);
+	free(hj->slots);
+	hj->slots = NULL;
+	hj->entries = NULL;
+	hj->lastEntry = NULL;
+	hj->numEntries = 0;
+	hj->used = 0;
+}
+
+// add every record of the build side to the hash table. Stops as soon as
+// the table does not fit into the memory, fits tells whether it did.
+static RC buildTable(HashJoin *hj, RM_TableData *build, int *fits) {
+	RM_ScanHandle sc;
+	Record *record;
+	char *key = (char *)malloc(hj->keyLen);
+	RC rc = RC_OK;
+
+	if ((rc = startScan(build, &sc, NULL)) != RC_OK) {
+		free(key);
+		return rc;
+	}
+	*fits = 1;
+	createRecordInArena(&record, hj->buildSchema, getScanArena(&sc));
+	while (next(&sc, record) == RC_OK) {
+		joinKey(hj->buildSchema, hj->buildAttr, record->data, key, hj->keyLen);
+		addEntry(hj, record->id, key, hllHash(key, hj->keyLen), record->data);
+		if (hj->used > hj->memory) {
+			*fits = 0;
+			break;
+		}
+	}
+	closeScan(&sc);
+	free(key);
+	return rc;
+}
+
+// create the temporary file of one side of a partition, prefix is the name
+// of the files of the join.
+static RC openSpill(SpillFile *file, char *prefix, char side, int partition) {
+	RC rc;
+
+	file->name = (char *)malloc(strlen(prefix) + 16);
+	sprintf(file->name, "%s.%c%d", prefix, side, partition);
+	file->page = (char *)calloc(1, PAGE_SIZE);
+	file->count = 0;
+	file->numPages = 0;
+	if ((rc = createPageFile(file->name)) != RC_OK || (rc = openPageFile(file->name, &file->fh)) != RC_OK) {
+		free(file->name);
+		free(file->page);
+		file->name = NULL;
+		return rc;
+	}
+	return RC_OK;
+}
+
+// write the page being filled, if it has records.
+static RC flushSpill(SpillFile *file) {
+	RC rc;
+
+	if (file->count == 0) {
+		return RC_OK;
+	}
+	memcpy(file->page, &file->count, sizeof(int));
+	if ((rc = writeBlocks(file->numPages, 1, &file->fh, file->page)) != RC_OK) {
+		return rc;
+	}
+	file->numPages++;
+	file->count = 0;
+	return RC_OK;
+}
+
+// delete the temporary file of one side of a partition.
+static void dropSpill(SpillFile *file) {
+	if (file->name == NULL) {
+		return;
+	}
+	closePageFile(&file->fh);
+	destroyPageFile(file->name);
+	free(file->name);
+	free(file->page);
+	file->name = NULL;
+}
+
+// write every record of a table to the file of the partition of its key.
+static RC spillTable(HashJoin *hj, RM_TableData *rel, Schema *schema, int attr, int size, SpillFile *files) {
+	RM_ScanHandle sc;
+	Record *record;
+	char *key = (char *)malloc(hj->keyLen);
+	int perPage = spillRecords(size), p;
+	RC rc;
+
+	if ((rc = startScan(rel, &sc, NULL)) != RC_OK) {
+		free(key);
+		return rc;
+	}
+	createRecordInArena(&record, schema, getScanArena(&sc));
+	while (rc == RC_OK && next(&sc, record) == RC_OK) {
+		SpillFile *file;
+		char *pos;
+
+		joinKey(schema, attr, record->data, key, hj->keyLen);
+		file = &files[hllHash(key, hj->keyLen) >> (64 - hj->partitionBits)];
+		pos = file->page + sizeof(int) + file->count * (sizeof(RID) + size);
+		memcpy(pos, &record->id, sizeof(RID));
+		memcpy(pos + sizeof(RID), record->data, size);
+		if (++file->count == perPage) {
+			rc = flushSpill(file);
+		}
+	}
+	closeScan(&sc);
+	for (p = 0; p < hj->numPartitions && rc == RC_OK; p++) {
+		rc = flushSpill(&files[p]);
+	}
+	free(key);
+	return rc;
+}
+
+// split both tables into partitions small enough for the memory, as far as
+// their keys are spread evenly.
+static RC partitionTables(HashJoin *hj, RM_TableData *build, RM_TableData *probe) {
+	double needed = (double)getNumTuples(build) * entrySize(hj);
+	char *prefix = tempFileName(build->name, "join");
+	int p;
+	RC rc = RC_OK;
+
+	if (needed < 2.0 * hj->used) {
+		needed = 2.0 * hj->used;
+	}
+	resetTable(hj);
+	hj->partitionBits = 1;
+	while ((1 << hj->partitionBits) < HASH_JOIN_MAX_PARTITIONS
+			&& (double)(1 << hj->partitionBits) * hj->memory < 2 * needed) {
+		hj->partitionBits++;
+	}
+	hj->numPartitions = 1 << hj->partitionBits;
+	hj->buildFiles = (SpillFile *)calloc(hj->numPartitions, sizeof(SpillFile));
+	hj->probeFiles = (SpillFile *)calloc(hj->numPartitions, sizeof(SpillFile));
+
+	for (p = 0; p < hj->numPartitions && rc == RC_OK; p++) {
+		if ((rc = openSpill(&hj->buildFiles[p], prefix, 'b', p)) == RC_OK) {
+			rc = openSpill(&hj->probeFiles[p], prefix, 'p', p);
+		}
+	}
+	free(prefix);
+	if (rc != RC_OK || (rc = spillTable(hj, build, hj->buildSchema, hj->buildAttr, hj->buildSize, hj->buildFiles)) != RC_OK) {
+		return rc;
+	}
+	return spillTable(hj, probe, hj->probeSchema, hj->probeAttr, hj->probeSize, hj->probeFiles);
+}
+
+// build the hash table of a partition and start reading its probe file.
+static RC loadPartition(HashJoin *hj) {
+	SpillFile *file = &hj->buildFiles[hj->partition];
+	char *key = (char *)malloc(hj->keyLen);
+	int pageNum, i, count;
+	RC rc = RC_OK;
+
+	resetTable(hj);
+	for (pageNum = 0; pageNum < file->numPages && rc == RC_OK; pageNum++) {
+		if ((rc = readBlock(pageNum, &file->fh, hj->page)) != RC_OK) {
+			break;
+		}
+		memcpy(&count, hj->page, sizeof(int));
+		for (i = 0; i < count; i++) {
+			char *pos = hj->page + sizeof(int) + i * (sizeof(RID) + hj->buildSize);
+			RID id;
+
+			memcpy(&id, pos, sizeof(RID));
+			joinKey(hj->buildSchema, hj->buildAttr, pos + sizeof(RID), key, hj->keyLen);
+			addEntry(hj, id, key, hllHash(key, hj->keyLen), pos + sizeof(RID));
+		}
+	}
+	dropSpill(file);
+	free(key);
+
+	hj->pageNum = 0;
+	hj->pageCount = 0;
+	hj->recordNum = 0;
+	if (rc != RC_OK) {
+		return rc;
+	}
+	return buildSlots(hj);
+}
+
+// the next record of the probe side, RC_RM_NO_MORE_TUPLES at the end of
+// the probe side of the partition.
+static RC nextProbe(HashJoin *hj) {
+	unsigned long long hash;
+
+	// nothing can match an empty hash table
+	if (hj->numEntries == 0) {
+		return RC_RM_NO_MORE_TUPLES;
+	}
+
+	if (hj->scanning) {
+		if (next(&hj->scan, hj->scanRecord) != RC_OK) {
+			return RC_RM_NO_MORE_TUPLES;
+		}
+		hj->probeData = hj->scanRecord->data;
+		hj->probeId = hj->scanRecord->id;
+	}
+	else {
+		SpillFile *file = &hj->probeFiles[hj->partition];
+		char *pos;
+
+		while (hj->recordNum == hj->pageCount) {
+			if (hj->pageNum == file->numPages) {
+				return RC_RM_NO_MORE_TUPLES;
+			}
+			if (readBlock(hj->pageNum++, &file->fh, hj->page) != RC_OK) {
+				return RC_READ_NON_EXISTING_PAGE;
+			}
+			memcpy(&hj->pageCount, hj->page, sizeof(int));
+			hj->recordNum = 0;
+		}
+		pos = hj->page + sizeof(int) + hj->recordNum++ * (sizeof(RID) + hj->probeSize);
+		memcpy(&hj->probeId, pos, sizeof(RID));
+		hj->probeData = pos + sizeof(RID);
+	}
+
+	joinKey(hj->probeSchema, hj->probeAttr, hj->probeData, hj->probeKey, hj->keyLen);
+	hash = hllHash(hj->probeKey, hj->keyLen);
+	hj->probeTag = (unsigned int)(hash >> 32);
+	hj->slot = hash & hj->mask;
+	return RC_OK;
+}
+
+/**
+ * compare two sort keys. A key longer than the other, as of a longer
+ * string attribute, is larger only if its other bytes are not all zero.
+ * @return <0, 0 or >0 like memcmp.
+ */
+static int compareKeys(char *a, int aLen, char *b, int bLen) {
+	int len = (aLen < bLen) ? aLen : bLen, c, i;
+
+	if ((c = memcmp(a, b, len)) != 0) {
+		return c;
+	}
+	for (i = len; i < aLen; i++) {
+		if (a[i] != 0) {
+			return 1;
+		}
+	}
+	for (i = len; i < bLen; i++) {
+		if (b[i] != 0) {
+			return -1;
+		}
+	}
+	return 0;
+}
+
+// read the next left record.
+static RC advanceLeft(MergeJoin *mj) {
+	RC rc = nextSorted(&mj->left, mj->leftRecord);
+
+	mj->haveLeft = (rc == RC_OK);
+	if (rc == RC_OK) {
+		mj->leftKey = getSortKey(&mj->left, &mj->leftKeyLen);
+	}
+	return (rc == RC_RM_NO_MORE_TUPLES) ? RC_OK : rc;
+}
+
+// read the next right record.
+static RC advanceRight(MergeJoin *mj) {
+	RC rc = nextSorted(&mj->right, mj->rightRecord);
+
+	mj->haveRight = (rc == RC_OK);
+	if (rc == RC_OK) {
+		mj->rightKey = getSortKey(&mj->right, &mj->rightKeyLen);
+	}
+	return (rc == RC_RM_NO_MORE_TUPLES) ? RC_OK : rc;
+}
+
+// add the left record to the group.
+static void addToGroup(MergeJoin *mj) {
+	size_t size = sizeof(RID) + mj->leftSize;
+
+	if (mj->groupCount == mj->groupCapacity) {
+		mj->groupCapacity = (mj->groupCapacity > 0) ? mj->groupCapacity * 2 : 16;
+		mj->group = (char *)realloc(mj->group, size * mj->groupCapacity);
+	}
+	memcpy(mj->group + size * mj->groupCount, &mj->leftRecord->id, sizeof(RID));
+	memcpy(mj->group + size * mj->groupCount + sizeof(RID), mj->leftRecord->data, mj->leftSize);
+	mj->groupCount++;
+}
+
+// the next pair of a merge join: the left records of a key are collected in
+// the group, which is returned with every right record of the key.
+static RC nextMergeJoin(MergeJoin *mj, Record *leftRecord, Record *rightRecord) {
+	size_t size = sizeof(RID) + mj->leftSize;
+	RC rc;
+	int c;
+
+	while (!mj->done) {
+		if (mj->matching) {
+			if (mj->groupPos < mj->groupCount) {
+				char *entry = mj->group + size * mj->groupPos++;
+
+				memcpy(&leftRecord->id, entry, sizeof(RID));
+				memcpy(leftRecord->data, entry + sizeof(RID), mj->leftSize);
+				memcpy(&rightRecord->id, &mj->rightRecord->id, sizeof(RID));
+				memcpy(rightRecord->data, mj->rightRecord->data, mj->rightSize);
+				return RC_OK;
+			}
+			mj->matching = 0;
+			if ((rc = advanceRight(mj)) != RC_OK) {
+				return rc;
+			}
+		}
+		if (!mj->haveRight) {
+			break;
+		}
+
+		// the right record against the group
+		if (mj->groupCount > 0) {
+			c = compareKeys(mj->rightKey, mj->rightKeyLen, mj->groupKey, mj->leftKeyLen);
+			if (c == 0) {
+				mj->matching = 1;
+				mj->groupPos = 0;
+				continue;
+			}
+			if (c < 0) {
+				if ((rc = advanceRight(mj)) != RC_OK) {
+					return rc;
+				}
+				continue;
+			}
+			mj->groupCount = 0;
+		}
+
+		// go on with the side of the smaller key until both have the same
+		if (!mj->haveLeft) {
+			break;
+		}
+		c = compareKeys(mj->leftKey, mj->leftKeyLen, mj->rightKey, mj->rightKeyLen);
+		if (c != 0) {
+			if ((rc = (c < 0) ? advanceLeft(mj) : advanceRight(mj)) != RC_OK) {
+				return rc;
+			}
+			continue;
+		}
+		memcpy(mj->groupKey, mj->leftKey, mj->leftKeyLen);
+		do {
+			addToGroup(mj);
+			if ((rc = advanceLeft(mj)) != RC_OK) {
+				return rc;
+			}
+		} while (mj->haveLeft && memcmp(mj->leftKey, mj->groupKey, mj->leftKeyLen) == 0);
+	}
+	mj->done = 1;
+	return RC_RM_NO_MORE_TUPLES;
+}
+
+static void closeMergeJoin(MergeJoin *mj) {
+	closeSort(&mj->left);
+	closeSort(&mj->right);
+	if (mj->leftRecord != NULL) {
+		freeRecord(mj->leftRecord);
+	}
+	if (mj->rightRecord != NULL) {
+		freeRecord(mj->rightRecord);
+	}
+	free(mj->group);
+	free(mj->groupKey);
+	free(mj);
+}
+
+/**
+ * start a hash join of two tables on build.buildAttr = probe.probeAttr.
+ * The records of the build table, which should be the smaller one, go into
+ * a hash table in an arena of the join; the probe table is then scanned and
+ * every record looked up in it. If the hash table does not fit into memory
+ * bytes, both tables are split by the hash of their key into partitions in
+ * temporary page files (see setTempDirectory), and the partitions are
+ * joined one after the other (grace hash join). A partition that still
+ * does not fit, like one with many records of the same key, is joined in
+ * memory anyway. The tables must not be changed during the join.
+ * @param  join      RM_JoinHandle
+ * @param  build     the table the hash table is built from.
+ * @param  buildAttr its join attribute.
+ * @param  probe     the table looked up in the hash table.
+ * @param  probeAttr its join attribute.
+ * @param  memory    bytes of the hash table, 0 for HASH_JOIN_MEMORY.
+ * @return           RC_OK | RC_RM_NO_SUCH_ATTR | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC startHashJoin (RM_JoinHandle *join, RM_TableData *build, int buildAttr,
+		RM_TableData *probe, int probeAttr, size_t memory) {
+	HashJoin *hj;
+	int fits;
+	RC rc;
+
+	join->mgmtData = NULL;
+	if (buildAttr < 0 || buildAttr >= build->schema->numAttr || probeAttr < 0 || probeAttr >= probe->schema->numAttr) {
+		THROW(RC_RM_NO_SUCH_ATTR, "join attribute does not exist");
+	}
+	if (build->schema->dataTypes[buildAttr] != probe->schema->dataTypes[probeAttr]) {
+		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "join attributes of different datatypes");
+	}
+
+	hj = (HashJoin *)calloc(1, sizeof(HashJoin));
+	hj->type = JOIN_HASH;
+	hj->buildSchema = build->schema;
+	hj->probeSchema = probe->schema;
+	hj->buildAttr = buildAttr;
+	hj->probeAttr = probeAttr;
+	hj->keyLen = build->schema->attrSizes[buildAttr];
+	if (probe->schema->attrSizes[probeAttr] > hj->keyLen) {
+		hj->keyLen = probe->schema->attrSizes[probeAttr];
+	}
+	hj->buildSize = getRecordSize(build->schema);
+	hj->probeSize = getRecordSize(probe->schema);
+	hj->memory = (memory > 0) ? memory : HASH_JOIN_MEMORY;
+	hj->arena = createArena(0);
+	hj->probeKey = (char *)malloc(hj->keyLen);
+	hj->page = (char *)malloc(PAGE_SIZE);
+
+	join->build = build;
+	join->probe = probe;
+	join->mgmtData = hj;
+
+	if ((rc = buildTable(hj, build, &fits)) == RC_OK && fits) {
+		if ((rc = buildSlots(hj)) == RC_OK && (rc = startScan(probe, &hj->scan, NULL)) == RC_OK) {
+			hj->scanning = 1;
+			createRecordInArena(&hj->scanRecord, probe->schema, getScanArena(&hj->scan));
+		}
+	}
+	else if (rc == RC_OK && (rc = partitionTables(hj, build, probe)) == RC_OK) {
+		hj->partition = 0;
+		rc = loadPartition(hj);
+	}
+
+	if (rc != RC_OK) {
+		closeJoin(join);
+	}
+	return rc;
+}
+
+/**
+ * start a sort-merge join of two tables on left.leftAttr = right.rightAttr.
+ * Both tables are sorted on their join attribute with startSort, memory / 2
+ * bytes each, and read side by side; the left records of a key are kept in
+ * memory while the right records of the key are returned with them. The
+ * pairs come in the order of the key, which makes this join the one for
+ * ordered output and for tables far larger than memory. The tables must
+ * not be changed during the join.
+ * @param  join      RM_JoinHandle, build is the left table and probe the right one.
+ * @param  left      the left table.
+ * @param  leftAttr  its join attribute.
+ * @param  right     the right table.
+ * @param  rightAttr its join attribute.
+ * @param  memory    bytes of both sorts, 0 for 2 * SORT_MEMORY.
+ * @return           RC_OK | RC_RM_NO_SUCH_ATTR | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC startMergeJoin (RM_JoinHandle *join, RM_TableData *left, int leftAttr,
+		RM_TableData *right, int rightAttr, size_t memory) {
+	MergeJoin *mj;
+	RC rc;
+
+	join->mgmtData = NULL;
+	if (leftAttr < 0 || leftAttr >= left->schema->numAttr || rightAttr < 0 || rightAttr >= right->schema->numAttr) {
+		THROW(RC_RM_NO_SUCH_ATTR, "join attribute does not exist");
+	}
+	if (left->schema->dataTypes[leftAttr] != right->schema->dataTypes[rightAttr]) {
+		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "join attributes of different datatypes");
+	}
+
+	mj = (MergeJoin *)calloc(1, sizeof(MergeJoin));
+	mj->type = JOIN_MERGE;
+	mj->leftSize = getRecordSize(left->schema);
+	mj->rightSize = getRecordSize(right->schema);
+	mj->groupKey = (char *)malloc(left->schema->attrSizes[leftAttr]);
+	createRecord(&mj->leftRecord, left->schema);
+	createRecord(&mj->rightRecord, right->schema);
+
+	join->build = left;
+	join->probe = right;
+	join->mgmtData = mj;
+
+	memory = (memory > 0) ? memory / 2 : SORT_MEMORY;
+	if ((rc = startSort(&mj->left, left, &leftAttr, NULL, 1, memory)) == RC_OK
+			&& (rc = startSort(&mj->right, right, &rightAttr, NULL, 1, memory)) == RC_OK
+			&& (rc = advanceLeft(mj)) == RC_OK) {
+		rc = advanceRight(mj);
+	}
+
+	if (rc != RC_OK) {
+		closeJoin(join);
+	}
+	return rc;
+}
+
+/**
+ * the next pair of records with equal join attributes. Pairs of a hash
+ * join come in no particular order, those of a merge join in the order of
+ * their key.
+ * @param  join        RM_JoinHandle
+ * @param  buildRecord receives the record of the build table, made by createRecord.
+ * @param  probeRecord receives the record of the probe table, made by createRecord.
+ * @return             RC_OK | RC_RM_NO_MORE_TUPLES | RC_READ_NON_EXISTING_PAGE
+ */
+RC nextJoin (RM_JoinHandle *join, Record *buildRecord, Record *probeRecord) {
+	HashJoin *hj = (HashJoin *)join->mgmtData;
+	RC rc;
+
+	if (hj->type == JOIN_MERGE) {
+		return nextMergeJoin((MergeJoin *)join->mgmtData, buildRecord, probeRecord);
+	}
+	while (!hj->done) {
+		// go on with the slots of the probe record
+		if (hj->probing) {
+			for (; hj->slots[hj->slot].entry != NULL; hj->slot = (hj->slot + 1) & hj->mask) {
+				JoinSlot *slot = &hj->slots[hj->slot];
+
+				if (slot->tag == hj->probeTag && memcmp(slot->entry->tuple, hj->probeKey, hj->keyLen) == 0) {
+					memcpy(buildRecord->data, slot->entry->tuple + hj->keyLen, hj->buildSize);
+					buildRecord->id = slot->entry->id;
+					memcpy(probeRecord->data, hj->probeData, hj->probeSize);
+					probeRecord->id = hj->probeId;
+					hj->slot = (hj->slot + 1) & hj->mask;
+					return RC_OK;
+				}
+			}
+			hj->probing = 0;
+		}
+
+		if ((rc = nextProbe(hj)) == RC_OK) {
+			hj->probing = 1;
+			continue;
+		}
+		if (rc != RC_RM_NO_MORE_TUPLES) {
+			return rc;
+		}
+
+		// the probe side is done, go on with the next partition
+		if (hj->numPartitions == 0) {
+			hj->done = 1;
+			break;
+		}
+		dropSpill(&hj->probeFiles[hj->partition]);
+		if (++hj->partition == hj->numPartitions) {
+			resetTable(hj);
+			hj->done = 1;
+			break;
+		}
+		if ((rc = loadPartition(hj)) != RC_OK) {
+			return rc;
+		}
+	}
+	return RC_RM_NO_MORE_TUPLES;
+}
+
+/**
+ * end a join, deleting its temporary files.
+ * @param  join RM_JoinHandle
+ * @return      RC_OK
+ */
+RC closeJoin (RM_JoinHandle *join) {
+	HashJoin *hj = (HashJoin *)join->mgmtData;
+	int p;
+
+	if (hj == NULL) {
+		return RC_OK;
+	}
+	if (hj->type == JOIN_MERGE) {
+		closeMergeJoin((MergeJoin *)join->mgmtData);
+		join->mgmtData = NULL;
+		return RC_OK;
+	}
+	if (hj->scanning) {
+		closeScan(&hj->scan);
+	}
+	for (p = 0; p < hj->numPartitions; p++) {
+		if (hj->buildFiles != NULL) {
+			dropSpill(&hj->buildFiles[p]);
+		}
+		if (hj->probeFiles != NULL) {
+			dropSpill(&hj->probeFiles[p]);
+		}
+	}
+	free(hj->buildFiles);
+	free(hj->probeFiles);
+	free(hj->slots);
+	freeArena(hj->arena);
+	free(hj->probeKey);
+	free(hj->page);
+	free(hj);
+	join->mgmtData = NULL;
+	return RC_OK;
+}
+
+/**
+ * the number of partitions a join was split into.
+ * @param  join RM_JoinHandle
+ * @return      0 if the hash table fit into memory or for a merge join.
+ */
+int getJoinPartitions (RM_JoinHandle *join) {
+	HashJoin *hj = (HashJoin *)join->mgmtData;
+
+	return (hj->type == JOIN_HASH) ? hj->numPartitions : 0;
+}
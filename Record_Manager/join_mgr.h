@@ -0,0 +1,29 @@
+#ifndef JOIN_MGR_H
+#define JOIN_MGR_H
+
+#include <stddef.h>
+
+#include "dberror.h"
+#include "tables.h"
+
+// memory of a hash join when none is given, its hash table has to fit
+#define HASH_JOIN_MEMORY (64 << 20)
+
+// Bookkeeping for joins
+typedef struct RM_JoinHandle
+{
+  RM_TableData *build;
+  RM_TableData *probe;
+  void *mgmtData;
+} RM_JoinHandle;
+
+// equi-joins of two tables
+extern RC startHashJoin (RM_JoinHandle *join, RM_TableData *build, int buildAttr,
+			 RM_TableData *probe, int probeAttr, size_t memory);
+extern RC startMergeJoin (RM_JoinHandle *join, RM_TableData *left, int leftAttr,
+			  RM_TableData *right, int rightAttr, size_t memory);
+extern RC nextJoin (RM_JoinHandle *join, Record *buildRecord, Record *probeRecord);
+extern RC closeJoin (RM_JoinHandle *join);
+extern int getJoinPartitions (RM_JoinHandle *join);
+
+#endif // JOIN_MGR_H
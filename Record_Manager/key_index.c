@@ -0,0 +1,158 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "key_index.h"
+
+// FNV-1a over the key bytes.
+static unsigned int hashKey(char *key, int keySize) {
+	unsigned int hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < keySize; i++) {
+		hash ^= (unsigned char)key[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+// double the bucket array once there is more than one entry per bucket.
+static RC growKeyIndex(KeyIndex *index) {
+	unsigned int numBuckets = index->numBuckets * 2;
+	KeyEntry **buckets;
+	KeyEntry *entry, *next;
+	unsigned int i;
+
+	if ((buckets = (KeyEntry **)calloc(numBuckets, sizeof(KeyEntry *))) == NULL)
+		return RC_WRITE_FAILED;
+
+	for (i = 0; i < index->numBuckets; i++) {
+		for (entry = index->buckets[i]; entry != NULL; entry = next) {
+			next = entry->next;
+			entry->next = buckets[entry->hash & (numBuckets - 1)];
+			buckets[entry->hash & (numBuckets - 1)] = entry;
+		}
+	}
+
+	free(index->buckets);
+	index->buckets = buckets;
+	index->numBuckets = numBuckets;
+	return RC_OK;
+}
+
+/**
+ * create an empty index over keys of keySize bytes.
+ * @param  keySize size of a key in bytes.
+ * @return         the index, or NULL if out of memory.
+ */
+KeyIndex *createKeyIndex(int keySize) {
+	KeyIndex *index;
+
+	if ((index = (KeyIndex *)malloc(sizeof(KeyIndex))) == NULL)
+		return NULL;
+
+	index->keySize = keySize;
+	index->numEntries = 0;
+	index->numBuckets = KEY_INDEX_INITIAL_BUCKETS;
+	index->freeEntries = NULL;
+	index->buckets = (KeyEntry **)calloc(index->numBuckets, sizeof(KeyEntry *));
+	index->arena = createArena(0);
+	if (index->buckets == NULL || index->arena == NULL) {
+		freeKeyIndex(index);
+		return NULL;
+	}
+	return index;
+}
+
+/**
+ * add the key of the record at id. an existing entry for the same key is
+ * kept, so duplicates written without a key check stay visible.
+ * @param  index the index.
+ * @param  key   keySize bytes of key.
+ * @param  id    RID of the record.
+ * @return       RC_OK, or RC_WRITE_FAILED if out of memory.
+ */
+RC keyIndexInsert(KeyIndex *index, char *key, RID id) {
+	KeyEntry *entry;
+	unsigned int bucket;
+
+	if (index->numEntries >= (int)index->numBuckets && growKeyIndex(index) != RC_OK)
+		return RC_WRITE_FAILED;
+
+	if ((entry = index->freeEntries) != NULL)
+		index->freeEntries = entry->next;
+	else if ((entry = (KeyEntry *)arenaAlloc(index->arena, sizeof(KeyEntry) + index->keySize)) == NULL)
+		return RC_WRITE_FAILED;
+
+	entry->hash = hashKey(key, index->keySize);
+	entry->id = id;
+	memcpy(entry->key, key, index->keySize);
+
+	bucket = entry->hash & (index->numBuckets - 1);
+	entry->next = index->buckets[bucket];
+	index->buckets[bucket] = entry;
+	index->numEntries++;
+	return RC_OK;
+}
+
+/**
+ * remove the entry of key at id.
+ * @param  index the index.
+ * @param  key   keySize bytes of key.
+ * @param  id    RID of the record.
+ * @return       1 if the entry was removed, 0 if there was none.
+ */
+int keyIndexRemove(KeyIndex *index, char *key, RID id) {
+	unsigned int hash = hashKey(key, index->keySize);
+	KeyEntry **link = &index->buckets[hash & (index->numBuckets - 1)];
+	KeyEntry *entry;
+
+	for (; (entry = *link) != NULL; link = &entry->next) {
+		if (entry->hash == hash && entry->id.page == id.page && entry->id.slot == id.slot
+				&& memcmp(entry->key, key, index->keySize) == 0) {
+			*link = entry->next;
+			entry->next = index->freeEntries;
+			index->freeEntries = entry;
+			index->numEntries--;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * look up key.
+ * @param  index  the index.
+ * @param  key    keySize bytes of key.
+ * @param  except entry to ignore, e.g. the record being updated, or NULL.
+ * @param  result RID of the matching record if not NULL.
+ * @return        1 if the key is found, 0 otherwise.
+ */
+int keyIndexFind(KeyIndex *index, char *key, RID *except, RID *result) {
+	unsigned int hash = hashKey(key, index->keySize);
+	KeyEntry *entry;
+
+	for (entry = index->buckets[hash & (index->numBuckets - 1)]; entry != NULL; entry = entry->next) {
+		if (entry->hash != hash || memcmp(entry->key, key, index->keySize) != 0)
+			continue;
+		if (except != NULL && entry->id.page == except->page && entry->id.slot == except->slot)
+			continue;
+		if (result != NULL)
+			*result = entry->id;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * free the index and all of its entries.
+ * @param index the index, may be NULL.
+ */
+void freeKeyIndex(KeyIndex *index) {
+	if (index == NULL)
+		return;
+
+	free(index->buckets);
+	if (index->arena != NULL)
+		freeArena(index->arena);
+	free(index);
+}
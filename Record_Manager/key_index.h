@@ -0,0 +1,33 @@
+#ifndef __KEY_INDEX_H__
+#define __KEY_INDEX_H__
+
+#include "tables.h"
+#include "arena.h"
+
+#define KEY_INDEX_INITIAL_BUCKETS 1024
+
+// an in-memory hash index from the bytes of a composite key to the RIDs
+// holding it. the same key may be stored more than once.
+typedef struct KeyEntry {
+	struct KeyEntry *next;
+	unsigned int hash;
+	RID id;
+	char key[];
+} KeyEntry;
+
+typedef struct KeyIndex {
+	int keySize;
+	int numEntries;
+	unsigned int numBuckets;
+	KeyEntry **buckets;
+	KeyEntry *freeEntries;
+	Arena *arena;
+} KeyIndex;
+
+
+KeyIndex *createKeyIndex(int keySize);
+RC keyIndexInsert(KeyIndex *index, char *key, RID id);
+int keyIndexRemove(KeyIndex *index, char *key, RID id);
+int keyIndexFind(KeyIndex *index, char *key, RID *except, RID *result);
+void freeKeyIndex(KeyIndex *index);
+#endif
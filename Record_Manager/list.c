@@ -99,8 +99,10 @@ RC releaseList(List *l) {
 
 	while (current != NULL) {
 		next = current->next;
+		free(current->value);
 		free(current);
 		current = next;
 	}
+	free(l);
 	return RC_OK;
 }
@@ -0,0 +1,208 @@
+#include <string.h>
+
+#include "lz_codec.h"
+
+// positions of the last 4 bytes seen with every hash.
+#define LZ_HASH_BITS 12
+
+// the last bytes of a block are always literals and no match starts in the
+// bytes before them, as in LZ4.
+#define LZ_LAST_LITERALS 5
+#define LZ_MATCH_LIMIT 12
+
+// a search that finds no match moves on faster, one more byte for every
+// 2^LZ_SKIP_SHIFT bytes without one.
+#define LZ_SKIP_SHIFT 6
+
+static unsigned int read32(const unsigned char *p) {
+	unsigned int value;
+
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static int hash32(unsigned int value) {
+	return (int)((value * 2654435761u) >> (32 - LZ_HASH_BITS));
+}
+
+// the part of a length that does not fit into its half of the token, in
+// bytes of 255 and a last byte below it.
+static unsigned char *writeLength(unsigned char *op, int length) {
+	while (length >= 255) {
+		*op++ = 255;
+		length -= 255;
+	}
+	*op++ = (unsigned char)length;
+	return op;
+}
+
+// read the rest of a length written by writeLength, -1 past the input.
+static int readLength(const unsigned char **ip, const unsigned char *end, int length) {
+	unsigned char b;
+
+	do {
+		if (*ip >= end) {
+			return -1;
+		}
+		b = *(*ip)++;
+		length += b;
+	} while (b == 255);
+	return length;
+}
+
+// write a sequence, its match is left out if matchLength is 0. Returns the
+// end of the output, NULL if it does not fit.
+static unsigned char *writeSequence(unsigned char *op, unsigned char *end, const unsigned char *literals,
+		int literalLength, int offset, int matchLength) {
+	unsigned char *token = op++;
+
+	if (end - op < literalLength + literalLength / 255 + 1 + 2 + matchLength / 255 + 1) {
+		return NULL;
+	}
+	*token = (unsigned char)((literalLength >= 15 ? 15 : literalLength) << 4);
+	if (literalLength >= 15) {
+		op = writeLength(op, literalLength - 15);
+	}
+	memcpy(op, literals, literalLength);
+	op += literalLength;
+
+	if (matchLength > 0) {
+		*op++ = (unsigned char)(offset & 0xFF);
+		*op++ = (unsigned char)(offset >> 8);
+		matchLength -= LZ_MIN_MATCH;
+		*token |= (unsigned char)(matchLength >= 15 ? 15 : matchLength);
+		if (matchLength >= 15) {
+			op = writeLength(op, matchLength - 15);
+		}
+	}
+	return op;
+}
+
+// copy a match that may overlap the bytes it writes. Copies of 8 bytes may
+// write up to 7 bytes after it when there is room for them.
+static void copyMatch(unsigned char *op, const unsigned char *match, int length, unsigned char *end) {
+	int i;
+
+	if (op - match >= 8 && end - op >= length + 8) {
+		for (i = 0; i < length; i += 8) {
+			memcpy(op + i, match + i, 8);
+		}
+	}
+	else if (op - match >= length) {
+		memcpy(op, match, length);
+	}
+	else {
+		for (i = 0; i < length; i++) {
+			op[i] = match[i];
+		}
+	}
+}
+
+/**
+ * compress a block. Every 4 bytes are looked up in a hash table of the
+ * positions seen last; a match is grown backwards over the literals before
+ * it and forwards as far as it goes.
+ * @param  in       the block.
+ * @param  size     its length, up to LZ_MAX_OFFSET bytes are looked back.
+ * @param  out      receives the compressed block.
+ * @param  capacity bytes out can take, LZ_BOUND(size) is always enough.
+ * @return          length of the compressed block, -1 if it does not fit.
+ */
+int lzCompress(const char *in, int size, char *out, int capacity) {
+	const unsigned char *base = (const unsigned char *)in;
+	const unsigned char *ip = base, *anchor = base, *end = base + size;
+	const unsigned char *matchLimit = end - LZ_MATCH_LIMIT;
+	const unsigned char *matchEnd = end - LZ_LAST_LITERALS;
+	unsigned char *op = (unsigned char *)out, *opEnd = op + capacity;
+	int table[1 << LZ_HASH_BITS];
+
+	memset(table, 0xFF, sizeof(table));
+
+	while (size > LZ_MATCH_LIMIT && ip < matchLimit) {
+		unsigned int sequence = read32(ip);
+		int h = hash32(sequence);
+		int ref = table[h];
+		const unsigned char *match;
+		int length;
+
+		table[h] = (int)(ip - base);
+		if (ref < 0 || ip - base - ref > LZ_MAX_OFFSET || read32(base + ref) != sequence) {
+			ip += 1 + ((ip - anchor) >> LZ_SKIP_SHIFT);
+			continue;
+		}
+
+		match = base + ref;
+		while (ip > anchor && match > base && ip[-1] == match[-1]) {
+			ip--;
+			match--;
+		}
+		for (length = LZ_MIN_MATCH; ip + length < matchEnd && ip[length] == match[length]; length++)
+			;
+
+		if ((op = writeSequence(op, opEnd, anchor, (int)(ip - anchor), (int)(ip - match), length)) == NULL) {
+			return -1;
+		}
+		ip += length;
+		anchor = ip;
+
+		// the position two bytes back is likely the start of the next match
+		if (ip < matchLimit) {
+			table[hash32(read32(ip - 2))] = (int)(ip - 2 - base);
+		}
+	}
+
+	if ((op = writeSequence(op, opEnd, anchor, (int)(end - anchor), 0, 0)) == NULL) {
+		return -1;
+	}
+	return (int)(op - (unsigned char *)out);
+}
+
+/**
+ * decompress a block written by lzCompress. A block that is not well formed
+ * or does not fit is refused, it never makes the reads or writes leave in
+ * and out.
+ * @param  in       the compressed block.
+ * @param  size     its length.
+ * @param  out      receives the block.
+ * @param  capacity bytes out can take.
+ * @return          length of the block, -1 if it is not well formed.
+ */
+int lzDecompress(const char *in, int size, char *out, int capacity) {
+	const unsigned char *ip = (const unsigned char *)in, *ipEnd = ip + size;
+	unsigned char *base = (unsigned char *)out, *op = base, *opEnd = base + capacity;
+
+	while (ip < ipEnd) {
+		int token = *ip++;
+		int literalLength = token >> 4, matchLength = token & 15, offset;
+
+		if (literalLength == 15 && (literalLength = readLength(&ip, ipEnd, literalLength)) < 0) {
+			return -1;
+		}
+		if (literalLength > ipEnd - ip || literalLength > opEnd - op) {
+			return -1;
+		}
+		memcpy(op, ip, literalLength);
+		op += literalLength;
+		ip += literalLength;
+
+		// the last sequence has no match
+		if (ip == ipEnd) {
+			break;
+		}
+		if (ipEnd - ip < 2) {
+			return -1;
+		}
+		offset = ip[0] | (ip[1] << 8);
+		ip += 2;
+		if (matchLength == 15 && (matchLength = readLength(&ip, ipEnd, matchLength)) < 0) {
+			return -1;
+		}
+		matchLength += LZ_MIN_MATCH;
+		if (offset == 0 || offset > op - base || matchLength > opEnd - op) {
+			return -1;
+		}
+		copyMatch(op, op - offset, matchLength, opEnd);
+		op += matchLength;
+	}
+	return (int)(op - base);
+}
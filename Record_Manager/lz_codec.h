@@ -0,0 +1,15 @@
+#ifndef __LZ_CODEC_H__
+#define __LZ_CODEC_H__
+
+// a block compressor of the LZ77 family in the format of LZ4 blocks: a
+// sequence of literals followed by a match of at least LZ_MIN_MATCH bytes
+// up to LZ_MAX_OFFSET bytes back, the last sequence only has literals.
+#define LZ_MIN_MATCH 4
+#define LZ_MAX_OFFSET 65535
+
+// the most bytes size bytes can take compressed.
+#define LZ_BOUND(size) ((size) + (size) / 255 + 16)
+
+int lzCompress(const char *in, int size, char *out, int capacity);
+int lzDecompress(const char *in, int size, char *out, int capacity);
+#endif
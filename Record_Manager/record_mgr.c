@@ -6,6 +6,9 @@
 #include <errno.h>
 #include <sys/stat.h>
 #include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <math.h>
 
 #include "record_mgr.h"
 #include "storage_mgr.h"
@@ -17,16 +20,210 @@
 #include "expr.h"
 #include "rm_serializer.c"
 #include "list.h"
+#include "key_index.h"
+#include "hash_mgr.h"
+#include "hll.h"
+#include "zone_map.h"
+#include "column_codec.h"
 
 
+// number of pages bulkLoad fills in memory before writing them out at once.
+#define BULK_LOAD_PAGES 64
+
+// number of pages a thread of a parallel scan claims at once.
+#define SCAN_MORSEL_PAGES 16
+
+// number of recently read pages a shared scan keeps for the scans that
+// joined it.
+#define SHARED_SCAN_PAGES 256
+
+// how long a shared scan waits for a slower one to take a page before it
+// replaces the page anyway and stops waiting for the others.
+#define SHARED_SCAN_WAIT_MS 50
+
+// number of keys createKeyHash inserts into a hash index at once.
+#define KEY_HASH_BATCH (1 << 20)
+
+// frames of the buffer pool analyzeTable reads the sampled pages through.
+#define STATS_POOL_PAGES 16
+
+// records analyzeTable keeps from the sampled pages to build histograms and
+// estimate distinct values.
+#define STATS_SAMPLE_RECORDS 30000
+
+// buckets of the histogram of an attribute, halved until the statistics of
+// all attributes fit into the stats page.
+#define STATS_HISTOGRAM_BUCKETS 64
+
+// page 0 holds the table information, the tombstone list from
+// TABLE_TOMBSTONE_OFFSET on, the layout of the data pages and the primary
+// key attributes at its end. The entries of the tombstone list that do not
+// fit into page 0 go on in the pages of the tombstone file.
+#define TABLE_TOMBSTONE_OFFSET 1024
+#define TABLE_LAYOUT_OFFSET (PAGE_SIZE - 72)
+#define TABLE_KEYS_OFFSET (PAGE_SIZE - 64)
+
+// the minipages of a PAX data page start after the page header, aligned for
+// every datatype.
+#define PAX_PAGE_OFFSET 56
+
+// a compressed data page holds up to COMPRESSED_PAGE_RATIO times the slots
+// of a PAX page, as many as fit once its minipages are encoded. Its number
+// of slots is kept at PAGE_SLOTS_OFFSET, before its columns.
+#define COMPRESSED_PAGE_RATIO 16
+#define PAGE_SLOTS_OFFSET 52
+
 // Global configuration, used to set if using primaryKeyCheck.
 Config *config;
 
+// position of one record of a batch, used to group a batch by page.
+typedef struct BatchEntry {
+	RID id;
+	int index;
+} BatchEntry;
+
+// state shared by the threads of a parallel scan.
+typedef struct ParallelScan {
+	RM_TableData *rel;
+	Expr *cond;
+	ScanCallback callback;
+	BatchCallback batchCallback;	// instead of callback for a batch scan
+	void *context;
+	SM_FileHandle fh;
+	ZoneBounds *zoneBounds;		// see ScanInfo
+	ExprRange *ranges;		// see ScanInfo
+	atomic_int nextMorsel;		// next morsel of pages to claim
+} ParallelScan;
+
+// one thread of a parallel scan.
+typedef struct ScanWorker {
+	ParallelScan *scan;
+	int thread;
+	pthread_t id;
+	int started;
+	RC rc;
+} ScanWorker;
+
+// one pass over a table shared by the scans started with startSharedScan.
+// page p is kept in slot p % SHARED_SCAN_PAGES until another page takes
+// its place.
+typedef struct SharedScan {
+	char *name;				// the table file
+	struct SharedCursor *cursors;		// scans attached to the pass
+	int position;				// page read last, where a joining scan starts
+	pthread_mutex_t lock;
+	pthread_cond_t changed;			// signalled when a slot is read or taken
+	char *pages;
+	int pageNums[SHARED_SCAN_PAGES];	// page held by every slot, 0 for none
+	char loading[SHARED_SCAN_PAGES];	// the slot is being read
+	struct SharedScan *next;
+} SharedScan;
+
+// a scan attached to a shared pass, changed under the lock of the pass.
+typedef struct SharedCursor {
+	SharedScan *pass;
+	int page;				// next page the scan needs
+	int pagesLeft;				// pages it needs from page on
+	int lastPage;				// where it wraps around to page 1
+	int waits;				// it waits for slower scans
+	pthread_t thread;			// thread reading through the scan
+	struct SharedCursor *next;
+} SharedCursor;
+
+// records kept by an ORDER BY ... LIMIT scan. While the table is read, order
+// is a heap whose first record is the one dropped next; afterwards it is
+// sorted and next returns the records in its order.
+typedef struct TopRecords {
+	Schema *schema;
+	int attr;
+	int descending;
+	int k;
+	int count;
+	int next;				// position in order next returns
+	int slotLen;
+	char *records;				// k + 1 records, the one not in order is read into
+	double *keys;				// attr of every record unless it is a string
+	RID *ids;
+	int *order;
+	int spare;				// the record not in order
+} TopRecords;
+
+// a data page and the bound of its zone an ORDER BY ... LIMIT scan sorts by
+typedef struct ZonePage {
+	double key;
+	int page;
+} ZonePage;
+
+// the value of an attribute in a slot of a data page. A row page holds
+// slots of recordSize bytes after the page header, a PAX page a minipage
+// per attribute with its values of every slot from PAX_PAGE_OFFSET on. A
+// compressed page is read decoded into a PAX page of recordsPerPage slots.
+static inline char *slotAttr(Table_Header *tableHeader, Schema *schema, char *page, int slot, int attr) {
+	if (tableHeader->layout != LAYOUT_ROW) {
+		return page + PAX_PAGE_OFFSET + tableHeader->recordsPerPage * schema->attrOffsets[attr]
+			+ slot * schema->attrSizes[attr];
+	}
+	return page + 50 + slot * schema->recordSize + schema->attrOffsets[attr];
+}
+
+// passes in flight, at most one per table.
+static SharedScan *sharedScans = NULL;
+static pthread_mutex_t sharedScansLock = PTHREAD_MUTEX_INITIALIZER;
+
+static char *slotRecord(RM_TableData *rel, char *page, int slot, char *row);
+static void storeSlot(RM_TableData *rel, char *page, int slot, char *data);
+static void slotColumns(RM_TableData *rel, char *page, char **columns, int *strides);
+static void filterPage(RM_TableData *rel, ExprFilter *filter, char *page, int numSlots, unsigned char *selection);
+static int pageBufferSize(RM_TableData *rel);
+static int pageSlots(char *page);
+static RC readDataPage(RM_TableData *rel, SM_FileHandle *fh, int pageNum, char *page);
+static RC writeDataPage(RM_TableData *rel, SM_FileHandle *fh, int pageNum, char *page);
+static int decodeScanPage(RM_TableData *rel, char *raw, char *page, ExprRange *ranges, unsigned char *selection);
+static ExprRange *scanRanges(RM_TableData *rel, Expr *cond, Arena *arena);
+static void loadPageHeader(char *page, Page_Header *pageHeader);
+static void storePageHeader(RM_TableData *rel, Page_Header *pageHeader, char *page);
+static RC storeTableHeader(RM_TableData *rel, SM_FileHandle *fh, char *page);
+static RC loadBatchPage(RM_TableData *rel, SM_FileHandle *fh, int pageNum, char *page, Page_Header *pageHeader);
+static BatchEntry *sortBatch(RID *ids, Record **records, int num);
+static int conditionIsEmpty(Schema *schema, Expr *cond);
+static RC runParallelScan(RM_TableData *rel, Expr *cond, int nThreads, ScanCallback callback,
+		BatchCallback batchCallback, void *context);
+static void *parallelScanWorker(void *arg);
+static RC readScanPage(ScanInfo *scanInfo, int pageNum);
+static int pageNeeded(SharedScan *shared, SharedCursor *self, int pageNum);
+static void leaveSharedScan(SharedCursor *cursor);
+static void storeTableKeys(Schema *schema, char *page);
+static int loadTableKeys(char *page, int numAttr, int *keys);
+static void storeTableLayout(TableLayout layout, char *page);
+static TableLayout loadTableLayout(char *page);
+static KeyIndex *loadKeyIndex(RM_TableData *rel);
+static RC updateKeyIndex(RM_TableData *rel, char *oldData, char *newData, RID id, int check);
+static RC checkBatchKeys(RM_TableData *rel, Record **records, int numRecords);
+static RC updateBatchKeys(RM_TableData *rel, SM_FileHandle *fh, BatchEntry *entries, Record **records, int numRecords, char *page);
+static char *keyHashName(char *name);
+static void updateKeyHash(RM_TableData *rel, char *oldKey, char *newKey, RID id);
+static char *statsName(char *name);
+static TableStats *loadTableStats(RM_TableData *rel);
+static void freeTableStats(TableStats *stats);
+static char *zonesName(char *name);
+static void updateZoneMap(RM_TableData *rel, int pageNum, char *data);
+static ZoneBounds *scanZoneBounds(RM_TableData *rel, Expr *cond, Arena *arena);
+static void releaseScanFile(ScanInfo *scanInfo);
+static int compareTop(TopRecords *top, int a, int b);
+static void siftTop(TopRecords *top, int pos, int count);
+static void addTopRecord(TopRecords *top, RID id);
+static int *zonePageOrder(RM_TableData *rel, int zone, int descending, Arena *arena);
+static int compareZonePages(const void *a, const void *b);
+static char *tombstoneName(char *name);
+static RC storeTombstone(RM_TableData *rel, char *page);
+static List *loadTombstone(char *name, char *page);
+static RC checkDeletedBatch(Table_Header *tableHeader, BatchEntry *entries, int numIds);
+static void setDeletedSlot(Table_Header *tableHeader, RID id, int deleted);
+static inline int isDeletedSlot(Table_Header *tableHeader, RID id);
+
 // table and manager
 RC initRecordManager (void *mgmtData) {
-	Config *c = (Config *)malloc(sizeof(Config));
-	c = (Config *)mgmtData;
-	config = c;
+	config = (Config *)mgmtData;
   return RC_OK;
 }
 RC shutdownRecordManager () {
@@ -40,6 +237,22 @@ RC shutdownRecordManager () {
  * @return       	RC_OK;
  */
 RC createTable (char *name, Schema *schema) {
+	return createTableWithLayout(name, schema, LAYOUT_ROW);
+}
+
+/**
+ * create a table whose data pages have the given layout. A PAX page keeps
+ * the values of every attribute together in a minipage, so a scan or an
+ * aggregation that reads few attributes goes through contiguous arrays;
+ * records are still read and written whole. A compressed page encodes its
+ * minipages and holds as many slots as fit encoded; records of a
+ * compressed table are always appended, its deleted slots are not reused.
+ * @param  name   table file name
+ * @param  schema schema of record manager.
+ * @param  layout LAYOUT_ROW | LAYOUT_PAX | LAYOUT_COMPRESSED
+ * @return        RC_OK
+ */
+RC createTableWithLayout (char *name, Schema *schema, TableLayout layout) {
   RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
 	Page_Header *pageHeader = (Page_Header *)malloc(sizeof(Page_Header));
 
@@ -50,6 +263,14 @@ RC createTable (char *name, Schema *schema) {
   // initialize table header.
 	Table_Header *tableHeader = (Table_Header *)malloc(sizeof(Table_Header));
 	initTableManager(tableHeader, schema);
+	if (layout != LAYOUT_ROW) {
+		tableHeader->layout = layout;
+		tableHeader->recordsPerPage = (PAGE_SIZE - PAX_PAGE_OFFSET) / schemaLength(schema);
+		if (layout == LAYOUT_COMPRESSED) {
+			tableHeader->recordsPerPage *= COMPRESSED_PAGE_RATIO;
+		}
+		tableHeader->tableCapacity = (TOTAL_PAGES - 1) * tableHeader->recordsPerPage;
+	}
 
   // assign table header to mgmtData.
 	table->mgmtData = tableHeader;
@@ -58,13 +279,24 @@ RC createTable (char *name, Schema *schema) {
   // into page file via buffer manager.
   BM_BufferPool *bm = MAKE_POOL();
   BM_PageHandle *h = MAKE_PAGE_HANDLE();
-  SM_FileHandle fh;
 
   createPageFile(name);
   initBufferPool(bm, name, 5, RS_FIFO, NULL);
 
+	// a tombstone file left by an old table of the name is not read again.
+	char *tombstone = tombstoneName(name);
+	if (access(tombstone, F_OK) == 0) {
+		destroyPageFile(tombstone);
+	}
+	free(tombstone);
+
 	pinPage(bm, h, 0);
-	h->data = generateTableInfo(table);
+	char *tableInfo = generateTableInfo(table);
+	memset(h->data, 0, PAGE_SIZE);
+	memcpy(h->data, tableInfo, strlen(tableInfo));
+	storeTableKeys(schema, h->data);
+	storeTableLayout(layout, h->data);
+	free(tableInfo);
 	markDirty(bm, h);
 	unpinPage(bm, h);
 
@@ -74,7 +306,8 @@ RC createTable (char *name, Schema *schema) {
 	pinPage(bm, h, 1);
 
 	initPageHeader(table, pageHeader, 1);
-	h->data = generatePageHeader(table, pageHeader);
+	memset(h->data, 0, PAGE_SIZE);
+	storePageHeader(table, pageHeader, h->data);
 	markDirty(bm, h);
 	unpinPage(bm, h);
 
@@ -82,9 +315,11 @@ RC createTable (char *name, Schema *schema) {
 
   // free memeory.
 	free(h);
-  closePageFile(&fh);
+	free(bm);
 	free(table);
 	free(pageHeader);
+	free(tableHeader->lastAccessed);
+	free(tableHeader->freePointer);
 	free(tableHeader);
   return RC_OK;
 
@@ -109,14 +344,42 @@ RC openTable (RM_TableData *rel, char *name) {
 
   // initialize schema and table header by deserialize information stored in
   // the first page.
-	rel->schema = (Schema *)malloc(sizeof(Schema));
 	parseTableHeader(rel, ph);
 
-  List *l = deserializeTombstoneList(ph+100);
+  List *l = loadTombstone(name, ph);
 
 	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
   tableHeader->tombstone = l;
 	closePageFile(&fh);
+	free(ph);
+
+	// the deleted slots are looked up in a bitmap rather than in the list.
+	ListNode *node;
+	for (node = l->head; node != NULL; node = node->next) {
+		setDeletedSlot(tableHeader, *(RID *)node->value, 1);
+	}
+
+	// build the primary key index now rather than on the first insert.
+	if (config != NULL && config->primaryKeyCheck) {
+		loadKeyIndex(rel);
+	}
+
+	// open the hash index made by createKeyHash.
+	char *hashName = keyHashName(name);
+	if (access(hashName, F_OK) != 0 || openHashIndex(&tableHeader->keyHash, hashName) != RC_OK) {
+		free(hashName);
+	}
+
+	// load the statistics made by analyzeTable.
+	tableHeader->stats = loadTableStats(rel);
+
+	// load the zone map made by buildZoneMap, one not stored by closeTable
+	// may miss changes and is dropped.
+	char *zones = zonesName(name);
+	if ((tableHeader->zones = loadZoneMap(zones)) == NULL && access(zones, F_OK) == 0) {
+		destroyPageFile(zones);
+	}
+	free(zones);
 
 	return RC_OK;
 }
@@ -139,15 +402,30 @@ RC closeTable (RM_TableData *rel) {
   openPageFile(rel->name, &fh);
   readBlock(0, &fh, ph);
 
-  char *list = serializeTombstonList(tableHeader->tombstone);
-
-  memcpy(ph+100, list, strlen(list));
+  storeTombstone(rel, ph);
   writeBlock(0, &fh, ph);
   closePageFile(&fh);
+  free(ph);
 
   // close table and free memeory.
   freeSchema(rel->schema);
   releaseList(tableHeader->tombstone);
+  free(tableHeader->deletedSlots);
+  freeKeyIndex(tableHeader->keyIndex);
+  if (tableHeader->keyHash != NULL) {
+    char *hashName = tableHeader->keyHash->idxId;
+    closeHashIndex(tableHeader->keyHash);
+    free(hashName);
+  }
+  freeTableStats(tableHeader->stats);
+  if (tableHeader->zones != NULL) {
+    char *zones = zonesName(rel->name);
+    storeZoneMap(tableHeader->zones, zones, 1);
+    freeZoneMap(tableHeader->zones);
+    free(zones);
+  }
+  free(tableHeader->lastAccessed);
+  free(tableHeader->freePointer);
   free(rel->mgmtData);
 
   return RC_OK;
@@ -160,6 +438,30 @@ RC closeTable (RM_TableData *rel) {
  */
 RC deleteTable (char *name) {
   destroyPageFile(name);
+
+  char *hashName = keyHashName(name);
+  if (access(hashName, F_OK) == 0) {
+    deleteHashIndex(hashName);
+  }
+  free(hashName);
+
+  char *stats = statsName(name);
+  if (access(stats, F_OK) == 0) {
+    destroyPageFile(stats);
+  }
+  free(stats);
+
+  char *zones = zonesName(name);
+  if (access(zones, F_OK) == 0) {
+    destroyPageFile(zones);
+  }
+  free(zones);
+
+  char *tombstone = tombstoneName(name);
+  if (access(tombstone, F_OK) == 0) {
+    destroyPageFile(tombstone);
+  }
+  free(tombstone);
   return RC_OK;
 }
 
@@ -196,6 +498,12 @@ RC insertRecord (RM_TableData *rel, Record *record) {
 		}
 	}
 
+	// a compressed page only takes records at its end.
+	if (tableHeader->layout == LAYOUT_COMPRESSED) {
+		free(rid);
+		return bulkLoad(rel, &record, 1);
+	}
+
 	SM_FileHandle fh;
 	SM_PageHandle ph;
 	ph = (SM_PageHandle) malloc(PAGE_SIZE);
@@ -208,6 +516,9 @@ RC insertRecord (RM_TableData *rel, Record *record) {
 		RID *id = (RID *)node->value;
 		rid->page = id->page;
 		rid->slot = id->slot;
+		setDeletedSlot(tableHeader, *id, 0);
+		free(id);
+		free(node);
 
 		insertIntoTombstone = 1;
 	}
@@ -217,33 +528,16 @@ RC insertRecord (RM_TableData *rel, Record *record) {
 		rid->slot = freePointer->slot;
 	}
 
-	int offset = 50 + (rid->slot) * (schemaLength(rel->schema));
-
-  // serialize the record with separator defined as "&".
+  // write the record into its slot.
 	openPageFile(rel->name, &fh);
 	readBlock(rid->page, &fh, ph);
-	Value *value;
-  VarString *result;
-  MAKE_VARSTRING(result);
-
-
-	for (i = 0; i < rel->schema->numAttr; i++) {
-		getAttr(record, rel->schema, i, &value);
-
-		APPEND(result, "%s&", serializeValue(value));
-	}
-	freeVal(value);
-
-  // find the offset of the record and copy it to that place.
-	memcpy(ph+offset, result->buf, strlen(result->buf));
+	storeSlot(rel, ph, rid->slot, record->data);
+	updateZoneMap(rel, rid->page, record->data);
 
 	// after a new record has been added, we increase the recordCount by 1 and
 	// update the page header;
 	Page_Header *updatedHeader = (Page_Header *)malloc(sizeof(Page_Header));
-	char *header = (char *)malloc(sizeof(char) * 50);
-	//
-	memcpy(header, ph, 50);
-	deserializePageHeader(header, updatedHeader);
+	loadPageHeader(ph, updatedHeader);
 
 	updatedHeader->recordCount++;
 
@@ -269,12 +563,11 @@ RC insertRecord (RM_TableData *rel, Record *record) {
 			Page_Header *pageHeader = (Page_Header *)malloc(sizeof(Page_Header));
 
 			initPageHeader(rel, pageHeader, freePointer->page);
-			char *s;
-			s = generatePageHeader(rel, pageHeader);
+			memset(ph, 0, PAGE_SIZE);
+			storePageHeader(rel, pageHeader, ph);
 			ensureCapacity(freePointer->page, &fh);
-			writeBlock(freePointer->page, &fh, s);
+			writeBlock(freePointer->page, &fh, ph);
 			free(pageHeader);
-			free(s);
 
 		}
 	}
@@ -290,38 +583,184 @@ RC insertRecord (RM_TableData *rel, Record *record) {
 	writeBlock(0, &fh, ph);
 
 	record->id = *rid;
+	updateKeyIndex(rel, NULL, record->data, record->id, 0);
 
 	closePageFile(&fh);
-	// free(rid);
-	// free(updatedHeader);
-	// free(updatedHeaderStr);
-	// free(header);
-	// free(tableHeaderStr);
-	// free(ph);
+	free(rid);
+	free(tableHeaderStr);
+	free(ph);
   return RC_OK;
 }
 
+/**
+ * Load many records at once. Instead of reopening the page file and
+ * rewriting the data page and page 0 for every record as insertRecord does,
+ * whole pages are filled in memory and written with large sequential writes,
+ * and the table header is written once at the end.
+ *
+ * Records are appended after the last used slot; slots in the tombstone list
+ * are not reused and the primary key check is not applied. A page of a
+ * compressed table is filled decoded and encoded once no further record
+ * fits; a sizer follows what its columns take encoded as records are added.
+ * @param  rel        RM_TableData
+ * @param  records    records to load, their ids are assigned on return.
+ * @param  numRecords number of records.
+ * @return            RC_OK | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC bulkLoad (RM_TableData *rel, Record **records, int numRecords) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	RID *freePointer = tableHeader->freePointer;
+	int compressed = tableHeader->layout == LAYOUT_COMPRESSED;
+	PageSizer *sizer = NULL;
+	Page_Header pageHeader;
+	SM_FileHandle fh;
+	RC rc;
+	int i;
+
+	if (numRecords <= 0) {
+		return RC_OK;
+	}
+
+	if ((rc = openPageFile(rel->name, &fh)) != RC_OK) {
+		return rc;
+	}
+
+	// 'pages' buffers the pages from 'firstPage' on as they are written,
+	// 'page' is the one being filled, apart from them if it is compressed.
+	char *pages = (char *)calloc(BULK_LOAD_PAGES, PAGE_SIZE);
+	char *page = compressed ? (char *)calloc(1, pageBufferSize(rel)) : pages;
+	char *row = (char *)malloc(schemaLength(rel->schema));
+	int firstPage = freePointer->page;
+	int bufferedPages = 1;
+
+	// continue the page the free pointer points into if it already has records.
+	if (freePointer->slot > 0) {
+		readDataPage(rel, &fh, firstPage, page);
+		loadPageHeader(page, &pageHeader);
+	}
+	else {
+		initPageHeader(rel, &pageHeader, firstPage);
+	}
+	if (compressed) {
+		sizer = createPageSizer(rel->schema, tableHeader->recordsPerPage);
+		for (i = 0; i < freePointer->slot; i++) {
+			pageSizerAdd(sizer, slotRecord(rel, page, i, row));
+		}
+	}
+
+	for (i = 0; i <= numRecords; i++) {
+		// a page is full after its last slot, a compressed one also when the
+		// record does not fit encoded. The next page is started even if no
+		// record is left for it.
+		int full = freePointer->slot > tableHeader->recordsPerPage - 1;
+
+		if (compressed && i < numRecords && pageSizerAdd(sizer, records[i]->data) > PAGE_SIZE - PAX_PAGE_OFFSET
+				&& freePointer->slot > 0) {
+			full = 1;
+		}
+		if (full) {
+			// start the next page (flushing the buffer if needed).
+			pageHeader.isFull = 1;
+			storePageHeader(rel, &pageHeader, page);
+			if (compressed) {
+				memcpy(pages + (bufferedPages - 1) * PAGE_SIZE, page, PAX_PAGE_OFFSET);
+				encodeColumns(rel->schema, page + PAX_PAGE_OFFSET, tableHeader->recordsPerPage, freePointer->slot,
+					pages + (bufferedPages - 1) * PAGE_SIZE + PAX_PAGE_OFFSET, PAGE_SIZE - PAX_PAGE_OFFSET);
+				memset(page, 0, pageBufferSize(rel));
+				resetPageSizer(sizer);
+				if (i < numRecords) {
+					pageSizerAdd(sizer, records[i]->data);
+				}
+			}
+			freePointer->slot = 0;
+			freePointer->page++;
+
+			if (bufferedPages == BULK_LOAD_PAGES) {
+				if ((rc = writeBlocks(firstPage, bufferedPages, &fh, pages)) != RC_OK) {
+					break;
+				}
+				memset(pages, 0, BULK_LOAD_PAGES * PAGE_SIZE);
+				firstPage += bufferedPages;
+				bufferedPages = 0;
+			}
+			if (!compressed) {
+				page = pages + bufferedPages * PAGE_SIZE;
+			}
+			bufferedPages++;
+			initPageHeader(rel, &pageHeader, freePointer->page);
+		}
+		if (i == numRecords) {
+			break;
+		}
+
+		storeSlot(rel, page, freePointer->slot, records[i]->data);
+		updateZoneMap(rel, freePointer->page, records[i]->data);
+		records[i]->id.page = freePointer->page;
+		records[i]->id.slot = freePointer->slot;
+		pageHeader.recordCount++;
+		freePointer->slot++;
+	}
+
+	// write the remaining pages, including the (possibly empty) page the free
+	// pointer now points into.
+	if (rc == RC_OK) {
+		storePageHeader(rel, &pageHeader, page);
+		if (compressed) {
+			memcpy(pages + (bufferedPages - 1) * PAGE_SIZE, page, PAX_PAGE_OFFSET);
+			encodeColumns(rel->schema, page + PAX_PAGE_OFFSET, tableHeader->recordsPerPage, freePointer->slot,
+				pages + (bufferedPages - 1) * PAGE_SIZE + PAX_PAGE_OFFSET, PAGE_SIZE - PAX_PAGE_OFFSET);
+		}
+		rc = writeBlocks(firstPage, bufferedPages, &fh, pages);
+	}
+
+	// update table header once.
+	if (rc == RC_OK) {
+		tableHeader->pageCount = freePointer->page;
+		tableHeader->totalRecordCount += numRecords;
+		rc = storeTableHeader(rel, &fh, pages);
+	}
+
+	for (i = 0; i < numRecords && rc == RC_OK; i++) {
+		updateKeyIndex(rel, NULL, records[i]->data, records[i]->id, 0);
+	}
+
+	closePageFile(&fh);
+	if (compressed) {
+		freePageSizer(sizer);
+		free(page);
+	}
+	free(pages);
+	free(row);
+	return rc;
+}
+
 /**
  * delete a record
  * @param  rel RM_TableData
  * @param  id  the id of the record needs to be deleted.
- * @return     RC_OK
+ * @return     RC_OK | RC_TUPLE_NOT_FOUND
  */
 RC deleteRecord (RM_TableData *rel, RID id) {
   // define r;
   // getRecord(rel, id, r);
   // mark r as deleted.
   Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+
+	// a record deleted already stays deleted.
+	if (isDeletedSlot(tableHeader, id)) {
+		return RC_TUPLE_NOT_FOUND;
+	}
 	RID *tstone_id = (RID *)malloc(sizeof(RID));
 	tstone_id->page = id.page;
 	tstone_id->slot = id.slot;
 	tableHeader->totalRecordCount--;
 	if (insert(tableHeader->tombstone, tstone_id) == 0 ) {
+		setDeletedSlot(tableHeader, id, 1);
 
 		// update tombstone stored in table file.
 		SM_FileHandle fh;
 		SM_PageHandle ph;
-		ph = (SM_PageHandle) malloc(PAGE_SIZE);
+		ph = (SM_PageHandle) malloc(pageBufferSize(rel));
 		openPageFile(rel->name, &fh);
 		readBlock(0, &fh, ph);
 		char *tableHeaderStr = generateTableInfo(rel);
@@ -330,20 +769,20 @@ RC deleteRecord (RM_TableData *rel, RID id) {
 
 		// update page header by decrease recordCount by 1.
 		Page_Header *updatedHeader = (Page_Header *)malloc(sizeof(Page_Header));
-		char *header = (char *)malloc(sizeof(char) * 50);
 
-		readBlock(id.page, &fh, ph);
-		memcpy(header, ph, 50);
-		deserializePageHeader(header, updatedHeader);
+		char *row = (char *)malloc(schemaLength(rel->schema));
+		readDataPage(rel, &fh, id.page, ph);
+		loadPageHeader(ph, updatedHeader);
+		updateKeyIndex(rel, slotRecord(rel, ph, id.slot, row), NULL, id, 0);
+		free(row);
 
 		updatedHeader->recordCount--;
 		char *updatedHeaderStr = generatePageHeader(rel, updatedHeader);
 		memcpy(ph, updatedHeaderStr, strlen(updatedHeaderStr));
-		writeBlock(id.page, &fh, ph);
+		writeDataPage(rel, &fh, id.page, ph);
 		closePageFile(&fh);
 
 		free(updatedHeader);
-		free(header);
 
 		return RC_OK;
 	}
@@ -351,55 +790,291 @@ RC deleteRecord (RM_TableData *rel, RID id) {
 }
 
 /**
- * update a particular record.
+ * update a particular record. If primary key checking is on, a new key held
+ * by another record is refused. A record of a compressed page is not
+ * changed if the page no longer fits encoded with it.
  * @param  rel    RM_TableData
  * @param  record the new record.
- * @return        RC_OK;
+ * @return        RC_OK | RC_DUPLICATED_PRIMARYKEY | RC_RM_PAGE_FULL
  */
 RC updateRecord (RM_TableData *rel, Record *record) {
   // define a new r;
-	Record *r = (Record *)malloc(sizeof(Record));
+	Record *r;
+	createRecord(&r, rel->schema);
 
 
 	// get the record that needs to be updated.
 	getRecord(rel, record->id, r);
-	Value *value;
-	VarString *result;
-	MAKE_VARSTRING(result);
+	Value value;
+	RC rc;
 
 	int i;
 
-	// update each column.
-	for (i = 0; i < rel->schema->numAttr; i++) {
-		getAttr(record, rel->schema, i, &value);
-		setAttr(r, rel->schema, i, value);
-		freeVal(value);
+	// the new key must not be held by another record.
+	if ((rc = updateKeyIndex(rel, r->data, record->data, record->id, 1)) != RC_OK) {
+		freeRecord(r);
+		return rc;
 	}
 
-	// serialize record.
+	// update each column.
 	for (i = 0; i < rel->schema->numAttr; i++) {
-		getAttr(r, rel->schema, i, &value);
-		APPEND(result, "%s&", serializeValue(value));
-		freeVal(value);
+		getAttrInto(record, rel->schema, i, &value);
+		setAttr(r, rel->schema, i, &value);
 	}
 
 	// write changes to table file.
 	SM_FileHandle fh;
 	SM_PageHandle ph;
-	ph = (SM_PageHandle) malloc(PAGE_SIZE);
+	ph = (SM_PageHandle) malloc(pageBufferSize(rel));
 	openPageFile(rel->name, &fh);
-	int offset = 50 + (record->id.slot) * (schemaLength(rel->schema));
-	readBlock(record->id.page, &fh, ph);
-	strncpy(ph+offset, result->buf, schemaLength(rel->schema));
-	writeBlock(record->id.page, &fh, ph);
+	readDataPage(rel, &fh, record->id.page, ph);
+	storeSlot(rel, ph, record->id.slot, r->data);
+	if ((rc = writeDataPage(rel, &fh, record->id.page, ph)) == RC_OK) {
+		updateZoneMap(rel, record->id.page, r->data);
+	}
+	else {
+		getRecord(rel, record->id, r);
+		updateKeyIndex(rel, record->data, r->data, record->id, 0);
+	}
 
 	// close table file and free memory.
 	closePageFile(&fh);
 	free(ph);
-	FREE_VARSTRING(result);
-	free(r);
+	freeRecord(r);
 
-	return RC_OK;
+	return rc;
+}
+
+/**
+ * Insert a batch of records. Slots are assigned like insertRecord does
+ * (deleted slots from the tombstone first, then the free pointer), then the
+ * batch is grouped by page so that every page is read and written once, and
+ * the table header is written once for the whole batch.
+ *
+ * If primary key checking is on, nothing is inserted when any record of the
+ * batch has a duplicated key.
+ * @param  rel        RM_TableData
+ * @param  records    records to insert, their ids are assigned on return.
+ * @param  numRecords number of records.
+ * @return            RC_OK | RC_DUPLICATED_PRIMARYKEY | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC insertRecords (RM_TableData *rel, Record **records, int numRecords) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	RID *freePointer = tableHeader->freePointer;
+	Page_Header pageHeader;
+	SM_FileHandle fh;
+	RC rc;
+	int i;
+
+	if (numRecords <= 0) {
+		return RC_OK;
+	}
+
+	// check existance of duplicated primiary keys before anything is changed.
+	if (config != NULL && config->primaryKeyCheck) {
+		if ((rc = checkBatchKeys(rel, records, numRecords)) != RC_OK) {
+			return rc;
+		}
+	}
+
+	// a compressed page only takes records at its end.
+	if (tableHeader->layout == LAYOUT_COMPRESSED) {
+		return bulkLoad(rel, records, numRecords);
+	}
+
+	if ((rc = openPageFile(rel->name, &fh)) != RC_OK) {
+		return rc;
+	}
+
+	// assign a slot to every record.
+	for (i = 0; i < numRecords; i++) {
+		if (tableHeader->tombstone->itemCount != 0) {
+			ListNode *node = popTail(tableHeader->tombstone);
+			records[i]->id = *(RID *)node->value;
+			setDeletedSlot(tableHeader, records[i]->id, 0);
+			free(node->value);
+			free(node);
+		}
+		else {
+			records[i]->id = *freePointer;
+			freePointer->slot++;
+			if (freePointer->slot > tableHeader->recordsPerPage - 1) {
+				freePointer->slot = 0;
+				freePointer->page++;
+			}
+		}
+	}
+
+	BatchEntry *entries = sortBatch(NULL, records, numRecords);
+	char *page = (char *)malloc(PAGE_SIZE);
+
+	// write each page once with all of its new records.
+	for (i = 0; i < numRecords && rc == RC_OK; ) {
+		int pageNum = entries[i].id.page;
+
+		if ((rc = loadBatchPage(rel, &fh, pageNum, page, &pageHeader)) != RC_OK) {
+			break;
+		}
+		for (; i < numRecords && entries[i].id.page == pageNum; i++) {
+			storeSlot(rel, page, entries[i].id.slot, records[entries[i].index]->data);
+			updateZoneMap(rel, pageNum, records[entries[i].index]->data);
+			pageHeader.recordCount++;
+		}
+		if (pageHeader.recordCount > pageHeader.recordCapacity - 1) {
+			pageHeader.isFull = 1;
+		}
+		storePageHeader(rel, &pageHeader, page);
+		rc = writeBlocks(pageNum, 1, &fh, page);
+	}
+
+	// a page the free pointer moved into without getting records still needs
+	// its page header.
+	if (rc == RC_OK && freePointer->page >= fh.totalNumPages) {
+		memset(page, 0, PAGE_SIZE);
+		initPageHeader(rel, &pageHeader, freePointer->page);
+		storePageHeader(rel, &pageHeader, page);
+		rc = writeBlocks(freePointer->page, 1, &fh, page);
+	}
+
+	// update table header once.
+	if (rc == RC_OK) {
+		tableHeader->pageCount = freePointer->page;
+		tableHeader->totalRecordCount += numRecords;
+		rc = storeTableHeader(rel, &fh, page);
+	}
+
+	for (i = 0; i < numRecords && rc == RC_OK; i++) {
+		updateKeyIndex(rel, NULL, records[i]->data, records[i]->id, 0);
+	}
+
+	closePageFile(&fh);
+	free(entries);
+	free(page);
+	return rc;
+}
+
+/**
+ * Delete a batch of records. All ids are added to the tombstone, every
+ * affected page header is rewritten once and the table header is written
+ * once for the whole batch. Nothing is deleted when an id is already in the
+ * tombstone or appears twice in the batch.
+ * @param  rel    RM_TableData
+ * @param  ids    ids of the records to delete.
+ * @param  numIds number of ids.
+ * @return        RC_OK | RC_TUPLE_NOT_FOUND | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC deleteRecords (RM_TableData *rel, RID *ids, int numIds) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	int slotLen = schemaLength(rel->schema);
+	Page_Header pageHeader;
+	SM_FileHandle fh;
+	RC rc;
+	int i;
+
+	if (numIds <= 0) {
+		return RC_OK;
+	}
+
+	if ((rc = openPageFile(rel->name, &fh)) != RC_OK) {
+		return rc;
+	}
+
+	BatchEntry *entries = sortBatch(ids, NULL, numIds);
+	char *page = (char *)malloc(pageBufferSize(rel));
+	char *row = (char *)malloc(slotLen);
+
+	rc = checkDeletedBatch(tableHeader, entries, numIds);
+
+	// decrease the record count of each page once.
+	for (i = 0; i < numIds && rc == RC_OK; ) {
+		int pageNum = entries[i].id.page;
+
+		if ((rc = loadBatchPage(rel, &fh, pageNum, page, &pageHeader)) != RC_OK) {
+			break;
+		}
+		for (; i < numIds && entries[i].id.page == pageNum; i++) {
+			updateKeyIndex(rel, slotRecord(rel, page, entries[i].id.slot, row), NULL, entries[i].id, 0);
+			pageHeader.recordCount--;
+		}
+		storePageHeader(rel, &pageHeader, page);
+		rc = writeDataPage(rel, &fh, pageNum, page);
+	}
+
+	// mark the records as deleted, in the order they were given.
+	if (rc == RC_OK) {
+		for (i = 0; i < numIds; i++) {
+			RID *tstone_id = (RID *)malloc(sizeof(RID));
+			*tstone_id = ids[i];
+			insert(tableHeader->tombstone, tstone_id);
+			setDeletedSlot(tableHeader, ids[i], 1);
+		}
+		tableHeader->totalRecordCount -= numIds;
+		rc = storeTableHeader(rel, &fh, page);
+	}
+
+	closePageFile(&fh);
+	free(entries);
+	free(page);
+	free(row);
+	return rc;
+}
+
+/**
+ * Update a batch of records, each identified by its id. The batch is grouped
+ * by page so that every page is read and written once.
+ *
+ * If primary key checking is on, nothing is updated when a new key of the
+ * batch is held by another record. The records of a compressed table are
+ * updated one by one, up to the first one its page has no room for.
+ * @param  rel        RM_TableData
+ * @param  records    the new records.
+ * @param  numRecords number of records.
+ * @return            RC_OK | RC_DUPLICATED_PRIMARYKEY | RC_RM_PAGE_FULL | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC updateRecords (RM_TableData *rel, Record **records, int numRecords) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Page_Header pageHeader;
+	SM_FileHandle fh;
+	RC rc = RC_OK;
+	int i;
+
+	if (numRecords <= 0) {
+		return RC_OK;
+	}
+
+	if (tableHeader->layout == LAYOUT_COMPRESSED) {
+		for (i = 0; i < numRecords && rc == RC_OK; i++) {
+			rc = updateRecord(rel, records[i]);
+		}
+		return rc;
+	}
+
+	if ((rc = openPageFile(rel->name, &fh)) != RC_OK) {
+		return rc;
+	}
+
+	BatchEntry *entries = sortBatch(NULL, records, numRecords);
+	char *page = (char *)malloc(PAGE_SIZE);
+
+	rc = updateBatchKeys(rel, &fh, entries, records, numRecords, page);
+
+	for (i = 0; i < numRecords && rc == RC_OK; ) {
+		int pageNum = entries[i].id.page;
+
+		if ((rc = loadBatchPage(rel, &fh, pageNum, page, &pageHeader)) != RC_OK) {
+			break;
+		}
+		for (; i < numRecords && entries[i].id.page == pageNum; i++) {
+			storeSlot(rel, page, entries[i].id.slot, records[entries[i].index]->data);
+			updateZoneMap(rel, pageNum, records[entries[i].index]->data);
+		}
+		rc = writeBlocks(pageNum, 1, &fh, page);
+	}
+
+	closePageFile(&fh);
+	free(entries);
+	free(page);
+	return rc;
 }
 
 /**
@@ -414,41 +1089,44 @@ RC getRecord(RM_TableData *rel, RID id, Record *record) {
 	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
 	// if the record is in the tombstone list, it means the record has been
 	// deleted. 'RC_TUPLE_NOT_FOUND' is returned.
-	RC f = find(tableHeader->tombstone, id);
-	if (f == RC_OK) {
+	if (isDeletedSlot(tableHeader, id)) {
 		return RC_TUPLE_NOT_FOUND;
 	}
 
-
 	// otherwise, fetch the record using id.
-	int offset = 50 + (id.slot) * (schemaLength(rel->schema));
-	SM_PageHandle p = (SM_PageHandle) malloc(PAGE_SIZE);
-
+	int slotLen = schemaLength(rel->schema);
+	Page_Header pageHeader;
 	SM_FileHandle fh;
 	SM_PageHandle ph;
-	ph = (SM_PageHandle) malloc(PAGE_SIZE);
+	char *data;
+	int lastSlot;
+	ph = (SM_PageHandle) malloc(pageBufferSize(rel));
 	openPageFile(rel->name, &fh);
-	readBlock(id.page, &fh, ph);
-
-	char *pageHeaderStr = (char *)malloc(sizeof(char) * 50);
-	Page_Header *pageHeader = (Page_Header *)malloc(sizeof(Page_Header));
+	readDataPage(rel, &fh, id.page, ph);
+	closePageFile(&fh);
 
-	memcpy(pageHeaderStr, ph, 50);
-	deserializePageHeader(pageHeaderStr, pageHeader);
+	loadPageHeader(ph, &pageHeader);
 
-	if (id.page >tableHeader->pageCount || id.slot > pageHeader->recordCount) {
+	// deleted slots of a compressed page are not reused, its slots are counted
+	// apart from its records.
+	lastSlot = tableHeader->layout == LAYOUT_COMPRESSED ? pageSlots(ph) - 1 : pageHeader.recordCount;
+	if (id.page >tableHeader->pageCount || id.slot > lastSlot) {
+		free(ph);
 		return RC_RM_NO_MORE_TUPLES;
 	}
 
-	memcpy(p, ph+offset, schemaLength(rel->schema));
-
-	Record *r = deserializeRecord(rel->schema, p, id);
-	record->id = r->id;
-	record->data = r->data;
-
-	closePageFile(&fh);
-
+	// the record is filled in place, a record without data gets a buffer that
+	// is released by freeRecord.
+	if (record->data == NULL) {
+		record->data = (char *)malloc(getRecordSize(rel->schema));
+	}
+	data = slotRecord(rel, ph, id.slot, record->data);
+	if (data != record->data) {
+		memcpy(record->data, data, slotLen);
+	}
+	record->id = id;
 
+	free(ph);
   return RC_OK;
 }
 
@@ -458,12 +1136,66 @@ RC getRecord(RM_TableData *rel, RID id, Record *record) {
  * @param  rel  RM_TableData
  * @param  scan RM_ScanHandle
  * @param  cond scan condition(s)
- * @return      RC_OK
+ * @return      RC_OK | RC_FILE_NOT_FOUND
  */
 RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond) {
-	ScanInfo *scanInfo = (ScanInfo *)malloc(sizeof(ScanInfo));
-	scanInfo->cond = cond;
+	// everything the scan needs lives in its arena and is released by closeScan.
+	Arena *arena;
+	ScanInfo *scanInfo;
+	SM_FileHandle fh;
 	RID startRID;
+
+	// the file stays open for the whole scan, next reads its pages with
+	// readBlock, which decompresses the pages of a compressed page file.
+	if (openPageFile(rel->name, &fh) != RC_OK) {
+		return RC_FILE_NOT_FOUND;
+	}
+
+	arena = createArena(0);
+	scanInfo = (ScanInfo *)arenaAlloc(arena, sizeof(ScanInfo));
+	scanInfo->cond = cond;
+	scanInfo->arena = arena;
+	scanInfo->page = (char *)arenaAlloc(arena, PAGE_SIZE);
+	scanInfo->row = (char *)arenaAlloc(arena, getRecordSize(rel->schema));
+	scanInfo->pageNum = 0;
+	scanInfo->pageReads = 0;
+	scanInfo->fh = fh;
+
+	// the condition is compiled once into a filter whose conjuncts are
+	// reordered as the scan goes; a condition that does not compile is
+	// evaluated as a tree and reports its error there.
+	scanInfo->filter = NULL;
+	if (cond != NULL) {
+		compileFilter(cond, rel->schema, &scanInfo->filter);
+	}
+	scanInfo->selection = (unsigned char *)arenaAlloc(arena, (((Table_Header *)rel->mgmtData)->recordsPerPage + 7) / 8);
+	scanInfo->selectionPage = 0;
+	scanInfo->selectionSlots = 0;
+
+	// a condition that bounds some attribute to an empty range, like
+	// a > 5 AND a < 3, needs no page to be read.
+	scanInfo->projection = NULL;
+	scanInfo->projAttrs = NULL;
+	scanInfo->shared = NULL;
+	scanInfo->pagesLeft = 0;
+	scanInfo->lastPage = 0;
+
+	scanInfo->empty = conditionIsEmpty(rel->schema, cond);
+	scanInfo->zoneBounds = scanZoneBounds(rel, cond, arena);
+
+	// pages of a compressed table are decoded into a page of their own,
+	// unless the condition leaves none of their slots.
+	scanInfo->decoded = NULL;
+	if (((Table_Header *)rel->mgmtData)->layout == LAYOUT_COMPRESSED) {
+		scanInfo->decoded = (char *)arenaAlloc(arena, pageBufferSize(rel));
+	}
+	scanInfo->ranges = scanRanges(rel, cond, arena);
+	scanInfo->pagesDecoded = 0;
+	scanInfo->limit = -1;
+	scanInfo->top = NULL;
+	scanInfo->pageOrder = NULL;
+	scanInfo->orderPos = 0;
+
 	startRID.page = 1;
 	startRID.slot = 0;
 	scanInfo->curRID = startRID;
@@ -475,82 +1207,617 @@ RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond) {
 }
 
 /**
- * find the matching record by iteratively going through all records.
- * @param  scan   RM_ScanHandle
- * @param  record the goal record
- * @return        RC_OK | RC_RM_NO_MORE_TUPLES
+ * initialize a scan that returns only some attributes. The condition is
+ * evaluated on the stored records, the returned records hold the
+ * attributes of attrList in that order and are laid out by the schema
+ * getScanSchema returns.
+ * @param  rel      RM_TableData
+ * @param  scan     RM_ScanHandle
+ * @param  cond     scan condition(s)
+ * @param  attrList attributes to return
+ * @param  numAttrs length of attrList
+ * @return          RC_OK | RC_RM_NO_SUCH_ATTR | RC_FILE_NOT_FOUND
  */
-RC next (RM_ScanHandle *scan, Record *record) {
-	ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
-	RID currentRID = scanInfo->curRID;
-	Value *value;
-
-	SM_FileHandle fh;
-	SM_PageHandle ph;
-	ph = (SM_PageHandle) malloc(PAGE_SIZE);
-
-	openPageFile(scan->rel->name, &fh);
-	readBlock(currentRID.page, &fh, ph);
-
-	char *pageHeaderStr = (char *)malloc(sizeof(char) * 50);
-	Page_Header *pageHeader = (Page_Header *)malloc(sizeof(Page_Header));
-
-	memcpy(pageHeaderStr, ph, 50);
-	deserializePageHeader(pageHeaderStr, pageHeader);
-
-	if (currentRID.slot > pageHeader->recordCount) {
-		return RC_RM_NO_MORE_TUPLES;
+RC startScanProjected (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrList, int numAttrs) {
+	Schema *schema = rel->schema;
+	ScanInfo *scanInfo;
+	char **names;
+	DataType *dataTypes;
+	int *typeLength, *keys;
+	int i, j, keySize = 0;
+	RC rc;
+
+	for (i = 0; i < numAttrs; i++) {
+		if (attrList[i] < 0 || attrList[i] >= schema->numAttr) {
+			THROW(RC_RM_NO_SUCH_ATTR, "projected attribute does not exist");
+		}
 	}
 
-	int i;
-	for (i = currentRID.slot; i < pageHeader->recordCount; i++) {
-		RID fetchRId;
-		fetchRId.page = currentRID.page;
-		fetchRId.slot = i;
-		RC fetch = getRecord(scan->rel, fetchRId, record);
-
-		if (fetch != RC_RM_NO_MORE_TUPLES) {
-			evalExpr(record, scan->rel->schema, scanInfo->cond, &value);
-			if (value->v.boolV == 1) {
-				scanInfo->curRID.slot = fetchRId.slot+1;
-				free(ph);
-				closePageFile(&fh);
-				free(pageHeader);
-				free(pageHeaderStr);
-				return RC_OK;
+	if ((rc = startScan(rel, scan, cond)) != RC_OK) {
+		return rc;
+	}
+	scanInfo = (ScanInfo *)scan->mgmtData;
+
+	// the projected schema keeps the key attributes it contains
+	names = (char **)malloc(sizeof(char *) * numAttrs);
+	dataTypes = (DataType *)malloc(sizeof(DataType) * numAttrs);
+	typeLength = (int *)malloc(sizeof(int) * numAttrs);
+	keys = (int *)malloc(sizeof(int) * (numAttrs > 0 ? numAttrs : 1));
+	for (i = 0; i < numAttrs; i++) {
+		int attr = attrList[i];
+		names[i] = (char *)malloc(strlen(schema->attrNames[attr]) + 1);
+		strcpy(names[i], schema->attrNames[attr]);
+		dataTypes[i] = schema->dataTypes[attr];
+		typeLength[i] = schema->typeLength[attr];
+		for (j = 0; j < schema->keySize; j++) {
+			if (schema->keyAttrs[j] == attr) {
+				keys[keySize++] = i;
 			}
 		}
 	}
+	scanInfo->projection = createSchema(numAttrs, names, dataTypes, typeLength, keySize, keys);
+	scanInfo->projAttrs = (int *)arenaAlloc(scanInfo->arena, sizeof(int) * (numAttrs > 0 ? numAttrs : 1));
+	memcpy(scanInfo->projAttrs, attrList, sizeof(int) * numAttrs);
 
-	free(ph);
-	closePageFile(&fh);
-	free(pageHeader);
-	free(pageHeaderStr);
+	return RC_OK;
+}
+
+/**
+ * initialize a scan that returns at most limit matching records. Once the
+ * last of them is returned the scan closes the table file and leaves a
+ * shared pass, the pages after it are never read.
+ * @param  rel   RM_TableData
+ * @param  scan  RM_ScanHandle
+ * @param  cond  scan condition(s)
+ * @param  limit largest number of records returned
+ * @return       RC_OK | RC_RM_INVALID_LIMIT | RC_FILE_NOT_FOUND
+ */
+RC startScanLimit (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int limit) {
+	ScanInfo *scanInfo;
+	RC rc;
+
+	if (limit < 0) {
+		THROW(RC_RM_INVALID_LIMIT, "a scan limit cannot be negative");
+	}
+	if ((rc = startScan(rel, scan, cond)) != RC_OK) {
+		return rc;
+	}
+	scanInfo = (ScanInfo *)scan->mgmtData;
+	scanInfo->limit = limit;
+	if (limit == 0) {
+		releaseScanFile(scanInfo);
+	}
+	return RC_OK;
+}
+
+/**
+ * initialize a scan that returns the k matching records with the smallest
+ * values of an attribute, or the largest if descending, in that order.
+ * Records with equal values come in the order of the table. The table is
+ * read here and only the k best records are kept in a heap. If the
+ * attribute has a zone map, the pages are read from the one with the best
+ * zone on, and once there are k records a page whose zone cannot hold a
+ * better value is not read. next returns the kept records, closeScan
+ * releases them.
+ * @param  rel        RM_TableData
+ * @param  scan       RM_ScanHandle
+ * @param  cond       scan condition(s)
+ * @param  attrNum    the attribute to order by
+ * @param  descending the largest values come first
+ * @param  k          largest number of records returned
+ * @return            RC_OK | RC_RM_NO_SUCH_ATTR | RC_RM_INVALID_LIMIT | RC_FILE_NOT_FOUND
+ */
+RC startScanTopK (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int attrNum, int descending, int k) {
+	Schema *schema = rel->schema;
+	ZoneMap *zones = ((Table_Header *)rel->mgmtData)->zones;
+	ScanInfo *scanInfo;
+	TopRecords *top;
+	Record record;
+	int i, zone = -1;
+	RC rc;
+
+	if (attrNum < 0 || attrNum >= schema->numAttr) {
+		THROW(RC_RM_NO_SUCH_ATTR, "order by attribute does not exist");
+	}
+	if (k < 0) {
+		THROW(RC_RM_INVALID_LIMIT, "a scan limit cannot be negative");
+	}
+	if ((rc = startScan(rel, scan, cond)) != RC_OK) {
+		return rc;
+	}
+	scanInfo = (ScanInfo *)scan->mgmtData;
+
+	top = (TopRecords *)arenaAlloc(scanInfo->arena, sizeof(TopRecords));
+	top->schema = schema;
+	top->attr = attrNum;
+	top->descending = descending;
+	top->count = 0;
+	top->next = 0;
+	top->slotLen = schemaLength(schema);
+	top->records = (char *)arenaAlloc(scanInfo->arena, (size_t)(k + 1) * top->slotLen);
+	top->keys = (double *)arenaAlloc(scanInfo->arena, sizeof(double) * (k + 1));
+	top->ids = (RID *)arenaAlloc(scanInfo->arena, sizeof(RID) * (k + 1));
+	top->order = (int *)arenaAlloc(scanInfo->arena, sizeof(int) * (k + 1));
+	top->k = k;
+	top->spare = 0;
+
+	// the zone map prunes by the attribute once the heap is full, a
+	// condition without bounds on the zone map gets empty ones.
+	if (zones != NULL) {
+		for (i = 0; i < zones->numAttrs; i++) {
+			if (zones->attrs[i] == attrNum) {
+				zone = i;
+			}
+		}
+	}
+	if (zone >= 0 && scanInfo->zoneBounds == NULL) {
+		scanInfo->zoneBounds = (ZoneBounds *)arenaAlloc(scanInfo->arena, sizeof(ZoneBounds) * zones->numAttrs);
+		memset(scanInfo->zoneBounds, 0, sizeof(ZoneBounds) * zones->numAttrs);
+	}
+	if (zone >= 0 && k > 0) {
+		scanInfo->pageOrder = zonePageOrder(rel, zone, descending, scanInfo->arena);
+		scanInfo->curRID.page = scanInfo->pageOrder[0];
+	}
+
+	record.data = top->records + (size_t)top->spare * top->slotLen;
+	while (k > 0 && next(scan, &record) == RC_OK) {
+		addTopRecord(top, record.id);
+		record.data = top->records + (size_t)top->spare * top->slotLen;
+
+		// a page holds a better record only if its zone reaches the worst
+		// kept value, an equal value may come before it in the table.
+		if (zone >= 0 && top->count == k) {
+			ZoneBounds *bounds = &scanInfo->zoneBounds[zone];
+			double threshold = top->keys[top->order[0]];
+
+			if (!descending && (!bounds->hasHigh || threshold < bounds->high)) {
+				bounds->hasHigh = 1;
+				bounds->highInclusive = 1;
+				bounds->high = threshold;
+			}
+			else if (descending && (!bounds->hasLow || threshold > bounds->low)) {
+				bounds->hasLow = 1;
+				bounds->lowInclusive = 1;
+				bounds->low = threshold;
+			}
+		}
+	}
+
+	// the heap is sorted in place, the worst record goes to the end first
+	for (i = top->count - 1; i > 0; i--) {
+		int first = top->order[0];
+		top->order[0] = top->order[i];
+		top->order[i] = first;
+		siftTop(top, 0, i);
+	}
+
+	releaseScanFile(scanInfo);
+	scanInfo->top = top;
+	return RC_OK;
+}
+
+/**
+ * the schema of the records a scan returns, the table schema unless the
+ * scan was started by startScanProjected.
+ * @param  scan RM_ScanHandle
+ * @return      the schema
+ */
+Schema *getScanSchema (RM_ScanHandle *scan) {
+	ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
+
+	return (scanInfo->projection != NULL) ? scanInfo->projection : scan->rel->schema;
+}
+
+/**
+ * find the next matching record, going through the slots of every data page
+ * in order. The page of the scan position is kept by the scan between calls,
+ * so every page is read once. The record is filled in place; a record
+ * without data gets it from the scan arena, so it is valid until closeScan.
+ * A projected scan copies only the projected attributes.
+ * @param  scan   RM_ScanHandle
+ * @param  record the goal record
+ * @return        RC_OK | RC_RM_NO_MORE_TUPLES
+ */
+RC next (RM_ScanHandle *scan, Record *record) {
+	ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
+	Schema *schema = scan->rel->schema;
+	Table_Header *tableHeader = (Table_Header *)scan->rel->mgmtData;
+	int slotLen = schemaLength(schema);
+	char *page = (scanInfo->decoded != NULL) ? scanInfo->decoded : scanInfo->page;
+	Record slot;
+	Value value;
+	int i;
+
+	if (record->data == NULL) {
+		record->data = (char *)arenaAlloc(scanInfo->arena, getRecordSize(getScanSchema(scan)));
+	}
+
+	// an ORDER BY ... LIMIT scan has read its records when it started
+	if (scanInfo->top != NULL) {
+		TopRecords *top = scanInfo->top;
+
+		if (top->next >= top->count) {
+			return RC_RM_NO_MORE_TUPLES;
+		}
+		memcpy(record->data, top->records + (size_t)top->order[top->next] * slotLen, slotLen);
+		record->id = top->ids[top->order[top->next]];
+		top->next++;
+		return RC_OK;
+	}
+	if (scanInfo->empty || scanInfo->limit == 0) {
+		return RC_RM_NO_MORE_TUPLES;
+	}
+
+	while ((scanInfo->shared != NULL) ? scanInfo->pagesLeft > 0 : scanInfo->curRID.page <= tableHeader->pageCount) {
+		// slots are used up to the free pointer, deleted ones are in the
+		// tombstone list.
+		int usedSlots = (scanInfo->curRID.page == tableHeader->freePointer->page)
+			? tableHeader->freePointer->slot : tableHeader->recordsPerPage;
+
+		// a page whose zones are outside the condition is not read.
+		if (scanInfo->pageNum != scanInfo->curRID.page) {
+			if (scanInfo->zoneBounds != NULL
+					&& !zoneMapMayMatch(tableHeader->zones, scanInfo->curRID.page, scanInfo->zoneBounds)) {
+				usedSlots = 0;
+			}
+			else if (readScanPage(scanInfo, scanInfo->curRID.page) != RC_OK) {
+				break;
+			}
+			else {
+				scanInfo->pageNum = scanInfo->curRID.page;
+				if (scanInfo->decoded != NULL) {
+					// a page without slots left by the condition counts as empty
+					if (decodeScanPage(scan->rel, scanInfo->page, page, scanInfo->ranges, scanInfo->selection) == 0) {
+						memset(page + PAGE_SLOTS_OFFSET, 0, sizeof(int));
+					}
+					else {
+						scanInfo->pagesDecoded++;
+					}
+					scanInfo->selectionPage = 0;
+				}
+			}
+		}
+
+		// a compressed page holds as many slots as fitted into it.
+		if (scanInfo->decoded != NULL && scanInfo->pageNum == scanInfo->curRID.page) {
+			usedSlots = pageSlots(page);
+		}
+
+		// a compiled condition is evaluated for the whole page at once, only
+		// the selected slots are copied out.
+		if (scanInfo->filter != NULL && usedSlots > 0 && (scanInfo->selectionPage != scanInfo->curRID.page
+				|| scanInfo->selectionSlots != usedSlots)) {
+			filterPage(scan->rel, scanInfo->filter, page, usedSlots, scanInfo->selection);
+			scanInfo->selectionPage = scanInfo->curRID.page;
+			scanInfo->selectionSlots = usedSlots;
+		}
+
+		for (; scanInfo->curRID.slot < usedSlots; scanInfo->curRID.slot++) {
+			RID id = scanInfo->curRID;
+
+			if (scanInfo->filter != NULL
+					&& !(scanInfo->selection[id.slot / 8] & (1 << (id.slot % 8)))) {
+				continue;
+			}
+			if (isDeletedSlot(tableHeader, id)) {
+				continue;
+			}
+
+			// the condition is evaluated on the slot, matches are copied out;
+			// a projected scan of a PAX page copies from the minipages
+			if (scanInfo->filter == NULL && scanInfo->cond != NULL) {
+				slot.data = slotRecord(scan->rel, page, id.slot, scanInfo->row);
+				evalExprInto(&slot, schema, scanInfo->cond, &value);
+				if (!value.v.boolV) {
+					continue;
+				}
+			}
+
+			if (scanInfo->projection == NULL) {
+				char *data = slotRecord(scan->rel, page, id.slot, record->data);
+				if (data != record->data) {
+					memcpy(record->data, data, slotLen);
+				}
+			}
+			else {
+				Schema *projection = scanInfo->projection;
+				for (i = 0; i < projection->numAttr; i++) {
+					int attr = scanInfo->projAttrs[i];
+					memcpy(record->data + projection->attrOffsets[i],
+						slotAttr(tableHeader, schema, page, id.slot, attr), projection->attrSizes[i]);
+				}
+			}
+			record->id = id;
+
+			scanInfo->curRID.slot++;
+			if (scanInfo->limit > 0 && --scanInfo->limit == 0) {
+				releaseScanFile(scanInfo);
+			}
+			return RC_OK;
+		}
+
+		scanInfo->curRID.page++;
+		scanInfo->curRID.slot = 0;
+		if (scanInfo->pageOrder != NULL) {
+			scanInfo->orderPos++;
+			scanInfo->curRID.page = (scanInfo->orderPos < tableHeader->pageCount)
+				? scanInfo->pageOrder[scanInfo->orderPos] : tableHeader->pageCount + 1;
+		}
+
+		// a shared scan wraps around to the pages before the one it joined at
+		if (scanInfo->shared != NULL) {
+			scanInfo->pagesLeft--;
+			if (scanInfo->curRID.page > scanInfo->lastPage) {
+				scanInfo->curRID.page = 1;
+			}
+		}
+	}
 
 	return RC_RM_NO_MORE_TUPLES;
 }
+
+/**
+ * close a scan and release everything allocated from its arena.
+ * @param  scan RM_ScanHandle
+ * @return      RC_OK
+ */
 RC closeScan (RM_ScanHandle *scan) {
+	ScanInfo *scanInfo = (ScanInfo *)scan->mgmtData;
+
+	if (scanInfo != NULL) {
+		if (scanInfo->filter != NULL) {
+			freeExprFilter(scanInfo->filter);
+		}
+		if (scanInfo->projection != NULL) {
+			freeSchema(scanInfo->projection);
+		}
+		releaseScanFile(scanInfo);
+		freeArena(scanInfo->arena);
+		scan->mgmtData = NULL;
+	}
+	return RC_OK;
+}
+
+/**
+ * the arena of a scan, records and values allocated from it are released by
+ * closeScan.
+ * @param  scan RM_ScanHandle
+ * @return      the arena
+ */
+Arena *getScanArena (RM_ScanHandle *scan) {
+	return ((ScanInfo *)scan->mgmtData)->arena;
+}
+
+/**
+ * the number of pages a scan has read so far. Pages a shared scan got from
+ * the pass it joined are not counted.
+ * @param  scan RM_ScanHandle
+ * @return      pages read
+ */
+int getScanPageReads (RM_ScanHandle *scan) {
+	return ((ScanInfo *)scan->mgmtData)->pageReads;
+}
+
+/**
+ * the number of compressed pages a scan has decoded so far, pages whose
+ * encoded columns leave no slot for the condition are read but not decoded.
+ * @param  scan RM_ScanHandle
+ * @return      pages decoded
+ */
+int getScanDecodedPages (RM_ScanHandle *scan) {
+	return ((ScanInfo *)scan->mgmtData)->pagesDecoded;
+}
+
+/**
+ * scan a table with several threads and call callback for every matching
+ * record. The data pages are split into morsels of SCAN_MORSEL_PAGES pages
+ * that the threads claim one after the other from a shared counter, so a
+ * thread that is done early takes over the rest of the table. Every thread
+ * reads its pages with readBlock, compiles the condition into a filter of its
+ * own and passes its index to callback, which can use it to fill per
+ * thread results without locking. Records are passed in no particular
+ * order. The table must not be changed during the scan.
+ * @param  rel      RM_TableData
+ * @param  cond     scan condition(s), NULL for every record
+ * @param  nThreads number of threads, the calling thread is thread 0
+ * @param  callback called for every matching record
+ * @param  context  passed to callback
+ * @return          RC_OK | RC_FILE_NOT_FOUND | RC_READ_NON_EXISTING_PAGE
+ */
+RC startParallelScan (RM_TableData *rel, Expr *cond, int nThreads, ScanCallback callback, void *context) {
+	return runParallelScan(rel, cond, nThreads, callback, NULL, context);
+}
+
+/**
+ * scan a table like startParallelScan, but call callback once for every
+ * data page with its slots and a bitmap of the matching records, deleted
+ * ones left out. Callbacks can work on the columns of a whole page, like
+ * evalProgramBatch does.
+ * @param  rel      RM_TableData
+ * @param  cond     scan condition(s), NULL for every record
+ * @param  nThreads number of threads, the calling thread is thread 0
+ * @param  callback called for every data page with a matching record
+ * @param  context  passed to callback
+ * @return          RC_OK | RC_FILE_NOT_FOUND | RC_READ_NON_EXISTING_PAGE
+ */
+RC startParallelBatchScan (RM_TableData *rel, Expr *cond, int nThreads, BatchCallback callback, void *context) {
+	return runParallelScan(rel, cond, nThreads, NULL, callback, context);
+}
+
+// run the threads of a parallel scan, calling one of the callbacks.
+static RC runParallelScan(RM_TableData *rel, Expr *cond, int nThreads, ScanCallback callback,
+		BatchCallback batchCallback, void *context) {
+	ParallelScan scan;
+	ScanWorker *workers;
+	RC rc = RC_OK;
+	int i;
+
+	if (conditionIsEmpty(rel->schema, cond)) {
+		return RC_OK;
+	}
+	if (nThreads < 1) {
+		nThreads = 1;
+	}
+
+	scan.rel = rel;
+	scan.cond = cond;
+	scan.callback = callback;
+	scan.batchCallback = batchCallback;
+	scan.context = context;
+	atomic_init(&scan.nextMorsel, 0);
+	if (openPageFile(rel->name, &scan.fh) != RC_OK) {
+		return RC_FILE_NOT_FOUND;
+	}
+	Arena *arena = createArena(0);
+	scan.zoneBounds = scanZoneBounds(rel, cond, arena);
+	scan.ranges = scanRanges(rel, cond, arena);
+
+	// a thread that cannot be started leaves its morsels to the others.
+	workers = (ScanWorker *)malloc(sizeof(ScanWorker) * nThreads);
+	for (i = 0; i < nThreads; i++) {
+		workers[i].scan = &scan;
+		workers[i].thread = i;
+		workers[i].rc = RC_OK;
+		workers[i].started = (i > 0 && pthread_create(&workers[i].id, NULL, parallelScanWorker, &workers[i]) == 0);
+	}
+	parallelScanWorker(&workers[0]);
+
+	for (i = 0; i < nThreads; i++) {
+		if (workers[i].started) {
+			pthread_join(workers[i].id, NULL);
+		}
+		if (workers[i].rc != RC_OK) {
+			rc = workers[i].rc;
+		}
+	}
+
+	free(workers);
+	freeArena(arena);
+	closePageFile(&scan.fh);
+	return rc;
+}
+
+/**
+ * initialize a scan that shares its page reads with the other shared scans
+ * of the same table. A scan started while another one is running joins it
+ * at the page the pass has reached, gets the pages read by the others from
+ * a window of the last SHARED_SCAN_PAGES pages and wraps around to page 1
+ * after the last page to cover the pages it missed, so records come in
+ * rotated page order. A scan does not replace a page of the window that a
+ * scan of another thread still needs unless it has waited
+ * SHARED_SCAN_WAIT_MS for it, then it stops waiting for the others; a scan
+ * that falls behind the window reads its pages itself. Every scan has its
+ * own condition and may run on its own thread.
+ * The table must not be changed during the scan.
+ * @param  rel  RM_TableData
+ * @param  scan RM_ScanHandle
+ * @param  cond scan condition(s)
+ * @return      RC_OK | RC_FILE_NOT_FOUND
+ */
+RC startSharedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	ScanInfo *scanInfo;
+	SharedScan *shared;
+	SharedCursor *cursor;
+	RC rc;
+
+	if ((rc = startScan(rel, scan, cond)) != RC_OK) {
+		return rc;
+	}
+	scanInfo = (ScanInfo *)scan->mgmtData;
+	scanInfo->lastPage = tableHeader->pageCount;
+	scanInfo->pagesLeft = tableHeader->pageCount;
+
+	pthread_mutex_lock(&sharedScansLock);
+	for (shared = sharedScans; shared != NULL && strcmp(shared->name, rel->name) != 0; shared = shared->next)
+		;
+	if (shared == NULL) {
+		shared = (SharedScan *)calloc(1, sizeof(SharedScan));
+		shared->name = (char *)malloc(strlen(rel->name) + 1);
+		strcpy(shared->name, rel->name);
+		shared->pages = (char *)malloc((size_t)SHARED_SCAN_PAGES * PAGE_SIZE);
+		pthread_mutex_init(&shared->lock, NULL);
+		pthread_cond_init(&shared->changed, NULL);
+		shared->next = sharedScans;
+		sharedScans = shared;
+	}
+
+	cursor = (SharedCursor *)arenaAlloc(scanInfo->arena, sizeof(SharedCursor));
+	cursor->pass = shared;
+	cursor->pagesLeft = scanInfo->pagesLeft;
+	cursor->lastPage = scanInfo->lastPage;
+	cursor->waits = 1;
+	cursor->thread = pthread_self();
+
+	pthread_mutex_lock(&shared->lock);
+	cursor->page = (shared->position >= 1 && shared->position <= scanInfo->lastPage) ? shared->position : 1;
+	cursor->next = shared->cursors;
+	shared->cursors = cursor;
+	pthread_mutex_unlock(&shared->lock);
+	pthread_mutex_unlock(&sharedScansLock);
+
+	scanInfo->shared = cursor;
+	scanInfo->curRID.page = cursor->page;
+
 	return RC_OK;
 }
 
 // dealing with schema
 /**
- * calculate the size of the schema.
+ * size of a record of the schema, computed once by createSchema.
  * @param  schema Schema struct
  * @return        INT
  */
 int getRecordSize (Schema *schema) {
-	int schemaLength= 0;
+	return schema->recordSize;
+}
+
+/**
+ * compute the offset and size of every attribute of a record. Ints and floats
+ * are aligned to their size, bools take one byte and strings their fixed
+ * length plus a terminating NUL, so they can be used in place. The record
+ * size is padded to the largest alignment so records can be stored back to
+ * back.
+ * @param  schema Schema struct
+ */
+static void initSchemaLayout(Schema *schema) {
+	int offset = 0;
+	int maxAlign = 1;
 	int i;
+
+	schema->attrOffsets = (int *)malloc(sizeof(int) * schema->numAttr);
+	schema->attrSizes = (int *)malloc(sizeof(int) * schema->numAttr);
+
 	for (i = 0; i < schema->numAttr; i++) {
-		if (schema->dataTypes[i] == DT_STRING) {
-		schemaLength+= schema->typeLength[i];
+		int size, align;
+
+		switch (schema->dataTypes[i]) {
+			case DT_INT:
+				size = align = sizeof(int);
+				break;
+			case DT_FLOAT:
+				size = align = sizeof(float);
+				break;
+			case DT_BOOL:
+				size = align = 1;
+				break;
+			case DT_STRING:
+			default:
+				size = schema->typeLength[i] + 1;
+				align = 1;
+				break;
 		}
-		else {
-		schemaLength+= 1;
+
+		offset = (offset + align - 1) / align * align;
+		schema->attrOffsets[i] = offset;
+		schema->attrSizes[i] = size;
+		offset += size;
+		if (align > maxAlign) {
+			maxAlign = align;
 		}
 	}
-	return schemaLength;
+
+	schema->recordSize = (offset + maxAlign - 1) / maxAlign * maxAlign;
 }
 
 /**
@@ -572,10 +1839,16 @@ Schema *createSchema (int numAttr, char **attrNames, DataType *dataTypes, int *t
 	schema->typeLength = typeLength;
 	schema->keyAttrs = keys;
 	schema->keySize = keySize;
+	initSchemaLayout(schema);
 	return schema;
 }
 
 RC freeSchema (Schema *schema) {
+  int i;
+  for (i = 0; i < schema->numAttr; i++)
+    free(schema->attrNames[i]);
+  free(schema->attrOffsets);
+  free(schema->attrSizes);
   free(schema->dataTypes);
 
   free(schema->attrNames);
@@ -589,22 +1862,13 @@ RC freeSchema (Schema *schema) {
 
 
 /**
- * calculate the total lenght of serialized schema.
+ * length of a record slot in a data page, records are stored as they are
+ * laid out in memory.
  * @param  schema Schema pointer
- * @return       	RC_OK
+ * @return       	INT
  */
 int schemaLength(Schema *schema) {
-	int schemaLength= 0;
-  int i;
-  for (i = 0; i < schema->numAttr; i++) {
-		if (schema->dataTypes[i] == DT_STRING) {
-		schemaLength+= schema->typeLength[i];
-		}
-		else {
-		schemaLength+= 4;
-		}
-  }
-	return schemaLength;
+	return schema->recordSize;
 }
 
 
@@ -616,60 +1880,193 @@ RC createRecord (Record **record, Schema *schema) {
 
 	*record = (Record *)malloc(sizeof(Record));
 
-	(*record)->data = (char *)malloc(recordLength);
+	// zeroed so padding between attributes compares equal.
+	(*record)->data = (char *)calloc(1, recordLength);
 
   return RC_OK;
 }
 
 RC freeRecord (Record *record) {
+	free(record->data);
 	free(record);
 	return RC_OK;
 }
 
+/**
+ * create a record in an arena. It is released with the arena and must not be
+ * passed to freeRecord.
+ * @param  record set to the new record.
+ * @param  schema Schema of the record.
+ * @param  arena  the arena.
+ * @return        RC_OK
+ */
+RC createRecordInArena (Record **record, Schema *schema, Arena *arena) {
+	int recordLength = getRecordSize(schema);
+
+	*record = (Record *)arenaAlloc(arena, sizeof(Record));
+	(*record)->data = (char *)arenaAlloc(arena, recordLength);
+	memset((*record)->data, 0, recordLength);
+
+  return RC_OK;
+}
+
+/**
+ * get an attribute as a newly allocated Value, free it with freeVal.
+ * @param  record  the record.
+ * @param  schema  Schema of the record.
+ * @param  attrNum index of the attribute.
+ * @param  value   set to the new Value.
+ * @return         RC_OK
+ */
 RC getAttr (Record *record, Schema *schema, int attrNum, Value **value) {
 	*value = (Value *)malloc(sizeof(Value));
-	int offset;
-	attrOffset(schema, attrNum, &offset);
-	char *valueFromRecord = record->data + offset;
+	getAttrInto(record, schema, attrNum, *value);
 
-    if(schema->dataTypes[attrNum] == DT_INT){
-        (*value)->dt = DT_INT;
-        memcpy(&((*value)->v.intV), valueFromRecord, sizeof(int));
-    }
-    else if(schema->dataTypes[attrNum] == DT_BOOL){
-        (*value)->dt = DT_BOOL;
-        memcpy(&((*value)->v.intV), valueFromRecord, sizeof(bool));
-    }
-    else if(schema->dataTypes[attrNum] == DT_FLOAT){
-        (*value)->dt = DT_FLOAT;
-        memcpy(&((*value)->v.floatV), valueFromRecord, sizeof(float));
-    }
-    else if(schema->dataTypes[attrNum] == DT_STRING){
-        (*value)->dt = DT_STRING;
-        int stringLength = schema->typeLength[attrNum];
-        (*value)->v.stringV = (char *)malloc(sizeof(char) * stringLength + 1);
-        strncpy((*value)->v.stringV, valueFromRecord, stringLength);
-        (*value)->v.stringV[stringLength] = '\0';
-    }
+	if ((*value)->dt == DT_STRING) {
+		char *s = (*value)->v.stringV;
+		(*value)->v.stringV = (char *)malloc(strlen(s) + 1);
+		strcpy((*value)->v.stringV, s);
+	}
 
   return RC_OK;
 }
 
+/**
+ * get an attribute as a Value allocated in an arena, strings are copied into
+ * the arena too. It is released with the arena and must not be passed to
+ * freeVal.
+ * @param  record  the record.
+ * @param  schema  Schema of the record.
+ * @param  attrNum index of the attribute.
+ * @param  value   set to the new Value.
+ * @param  arena   the arena.
+ * @return         RC_OK
+ */
+RC getAttrInArena (Record *record, Schema *schema, int attrNum, Value **value, Arena *arena) {
+	*value = (Value *)arenaAlloc(arena, sizeof(Value));
+	getAttrInto(record, schema, attrNum, *value);
+
+	if ((*value)->dt == DT_STRING) {
+		(*value)->v.stringV = arenaStrdup(arena, (*value)->v.stringV);
+	}
+
+  return RC_OK;
+}
+
+/**
+ * get an attribute into a Value owned by the caller, nothing is allocated.
+ * A string value points into the record data, so it is only valid while the
+ * record is, and must not be passed to freeVal.
+ * @param  record  the record.
+ * @param  schema  Schema of the record.
+ * @param  attrNum index of the attribute.
+ * @param  value   Value to fill.
+ * @return         RC_OK | RC_RM_UNKOWN_DATATYPE
+ */
+RC getAttrInto (Record *record, Schema *schema, int attrNum, Value *value) {
+	char *valueFromRecord = record->data + schema->attrOffsets[attrNum];
+
+	value->dt = schema->dataTypes[attrNum];
+	switch (value->dt) {
+		case DT_INT:
+			memcpy(&(value->v.intV), valueFromRecord, sizeof(int));
+			break;
+		case DT_FLOAT:
+			memcpy(&(value->v.floatV), valueFromRecord, sizeof(float));
+			break;
+		case DT_BOOL:
+			value->v.boolV = (*valueFromRecord != 0);
+			break;
+		case DT_STRING:
+			value->v.stringV = valueFromRecord;
+			break;
+		default:
+			return RC_RM_UNKOWN_DATATYPE;
+	}
+
+	return RC_OK;
+}
+
+/**
+ * get an int attribute without allocating.
+ * @param  record  the record.
+ * @param  schema  Schema of the record.
+ * @param  attrNum index of the attribute.
+ * @param  result  set to the value.
+ * @return         RC_OK | RC_RM_ATTR_WRONG_DATATYPE
+ */
+RC getIntAttr (Record *record, Schema *schema, int attrNum, int *result) {
+	if (schema->dataTypes[attrNum] != DT_INT) {
+		return RC_RM_ATTR_WRONG_DATATYPE;
+	}
+	memcpy(result, record->data + schema->attrOffsets[attrNum], sizeof(int));
+	return RC_OK;
+}
+
+/**
+ * get a float attribute without allocating.
+ * @param  record  the record.
+ * @param  schema  Schema of the record.
+ * @param  attrNum index of the attribute.
+ * @param  result  set to the value.
+ * @return         RC_OK | RC_RM_ATTR_WRONG_DATATYPE
+ */
+RC getFloatAttr (Record *record, Schema *schema, int attrNum, float *result) {
+	if (schema->dataTypes[attrNum] != DT_FLOAT) {
+		return RC_RM_ATTR_WRONG_DATATYPE;
+	}
+	memcpy(result, record->data + schema->attrOffsets[attrNum], sizeof(float));
+	return RC_OK;
+}
+
+/**
+ * get a bool attribute without allocating. The result is an int since the
+ * size of bool depends on whether stdbool.h was included before dt.h.
+ * @param  record  the record.
+ * @param  schema  Schema of the record.
+ * @param  attrNum index of the attribute.
+ * @param  result  set to 1 or 0.
+ * @return         RC_OK | RC_RM_ATTR_WRONG_DATATYPE
+ */
+RC getBoolAttr (Record *record, Schema *schema, int attrNum, int *result) {
+	if (schema->dataTypes[attrNum] != DT_BOOL) {
+		return RC_RM_ATTR_WRONG_DATATYPE;
+	}
+	*result = (record->data[schema->attrOffsets[attrNum]] != 0);
+	return RC_OK;
+}
+
+/**
+ * get a string attribute as a pointer into the record data. The string is
+ * NUL terminated (see initSchemaLayout) and valid while the record is.
+ * @param  record  the record.
+ * @param  schema  Schema of the record.
+ * @param  attrNum index of the attribute.
+ * @param  result  set to the string.
+ * @return         RC_OK | RC_RM_ATTR_WRONG_DATATYPE
+ */
+RC getStringAttrRef (Record *record, Schema *schema, int attrNum, char **result) {
+	if (schema->dataTypes[attrNum] != DT_STRING) {
+		return RC_RM_ATTR_WRONG_DATATYPE;
+	}
+	*result = record->data + schema->attrOffsets[attrNum];
+	return RC_OK;
+}
+
 RC setAttr (Record *record, Schema *schema, int attrNum, Value *value){
-    int offset;
-    attrOffset(schema, attrNum, &offset);
-    char *result = record->data+offset;
+    char *result = record->data + schema->attrOffsets[attrNum];
     if(value->dt == DT_INT){
         memcpy(result, &(value->v.intV) ,sizeof(int));
     }
     else if(value->dt == DT_BOOL){
-        memcpy(result, &(value->v.boolV) ,sizeof(bool));
+        *result = (value->v.boolV != 0);
     }
     else if(value->dt == DT_FLOAT){
         memcpy(result, &(value->v.floatV) ,sizeof(float));
     }
     else if(value->dt == DT_STRING){
-        memcpy(result, value->v.stringV, schema->typeLength[attrNum]);
+        strncpy(result, value->v.stringV, schema->typeLength[attrNum]);
+        result[schema->typeLength[attrNum]] = '\0';
     }
 		return RC_OK;
 }
@@ -683,7 +2080,7 @@ int currentTime(char *buffer) {
 	time(&timer);
 	tm_info = localtime(&timer);
 
-	strftime(t, 19, "%Y-%m-%d %H:%M:%S", tm_info);
+	strftime(t, 26, "%Y-%m-%d %H:%M:%S", tm_info);
 	strcpy(buffer, t);
 	free(t);
 
@@ -772,27 +2169,716 @@ char *generateTableInfo(RM_TableData *rel) {
   RETURN_STRING(result);
 }
 
-int tableInfoLength(RM_TableData *rel) {
-	int nameLen = strlen(rel->name);
-	int maxRecordsLen = sizeof(int);
-	int lastAccessedLen = 19; // 2016-11-04 21:10:00
-	int schemaLen = schemaLength(rel->schema);
-	int recordsPerPageLen = sizeof(int);
-	int freespacePointerLen = sizeof(RID *);
-	int total = nameLen + maxRecordsLen + lastAccessedLen + schemaLen + recordsPerPageLen + freespacePointerLen;
-	return total;
-}
+/**
+ * copy a record into a data page slot. A row slot holds the record exactly
+ * as it is laid out in memory (see initSchemaLayout), a PAX slot has every
+ * attribute in its minipage. A decoded compressed page grows to the slot.
+ * @param rel  RM_TableData
+ * @param page the data page.
+ * @param slot the slot.
+ * @param data the record.
+ */
+static void storeSlot(RM_TableData *rel, char *page, int slot, char *data) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	int i;
 
+	if (tableHeader->layout == LAYOUT_ROW) {
+		memcpy(page + 50 + slot * schema->recordSize, data, schema->recordSize);
+		return;
+	}
+	for (i = 0; i < schema->numAttr; i++) {
+		memcpy(slotAttr(tableHeader, schema, page, slot, i), data + schema->attrOffsets[i], schema->attrSizes[i]);
+	}
+	if (tableHeader->layout == LAYOUT_COMPRESSED && slot >= pageSlots(page)) {
+		slot++;
+		memcpy(page + PAGE_SLOTS_OFFSET, &slot, sizeof(int));
+	}
+}
 
-RC deserializePageHeader(char *str, Page_Header *pageHeader) {
+// the record in a slot of a data page: a row is returned where it is, the
+// values of a PAX slot are gathered into row.
+static char *slotRecord(RM_TableData *rel, char *page, int slot, char *row) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	int i;
+
+	if (tableHeader->layout == LAYOUT_ROW) {
+		return page + 50 + slot * schema->recordSize;
+	}
+	memset(row, 0, schema->recordSize);
+	for (i = 0; i < schema->numAttr; i++) {
+		memcpy(row + schema->attrOffsets[i], slotAttr(tableHeader, schema, page, slot, i), schema->attrSizes[i]);
+	}
+	return row;
+}
+
+// where every attribute of the first slot of a data page is and how many
+// bytes apart its values are.
+static void slotColumns(RM_TableData *rel, char *page, char **columns, int *strides) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	int i;
+
+	for (i = 0; i < schema->numAttr; i++) {
+		columns[i] = slotAttr(tableHeader, schema, page, 0, i);
+		strides[i] = (tableHeader->layout != LAYOUT_ROW) ? schema->attrSizes[i] : schema->recordSize;
+	}
+}
+
+// evaluate a compiled condition on the first numSlots slots of a data page.
+// The slots of a decoded compressed page are the ones decodeScanPage left in
+// selection.
+static void filterPage(RM_TableData *rel, ExprFilter *filter, char *page, int numSlots, unsigned char *selection) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+
+	if (tableHeader->layout == LAYOUT_COMPRESSED) {
+		evalFilterSelected(filter, page + PAX_PAGE_OFFSET, tableHeader->recordsPerPage, numSlots, selection);
+	}
+	else if (tableHeader->layout == LAYOUT_PAX) {
+		evalFilterColumns(filter, page + PAX_PAGE_OFFSET, tableHeader->recordsPerPage, numSlots, selection);
+	}
+	else {
+		evalFilterBatch(filter, page + 50, schemaLength(rel->schema), numSlots, selection);
+	}
+}
+
+// bytes of a buffer holding a data page as the slot functions read it, a
+// compressed page decoded into a PAX page needs more than PAGE_SIZE.
+static int pageBufferSize(RM_TableData *rel) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+
+	if (tableHeader->layout != LAYOUT_COMPRESSED) {
+		return PAGE_SIZE;
+	}
+	return PAX_PAGE_OFFSET + tableHeader->recordsPerPage * schemaLength(rel->schema);
+}
+
+// the number of slots of a compressed page, encoded or decoded.
+static int pageSlots(char *page) {
+	int numSlots;
+
+	memcpy(&numSlots, page + PAGE_SLOTS_OFFSET, sizeof(int));
+	return numSlots;
+}
+
+/**
+ * read a data page into a buffer of pageBufferSize bytes, a compressed page
+ * is decoded.
+ * @param  rel     RM_TableData
+ * @param  fh      open file handle of the table.
+ * @param  pageNum the page.
+ * @param  page    receives the page.
+ * @return         RC_OK | RC_READ_NON_EXISTING_PAGE
+ */
+static RC readDataPage(RM_TableData *rel, SM_FileHandle *fh, int pageNum, char *page) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	char *raw;
+	RC rc;
+
+	if (tableHeader->layout != LAYOUT_COMPRESSED) {
+		return readBlock(pageNum, fh, page);
+	}
+	raw = (char *)malloc(PAGE_SIZE);
+	if ((rc = readBlock(pageNum, fh, raw)) == RC_OK) {
+		memcpy(page, raw, PAX_PAGE_OFFSET);
+		decodeColumns(rel->schema, raw + PAX_PAGE_OFFSET, pageSlots(raw), page + PAX_PAGE_OFFSET,
+			tableHeader->recordsPerPage);
+	}
+	free(raw);
+	return rc;
+}
+
+/**
+ * write a data page read by readDataPage, a compressed page is encoded
+ * again. Changed values may no longer fit into the page, then nothing is
+ * written.
+ * @param  rel     RM_TableData
+ * @param  fh      open file handle of the table.
+ * @param  pageNum the page.
+ * @param  page    the page.
+ * @return         RC_OK | RC_RM_PAGE_FULL | RC_WRITE_FAILED
+ */
+static RC writeDataPage(RM_TableData *rel, SM_FileHandle *fh, int pageNum, char *page) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	char *raw;
+	RC rc = RC_OK;
+
+	if (tableHeader->layout != LAYOUT_COMPRESSED) {
+		return writeBlocks(pageNum, 1, fh, page);
+	}
+	raw = (char *)calloc(1, PAGE_SIZE);
+	memcpy(raw, page, PAX_PAGE_OFFSET);
+	if (encodeColumns(rel->schema, page + PAX_PAGE_OFFSET, tableHeader->recordsPerPage, pageSlots(page),
+			raw + PAX_PAGE_OFFSET, PAGE_SIZE - PAX_PAGE_OFFSET) < 0) {
+		rc = RC_RM_PAGE_FULL;
+	}
+	else {
+		rc = writeBlocks(pageNum, 1, fh, raw);
+	}
+	free(raw);
+	return rc;
+}
+
+/**
+ * decode a compressed data page read by a scan. The slots outside the
+ * ranges of the condition are found on the encoded columns first, like a
+ * dictionary code compared to the codes of the constants, and a page
+ * without slots left is not decoded.
+ * @param  rel       RM_TableData
+ * @param  raw       the page as it is stored.
+ * @param  page      receives the decoded page.
+ * @param  ranges    bounds of the condition on every attribute, or NULL.
+ * @param  selection receives the slots left.
+ * @return           number of slots of the page, 0 if none is left.
+ */
+static int decodeScanPage(RM_TableData *rel, char *raw, char *page, ExprRange *ranges, unsigned char *selection) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	int numSlots = pageSlots(raw);
+
+	if (ranges != NULL && selectEncoded(rel->schema, raw + PAX_PAGE_OFFSET, numSlots, ranges, selection) == 0) {
+		return 0;
+	}
+	if (ranges == NULL) {
+		memset(selection, 0xFF, (numSlots + 7) / 8);
+		if (numSlots % 8 != 0) {
+			selection[numSlots / 8] = (1 << (numSlots % 8)) - 1;
+		}
+	}
+	memcpy(page, raw, PAX_PAGE_OFFSET);
+	decodeColumns(rel->schema, raw + PAX_PAGE_OFFSET, numSlots, page + PAX_PAGE_OFFSET, tableHeader->recordsPerPage);
+	return numSlots;
+}
+
+// the bounds a condition puts on every attribute of a compressed table, NULL
+// if it bounds none.
+static ExprRange *scanRanges(RM_TableData *rel, Expr *cond, Arena *arena) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	ExprRange *ranges;
+	int i, bounded = 0;
+
+	if (cond == NULL || tableHeader->layout != LAYOUT_COMPRESSED) {
+		return NULL;
+	}
+	ranges = (ExprRange *)arenaAlloc(arena, sizeof(ExprRange) * (schema->numAttr > 0 ? schema->numAttr : 1));
+	for (i = 0; i < schema->numAttr; i++) {
+		getExprRange(cond, i, &ranges[i]);
+		bounded |= ranges[i].hasLow || ranges[i].hasHigh;
+	}
+	return bounded ? ranges : NULL;
+}
+
+/**
+ * read the page header stored in the first 50 bytes of a page.
+ * @param page       the page.
+ * @param pageHeader Page_Header to fill.
+ */
+static void loadPageHeader(char *page, Page_Header *pageHeader) {
+	char header[51];
+	memcpy(header, page, 50);
+	header[50] = '\0';
+	deserializePageHeader(header, pageHeader);
+}
+
+/**
+ * write a page header into the first 50 bytes of a page.
+ * @param rel        RM_TableData
+ * @param pageHeader the page header.
+ * @param page       the page.
+ */
+static void storePageHeader(RM_TableData *rel, Page_Header *pageHeader, char *page) {
+	char *header = generatePageHeader(rel, pageHeader);
+	memset(page, 0, 50);
+	memcpy(page, header, strlen(header));
+	free(header);
+}
+
+/**
+ * write the table header into page 0 of an open table file.
+ * @param  rel  RM_TableData
+ * @param  fh   open file handle of the table.
+ * @param  page a PAGE_SIZE buffer to work in.
+ * @return      RC_OK | RC_WRITE_FAILED
+ */
+static RC storeTableHeader(RM_TableData *rel, SM_FileHandle *fh, char *page) {
+	RC rc;
+	readBlock(0, fh, page);
+
+	char *tableHeaderStr = generateTableInfo(rel);
+	memcpy(page, tableHeaderStr, strlen(tableHeaderStr));
+	rc = writeBlock(0, fh, page);
+	free(tableHeaderStr);
+	return rc;
+}
+
+/**
+ * read a data page for a batch operation. A page past the end of the file
+ * is started as an empty page.
+ * @param  rel        RM_TableData
+ * @param  fh         open file handle of the table.
+ * @param  pageNum    page to read.
+ * @param  page       a buffer of pageBufferSize bytes receiving the page.
+ * @param  pageHeader receives the page header.
+ * @return            RC_OK | RC_READ_NON_EXISTING_PAGE
+ */
+static RC loadBatchPage(RM_TableData *rel, SM_FileHandle *fh, int pageNum, char *page, Page_Header *pageHeader) {
+	if (pageNum >= fh->totalNumPages) {
+		memset(page, 0, pageBufferSize(rel));
+		initPageHeader(rel, pageHeader, pageNum);
+		return RC_OK;
+	}
+
+	RC rc = readDataPage(rel, fh, pageNum, page);
+	if (rc == RC_OK) {
+		loadPageHeader(page, pageHeader);
+	}
+	return rc;
+}
+
+/**
+ * whether a condition bounds some attribute to an empty range, like
+ * a > 5 AND a < 3, so that no page needs to be read.
+ */
+static int conditionIsEmpty(Schema *schema, Expr *cond) {
+	ExprRange range;
+	int i;
+
+	for (i = 0; cond != NULL && i < schema->numAttr; i++) {
+		getExprRange(cond, i, &range);
+		if (range.empty) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * a thread of a parallel scan: claims morsels until every data page is
+ * taken and calls the callback for the matching records of their pages.
+ */
+static void *parallelScanWorker(void *arg) {
+	ScanWorker *worker = (ScanWorker *)arg;
+	ParallelScan *scan = worker->scan;
+	Schema *schema = scan->rel->schema;
+	Table_Header *tableHeader = (Table_Header *)scan->rel->mgmtData;
+	char *raw = (char *)malloc(PAGE_SIZE);
+	char *page = (tableHeader->layout == LAYOUT_COMPRESSED) ? (char *)malloc(pageBufferSize(scan->rel)) : raw;
+	char *row = (char *)malloc(schemaLength(schema));
+	char **columns = (char **)malloc(sizeof(char *) * schema->numAttr);
+	int *strides = (int *)malloc(sizeof(int) * schema->numAttr);
+	unsigned char *selection = (unsigned char *)malloc((tableHeader->recordsPerPage + 7) / 8);
+	ExprFilter *filter = NULL;
+	Record record;
+	Value value;
+	int morsel, pageNum, lastPage, slot, checkSlots;
+
+	if (scan->cond != NULL) {
+		compileFilter(scan->cond, schema, &filter);
+	}
+
+	while (worker->rc == RC_OK
+			&& (morsel = atomic_fetch_add(&scan->nextMorsel, 1)) * SCAN_MORSEL_PAGES < tableHeader->pageCount) {
+		pageNum = 1 + morsel * SCAN_MORSEL_PAGES;
+		lastPage = pageNum + SCAN_MORSEL_PAGES - 1;
+		if (lastPage > tableHeader->pageCount) {
+			lastPage = tableHeader->pageCount;
+		}
+
+		for (; pageNum <= lastPage; pageNum++) {
+			int usedSlots = (pageNum == tableHeader->freePointer->page)
+				? tableHeader->freePointer->slot : tableHeader->recordsPerPage;
+
+			if (scan->zoneBounds != NULL && !zoneMapMayMatch(tableHeader->zones, pageNum, scan->zoneBounds)) {
+				continue;
+			}
+			if (readBlock(pageNum, &scan->fh, raw) != RC_OK) {
+				worker->rc = RC_READ_NON_EXISTING_PAGE;
+				break;
+			}
+			if (page != raw && (usedSlots = decodeScanPage(scan->rel, raw, page, scan->ranges, selection)) == 0) {
+				continue;
+			}
+			if (filter != NULL) {
+				filterPage(scan->rel, filter, page, usedSlots, selection);
+			}
+			else if (scan->batchCallback != NULL) {
+				memset(selection, 0xFF, (usedSlots + 7) / 8);
+			}
+
+			// a batch scan of a table without deleted records has its
+			// selection already, slots are checked one by one otherwise.
+			checkSlots = scan->batchCallback == NULL || tableHeader->tombstone->itemCount != 0
+				|| (filter == NULL && scan->cond != NULL);
+			for (slot = 0; checkSlots && slot < usedSlots; slot++) {
+				if ((filter != NULL || scan->batchCallback != NULL) && !(selection[slot / 8] & (1 << (slot % 8)))) {
+					continue;
+				}
+				record.id.page = pageNum;
+				record.id.slot = slot;
+				if (isDeletedSlot(tableHeader, record.id)) {
+					selection[slot / 8] &= ~(1 << (slot % 8));
+					continue;
+				}
+				if (scan->batchCallback == NULL || (filter == NULL && scan->cond != NULL)) {
+					record.data = slotRecord(scan->rel, page, slot, row);
+				}
+				if (filter == NULL && scan->cond != NULL) {
+					evalExprInto(&record, schema, scan->cond, &value);
+					if (!value.v.boolV) {
+						selection[slot / 8] &= ~(1 << (slot % 8));
+						continue;
+					}
+				}
+				if (scan->batchCallback == NULL) {
+					scan->callback(worker->thread, &record, scan->context);
+				}
+			}
+			if (scan->batchCallback != NULL && usedSlots > 0) {
+				slotColumns(scan->rel, page, columns, strides);
+				scan->batchCallback(worker->thread, columns, strides, usedSlots, selection, scan->context);
+			}
+		}
+	}
+
+	if (filter != NULL) {
+		freeExprFilter(filter);
+	}
+	free(selection);
+	free(columns);
+	free(strides);
+	free(row);
+	if (page != raw) {
+		free(page);
+	}
+	free(raw);
+	return NULL;
+}
+
+// give the table file and the place in a shared pass of a scan back once it
+// reads no more pages.
+static void releaseScanFile(ScanInfo *scanInfo) {
+	if (scanInfo->shared != NULL) {
+		leaveSharedScan(scanInfo->shared);
+		scanInfo->shared = NULL;
+	}
+	if (scanInfo->fh.mgmtInfo >= 0) {
+		closePageFile(&scanInfo->fh);
+		scanInfo->fh.mgmtInfo = -1;
+	}
+}
+
+// order of two records of an ORDER BY ... LIMIT scan, > 0 if a comes after
+// b. Records with equal values keep the order of the table.
+static int compareTop(TopRecords *top, int a, int b) {
+	int c;
+
+	if (top->schema->dataTypes[top->attr] == DT_STRING) {
+		int offset = top->schema->attrOffsets[top->attr];
+		c = strncmp(top->records + (size_t)a * top->slotLen + offset, top->records + (size_t)b * top->slotLen + offset,
+			top->schema->attrSizes[top->attr]);
+	}
+	else {
+		c = (top->keys[a] > top->keys[b]) - (top->keys[a] < top->keys[b]);
+	}
+	if (top->descending) {
+		c = -c;
+	}
+	if (c == 0) {
+		c = (top->ids[a].page != top->ids[b].page) ? top->ids[a].page - top->ids[b].page : top->ids[a].slot - top->ids[b].slot;
+	}
+	return c;
+}
+
+// move the record at pos of the first count of order down to its place in
+// the heap.
+static void siftTop(TopRecords *top, int pos, int count) {
+	int *order = top->order;
+
+	for (;;) {
+		int child = 2 * pos + 1;
+		int tmp;
+
+		if (child >= count) {
+			break;
+		}
+		if (child + 1 < count && compareTop(top, order[child + 1], order[child]) > 0) {
+			child++;
+		}
+		if (compareTop(top, order[child], order[pos]) <= 0) {
+			break;
+		}
+		tmp = order[pos];
+		order[pos] = order[child];
+		order[child] = tmp;
+		pos = child;
+	}
+}
+
+// keep the record read into the spare record if it is among the best seen,
+// the one it replaces becomes the spare record.
+static void addTopRecord(TopRecords *top, RID id) {
+	int spare = top->spare;
+	Record record;
+	Value value;
+
+	top->ids[spare] = id;
+	if (top->schema->dataTypes[top->attr] != DT_STRING) {
+		record.data = top->records + (size_t)spare * top->slotLen;
+		getAttrInto(&record, top->schema, top->attr, &value);
+		top->keys[spare] = (value.dt == DT_INT) ? value.v.intV : (value.dt == DT_FLOAT) ? value.v.floatV : value.v.boolV;
+	}
+
+	// the heap is filled first, then the spare record replaces its worst
+	if (top->count < top->k) {
+		int pos = top->count++;
+
+		top->order[pos] = spare;
+		top->spare = top->count;
+		while (pos > 0 && compareTop(top, top->order[pos], top->order[(pos - 1) / 2]) > 0) {
+			int parent = (pos - 1) / 2;
+			int tmp = top->order[pos];
+			top->order[pos] = top->order[parent];
+			top->order[parent] = tmp;
+			pos = parent;
+		}
+		return;
+	}
+	if (compareTop(top, spare, top->order[0]) < 0) {
+		top->spare = top->order[0];
+		top->order[0] = spare;
+		siftTop(top, 0, top->count);
+	}
+}
+
+// the data pages of a table by the zone of an attribute of its zone map,
+// smallest low first or largest high first if descending, pages without
+// values last. From the arena of the scan.
+static int *zonePageOrder(RM_TableData *rel, int zone, int descending, Arena *arena) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	ZoneMap *zones = tableHeader->zones;
+	int numPages = tableHeader->pageCount;
+	ZonePage *pages = (ZonePage *)malloc(sizeof(ZonePage) * (numPages > 0 ? numPages : 1));
+	int *order = (int *)arenaAlloc(arena, sizeof(int) * (numPages + 1));
+	int i;
+
+	for (i = 0; i < numPages; i++) {
+		Zone *z = (i < zones->numPages) ? &zones->zones[i * zones->numAttrs + zone] : NULL;
+
+		pages[i].page = i + 1;
+		if (z == NULL || z->low > z->high) {
+			pages[i].key = HUGE_VAL;
+		}
+		else {
+			pages[i].key = descending ? -z->high : z->low;
+		}
+	}
+	qsort(pages, numPages, sizeof(ZonePage), compareZonePages);
+	for (i = 0; i < numPages; i++) {
+		order[i] = pages[i].page;
+	}
+	order[numPages] = numPages + 1;
+	free(pages);
+	return order;
+}
+
+static int compareZonePages(const void *a, const void *b) {
+	const ZonePage *x = (const ZonePage *)a, *y = (const ZonePage *)b;
+
+	if (x->key != y->key) {
+		return (x->key > y->key) - (x->key < y->key);
+	}
+	return x->page - y->page;
+}
+
+/**
+ * read a page into the page buffer of a scan. A shared scan takes it from
+ * the window of its pass if another scan has read it, otherwise it reads
+ * the page and leaves it in the window for the others.
+ * @param  scanInfo the scan
+ * @param  pageNum  the data page
+ * @return          RC_OK | RC_READ_NON_EXISTING_PAGE
+ */
+static RC readScanPage(ScanInfo *scanInfo, int pageNum) {
+	SharedCursor *cursor = scanInfo->shared;
+	SharedScan *shared;
+	int slot = pageNum % SHARED_SCAN_PAGES;
+	struct timespec deadline;
+	int read;
+
+	if (cursor == NULL) {
+		if (readBlock(pageNum, &scanInfo->fh, scanInfo->page) != RC_OK) {
+			return RC_READ_NON_EXISTING_PAGE;
+		}
+		scanInfo->pageReads++;
+		return RC_OK;
+	}
+	shared = cursor->pass;
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	deadline.tv_nsec += SHARED_SCAN_WAIT_MS * 1000000L;
+	deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+	deadline.tv_nsec %= 1000000000L;
+
+	pthread_mutex_lock(&shared->lock);
+	cursor->thread = pthread_self();
+	cursor->page = pageNum;
+	cursor->pagesLeft = scanInfo->pagesLeft;
+	for (;;) {
+		// a slot being read may hold the page we want once it is done
+		if (shared->loading[slot]) {
+			pthread_cond_wait(&shared->changed, &shared->lock);
+			continue;
+		}
+		if (shared->pageNums[slot] == pageNum) {
+			memcpy(scanInfo->page, shared->pages + (size_t)slot * PAGE_SIZE, PAGE_SIZE);
+			cursor->page = pageNum % cursor->lastPage + 1;
+			cursor->pagesLeft--;
+			pthread_cond_broadcast(&shared->changed);
+			pthread_mutex_unlock(&shared->lock);
+			return RC_OK;
+		}
+		if (!cursor->waits || shared->pageNums[slot] == 0 || !pageNeeded(shared, cursor, shared->pageNums[slot])) {
+			break;
+		}
+		if (pthread_cond_timedwait(&shared->changed, &shared->lock, &deadline) == ETIMEDOUT) {
+			cursor->waits = 0;
+		}
+	}
+	shared->loading[slot] = 1;
+	pthread_mutex_unlock(&shared->lock);
+
+	read = (readBlock(pageNum, &scanInfo->fh, scanInfo->page) == RC_OK);
+
+	pthread_mutex_lock(&shared->lock);
+	if (read) {
+		memcpy(shared->pages + (size_t)slot * PAGE_SIZE, scanInfo->page, PAGE_SIZE);
+		shared->pageNums[slot] = pageNum;
+		shared->position = pageNum;
+		cursor->page = pageNum % cursor->lastPage + 1;
+		cursor->pagesLeft--;
+	}
+	else {
+		shared->pageNums[slot] = 0;
+	}
+	shared->loading[slot] = 0;
+	pthread_cond_broadcast(&shared->changed);
+	pthread_mutex_unlock(&shared->lock);
+
+	if (!read) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	scanInfo->pageReads++;
+	return RC_OK;
+}
+
+/**
+ * whether a scan of another thread attached to a shared pass needs a page
+ * within the next SHARED_SCAN_PAGES pages it reads. Scans of the same
+ * thread are not waited for, they cannot move on while the thread waits.
+ * Called with the lock of the pass held.
+ * @param  shared  the pass
+ * @param  self    the asking scan
+ * @param  pageNum the page
+ * @return         1 if the page is needed, 0 otherwise
+ */
+static int pageNeeded(SharedScan *shared, SharedCursor *self, int pageNum) {
+	SharedCursor *cursor;
+	int ahead;
+
+	for (cursor = shared->cursors; cursor != NULL; cursor = cursor->next) {
+		if (cursor == self || cursor->pagesLeft <= 0 || pthread_equal(cursor->thread, self->thread)) {
+			continue;
+		}
+		ahead = (pageNum - cursor->page + cursor->lastPage) % cursor->lastPage;
+		if (ahead < cursor->pagesLeft && ahead < SHARED_SCAN_PAGES) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/**
+ * detach a closed scan from its shared pass, the last one frees it.
+ * @param cursor the scan in the pass
+ */
+static void leaveSharedScan(SharedCursor *cursor) {
+	SharedScan *shared = cursor->pass;
+	SharedScan **link;
+	SharedCursor **cursors;
+
+	pthread_mutex_lock(&sharedScansLock);
+	pthread_mutex_lock(&shared->lock);
+	for (cursors = &shared->cursors; *cursors != cursor; cursors = &(*cursors)->next)
+		;
+	*cursors = cursor->next;
+	pthread_cond_broadcast(&shared->changed);
+	pthread_mutex_unlock(&shared->lock);
+
+	if (shared->cursors == NULL) {
+		for (link = &sharedScans; *link != shared; link = &(*link)->next)
+			;
+		*link = shared->next;
+		pthread_mutex_destroy(&shared->lock);
+		pthread_cond_destroy(&shared->changed);
+		free(shared->pages);
+		free(shared->name);
+		free(shared);
+	}
+	pthread_mutex_unlock(&sharedScansLock);
+}
+
+static int compareBatchEntries(const void *a, const void *b) {
+	const BatchEntry *l = (const BatchEntry *)a;
+	const BatchEntry *r = (const BatchEntry *)b;
+
+	if (l->id.page != r->id.page) {
+		return l->id.page < r->id.page ? -1 : 1;
+	}
+	return l->id.slot - r->id.slot;
+}
+
+/**
+ * sort the positions of a batch by page and slot. The ids are taken from
+ * 'ids' if given, otherwise from the records.
+ * @param  ids     ids of the batch or NULL.
+ * @param  records records of the batch (if ids is NULL).
+ * @param  num     size of the batch.
+ * @return         the sorted entries, to be freed by the caller.
+ */
+static BatchEntry *sortBatch(RID *ids, Record **records, int num) {
+	BatchEntry *entries = (BatchEntry *)malloc(sizeof(BatchEntry) * num);
+	int i;
+
+	for (i = 0; i < num; i++) {
+		entries[i].id = (ids != NULL) ? ids[i] : records[i]->id;
+		entries[i].index = i;
+	}
+	qsort(entries, num, sizeof(BatchEntry), compareBatchEntries);
+	return entries;
+}
+
+int tableInfoLength(RM_TableData *rel) {
+	int nameLen = strlen(rel->name);
+	int maxRecordsLen = sizeof(int);
+	int lastAccessedLen = 19; // 2016-11-04 21:10:00
+	int schemaLen = schemaLength(rel->schema);
+	int recordsPerPageLen = sizeof(int);
+	int freespacePointerLen = sizeof(RID *);
+	int total = nameLen + maxRecordsLen + lastAccessedLen + schemaLen + recordsPerPageLen + freespacePointerLen;
+	return total;
+}
 
-	int vals[4], i;
+
+RC deserializePageHeader(char *str, Page_Header *pageHeader) {
+
+	int vals[4], i;
 
 	i = 0;
 
 	char *token;
 	token = strtok(str, "&");
-	while(token != NULL) {
+	while(token != NULL && i < 4) {
 		vals[i] = atoi(token);
 		token = strtok(NULL, "&");
 		i++;
@@ -840,6 +2926,7 @@ RC initTableManager(Table_Header *manager, Schema *schema) {
 
 	manager->tableCapacity = (TOTAL_PAGES - 1) * ((PAGE_SIZE - 50)/schemaLen);
 	manager->pageCount = 0;
+	manager->totalRecordCount = 0;
 
 	char *timer = (char *)malloc(26);
 	currentTime(timer);
@@ -851,6 +2938,13 @@ RC initTableManager(Table_Header *manager, Schema *schema) {
 	freePointer->page = 1;
 	freePointer->slot = 0;
 	manager->freePointer = freePointer;
+	manager->deletedSlots = NULL;
+	manager->deletedSlotsSize = 0;
+	manager->keyIndex = NULL;
+	manager->keyHash = NULL;
+	manager->stats = NULL;
+	manager->zones = NULL;
+	manager->layout = LAYOUT_ROW;
 
 	return RC_OK;
 }
@@ -880,8 +2974,7 @@ RC parseTableHeader(RM_TableData *rel, char *stringHeader) {
 	DataType dataTypes[numAttr];
 	int typeLength[numAttr];
 	int keyAttrs[numAttr];
-	int keySize = 1;
-	int keys[] = {0};
+	int keySize = loadTableKeys(stringHeader, numAttr, keyAttrs);
 	i = 0;
 
 	for (i = 0; i < numAttr; i++) {
@@ -908,21 +3001,20 @@ RC parseTableHeader(RM_TableData *rel, char *stringHeader) {
   char **cpNames = (char **) malloc(sizeof(char*) * numAttr);
   DataType *cpDt = (DataType *) malloc(sizeof(DataType) * numAttr);
   int *cpSizes = (int *) malloc(sizeof(int) * numAttr);
-  int *cpKeys = (int *) malloc(sizeof(int));
+  int *cpKeys = (int *) malloc(sizeof(int) * keySize);
 
-  for(i = 0; i < 3; i++)
+  for(i = 0; i < numAttr; i++)
     {
-      cpNames[i] = (char *) malloc(2);
+      cpNames[i] = (char *) malloc(strlen(attrNames[i]) + 1);
       strcpy(cpNames[i], attrNames[i]);
     }
-  memcpy(cpDt, dataTypes, sizeof(DataType) * 3);
-  memcpy(cpSizes, typeLength, sizeof(int) * 3);
-  memcpy(cpKeys, keys, sizeof(int));
+  memcpy(cpDt, dataTypes, sizeof(DataType) * numAttr);
+  memcpy(cpSizes, typeLength, sizeof(int) * numAttr);
+  memcpy(cpKeys, keyAttrs, sizeof(int) * keySize);
 
-	schema = createSchema(numAttr, cpNames, cpDt, cpSizes, 1, cpKeys);
+	schema = createSchema(numAttr, cpNames, cpDt, cpSizes, keySize, cpKeys);
 
 
-	rel->name = tableAttrs[0];
 	rel->schema = schema;
 
 	RID *freePointer = (RID *)malloc(sizeof(RID));
@@ -935,10 +3027,19 @@ RC parseTableHeader(RM_TableData *rel, char *stringHeader) {
 	tableHeader->totalRecordCount = atoi(tableAttrs[4]);
 	freePointer->page = atoi(tableAttrs[5]);
 	freePointer->slot = atoi(tableAttrs[6]);
-	tableHeader->lastAccessed = tableAttrs[7];
+	tableHeader->lastAccessed = (char *)malloc(26);
+	strncpy(tableHeader->lastAccessed, tableAttrs[7], 25);
+	tableHeader->lastAccessed[25] = '\0';
 
   // tableHeader->tombstone = createList();
+	tableHeader->deletedSlots = NULL;
+	tableHeader->deletedSlotsSize = 0;
 	tableHeader->freePointer = freePointer;
+	tableHeader->keyIndex = NULL;
+	tableHeader->keyHash = NULL;
+	tableHeader->stats = NULL;
+	tableHeader->zones = NULL;
+	tableHeader->layout = loadTableLayout(stringHeader);
 
 	rel->mgmtData = tableHeader;
 
@@ -979,53 +3080,18 @@ RC initPageHeader(RM_TableData *rel, Page_Header *pageHeader, int pageId) {
 }
 
 
+/**
+ * build a record from the content of a data page slot.
+ * @param  schema       Schema of the record.
+ * @param  recordString start of the slot.
+ * @param  id           RID of the record.
+ * @return              the record, free it with freeRecord.
+ */
 Record *deserializeRecord(Schema *schema, char *recordString, RID id) {
-	char *token;
-	token = strtok(recordString, "&");
-	int i = 0;
-    int index = 0;
-	char **temp = malloc((schema->numAttr) * sizeof(char *));
-
-	while (token != NULL && i < schema->numAttr)
-	{
-		temp[i] = malloc(strlen(token));
-		temp[i] = token;
-		token = strtok (NULL, "&");
-		i++;
-	}
-
 	Record *record;
-	Value *value = (Value *)malloc(sizeof(Value));
 
 	createRecord(&record, schema);
-
-	int offset;
-
-
-
-	for (i = 0; i < schema->numAttr; i++) {
-
-		switch (schema->dataTypes[i]) {
-			case DT_INT:
-				MAKE_VALUE(value, DT_INT, atoi(temp[i]));
-				setAttr(record, schema, i, value);
-				break;
-			case DT_STRING:
-				MAKE_STRING_VALUE(value, temp[i]);
-				setAttr(record, schema, i, value);
-				break;
-			case DT_FLOAT:
-				MAKE_VALUE(value, DT_FLOAT, atoi(temp[i]));
-				setAttr(record, schema, i, value);
-				break;
-			case DT_BOOL:
-				MAKE_VALUE(value, DT_BOOL, strtof(temp[i], NULL));
-				setAttr(record, schema, i, value);
-				break;
-		}
-		freeVal(value);
-	}
-	free(temp);
+	memcpy(record->data, recordString, getRecordSize(schema));
 	record->id = id;
 
 	return record;
@@ -1033,7 +3099,7 @@ Record *deserializeRecord(Schema *schema, char *recordString, RID id) {
 
 RID *deserializeTombstoneNode(char *str) {
 	RID *r;
-	char *new = (char *)malloc(sizeof(strlen(str)));
+	char *new = (char *)malloc(strlen(str) + 1);
 	strcpy(new, str);
 	if (((r = (RID *)malloc(sizeof(RID))) == NULL)) {
 		// printf("Creating tombstone node fails\n");
@@ -1065,15 +3131,88 @@ RID *deserializeTombstoneNode(char *str) {
 	return r;
 }
 
-List *deserializeTombstoneList(char *str) {
-	if (strlen(str) == 0) {
-		// printf("create new list \n");
-		return createList();
+/**
+ * write the primary key attributes of a schema to the end of page 0, as
+ * "keySize&attr&attr&".
+ * @param schema the schema.
+ * @param page   page 0 of the table.
+ */
+static void storeTableKeys(Schema *schema, char *page) {
+	char *keys = page + TABLE_KEYS_OFFSET;
+	int size = PAGE_SIZE - TABLE_KEYS_OFFSET;
+	int i, length;
+
+	memset(keys, 0, size);
+	length = snprintf(keys, size, "%d&", schema->keySize);
+	for (i = 0; i < schema->keySize && length < size; i++) {
+		length += snprintf(keys + length, size - length, "%d&", schema->keyAttrs[i]);
 	}
 
-	// e.g. char s[] = "(3,2)&(4,7)&(9,3)&(3,5)&";
-	// create a list (3,2)->(4,7)->(9,3)->(3,5)->NULL.
-  char *token;
+	// a list that does not fit is not stored at all.
+	if (length >= size) {
+		memset(keys, 0, size);
+	}
+}
+
+/**
+ * read the primary key attributes stored by storeTableKeys. Tables written
+ * before they were stored are keyed on their first attribute.
+ * @param  page    page 0 of the table.
+ * @param  numAttr number of attributes of the table.
+ * @param  keys    receives up to numAttr key attributes.
+ * @return         number of key attributes.
+ */
+static int loadTableKeys(char *page, int numAttr, int *keys) {
+	char *str = page + TABLE_KEYS_OFFSET;
+	char *end;
+	int i, keySize;
+
+	keySize = (int)strtol(str, &end, 10);
+	if (end == str || keySize < 1 || keySize > numAttr) {
+		keys[0] = 0;
+		return 1;
+	}
+
+	for (i = 0; i < keySize; i++) {
+		str = end + 1;
+		keys[i] = (int)strtol(str, &end, 10);
+		if (end == str || keys[i] < 0 || keys[i] >= numAttr) {
+			keys[0] = 0;
+			return 1;
+		}
+	}
+	return keySize;
+}
+
+// write the layout of the data pages into page 0 of a table.
+static void storeTableLayout(TableLayout layout, char *page) {
+	memset(page + TABLE_LAYOUT_OFFSET, 0, TABLE_KEYS_OFFSET - TABLE_LAYOUT_OFFSET);
+	if (layout == LAYOUT_PAX) {
+		strcpy(page + TABLE_LAYOUT_OFFSET, "pax");
+	}
+	else if (layout == LAYOUT_COMPRESSED) {
+		strcpy(page + TABLE_LAYOUT_OFFSET, "cpax");
+	}
+}
+
+// the layout stored by storeTableLayout, rows for tables written before it
+// was stored.
+static TableLayout loadTableLayout(char *page) {
+	if (strncmp(page + TABLE_LAYOUT_OFFSET, "cpax", 5) == 0) {
+		return LAYOUT_COMPRESSED;
+	}
+	return (strncmp(page + TABLE_LAYOUT_OFFSET, "pax", 4) == 0) ? LAYOUT_PAX : LAYOUT_ROW;
+}
+
+List *deserializeTombstoneList(char *str) {
+	if (strlen(str) == 0) {
+		// printf("create new list \n");
+		return createList();
+	}
+
+	// e.g. char s[] = "(3,2)&(4,7)&(9,3)&(3,5)&";
+	// create a list (3,2)->(4,7)->(9,3)->(3,5)->NULL.
+  char *token;
   token = strtok(str, "&");
 	List *l = createList();
 	RID *r;
@@ -1110,43 +3249,258 @@ char *serializeTombstonList(List *l) {
 }
 
 /**
- * start a scan handle to check primary key attribute(s) through every record.
- * @param  rel RM_TableDat
+ * copy the primary key attributes of a record into key. Data page slots have
+ * the same layout as Record->data, so data may also point into a page.
+ * Strings are copied up to their terminator and zero padded, so equal keys
+ * always have equal bytes.
+ * @param schema Schema of the record.
+ * @param data   the record data.
+ * @param key    receives keyLength(schema) bytes.
+ */
+static void extractKey(Schema *schema, char *data, char *key) {
+	int i;
+
+	for (i = 0; i < schema->keySize; i++) {
+		int attr = schema->keyAttrs[i];
+		if (schema->dataTypes[attr] == DT_STRING) {
+			strncpy(key, data + schema->attrOffsets[attr], schema->attrSizes[attr]);
+		}
+		else {
+			memcpy(key, data + schema->attrOffsets[attr], schema->attrSizes[attr]);
+		}
+		key += schema->attrSizes[attr];
+	}
+}
+
+// size of a key produced by extractKey.
+static int keyLength(Schema *schema) {
+	int i, length = 0;
+
+	for (i = 0; i < schema->keySize; i++) {
+		length += schema->attrSizes[schema->keyAttrs[i]];
+	}
+	return length;
+}
+
+/**
+ * get the primary key index of an open table. The first call builds it from
+ * every live record, afterwards inserts, updates and deletes keep it up to
+ * date until the table is closed.
+ * @param  rel RM_TableData
+ * @return     the index, or NULL if the table has no key.
+ */
+static KeyIndex *loadKeyIndex(RM_TableData *rel) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	RM_ScanHandle sc;
+	Record *record;
+	KeyIndex *index;
+
+	if (tableHeader->keyIndex != NULL || schema->keySize <= 0) {
+		return tableHeader->keyIndex;
+	}
+	if ((index = createKeyIndex(keyLength(schema))) == NULL) {
+		return NULL;
+	}
+
+	char key[index->keySize];
+	if (startScan(rel, &sc, NULL) == RC_OK) {
+		createRecordInArena(&record, schema, getScanArena(&sc));
+		while (next(&sc, record) == RC_OK) {
+			extractKey(schema, record->data, key);
+			keyIndexInsert(index, key, record->id);
+		}
+		closeScan(&sc);
+	}
+
+	tableHeader->keyIndex = index;
+	return index;
+}
+
+/**
+ * move the key index entry of the record at id from the key in oldData to
+ * the one in newData. Either may be NULL for a record that is inserted or
+ * deleted. Nothing is done while the table has no index.
+ * @param  rel     RM_TableData
+ * @param  oldData the stored record, or NULL.
+ * @param  newData the new record, or NULL.
+ * @param  id      id of the record.
+ * @param  check   refuse a new key held by another record if primary key
+ *                 checking is on.
+ * @return         RC_OK | RC_DUPLICATED_PRIMARYKEY
+ */
+static RC updateKeyIndex(RM_TableData *rel, char *oldData, char *newData, RID id, int check) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	KeyIndex *index = tableHeader->keyIndex;
+	int keySize = keyLength(rel->schema);
+
+	check = check && config != NULL && config->primaryKeyCheck;
+	if (check) {
+		index = loadKeyIndex(rel);
+	}
+	if (keySize == 0 || (index == NULL && tableHeader->keyHash == NULL)) {
+		return RC_OK;
+	}
+
+	char oldKey[keySize], newKey[keySize];
+	if (oldData != NULL) {
+		extractKey(rel->schema, oldData, oldKey);
+	}
+	if (newData != NULL) {
+		extractKey(rel->schema, newData, newKey);
+		if (oldData != NULL && memcmp(oldKey, newKey, keySize) == 0) {
+			return RC_OK;
+		}
+		if (check && index != NULL && keyIndexFind(index, newKey, &id, NULL)) {
+			return RC_DUPLICATED_PRIMARYKEY;
+		}
+	}
+
+	if (index != NULL) {
+		if (oldData != NULL) {
+			keyIndexRemove(index, oldKey, id);
+		}
+		if (newData != NULL) {
+			keyIndexInsert(index, newKey, id);
+		}
+	}
+	updateKeyHash(rel, oldData != NULL ? oldKey : NULL, newData != NULL ? newKey : NULL, id);
+	return RC_OK;
+}
+
+/**
+ * check a batch of records that is going to be inserted for keys that are
+ * already in the table or appear twice in the batch.
+ * @param  rel        RM_TableData
+ * @param  records    the records.
+ * @param  numRecords number of records.
+ * @return            RC_OK | RC_DUPLICATED_PRIMARYKEY
+ */
+static RC checkBatchKeys(RM_TableData *rel, Record **records, int numRecords) {
+	KeyIndex *index = loadKeyIndex(rel);
+	KeyIndex *batch;
+	RID none = {-1, -1};
+	RC rc = RC_OK;
+	int i;
+
+	if (index == NULL || (batch = createKeyIndex(index->keySize)) == NULL) {
+		return RC_OK;
+	}
+
+	char key[index->keySize];
+	for (i = 0; i < numRecords && rc == RC_OK; i++) {
+		extractKey(rel->schema, records[i]->data, key);
+		if (keyIndexFind(index, key, NULL, NULL) || keyIndexFind(batch, key, NULL, NULL)) {
+			rc = RC_DUPLICATED_PRIMARYKEY;
+		}
+		else {
+			keyIndexInsert(batch, key, none);
+		}
+	}
+
+	freeKeyIndex(batch);
+	return rc;
+}
+
+/**
+ * move the key index entries of a batch of updated records to their new
+ * keys before any page is written. If a new key is held by a record outside
+ * the batch, or twice within it, and primary key checking is on, the index
+ * is restored and RC_DUPLICATED_PRIMARYKEY returned.
+ * @param  rel        RM_TableData
+ * @param  fh         open file handle of the table.
+ * @param  entries    the batch sorted by sortBatch.
+ * @param  records    the new records.
+ * @param  numRecords number of records.
+ * @param  page       a PAGE_SIZE buffer to read the stored records into.
+ * @return            RC_OK | RC_DUPLICATED_PRIMARYKEY | RC_READ_NON_EXISTING_PAGE
+ */
+static RC updateBatchKeys(RM_TableData *rel, SM_FileHandle *fh, BatchEntry *entries, Record **records, int numRecords, char *page) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	int check = config != NULL && config->primaryKeyCheck;
+	KeyIndex *index = check ? loadKeyIndex(rel) : tableHeader->keyIndex;
+	int slotLen = schemaLength(rel->schema);
+	int keySize = keyLength(rel->schema);
+	RC rc = RC_OK;
+	int i, j;
+
+	if (keySize == 0 || (index == NULL && tableHeader->keyHash == NULL)) {
+		return RC_OK;
+	}
+
+	char *oldKeys = (char *)malloc(numRecords * keySize);
+	char *newKeys = (char *)malloc(numRecords * keySize);
+	char *removed = (char *)calloc(numRecords, 1);
+	char *row = (char *)malloc(slotLen);
+
+	// the stored keys, read page by page.
+	for (i = 0; i < numRecords && rc == RC_OK; ) {
+		int pageNum = entries[i].id.page;
+
+		if ((rc = readBlock(pageNum, fh, page)) != RC_OK) {
+			break;
+		}
+		for (; i < numRecords && entries[i].id.page == pageNum; i++) {
+			extractKey(rel->schema, slotRecord(rel, page, entries[i].id.slot, row), oldKeys + i * keySize);
+			extractKey(rel->schema, records[entries[i].index]->data, newKeys + i * keySize);
+		}
+	}
+
+	// take out all old keys first, so that records of the batch may swap keys.
+	for (i = 0; i < numRecords && rc == RC_OK && index != NULL; i++) {
+		removed[i] = keyIndexRemove(index, oldKeys + i * keySize, entries[i].id);
+	}
+
+	for (i = 0; i < numRecords && rc == RC_OK && index != NULL; i++) {
+		if (check && keyIndexFind(index, newKeys + i * keySize, NULL, NULL)) {
+			for (j = 0; j < i; j++) {
+				keyIndexRemove(index, newKeys + j * keySize, entries[j].id);
+			}
+			for (j = 0; j < numRecords; j++) {
+				if (removed[j]) {
+					keyIndexInsert(index, oldKeys + j * keySize, entries[j].id);
+				}
+			}
+			rc = RC_DUPLICATED_PRIMARYKEY;
+			break;
+		}
+		keyIndexInsert(index, newKeys + i * keySize, entries[i].id);
+	}
+
+	for (i = 0; i < numRecords && rc == RC_OK; i++) {
+		updateKeyHash(rel, oldKeys + i * keySize, NULL, entries[i].id);
+	}
+	for (i = 0; i < numRecords && rc == RC_OK; i++) {
+		updateKeyHash(rel, NULL, newKeys + i * keySize, entries[i].id);
+	}
+
+	free(oldKeys);
+	free(newKeys);
+	free(removed);
+	free(row);
+	return rc;
+}
+
+/**
+ * check the primary key of a record that is going to be inserted against
+ * the key index of the table. All key attributes are compared.
+ * @param  rel RM_TableData
  * @param  r   the record that is going to be inserted into record manager.
  * @return     RC_OK | RC_DUPLICATED_PRIMARYKEY
  */
 RC primaryKeyCheck(RM_TableData *rel, Record *r) {
-  Record *foundRecord = (Record *)malloc(sizeof(Record));
-  Table_Header *tableheader = (Table_Header *)rel->mgmtData;
-  RC rc;
-  int found = 0;
-  Schema *schema = rel->schema;
-  RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
-  Expr *sel, *left, *right;
-  int i;
-  Value *value;
-
-  int keyAttr = schema->keyAttrs[0];
-  getAttr(r, schema, keyAttr, &value);
+	KeyIndex *index = loadKeyIndex(rel);
 
-  MAKE_CONS(left, value);
-  MAKE_ATTRREF(right, keyAttr);
-  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
-  startScan(rel, sc, sel);
+	if (index == NULL) {
+		return RC_OK;
+	}
 
-  while((rc = next(sc, foundRecord)) == RC_OK) {
-    found = 1;
-		break;
-  }
-	closeScan(sc);
-	if (found == 1) {
-		// printList(tableheader->tombstone);
-		int f = find(tableheader->tombstone, foundRecord->id);
-		free(foundRecord);
-		if (f == RC_NOT_FOUND_IN_TOMBSTONE)
-			return RC_DUPLICATED_PRIMARYKEY;
+	char key[index->keySize];
+	extractKey(rel->schema, r->data, key);
+	if (keyIndexFind(index, key, NULL, NULL)) {
+		return RC_DUPLICATED_PRIMARYKEY;
 	}
-  return RC_OK;
+	return RC_OK;
 }
 
 /**
@@ -1174,3 +3528,1035 @@ RC find(List *l, RID id) {
   }
   return RC_NOT_FOUND_IN_TOMBSTONE;
 }
+
+// name of the hash index file of a table.
+static char *keyHashName(char *name) {
+	char *result = (char *)malloc(strlen(name) + 6);
+
+	strcpy(result, name);
+	strcat(result, ".hash");
+	return result;
+}
+
+// the Value of a one attribute key produced by extractKey.
+static void keyToValue(Schema *schema, char *key, Value *value) {
+	value->dt = schema->dataTypes[schema->keyAttrs[0]];
+	switch (value->dt) {
+	case DT_INT:
+		memcpy(&value->v.intV, key, sizeof(int));
+		break;
+	case DT_FLOAT:
+		memcpy(&value->v.floatV, key, sizeof(float));
+		break;
+	case DT_BOOL:
+		value->v.boolV = (*key != 0);
+		break;
+	case DT_STRING:
+		value->v.stringV = key;
+		break;
+	}
+}
+
+/**
+ * move the hash index entry of the record at id from oldKey to newKey, see
+ * updateKeyIndex. The entry of oldKey is only removed if it belongs to id,
+ * and a newKey already in the index keeps its entry, so that duplicates
+ * loaded without a key check do not take each other's entries.
+ * @param rel    RM_TableData
+ * @param oldKey key bytes the record had, or NULL.
+ * @param newKey key bytes the record has now, or NULL.
+ * @param id     id of the record.
+ */
+static void updateKeyHash(RM_TableData *rel, char *oldKey, char *newKey, RID id) {
+	HashHandle *hash = ((Table_Header *)rel->mgmtData)->keyHash;
+	Value value;
+	RID found;
+
+	if (hash == NULL) {
+		return;
+	}
+	if (oldKey != NULL) {
+		keyToValue(rel->schema, oldKey, &value);
+		if (findHashKey(hash, &value, &found) == RC_OK && found.page == id.page && found.slot == id.slot) {
+			deleteHashKey(hash, &value);
+		}
+	}
+	if (newKey != NULL) {
+		keyToValue(rel->schema, newKey, &value);
+		insertHashKey(hash, &value, id);
+	}
+}
+
+/**
+ * build a persistent hash index on the primary key of a table, stored in
+ * the file "<table>.hash". From then on the index is opened with the table,
+ * kept up to date by every insert, update and delete, and used by
+ * getRecordByKey. An existing index is built again.
+ * @param  rel RM_TableData
+ * @return     RC_OK | RC_IM_COMPOSITE_KEY | RC_FILE_NOT_FOUND
+ */
+RC createKeyHash (RM_TableData *rel) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	RM_ScanHandle sc;
+	Record *record;
+	RC rc;
+
+	if (schema->keySize != 1) {
+		THROW(RC_IM_COMPOSITE_KEY, "a hash index needs a key of one attribute");
+	}
+
+	char *hashName = keyHashName(rel->name);
+	if (tableHeader->keyHash != NULL) {
+		char *oldName = tableHeader->keyHash->idxId;
+		closeHashIndex(tableHeader->keyHash);
+		free(oldName);
+		tableHeader->keyHash = NULL;
+	}
+	if (access(hashName, F_OK) == 0) {
+		deleteHashIndex(hashName);
+	}
+
+	int attr = schema->keyAttrs[0];
+	if (schema->dataTypes[attr] == DT_STRING) {
+		rc = createStringHashIndex(hashName, schema->typeLength[attr]);
+	}
+	else {
+		rc = createHashIndex(hashName, schema->dataTypes[attr]);
+	}
+	if (rc != RC_OK || (rc = openHashIndex(&tableHeader->keyHash, hashName)) != RC_OK) {
+		free(hashName);
+		return rc;
+	}
+
+	if ((rc = startScan(rel, &sc, NULL)) != RC_OK) {
+		return rc;
+	}
+
+	// the keys are inserted a batch at a time, which reads every bucket once
+	// per batch, see insertHashKeys.
+	int keySize = keyLength(schema), numKeys = 0;
+	char *keys = (char *)malloc((size_t)KEY_HASH_BATCH * keySize);
+	Value *values = (Value *)malloc(sizeof(Value) * KEY_HASH_BATCH);
+	RID *ids = (RID *)malloc(sizeof(RID) * KEY_HASH_BATCH);
+
+	createRecordInArena(&record, schema, getScanArena(&sc));
+	while (next(&sc, record) == RC_OK) {
+		extractKey(schema, record->data, keys + (size_t)numKeys * keySize);
+		keyToValue(schema, keys + (size_t)numKeys * keySize, &values[numKeys]);
+		ids[numKeys++] = record->id;
+		if (numKeys == KEY_HASH_BATCH) {
+			insertHashKeys(tableHeader->keyHash, values, ids, numKeys);
+			numKeys = 0;
+		}
+	}
+	insertHashKeys(tableHeader->keyHash, values, ids, numKeys);
+	closeScan(&sc);
+
+	free(keys);
+	free(values);
+	free(ids);
+	return RC_OK;
+}
+
+/**
+ * get the record with a primary key. The hash index of the table is used if
+ * the table has one, then the key index kept for primary key checks, and
+ * otherwise the table is scanned.
+ * @param  rel    RM_TableData
+ * @param  key    a value for every key attribute, in key order.
+ * @param  record receives the record, like getRecord.
+ * @return        RC_OK | RC_IM_KEY_NOT_FOUND | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+RC getRecordByKey (RM_TableData *rel, Value *key, Record *record) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	RM_ScanHandle sc;
+	Record *found, probe;
+	Expr *cond = NULL, *left, *right, *equal;
+	RID id;
+	RC rc;
+	int i;
+
+	for (i = 0; i < schema->keySize; i++) {
+		if (key[i].dt != schema->dataTypes[schema->keyAttrs[i]]) {
+			THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "key has a different type than the key attribute");
+		}
+	}
+
+	if (tableHeader->keyHash != NULL) {
+		if ((rc = findHashKey(tableHeader->keyHash, key, &id)) != RC_OK) {
+			return rc;
+		}
+		return getRecord(rel, id, record);
+	}
+
+	if (tableHeader->keyIndex != NULL) {
+		// the key as stored in a record.
+		char probeKey[keyLength(schema)];
+		probe.data = (char *)calloc(1, getRecordSize(schema));
+		for (i = 0; i < schema->keySize; i++) {
+			setAttr(&probe, schema, schema->keyAttrs[i], &key[i]);
+		}
+		extractKey(schema, probe.data, probeKey);
+		free(probe.data);
+
+		if (!keyIndexFind(tableHeader->keyIndex, probeKey, NULL, &id)) {
+			return RC_IM_KEY_NOT_FOUND;
+		}
+		return getRecord(rel, id, record);
+	}
+
+	// otherwise the table is scanned for a record whose key attributes equal
+	// the key, so that the compiled filter of the scan tests a page at a
+	// time. strings are cut to the attribute length like stored keys.
+	for (i = 0; i < schema->keySize; i++) {
+		int attr = schema->keyAttrs[i];
+		Value *value = (Value *)malloc(sizeof(Value));
+		Value *input = &key[i];
+
+		CPVAL(value, input);
+		if (value->dt == DT_STRING && (int)strlen(value->v.stringV) > schema->typeLength[attr]) {
+			value->v.stringV[schema->typeLength[attr]] = '\0';
+		}
+		MAKE_ATTRREF(left, attr);
+		MAKE_CONS(right, value);
+		MAKE_BINOP_EXPR(equal, left, right, OP_COMP_EQUAL);
+		if (cond == NULL) {
+			cond = equal;
+		}
+		else {
+			MAKE_BINOP_EXPR(cond, cond, equal, OP_BOOL_AND);
+		}
+	}
+
+	if ((rc = startScan(rel, &sc, cond)) != RC_OK) {
+		freeExpr(cond);
+		return rc;
+	}
+	createRecordInArena(&found, schema, getScanArena(&sc));
+	rc = RC_IM_KEY_NOT_FOUND;
+	if (next(&sc, found) == RC_OK) {
+		if (record->data == NULL) {
+			record->data = (char *)malloc(getRecordSize(schema));
+		}
+		memcpy(record->data, found->data, getRecordSize(schema));
+		record->id = found->id;
+		rc = RC_OK;
+	}
+	closeScan(&sc);
+	freeExpr(cond);
+	return rc;
+}
+
+// name of the file that takes the tombstone entries page 0 has no room for.
+static char *tombstoneName(char *name) {
+	char *result = (char *)malloc(strlen(name) + 11);
+
+	strcpy(result, name);
+	strcat(result, ".tombstone");
+	return result;
+}
+
+// write the tombstone list of a table into its page 0 and the entries that
+// do not fit there into the tombstone file, which is removed when all fit.
+static RC storeTombstone(RM_TableData *rel, char *page) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	char *list = serializeTombstonList(tableHeader->tombstone);
+	char *name = tombstoneName(rel->name);
+	int listLength = strlen(list);
+	int length = listLength;
+	RC rc = RC_OK;
+
+	// page 0 takes the entries that fit between the table info and the
+	// layout, with a NUL after them.
+	if (length > TABLE_LAYOUT_OFFSET - TABLE_TOMBSTONE_OFFSET - 1) {
+		length = TABLE_LAYOUT_OFFSET - TABLE_TOMBSTONE_OFFSET - 1;
+		while (length > 0 && list[length - 1] != '&') {
+			length--;
+		}
+	}
+	memset(page + TABLE_TOMBSTONE_OFFSET, 0, TABLE_LAYOUT_OFFSET - TABLE_TOMBSTONE_OFFSET);
+	memcpy(page + TABLE_TOMBSTONE_OFFSET, list, length);
+
+	if (length < listLength) {
+		// the rest is followed by at least one NUL in the last page.
+		int numPages = (listLength - length) / PAGE_SIZE + 1;
+		char *pages = (char *)calloc(numPages, PAGE_SIZE);
+		SM_FileHandle fh;
+
+		memcpy(pages, list + length, listLength - length);
+		if ((rc = createPageFile(name)) == RC_OK && (rc = openPageFile(name, &fh)) == RC_OK) {
+			rc = writeBlocks(0, numPages, &fh, pages);
+			closePageFile(&fh);
+		}
+		free(pages);
+	}
+	else if (access(name, F_OK) == 0) {
+		rc = destroyPageFile(name);
+	}
+
+	free(list);
+	free(name);
+	return rc;
+}
+
+// read the tombstone list of a table from its page 0 and the tombstone file.
+static List *loadTombstone(char *name, char *page) {
+	char *fileName = tombstoneName(name);
+	SM_FileHandle fh;
+	List *l;
+	int i;
+
+	if (access(fileName, F_OK) == 0 && openPageFile(fileName, &fh) == RC_OK) {
+		int length = strlen(page + TABLE_TOMBSTONE_OFFSET);
+		char *list = (char *)malloc(length + (size_t)fh.totalNumPages * PAGE_SIZE + 1);
+
+		memcpy(list, page + TABLE_TOMBSTONE_OFFSET, length);
+		for (i = 0; i < fh.totalNumPages && readBlock(i, &fh, list + length) == RC_OK; i++) {
+			length += PAGE_SIZE;
+		}
+		list[length] = '\0';
+		closePageFile(&fh);
+		l = deserializeTombstoneList(list);
+		free(list);
+	}
+	else {
+		l = deserializeTombstoneList(page + TABLE_TOMBSTONE_OFFSET);
+	}
+
+	free(fileName);
+	return l;
+}
+
+// check that no record of a sorted batch is deleted already or twice.
+static RC checkDeletedBatch(Table_Header *tableHeader, BatchEntry *entries, int numIds) {
+	int i;
+
+	for (i = 0; i < numIds; i++) {
+		if (isDeletedSlot(tableHeader, entries[i].id)
+				|| (i > 0 && compareBatchEntries(&entries[i - 1], &entries[i]) == 0)) {
+			return RC_TUPLE_NOT_FOUND;
+		}
+	}
+	return RC_OK;
+}
+
+// set or clear the bit of a slot in the bitmap of the slots in the tombstone.
+// Bit page * recordsPerPage + slot belongs to a slot, the bitmap grows with
+// the highest deleted slot.
+static void setDeletedSlot(Table_Header *tableHeader, RID id, int deleted) {
+	long bit = (long)id.page * tableHeader->recordsPerPage + id.slot;
+	int size = tableHeader->deletedSlotsSize;
+
+	if (id.page < 0 || id.slot < 0 || id.slot >= tableHeader->recordsPerPage) {
+		return;
+	}
+	if (bit / 8 >= size) {
+		if (!deleted) {
+			return;
+		}
+		while (bit / 8 >= size) {
+			size = (size == 0) ? 64 : size * 2;
+		}
+		tableHeader->deletedSlots = (unsigned char *)realloc(tableHeader->deletedSlots, size);
+		memset(tableHeader->deletedSlots + tableHeader->deletedSlotsSize, 0, size - tableHeader->deletedSlotsSize);
+		tableHeader->deletedSlotsSize = size;
+	}
+	if (deleted) {
+		tableHeader->deletedSlots[bit / 8] |= 1 << (bit % 8);
+	}
+	else {
+		tableHeader->deletedSlots[bit / 8] &= ~(1 << (bit % 8));
+	}
+}
+
+// true if the slot of a record is in the tombstone.
+static inline int isDeletedSlot(Table_Header *tableHeader, RID id) {
+	long bit = (long)id.page * tableHeader->recordsPerPage + id.slot;
+
+	return id.page >= 0 && id.slot >= 0 && id.slot < tableHeader->recordsPerPage
+		&& bit / 8 < tableHeader->deletedSlotsSize && (tableHeader->deletedSlots[bit / 8] & (1 << (bit % 8)));
+}
+
+// name of the statistics file of a table.
+static char *statsName(char *name) {
+	char *result = (char *)malloc(strlen(name) + 7);
+
+	strcpy(result, name);
+	strcat(result, ".stats");
+	return result;
+}
+
+// next number of a xorshift generator, analyzeTable starts from the same
+// state every time so the same table gives the same statistics.
+static unsigned long long nextRandom(unsigned long long *state) {
+	*state ^= *state << 13;
+	*state ^= *state >> 7;
+	*state ^= *state << 17;
+	return *state;
+}
+
+// hash of an attribute of a slot; a string is hashed up to its NUL.
+static unsigned long long hashAttr(Schema *schema, char *data, int attr) {
+	char *value = data + schema->attrOffsets[attr];
+	int size = schema->attrSizes[attr];
+
+	return hllHash(value, (schema->dataTypes[attr] == DT_STRING) ? (int)strnlen(value, size) : size);
+}
+
+// order pointers to attribute values of one datatype.
+static int compareStatsInts(const void *a, const void *b) {
+	int x, y;
+
+	memcpy(&x, *(char **)a, sizeof(int));
+	memcpy(&y, *(char **)b, sizeof(int));
+	return (x > y) - (x < y);
+}
+
+static int compareStatsStrings(const void *a, const void *b) {
+	return strcmp(*(char **)a, *(char **)b);
+}
+
+static int compareStatsFloats(const void *a, const void *b) {
+	float x, y;
+
+	memcpy(&x, *(char **)a, sizeof(float));
+	memcpy(&y, *(char **)b, sizeof(float));
+	return (x > y) - (x < y);
+}
+
+static int compareStatsBools(const void *a, const void *b) {
+	return (**(char **)a != 0) - (**(char **)b != 0);
+}
+
+// indexed by DataType
+static int (*statsComparators[])(const void *, const void *) = {
+	compareStatsInts, compareStatsStrings, compareStatsFloats, compareStatsBools
+};
+
+// order two values of the same datatype like strcmp.
+static int compareStatsValues(Value *left, Value *right) {
+	switch (left->dt) {
+		case DT_INT:
+			return (left->v.intV > right->v.intV) - (left->v.intV < right->v.intV);
+		case DT_FLOAT:
+			return (left->v.floatV > right->v.floatV) - (left->v.floatV < right->v.floatV);
+		case DT_BOOL:
+			return (left->v.boolV != 0) - (right->v.boolV != 0);
+		default:
+			return strcmp(left->v.stringV, right->v.stringV);
+	}
+}
+
+// the Value of the stored bytes of an attribute, a string is copied.
+static void statsValue(DataType dt, char *data, Value *value) {
+	value->dt = dt;
+	switch (dt) {
+		case DT_INT:
+			memcpy(&value->v.intV, data, sizeof(int));
+			break;
+		case DT_FLOAT:
+			memcpy(&value->v.floatV, data, sizeof(float));
+			break;
+		case DT_BOOL:
+			value->v.boolV = (*data != 0);
+			break;
+		case DT_STRING:
+			value->v.stringV = (char *)malloc(strlen(data) + 1);
+			strcpy(value->v.stringV, data);
+			break;
+	}
+}
+
+// order 64 bit hashes.
+static int compareStatsHashes(const void *a, const void *b) {
+	unsigned long long x = *(const unsigned long long *)a, y = *(const unsigned long long *)b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * the number of distinct values of an attribute in n records, estimated from
+ * r sampled records in sample. With d distinct values in the sample, f1 of
+ * them seen once and f2 twice, this is Chao's estimate
+ * d + f1 (f1 - 1) / (2 (f2 + 1)) if a value is seen twice, and GEE,
+ * sqrt(n / r) f1 + d - f1, otherwise: a sample without such repeats, as a
+ * few pages of a clustered attribute give, carries no evidence of how many
+ * values were missed and GEE keeps the error within a factor of sqrt(n / r).
+ * The estimate lies between seen, the distinct values of a larger sample the
+ * records were drawn from, and n.
+ */
+static double estimateDistinct(Schema *schema, int attr, char *sample, int r, int slotLen, double seen, double n) {
+	unsigned long long *hashes;
+	double d = 0, f1 = 0, f2 = 0, estimate;
+	int i, j;
+
+	if (r <= 0) {
+		return 0;
+	}
+	hashes = (unsigned long long *)malloc(sizeof(unsigned long long) * r);
+	for (i = 0; i < r; i++) {
+		hashes[i] = hashAttr(schema, sample + (size_t)i * slotLen, attr);
+	}
+	qsort(hashes, r, sizeof(unsigned long long), compareStatsHashes);
+	for (i = 0; i < r; i = j) {
+		for (j = i + 1; j < r && hashes[j] == hashes[i]; j++)
+			;
+		d++;
+		f1 += (j - i == 1);
+		f2 += (j - i == 2);
+	}
+	free(hashes);
+
+	if (f2 > 0) {
+		estimate = d + f1 * (f1 - 1) / (2 * (f2 + 1));
+	}
+	else {
+		estimate = sqrt(n / r) * f1 + d - f1;
+	}
+	if (estimate < seen) {
+		estimate = seen;
+	}
+	return (estimate > n) ? n : estimate;
+}
+
+// bytes the statistics take in the stats page with histograms of buckets
+// buckets, 0 for none.
+static int statsSize(Schema *schema, int buckets) {
+	int size = 4 * sizeof(int), attr;
+
+	for (attr = 0; attr < schema->numAttr; attr++) {
+		size += sizeof(double) + sizeof(int) + (buckets > 0 ? buckets + 1 : 0) * schema->attrSizes[attr];
+	}
+	return size;
+}
+
+/**
+ * build the equi-depth histogram of an attribute from the sampled records:
+ * the values are sorted and every numSample / buckets-th one is a bound.
+ * The first and last bound are low and high, the smallest and largest
+ * value of all records read.
+ */
+static void buildHistogram(Schema *schema, int attr, char *sample, int numSample, int slotLen, int buckets,
+		char *low, char *high, AttrStats *stats) {
+	char **values;
+	int i;
+
+	stats->numBounds = (buckets + 1 < numSample) ? buckets + 1 : numSample;
+	if (buckets == 0) {
+		stats->numBounds = 0;
+	}
+	stats->bounds = (Value *)malloc(sizeof(Value) * (stats->numBounds > 0 ? stats->numBounds : 1));
+	if (stats->numBounds == 0) {
+		return;
+	}
+
+	values = (char **)malloc(sizeof(char *) * numSample);
+	for (i = 0; i < numSample; i++) {
+		values[i] = sample + (size_t)i * slotLen + schema->attrOffsets[attr];
+	}
+	qsort(values, numSample, sizeof(char *), statsComparators[schema->dataTypes[attr]]);
+
+	for (i = 0; i < stats->numBounds; i++) {
+		long index = (stats->numBounds > 1) ? (long)i * (numSample - 1) / (stats->numBounds - 1) : 0;
+		char *bound = (i == 0) ? low : (i == stats->numBounds - 1) ? high : values[index];
+		statsValue(schema->dataTypes[attr], bound, &stats->bounds[i]);
+	}
+	free(values);
+}
+
+// write the statistics of a table into page 0 of its stats file.
+static RC storeTableStats(RM_TableData *rel, TableStats *stats) {
+	Schema *schema = rel->schema;
+	char *name = statsName(rel->name);
+	char *page = (char *)calloc(1, PAGE_SIZE);
+	char *pos = page;
+	SM_FileHandle fh;
+	int header[4] = { stats->numTuples, stats->sampledPages, stats->sampledTuples, stats->numAttr };
+	int attr, i;
+	RC rc;
+
+	memcpy(pos, header, sizeof(header));
+	pos += sizeof(header);
+	for (attr = 0; attr < stats->numAttr; attr++) {
+		AttrStats *attrStats = &stats->attrs[attr];
+		int size = schema->attrSizes[attr];
+
+		memcpy(pos, &attrStats->distinct, sizeof(double));
+		memcpy(pos + sizeof(double), &attrStats->numBounds, sizeof(int));
+		pos += sizeof(double) + sizeof(int);
+		for (i = 0; i < attrStats->numBounds; i++, pos += size) {
+			Value *bound = &attrStats->bounds[i];
+			switch (bound->dt) {
+				case DT_INT:
+					memcpy(pos, &bound->v.intV, sizeof(int));
+					break;
+				case DT_FLOAT:
+					memcpy(pos, &bound->v.floatV, sizeof(float));
+					break;
+				case DT_BOOL:
+					*pos = (bound->v.boolV != 0);
+					break;
+				case DT_STRING:
+					strncpy(pos, bound->v.stringV, size - 1);
+					break;
+			}
+		}
+	}
+
+	if ((rc = createPageFile(name)) == RC_OK && (rc = openPageFile(name, &fh)) == RC_OK) {
+		rc = writeBlock(0, &fh, page);
+		closePageFile(&fh);
+	}
+	free(page);
+	free(name);
+	return rc;
+}
+
+/**
+ * read the statistics of a table from its stats file.
+ * @param  rel RM_TableData
+ * @return     the statistics, or NULL if the table has not been analyzed
+ */
+static TableStats *loadTableStats(RM_TableData *rel) {
+	Schema *schema = rel->schema;
+	char *name = statsName(rel->name);
+	char *page, *pos;
+	SM_FileHandle fh;
+	TableStats *stats = NULL;
+	int header[4] = { 0, 0, 0, -1 };	// -1 attributes if the page cannot be read
+	int attr, i;
+
+	if (access(name, F_OK) != 0 || openPageFile(name, &fh) != RC_OK) {
+		free(name);
+		return NULL;
+	}
+	page = (char *)malloc(PAGE_SIZE);
+	if (readBlock(0, &fh, page) == RC_OK) {
+		memcpy(header, page, sizeof(header));
+		pos = page + sizeof(header);
+	}
+	closePageFile(&fh);
+	free(name);
+
+	// statistics of another schema are ignored
+	if (header[3] != schema->numAttr) {
+		free(page);
+		return NULL;
+	}
+
+	stats = (TableStats *)malloc(sizeof(TableStats));
+	stats->numTuples = header[0];
+	stats->sampledPages = header[1];
+	stats->sampledTuples = header[2];
+	stats->numAttr = header[3];
+	stats->attrs = (AttrStats *)malloc(sizeof(AttrStats) * (stats->numAttr > 0 ? stats->numAttr : 1));
+	for (attr = 0; attr < stats->numAttr; attr++) {
+		AttrStats *attrStats = &stats->attrs[attr];
+
+		memcpy(&attrStats->distinct, pos, sizeof(double));
+		memcpy(&attrStats->numBounds, pos + sizeof(double), sizeof(int));
+		pos += sizeof(double) + sizeof(int);
+		attrStats->bounds = (Value *)malloc(sizeof(Value) * (attrStats->numBounds > 0 ? attrStats->numBounds : 1));
+		for (i = 0; i < attrStats->numBounds; i++, pos += schema->attrSizes[attr]) {
+			statsValue(schema->dataTypes[attr], pos, &attrStats->bounds[i]);
+		}
+	}
+	free(page);
+	return stats;
+}
+
+// free statistics and their bounds, stats may be NULL.
+static void freeTableStats(TableStats *stats) {
+	int attr, i;
+
+	if (stats == NULL) {
+		return;
+	}
+	for (attr = 0; attr < stats->numAttr; attr++) {
+		for (i = 0; i < stats->attrs[attr].numBounds; i++) {
+			if (stats->attrs[attr].bounds[i].dt == DT_STRING) {
+				free(stats->attrs[attr].bounds[i].v.stringV);
+			}
+		}
+		free(stats->attrs[attr].bounds);
+	}
+	free(stats->attrs);
+	free(stats);
+}
+
+/**
+ * collect statistics of a table from a sample of its data pages: the
+ * number of records and, for every attribute, the smallest and largest
+ * value, the number of distinct values and an equi-depth histogram. A
+ * fraction sampleRate of the data pages, and at least one page, is chosen
+ * at random and read through a buffer pool. The distinct values are
+ * counted with a HyperLogLog sketch if every record is read, and estimated
+ * from how often values repeat among up to STATS_SAMPLE_RECORDS records of
+ * the sample otherwise; the histograms are built from these records too.
+ * The statistics are stored in the page file "<table>.stats", loaded with
+ * the table and returned by getTableStats. They are not kept up to date by
+ * changes to the table.
+ * @param  rel        RM_TableData
+ * @param  sampleRate fraction of the data pages to read, 1 for all of them
+ * @return            RC_OK | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC analyzeTable (RM_TableData *rel, double sampleRate) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	int slotLen = schemaLength(schema);
+	int numPages = tableHeader->pageCount;
+	int numSampled = (int)ceil(sampleRate * numPages);
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	unsigned long long state = 88172645463325252ULL, index;
+	HyperLogLog *sketches;
+	TableStats *stats;
+	char *sample, *low, *high, *value, *row, *pageData, *decoded = NULL;
+	long seen = 0;
+	int page, slot, attr, usedSlots, chosen = 0, buckets;
+	RC rc = RC_OK;
+
+	if (numSampled < 1) {
+		numSampled = 1;
+	}
+	if (numSampled > numPages) {
+		numSampled = numPages;
+	}
+	if (initBufferPool(bm, rel->name, STATS_POOL_PAGES, RS_LRU, NULL) != RC_OK) {
+		free(h);
+		free(bm);
+		return RC_FILE_NOT_FOUND;
+	}
+
+	sketches = (HyperLogLog *)malloc(sizeof(HyperLogLog) * (schema->numAttr > 0 ? schema->numAttr : 1));
+	for (attr = 0; attr < schema->numAttr; attr++) {
+		hllInit(&sketches[attr]);
+	}
+	sample = (char *)malloc((size_t)STATS_SAMPLE_RECORDS * slotLen);
+	row = (char *)malloc(slotLen);
+	if (tableHeader->layout == LAYOUT_COMPRESSED) {
+		decoded = (char *)malloc(pageBufferSize(rel));
+	}
+
+	// the smallest and largest value of every attribute, each at its offset
+	// in a slot of its own
+	low = (char *)malloc((size_t)(schema->numAttr > 0 ? schema->numAttr : 1) * slotLen);
+	high = (char *)malloc((size_t)(schema->numAttr > 0 ? schema->numAttr : 1) * slotLen);
+
+	// selection sampling chooses numSampled pages, read in page order
+	for (page = 1; page <= numPages && chosen < numSampled; page++) {
+		if (nextRandom(&state) % (numPages - page + 1) >= (unsigned long long)(numSampled - chosen)) {
+			continue;
+		}
+		chosen++;
+		if ((rc = pinPage(bm, h, page)) != RC_OK) {
+			break;
+		}
+
+		usedSlots = (page == tableHeader->freePointer->page) ? tableHeader->freePointer->slot : tableHeader->recordsPerPage;
+		pageData = h->data;
+		if (decoded != NULL) {
+			usedSlots = pageSlots(h->data);
+			decodeColumns(schema, h->data + PAX_PAGE_OFFSET, usedSlots, decoded + PAX_PAGE_OFFSET,
+				tableHeader->recordsPerPage);
+			pageData = decoded;
+		}
+		for (slot = 0; slot < usedSlots; slot++) {
+			RID id = { page, slot };
+			char *data = slotRecord(rel, pageData, slot, row);
+
+			if (isDeletedSlot(tableHeader, id)) {
+				continue;
+			}
+			for (attr = 0; attr < schema->numAttr; attr++) {
+				int offset = attr * slotLen + schema->attrOffsets[attr];
+				int (*compare)(const void *, const void *) = statsComparators[schema->dataTypes[attr]];
+				char *lowest = low + offset, *highest = high + offset;
+
+				hllAdd(&sketches[attr], hashAttr(schema, data, attr));
+				value = data + schema->attrOffsets[attr];
+				if (seen == 0 || compare(&value, &lowest) < 0) {
+					memcpy(lowest, value, schema->attrSizes[attr]);
+				}
+				if (seen == 0 || compare(&value, &highest) > 0) {
+					memcpy(highest, value, schema->attrSizes[attr]);
+				}
+			}
+
+			// reservoir sampling keeps every record with the same chance
+			index = (seen < STATS_SAMPLE_RECORDS) ? (unsigned long long)seen : nextRandom(&state) % (seen + 1);
+			if (index < STATS_SAMPLE_RECORDS) {
+				memcpy(sample + index * slotLen, data, slotLen);
+			}
+			seen++;
+		}
+		unpinPage(bm, h);
+	}
+	shutdownBufferPool(bm);
+	free(h);
+	free(bm);
+
+	if (rc == RC_OK) {
+		stats = (TableStats *)malloc(sizeof(TableStats));
+		stats->numTuples = (tableHeader->totalRecordCount > seen) ? tableHeader->totalRecordCount : (int)seen;
+		stats->sampledPages = chosen;
+		stats->sampledTuples = (int)seen;
+		stats->numAttr = schema->numAttr;
+		stats->attrs = (AttrStats *)malloc(sizeof(AttrStats) * (schema->numAttr > 0 ? schema->numAttr : 1));
+
+		for (buckets = STATS_HISTOGRAM_BUCKETS; buckets > 0 && statsSize(schema, buckets) > PAGE_SIZE; buckets /= 2)
+			;
+		for (attr = 0; attr < schema->numAttr; attr++) {
+			// an attribute that is the primary key on its own has a value per
+			// record, the sketch counts a table read as a whole
+			if (schema->keySize == 1 && schema->keyAttrs[0] == attr) {
+				stats->attrs[attr].distinct = stats->numTuples;
+			}
+			else if (seen >= stats->numTuples) {
+				stats->attrs[attr].distinct = hllEstimate(&sketches[attr]);
+			}
+			else {
+				stats->attrs[attr].distinct = estimateDistinct(schema, attr, sample,
+					(seen < STATS_SAMPLE_RECORDS) ? (int)seen : STATS_SAMPLE_RECORDS, slotLen,
+					hllEstimate(&sketches[attr]), stats->numTuples);
+			}
+			buildHistogram(schema, attr, sample, (seen < STATS_SAMPLE_RECORDS) ? (int)seen : STATS_SAMPLE_RECORDS,
+				slotLen, buckets, low + attr * slotLen + schema->attrOffsets[attr],
+				high + attr * slotLen + schema->attrOffsets[attr], &stats->attrs[attr]);
+		}
+
+		rc = storeTableStats(rel, stats);
+		freeTableStats(tableHeader->stats);
+		tableHeader->stats = stats;
+	}
+
+	free(low);
+	free(high);
+	free(sample);
+	free(row);
+	free(decoded);
+	free(sketches);
+	return rc;
+}
+
+/**
+ * the statistics of a table collected by analyzeTable. They belong to the
+ * table and are valid until it is closed or analyzed again.
+ * @param  rel RM_TableData
+ * @return     the statistics, or NULL if the table has not been analyzed
+ */
+TableStats *getTableStats (RM_TableData *rel) {
+	return ((Table_Header *)rel->mgmtData)->stats;
+}
+
+// fraction of the records of an attribute smaller than value, bounds of the
+// histogram are interpolated between for ints and floats.
+static double fractionSmaller(AttrStats *stats, Value *value) {
+	Value *bounds = stats->bounds;
+	int last = stats->numBounds - 1, i;
+	double low, high, x;
+
+	if (stats->numBounds == 0) {
+		return 0.5;
+	}
+	if (compareStatsValues(value, &bounds[0]) <= 0) {
+		return 0;
+	}
+	if (compareStatsValues(value, &bounds[last]) > 0) {
+		return 1;
+	}
+
+	// bounds[i] < value <= bounds[i + 1]
+	for (i = 0; compareStatsValues(&bounds[i + 1], value) < 0; i++)
+		;
+	if (value->dt == DT_INT || value->dt == DT_FLOAT) {
+		low = (value->dt == DT_INT) ? bounds[i].v.intV : bounds[i].v.floatV;
+		high = (value->dt == DT_INT) ? bounds[i + 1].v.intV : bounds[i + 1].v.floatV;
+		x = (value->dt == DT_INT) ? value->v.intV : value->v.floatV;
+		return (i + (x - low) / (high - low)) / last;
+	}
+	return (i + 0.5) / last;
+}
+
+// fraction of the records of an attribute equal to value: one over the
+// distinct values, or the buckets the value fills if it is that frequent.
+static double fractionEqual(AttrStats *stats, Value *value) {
+	int last = stats->numBounds - 1, i, equal = 0;
+	double fraction = (stats->distinct >= 1) ? 1 / stats->distinct : 1;
+
+	if (stats->numBounds == 0) {
+		return fraction;
+	}
+	if (compareStatsValues(value, &stats->bounds[0]) < 0 || compareStatsValues(value, &stats->bounds[last]) > 0) {
+		return 0;
+	}
+	for (i = 0; i <= last; i++) {
+		equal += (compareStatsValues(value, &stats->bounds[i]) == 0);
+	}
+	if (equal > 1 && (double)(equal - 1) / last > fraction) {
+		fraction = (double)(equal - 1) / last;
+	}
+	return fraction;
+}
+
+/**
+ * estimate the fraction of the records of a table for which attribute
+ * attrNum op value holds, from the statistics of analyzeTable. op is one of
+ * OP_COMP_EQUAL, OP_COMP_SMALLER, OP_COMP_GREATER, OP_COMP_LE and
+ * OP_COMP_GE, any other operator is estimated as 1.
+ * @param  rel     RM_TableData
+ * @param  attrNum the attribute
+ * @param  op      the comparison
+ * @param  value   the value compared with
+ * @param  result  set to the fraction, between 0 and 1
+ * @return         RC_OK | RC_RM_NO_STATS | RC_RM_NO_SUCH_ATTR | RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE
+ */
+RC estimateSelectivity (RM_TableData *rel, int attrNum, OpType op, Value *value, double *result) {
+	TableStats *stats = ((Table_Header *)rel->mgmtData)->stats;
+	AttrStats *attrStats;
+	double smaller, equal;
+
+	if (stats == NULL) {
+		THROW(RC_RM_NO_STATS, "the table has not been analyzed");
+	}
+	if (attrNum < 0 || attrNum >= stats->numAttr) {
+		THROW(RC_RM_NO_SUCH_ATTR, "attribute does not exist");
+	}
+	if (value->dt != rel->schema->dataTypes[attrNum]) {
+		THROW(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, "the value is not of the datatype of the attribute");
+	}
+
+	attrStats = &stats->attrs[attrNum];
+	smaller = fractionSmaller(attrStats, value);
+	equal = fractionEqual(attrStats, value);
+	switch (op) {
+		case OP_COMP_EQUAL:
+			*result = equal;
+			break;
+		case OP_COMP_SMALLER:
+			*result = smaller;
+			break;
+		case OP_COMP_LE:
+			*result = smaller + equal;
+			break;
+		case OP_COMP_GREATER:
+			*result = 1 - smaller - equal;
+			break;
+		case OP_COMP_GE:
+			*result = 1 - smaller;
+			break;
+		default:
+			*result = 1;
+			break;
+	}
+	*result = (*result < 0) ? 0 : (*result > 1) ? 1 : *result;
+	return RC_OK;
+}
+
+// name of the zone map file of a table.
+static char *zonesName(char *name) {
+	char *result = (char *)malloc(strlen(name) + 7);
+
+	strcpy(result, name);
+	strcat(result, ".zones");
+	return result;
+}
+
+// widen the zones of a page to a record written to it.
+static void updateZoneMap(RM_TableData *rel, int pageNum, char *data) {
+	ZoneMap *zones = ((Table_Header *)rel->mgmtData)->zones;
+
+	if (zones != NULL) {
+		zoneMapAdd(zones, rel->schema, pageNum, data);
+	}
+}
+
+// bounds of a condition on every attribute of the zone map, from the arena
+// of the scan. NULL if there is no zone map or the condition bounds none of
+// its attributes by a number.
+static ZoneBounds *scanZoneBounds(RM_TableData *rel, Expr *cond, Arena *arena) {
+	ZoneMap *zones = ((Table_Header *)rel->mgmtData)->zones;
+	ZoneBounds *bounds;
+	ExprRange range;
+	int i, bounded = 0;
+
+	if (zones == NULL || cond == NULL) {
+		return NULL;
+	}
+
+	bounds = (ZoneBounds *)arenaAlloc(arena, sizeof(ZoneBounds) * zones->numAttrs);
+	for (i = 0; i < zones->numAttrs; i++) {
+		memset(&bounds[i], 0, sizeof(ZoneBounds));
+		getExprRange(cond, zones->attrs[i], &range);
+		if (range.hasLow && (range.low.dt == DT_INT || range.low.dt == DT_FLOAT)) {
+			bounds[i].hasLow = 1;
+			bounds[i].lowInclusive = range.lowInclusive;
+			bounds[i].low = (range.low.dt == DT_INT) ? range.low.v.intV : range.low.v.floatV;
+		}
+		if (range.hasHigh && (range.high.dt == DT_INT || range.high.dt == DT_FLOAT)) {
+			bounds[i].hasHigh = 1;
+			bounds[i].highInclusive = range.highInclusive;
+			bounds[i].high = (range.high.dt == DT_INT) ? range.high.v.intV : range.high.v.floatV;
+		}
+		bounded |= bounds[i].hasLow || bounds[i].hasHigh;
+	}
+	return bounded ? bounds : NULL;
+}
+
+/**
+ * keep the smallest and largest value of some int or float attributes for
+ * every data page of a table. A scan whose condition bounds one of them,
+ * like a >= 10 AND a < 20, does not read the pages whose values are all
+ * outside the bounds. The zone map is built from the records of the table,
+ * widened by every insert and update and never narrowed by deletes. It is
+ * stored in the page file "<table>.zones" by closeTable and loaded by
+ * openTable; a zone map not stored by closeTable, like after a crash, is
+ * dropped. An existing zone map is replaced. It must not be called during a
+ * scan of the table.
+ * @param  rel      RM_TableData
+ * @param  attrList the attributes
+ * @param  numAttrs number of attributes
+ * @return          RC_OK | RC_RM_NO_SUCH_ATTR | RC_RM_ATTR_WRONG_DATATYPE | RC_FILE_NOT_FOUND
+ */
+RC buildZoneMap (RM_TableData *rel, int *attrList, int numAttrs) {
+	Table_Header *tableHeader = (Table_Header *)rel->mgmtData;
+	Schema *schema = rel->schema;
+	RM_ScanHandle sc;
+	Record *record;
+	ZoneMap *zones;
+	RC rc;
+	int i;
+
+	if (numAttrs < 1) {
+		THROW(RC_RM_NO_SUCH_ATTR, "a zone map needs an attribute");
+	}
+	for (i = 0; i < numAttrs; i++) {
+		if (attrList[i] < 0 || attrList[i] >= schema->numAttr) {
+			THROW(RC_RM_NO_SUCH_ATTR, "zone map attribute does not exist");
+		}
+		if (schema->dataTypes[attrList[i]] != DT_INT && schema->dataTypes[attrList[i]] != DT_FLOAT) {
+			THROW(RC_RM_ATTR_WRONG_DATATYPE, "a zone map keeps int and float attributes only");
+		}
+	}
+
+	freeZoneMap(tableHeader->zones);
+	tableHeader->zones = NULL;
+	if ((zones = createZoneMap(numAttrs, attrList)) == NULL) {
+		return RC_WRITE_FAILED;
+	}
+
+	if ((rc = startScan(rel, &sc, NULL)) != RC_OK) {
+		freeZoneMap(zones);
+		return rc;
+	}
+	createRecordInArena(&record, schema, getScanArena(&sc));
+	while (next(&sc, record) == RC_OK) {
+		zoneMapAdd(zones, schema, record->id.page, record->data);
+	}
+	closeScan(&sc);
+
+	tableHeader->zones = zones;
+	return RC_OK;
+}
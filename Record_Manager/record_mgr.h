@@ -5,6 +5,8 @@
 #include "expr.h"
 #include "tables.h"
 #include "list.h"
+#include "arena.h"
+#include "storage_mgr.h"
 // #include "table_mgr.h"
 
 // Bookkeeping for scans
@@ -18,13 +20,67 @@ typedef struct RM_ScanHandle
 typedef struct ScanInfo {
   Expr *cond;
 	RID curRID;
+	Arena *arena;
+	char *page;			// the page of curRID, read once per scan
+	char *row;			// a record of a PAX page gathered for the condition
+	char *decoded;			// page decoded into a PAX page, compressed tables only
+	ExprRange *ranges;		// bounds of the condition on every attribute, compressed tables only
+	int pagesDecoded;		// compressed pages the scan decoded
+	int pageNum;			// page held in page, 0 before the first read
+	int pageReads;			// pages read by the scan
+	SM_FileHandle fh;		// the table file, open until closeScan
+	ExprFilter *filter;		// the compiled condition
+	unsigned char *selection;	// matching slots of selectionPage
+	int selectionPage;
+	int selectionSlots;
+	int empty;			// the condition cannot match any tuple
+	Schema *projection;		// schema of the returned records, NULL for all attributes
+	int *projAttrs;			// table attribute of every projected attribute
+	struct SharedCursor *shared;	// place in the pass joined by startSharedScan, NULL otherwise
+	int pagesLeft;			// data pages a shared scan still has to go through
+	int lastPage;			// last data page when a shared scan started
+	struct ZoneBounds *zoneBounds;	// bounds of the condition on the zone map attributes, NULL if it has none
+	int limit;			// matches a LIMIT scan still returns, -1 without a limit
+	struct TopRecords *top;		// records of an ORDER BY ... LIMIT scan, NULL otherwise
+	int *pageOrder;			// data pages in the order the scan reads them, NULL for the table order
+	int orderPos;			// position of curRID.page in pageOrder
 } ScanInfo;
 
+// statistics of an attribute collected by analyzeTable. bounds are the
+// bounds of an equi-depth histogram, every bucket between two of them holds
+// about as many records; the first is the smallest value of the pages read
+// and the last the largest.
+typedef struct AttrStats {
+  double distinct;		// estimated number of distinct values
+  int numBounds;
+  Value *bounds;
+} AttrStats;
+
+// statistics of a table collected by analyzeTable.
+typedef struct TableStats {
+  int numTuples;		// records in the table when it was analyzed
+  int sampledPages;
+  int sampledTuples;
+  int numAttr;
+  AttrStats *attrs;
+} TableStats;
+
+// called by a parallel scan for every matching record. The record points
+// into the page of the calling thread and is valid only during the call.
+typedef void (*ScanCallback) (int thread, Record *record, void *context);
+
+// called by a parallel batch scan for every data page with numTuples slots:
+// attribute a of slot i is at columns[a] + i * strides[a], the slots with
+// bit i of selection (byte i / 8) set match.
+typedef void (*BatchCallback) (int thread, char **columns, int *strides, int numTuples, unsigned char *selection,
+			       void *context);
+
 
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableWithLayout (char *name, Schema *schema, TableLayout layout);
 extern RC openTable (RM_TableData *rel, char *name);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
@@ -35,11 +91,35 @@ extern RC insertRecord (RM_TableData *rel, Record *record);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+extern RC bulkLoad (RM_TableData *rel, Record **records, int numRecords);
+extern RC getRecordByKey (RM_TableData *rel, Value *key, Record *record);
+extern RC createKeyHash (RM_TableData *rel);
+extern RC buildZoneMap (RM_TableData *rel, int *attrList, int numAttrs);
+
+// statistics
+extern RC analyzeTable (RM_TableData *rel, double sampleRate);
+extern TableStats *getTableStats (RM_TableData *rel);
+extern RC estimateSelectivity (RM_TableData *rel, int attrNum, OpType op, Value *value, double *result);
+
+// handling batches of records in a table
+extern RC insertRecords (RM_TableData *rel, Record **records, int numRecords);
+extern RC deleteRecords (RM_TableData *rel, RID *ids, int numIds);
+extern RC updateRecords (RM_TableData *rel, Record **records, int numRecords);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+extern RC startScanProjected (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrList, int numAttrs);
+extern RC startScanLimit (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int limit);
+extern RC startScanTopK (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int attrNum, int descending, int k);
+extern Schema *getScanSchema (RM_ScanHandle *scan);
 extern RC next (RM_ScanHandle *scan, Record *record);
 extern RC closeScan (RM_ScanHandle *scan);
+extern Arena *getScanArena (RM_ScanHandle *scan);
+extern int getScanPageReads (RM_ScanHandle *scan);
+extern int getScanDecodedPages (RM_ScanHandle *scan);
+extern RC startParallelScan (RM_TableData *rel, Expr *cond, int nThreads, ScanCallback callback, void *context);
+extern RC startParallelBatchScan (RM_TableData *rel, Expr *cond, int nThreads, BatchCallback callback, void *context);
+extern RC startSharedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
@@ -52,6 +132,17 @@ extern RC freeRecord (Record *record);
 extern RC getAttr (Record *record, Schema *schema, int attrNum, Value **value);
 extern RC setAttr (Record *record, Schema *schema, int attrNum, Value *value);
 
+// reading attributes without allocating
+extern RC getAttrInto (Record *record, Schema *schema, int attrNum, Value *value);
+extern RC getIntAttr (Record *record, Schema *schema, int attrNum, int *result);
+extern RC getFloatAttr (Record *record, Schema *schema, int attrNum, float *result);
+extern RC getBoolAttr (Record *record, Schema *schema, int attrNum, int *result);
+extern RC getStringAttrRef (Record *record, Schema *schema, int attrNum, char **result);
+
+// records and values released together with an arena
+extern RC createRecordInArena (Record **record, Schema *schema, Arena *arena);
+extern RC getAttrInArena (Record *record, Schema *schema, int attrNum, Value **value, Arena *arena);
+
 
 // extra table and header related functions.
 RC initTableManager(Table_Header *manager, Schema *schema);
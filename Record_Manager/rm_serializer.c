@@ -49,6 +49,7 @@ typedef struct VarString {
       int newbufsize = var->bufsize;				\
       while((newbufsize *= 2) < newsize);			\
       var->buf = realloc(var->buf, newbufsize);			\
+      var->bufsize = newbufsize;				\
     }								\
   } while (0)
 
@@ -59,17 +60,14 @@ typedef struct VarString {
     var->size += strlen(string);					\
   } while(0)
 
-#define APPEND(var, ...)			\
-  do {						\
-    char *tmp = malloc(10000);			\
-    sprintf(tmp, __VA_ARGS__);			\
-    APPEND_STRING(var,tmp);			\
-    free(tmp);					\
+#define APPEND(var, ...)				\
+  do {							\
+    int len = snprintf(NULL, 0, __VA_ARGS__);		\
+    ENSURE_SIZE(var, var->size + len + 1);		\
+    snprintf(var->buf + var->size, len + 1, __VA_ARGS__);	\
+    var->size += len;					\
   } while(0)
 
-// prototypes
-static RC attrOffset (Schema *schema, int attrNum, int *result);
-
 // implementations
 char *
 serializeTableInfo(RM_TableData *rel)
@@ -78,7 +76,9 @@ serializeTableInfo(RM_TableData *rel)
   MAKE_VARSTRING(result);
 
   APPEND(result, "TABLE <%s> with <%i> tuples:\n", rel->name, getNumTuples(rel));
-  APPEND_STRING(result, serializeSchema(rel->schema));
+  char *schema = serializeSchema(rel->schema);
+  APPEND_STRING(result, schema);
+  free(schema);
 
   RETURN_STRING(result);
 }
@@ -89,20 +89,24 @@ serializeTableContent(RM_TableData *rel)
   int i;
   VarString *result;
   RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
-  Record *r = (Record *) malloc(sizeof(Record));
+  Record *r;
   MAKE_VARSTRING(result);
 
   for(i = 0; i < rel->schema->numAttr; i++)
     APPEND(result, "%s%s", (i != 0) ? ", " : "", rel->schema->attrNames[i]);
 
   startScan(rel, sc, NULL);
+  createRecordInArena(&r, rel->schema, getScanArena(sc));
 
   while(next(sc, r) != RC_RM_NO_MORE_TUPLES)
     {
-    APPEND_STRING(result,serializeRecord(r, rel->schema));
+    char *record = serializeRecord(r, rel->schema);
+    APPEND_STRING(result,record);
     APPEND_STRING(result,"\n");
+    free(record);
     }
   closeScan(sc);
+  free(sc);
 
   RETURN_STRING(result);
 }
@@ -159,7 +163,9 @@ serializeRecord(Record *record, Schema *schema)
 
   for(i = 0; i < schema->numAttr; i++)
     {
-      APPEND_STRING(result, serializeAttr (record, schema, i));
+      char *attr = serializeAttr (record, schema, i);
+      APPEND_STRING(result, attr);
+      free(attr);
       APPEND(result, "%s", (i == 0) ? "" : ",");
     }
 
@@ -171,51 +177,42 @@ serializeRecord(Record *record, Schema *schema)
 char *
 serializeAttr(Record *record, Schema *schema, int attrNum)
 {
-  int offset;
-  char *attrData;
   VarString *result;
   MAKE_VARSTRING(result);
 
-  attrOffset(schema, attrNum, &offset);
-  attrData = record->data + offset;
-
   switch(schema->dataTypes[attrNum])
     {
     case DT_INT:
       {
-	int val = 0;
-	memcpy(&val,attrData, sizeof(int));
+	int val;
+	getIntAttr(record, schema, attrNum, &val);
 	APPEND(result, "%s:%i", schema->attrNames[attrNum], val);
       }
       break;
     case DT_STRING:
       {
-	char *buf;
-	int len = schema->typeLength[attrNum];
-	buf = (char *) malloc(len + 1);
-	strncpy(buf, attrData, len);
-	buf[len] = '\0';
-
-	APPEND(result, "%s:%s", schema->attrNames[attrNum], buf);
-	free(buf);
+	char *val;
+	getStringAttrRef(record, schema, attrNum, &val);
+	APPEND(result, "%s:%s", schema->attrNames[attrNum], val);
       }
       break;
     case DT_FLOAT:
       {
 	float val;
-	memcpy(&val,attrData, sizeof(float));
+	getFloatAttr(record, schema, attrNum, &val);
 	APPEND(result, "%s:%f", schema->attrNames[attrNum], val);
       }
       break;
     case DT_BOOL:
       {
-	bool val;
-	memcpy(&val,attrData, sizeof(bool));
+	int val;
+	getBoolAttr(record, schema, attrNum, &val);
 	APPEND(result, "%s:%s", schema->attrNames[attrNum], val ? "TRUE" : "FALSE");
       }
       break;
     default:
-      return "NO SERIALIZER FOR DATATYPE";
+      APPEND_STRING(result, "NO SERIALIZER FOR DATATYPE");
+      break;
     }
 
   RETURN_STRING(result);
@@ -278,31 +275,3 @@ stringToValue(char *val)
 
   return result;
 }
-
-
-RC
-attrOffset (Schema *schema, int attrNum, int *result)
-{
-  int offset = 0;
-  int attrPos = 0;
-
-  for(attrPos = 0; attrPos < attrNum; attrPos++)
-    switch (schema->dataTypes[attrPos])
-      {
-      case DT_STRING:
-	offset += schema->typeLength[attrPos];
-	break;
-      case DT_INT:
-	offset += sizeof(int);
-	break;
-      case DT_FLOAT:
-	offset += sizeof(float);
-	break;
-      case DT_BOOL:
-	offset += sizeof(bool);
-	break;
-      }
-
-  *result = offset;
-  return RC_OK;
-}
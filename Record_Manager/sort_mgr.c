@@ -0,0 +1,928 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#include "sort_mgr.h"
+#include "record_mgr.h"
+#include "storage_mgr.h"
+
+// most runs merged at once, each has a page in memory
+#define SORT_MAX_FAN_IN 128
+
+// below this many items pdqsort sorts by insertion, above the other one it
+// takes the pivot from nine items instead of three.
+#define PDQ_INSERTION_SORT 24
+#define PDQ_NINTHER 128
+#define PDQ_PARTIAL_INSERTION 8
+
+// a record to be sorted. The first 8 bytes of its key are kept with it as
+// a number with the same order, most items compare by these alone.
+typedef struct SortItem {
+	unsigned long long prefix;
+	char *entry;			// the key, RID and record
+} SortItem;
+
+// a sorted run in a temporary page file. Every page starts with the number
+// of entries on it.
+typedef struct SortRun {
+	char *name;			// NULL once the file is deleted
+	int numPages;
+} SortRun;
+
+// reads the entries of a run in order.
+typedef struct RunReader {
+	SM_FileHandle fh;
+	char *page;
+	int pageNum;
+	int numPages;
+	int count;			// entries on page
+	int pos;
+	char *entry;			// the current entry, NULL at the end of the run
+} RunReader;
+
+// k runs merged with a tree of losers: node i keeps the run that lost the
+// comparison there, node 0 the run of the smallest entry.
+typedef struct Merger {
+	int k;
+	RunReader *readers;
+	int *losers;
+	int keyLen;
+} Merger;
+
+typedef struct SortState {
+	Schema *schema;
+	int numKeys;
+	int *attrs;
+	bool *descending;
+	int keyLen;
+	int recordSize;
+	int entrySize;			// bytes of a key, RID and record
+	size_t memory;
+
+	// the records of the current run
+	char *entries;
+	SortItem *items;
+	SortItem *scratch;
+	int numItems;
+	int capacity;
+	int next;			// next item returned when there are no runs
+
+	// the runs on disk, merged once the table is read
+	SortRun *runs;
+	int numRuns;
+	int firstRun;			// runs before it are merged into later ones
+	int maxRuns;
+	Merger merger;
+	int merging;
+
+	char *lastKey;			// key of the record returned last
+} SortState;
+
+static char *tempDirectory = NULL;
+static atomic_int tempSequence;
+
+/**
+ * set the directory of the temporary files of sorts and joins.
+ * @param  dir the directory, NULL for the directory of the table.
+ * @return     RC_OK | RC_FILE_NOT_FOUND
+ */
+RC setTempDirectory (char *dir) {
+	struct stat st;
+
+	if (dir != NULL && (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode) || access(dir, W_OK) != 0)) {
+		THROW(RC_FILE_NOT_FOUND, "the temporary directory does not exist or is not writable");
+	}
+	free(tempDirectory);
+	tempDirectory = NULL;
+	if (dir != NULL) {
+		tempDirectory = (char *)malloc(strlen(dir) + 1);
+		strcpy(tempDirectory, dir);
+	}
+	return RC_OK;
+}
+
+/**
+ * a new name for a temporary file of a table: "<table>.<kind><n>" in the
+ * temporary directory, or next to the table if there is none.
+ * @param  table name of the table.
+ * @param  kind  what the file holds.
+ * @return       the name, to be freed by the caller.
+ */
+char *tempFileName (char *table, char *kind) {
+	char *base = strrchr(table, '/');
+	char *name;
+	int sequence = atomic_fetch_add(&tempSequence, 1);
+
+	if (tempDirectory == NULL) {
+		name = (char *)malloc(strlen(table) + strlen(kind) + 16);
+		sprintf(name, "%s.%s%d", table, kind, sequence);
+	}
+	else {
+		base = (base != NULL) ? base + 1 : table;
+		name = (char *)malloc(strlen(tempDirectory) + strlen(base) + strlen(kind) + 17);
+		sprintf(name, "%s/%s.%s%d", tempDirectory, base, kind, sequence);
+	}
+	return name;
+}
+
+// size of an attribute in a sort key.
+static int keySize(Schema *schema, int attr) {
+	switch (schema->dataTypes[attr]) {
+		case DT_INT:
+		case DT_FLOAT:
+			return 4;
+		case DT_BOOL:
+			return 1;
+		default:
+			return schema->attrSizes[attr];
+	}
+}
+
+/**
+ * the sort key of a record: its attributes one after the other in bytes
+ * whose order by memcmp is the order of the values. Numbers are big endian
+ * with the sign bit flipped, negative floats have all bits flipped, strings
+ * are zero padded; the bytes of descending attributes are flipped.
+ * @param sort the sort.
+ * @param data the record.
+ * @param key  receives keyLen bytes.
+ */
+static void sortKey(SortState *sort, char *data, unsigned char *key) {
+	int i, j;
+
+	for (i = 0; i < sort->numKeys; i++) {
+		int attr = sort->attrs[i];
+		int size = keySize(sort->schema, attr);
+		char *value = data + sort->schema->attrOffsets[attr];
+		unsigned int bits = 0;
+		float f;
+
+		switch (sort->schema->dataTypes[attr]) {
+			case DT_INT:
+				memcpy(&bits, value, sizeof(int));
+				bits ^= 0x80000000u;
+				break;
+			case DT_FLOAT:
+				memcpy(&f, value, sizeof(float));
+				if (f == 0) {
+					f = 0;
+				}
+				memcpy(&bits, &f, sizeof(float));
+				bits = (bits & 0x80000000u) ? ~bits : bits ^ 0x80000000u;
+				break;
+			case DT_BOOL:
+				key[0] = (value[0] != 0);
+				break;
+			default:
+				memset(key, 0, size);
+				strncpy((char *)key, value, size);
+				break;
+		}
+		if (sort->schema->dataTypes[attr] == DT_INT || sort->schema->dataTypes[attr] == DT_FLOAT) {
+			key[0] = bits >> 24;
+			key[1] = bits >> 16;
+			key[2] = bits >> 8;
+			key[3] = bits;
+		}
+		if (sort->descending != NULL && sort->descending[i]) {
+			for (j = 0; j < size; j++) {
+				key[j] = ~key[j];
+			}
+		}
+		key += size;
+	}
+}
+
+// the first 8 bytes of a key as a number, zero padded.
+static unsigned long long keyPrefix(unsigned char *key, int keyLen) {
+	unsigned long long prefix = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		prefix = (prefix << 8) | (i < keyLen ? key[i] : 0);
+	}
+	return prefix;
+}
+
+static int itemLess(SortItem *a, SortItem *b, int keyLen) {
+	if (a->prefix != b->prefix) {
+		return a->prefix < b->prefix;
+	}
+	return keyLen > 8 && memcmp(a->entry + 8, b->entry + 8, keyLen - 8) < 0;
+}
+
+/**
+ * sort items on keys of up to 8 bytes, a byte at a time from the last
+ * one. Bytes that are the same in every item are skipped.
+ * @param items   the items.
+ * @param scratch room for n more items.
+ * @param n       number of items.
+ * @param keyLen  bytes of the key.
+ */
+static void radixSort(SortItem *items, SortItem *scratch, int n, int keyLen) {
+	SortItem *from = items, *to = scratch, *swap;
+	int counts[256];
+	int byte, i, sum;
+
+	for (byte = keyLen - 1; byte >= 0; byte--) {
+		int shift = 56 - 8 * byte;
+
+		memset(counts, 0, sizeof(counts));
+		for (i = 0; i < n; i++) {
+			counts[(from[i].prefix >> shift) & 0xff]++;
+		}
+		if (counts[(from[0].prefix >> shift) & 0xff] == n) {
+			continue;
+		}
+		for (i = 0, sum = 0; i < 256; i++) {
+			int count = counts[i];
+			counts[i] = sum;
+			sum += count;
+		}
+		for (i = 0; i < n; i++) {
+			to[counts[(from[i].prefix >> shift) & 0xff]++] = from[i];
+		}
+		swap = from;
+		from = to;
+		to = swap;
+	}
+	if (from != items) {
+		memcpy(items, from, sizeof(SortItem) * n);
+	}
+}
+
+static void swapItems(SortItem *a, SortItem *b) {
+	SortItem tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+static void sort2(SortItem *a, SortItem *b, int keyLen) {
+	if (itemLess(b, a, keyLen)) {
+		swapItems(a, b);
+	}
+}
+
+static void sort3(SortItem *a, SortItem *b, SortItem *c, int keyLen) {
+	sort2(a, b, keyLen);
+	sort2(b, c, keyLen);
+	sort2(a, b, keyLen);
+}
+
+// insertion sort, an unguarded one relies on the item before begin being
+// no larger than any of them.
+static void insertionSort(SortItem *begin, SortItem *end, int guarded, int keyLen) {
+	SortItem *cur, *sift, tmp;
+
+	if (begin == end) {
+		return;
+	}
+	for (cur = begin + 1; cur < end; cur++) {
+		sift = cur;
+		if (itemLess(cur, cur - 1, keyLen)) {
+			tmp = *cur;
+			do {
+				*sift = *(sift - 1);
+				sift--;
+			} while ((!guarded || sift != begin) && itemLess(&tmp, sift - 1, keyLen));
+			*sift = tmp;
+		}
+	}
+}
+
+// insertion sort that gives up after moving PDQ_PARTIAL_INSERTION items,
+// 0 if it did.
+static int partialInsertionSort(SortItem *begin, SortItem *end, int keyLen) {
+	SortItem *cur, *sift, tmp;
+	int moved = 0;
+
+	if (begin == end) {
+		return 1;
+	}
+	for (cur = begin + 1; cur < end; cur++) {
+		sift = cur;
+		if (itemLess(cur, cur - 1, keyLen)) {
+			tmp = *cur;
+			do {
+				*sift = *(sift - 1);
+				sift--;
+			} while (sift != begin && itemLess(&tmp, sift - 1, keyLen));
+			*sift = tmp;
+			moved += cur - sift;
+		}
+		if (moved > PDQ_PARTIAL_INSERTION) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void siftDown(SortItem *heap, int i, int n, int keyLen) {
+	int child;
+
+	while ((child = 2 * i + 1) < n) {
+		if (child + 1 < n && itemLess(&heap[child], &heap[child + 1], keyLen)) {
+			child++;
+		}
+		if (!itemLess(&heap[i], &heap[child], keyLen)) {
+			break;
+		}
+		swapItems(&heap[i], &heap[child]);
+		i = child;
+	}
+}
+
+static void heapSort(SortItem *begin, SortItem *end, int keyLen) {
+	int n = end - begin, i;
+
+	for (i = n / 2 - 1; i >= 0; i--) {
+		siftDown(begin, i, n, keyLen);
+	}
+	for (i = n - 1; i > 0; i--) {
+		swapItems(&begin[0], &begin[i]);
+		siftDown(begin, 0, i, keyLen);
+	}
+}
+
+// put the items smaller than the pivot *begin before it and the others
+// after it, tells whether they already were.
+static SortItem *partitionRight(SortItem *begin, SortItem *end, int *alreadyPartitioned, int keyLen) {
+	SortItem pivot = *begin, *first = begin, *last = end, *pivotPos;
+
+	while (itemLess(++first, &pivot, keyLen));
+	if (first - 1 == begin) {
+		while (first < last && !itemLess(--last, &pivot, keyLen));
+	}
+	else {
+		while (!itemLess(--last, &pivot, keyLen));
+	}
+
+	*alreadyPartitioned = first >= last;
+	while (first < last) {
+		swapItems(first, last);
+		while (itemLess(++first, &pivot, keyLen));
+		while (!itemLess(--last, &pivot, keyLen));
+	}
+
+	pivotPos = first - 1;
+	*begin = *pivotPos;
+	*pivotPos = pivot;
+	return pivotPos;
+}
+
+// put the items equal to the pivot *begin before it and the larger ones
+// after it, used when no item is smaller than the pivot.
+static SortItem *partitionLeft(SortItem *begin, SortItem *end, int keyLen) {
+	SortItem pivot = *begin, *first = begin, *last = end, *pivotPos;
+
+	while (itemLess(&pivot, --last, keyLen));
+	if (last + 1 == end) {
+		while (first < last && !itemLess(&pivot, ++first, keyLen));
+	}
+	else {
+		while (!itemLess(&pivot, ++first, keyLen));
+	}
+
+	while (first < last) {
+		swapItems(first, last);
+		while (itemLess(&pivot, --last, keyLen));
+		while (!itemLess(&pivot, ++first, keyLen));
+	}
+
+	pivotPos = last;
+	*begin = *pivotPos;
+	*pivotPos = pivot;
+	return pivotPos;
+}
+
+/**
+ * pattern-defeating quicksort: quicksort that sorts runs of equal items
+ * and already sorted parts in linear time, shuffles items after bad
+ * partitions and falls back to heap sort after too many of them.
+ * @param begin      first item.
+ * @param end        after the last item.
+ * @param badAllowed bad partitions left before heap sort.
+ * @param leftmost   whether there is no item before begin.
+ * @param keyLen     bytes of the key.
+ */
+static void pdqSort(SortItem *begin, SortItem *end, int badAllowed, int leftmost, int keyLen) {
+	while (1) {
+		int size = end - begin, half = size / 2, leftSize, rightSize, alreadyPartitioned;
+		SortItem *pivotPos;
+
+		if (size < PDQ_INSERTION_SORT) {
+			insertionSort(begin, end, leftmost, keyLen);
+			return;
+		}
+
+		// the median of three or of three medians of three becomes the pivot
+		if (size > PDQ_NINTHER) {
+			sort3(begin, begin + half, end - 1, keyLen);
+			sort3(begin + 1, begin + (half - 1), end - 2, keyLen);
+			sort3(begin + 2, begin + (half + 1), end - 3, keyLen);
+			sort3(begin + (half - 1), begin + half, begin + (half + 1), keyLen);
+			swapItems(begin, begin + half);
+		}
+		else {
+			sort3(begin + half, begin, end - 1, keyLen);
+		}
+
+		// a pivot equal to the item before begin is the smallest item, the
+		// items equal to it need no more sorting
+		if (!leftmost && !itemLess(begin - 1, begin, keyLen)) {
+			begin = partitionLeft(begin, end, keyLen) + 1;
+			continue;
+		}
+
+		pivotPos = partitionRight(begin, end, &alreadyPartitioned, keyLen);
+		leftSize = pivotPos - begin;
+		rightSize = end - (pivotPos + 1);
+
+		if (leftSize < size / 8 || rightSize < size / 8) {
+			if (--badAllowed == 0) {
+				heapSort(begin, end, keyLen);
+				return;
+			}
+			if (leftSize >= PDQ_INSERTION_SORT) {
+				swapItems(begin, begin + leftSize / 4);
+				swapItems(pivotPos - 1, pivotPos - leftSize / 4);
+				if (leftSize > PDQ_NINTHER) {
+					swapItems(begin + 1, begin + (leftSize / 4 + 1));
+					swapItems(begin + 2, begin + (leftSize / 4 + 2));
+					swapItems(pivotPos - 2, pivotPos - (leftSize / 4 + 1));
+					swapItems(pivotPos - 3, pivotPos - (leftSize / 4 + 2));
+				}
+			}
+			if (rightSize >= PDQ_INSERTION_SORT) {
+				swapItems(pivotPos + 1, pivotPos + (1 + rightSize / 4));
+				swapItems(end - 1, end - rightSize / 4);
+				if (rightSize > PDQ_NINTHER) {
+					swapItems(pivotPos + 2, pivotPos + (2 + rightSize / 4));
+					swapItems(pivotPos + 3, pivotPos + (3 + rightSize / 4));
+					swapItems(end - 2, end - (1 + rightSize / 4));
+					swapItems(end - 3, end - (2 + rightSize / 4));
+				}
+			}
+		}
+		else if (alreadyPartitioned && partialInsertionSort(begin, pivotPos, keyLen)
+				&& partialInsertionSort(pivotPos + 1, end, keyLen)) {
+			return;
+		}
+
+		pdqSort(begin, pivotPos, badAllowed, leftmost, keyLen);
+		begin = pivotPos + 1;
+		leftmost = 0;
+	}
+}
+
+// sort the items of the current run.
+static void sortItems(SortState *sort) {
+	int badAllowed = 1, n;
+
+	if (sort->numItems < 2) {
+		return;
+	}
+	if (sort->keyLen <= 8) {
+		radixSort(sort->items, sort->scratch, sort->numItems, sort->keyLen);
+		return;
+	}
+	for (n = sort->numItems; n > 1; n /= 2) {
+		badAllowed++;
+	}
+	pdqSort(sort->items, sort->items + sort->numItems, badAllowed, 1, sort->keyLen);
+}
+
+// entries on a page of a run.
+static int runEntries(SortState *sort) {
+	return (int)((PAGE_SIZE - sizeof(int)) / sort->entrySize);
+}
+
+// a new run file, or NULL.
+static SortRun *newRun(SortState *sort, RM_TableData *rel, SM_FileHandle *fh) {
+	SortRun *run;
+
+	if (sort->numRuns == sort->maxRuns) {
+		sort->maxRuns = (sort->maxRuns > 0) ? sort->maxRuns * 2 : 16;
+		sort->runs = (SortRun *)realloc(sort->runs, sizeof(SortRun) * sort->maxRuns);
+	}
+	run = &sort->runs[sort->numRuns];
+	run->name = tempFileName(rel->name, "sort");
+	run->numPages = 0;
+	if (createPageFile(run->name) != RC_OK || openPageFile(run->name, fh) != RC_OK) {
+		free(run->name);
+		return NULL;
+	}
+	sort->numRuns++;
+	return run;
+}
+
+// add an entry to the page of a run being written, and write the page once
+// it is full or flush is set. writeBlocks appends it to the file.
+static RC writeEntry(SortState *sort, SortRun *run, SM_FileHandle *fh, char *page, int *count, char *entry, int flush) {
+	RC rc;
+
+	if (entry != NULL) {
+		memcpy(page + sizeof(int) + *count * sort->entrySize, entry, sort->entrySize);
+		(*count)++;
+	}
+	if (*count == runEntries(sort) || (flush && *count > 0)) {
+		memcpy(page, count, sizeof(int));
+		if ((rc = writeBlocks(run->numPages, 1, fh, page)) != RC_OK) {
+			return rc;
+		}
+		run->numPages++;
+		*count = 0;
+	}
+	return RC_OK;
+}
+
+// write the sorted items as a run.
+static RC writeRun(SortState *sort, RM_TableData *rel) {
+	SM_FileHandle fh;
+	SortRun *run;
+	char *page;
+	int i, count = 0;
+	RC rc = RC_OK;
+
+	if ((run = newRun(sort, rel, &fh)) == NULL) {
+		return RC_WRITE_FAILED;
+	}
+	page = (char *)calloc(1, PAGE_SIZE);
+	for (i = 0; i < sort->numItems && rc == RC_OK; i++) {
+		rc = writeEntry(sort, run, &fh, page, &count, sort->items[i].entry, 0);
+	}
+	if (rc == RC_OK) {
+		rc = writeEntry(sort, run, &fh, page, &count, NULL, 1);
+	}
+	closePageFile(&fh);
+	free(page);
+	sort->numItems = 0;
+	return rc;
+}
+
+// delete the file of a run.
+static void dropRun(SortRun *run) {
+	if (run->name != NULL) {
+		destroyPageFile(run->name);
+		free(run->name);
+		run->name = NULL;
+	}
+}
+
+// go to the next entry of a run.
+static void advanceReader(RunReader *reader, int entrySize) {
+	if (++reader->pos < reader->count) {
+		reader->entry += entrySize;
+		return;
+	}
+	reader->entry = NULL;
+	if (reader->pageNum < reader->numPages && readBlock(reader->pageNum++, &reader->fh, reader->page) == RC_OK) {
+		memcpy(&reader->count, reader->page, sizeof(int));
+		reader->pos = 0;
+		reader->entry = reader->page + sizeof(int);
+	}
+}
+
+// whether the entry of run a comes before the one of run b. The run k
+// comes before all others, a run at its end after all others.
+static int mergeLess(Merger *merger, int a, int b) {
+	int c;
+
+	if (a == merger->k || b == merger->k) {
+		return a == merger->k;
+	}
+	if (merger->readers[a].entry == NULL || merger->readers[b].entry == NULL) {
+		return merger->readers[b].entry == NULL && merger->readers[a].entry != NULL;
+	}
+	c = memcmp(merger->readers[a].entry, merger->readers[b].entry, merger->keyLen);
+	return c < 0 || (c == 0 && a < b);
+}
+
+// play the run s up the tree, the winners go on and the losers stay.
+static void adjustMerger(Merger *merger, int s) {
+	int t = (s + merger->k) / 2, tmp;
+
+	for (; t > 0; t /= 2) {
+		if (mergeLess(merger, merger->losers[t], s)) {
+			tmp = s;
+			s = merger->losers[t];
+			merger->losers[t] = tmp;
+		}
+	}
+	merger->losers[0] = s;
+}
+
+// start merging k runs.
+static RC openMerger(SortState *sort, Merger *merger, SortRun *runs, int k) {
+	int i;
+
+	merger->k = k;
+	merger->keyLen = sort->keyLen;
+	merger->readers = (RunReader *)calloc(k, sizeof(RunReader));
+	merger->losers = (int *)malloc(sizeof(int) * k);
+	for (i = 0; i < k; i++) {
+		RunReader *reader = &merger->readers[i];
+
+		if (openPageFile(runs[i].name, &reader->fh) != RC_OK) {
+			return RC_FILE_NOT_FOUND;
+		}
+		reader->page = (char *)malloc(PAGE_SIZE);
+		reader->numPages = runs[i].numPages;
+		reader->pageNum = 0;
+		reader->count = 0;
+		reader->pos = 0;
+		advanceReader(reader, sort->entrySize);
+	}
+	for (i = 0; i < k; i++) {
+		merger->losers[i] = k;
+	}
+	for (i = k - 1; i >= 0; i--) {
+		adjustMerger(merger, i);
+	}
+	return RC_OK;
+}
+
+// the smallest entry of the runs, and go past it. NULL once they are all
+// merged.
+static char *nextMerged(SortState *sort, Merger *merger, char *copy) {
+	int winner = merger->losers[0];
+	RunReader *reader = &merger->readers[winner];
+
+	if (reader->entry == NULL) {
+		return NULL;
+	}
+	memcpy(copy, reader->entry, sort->entrySize);
+	advanceReader(reader, sort->entrySize);
+	adjustMerger(merger, winner);
+	return copy;
+}
+
+static void closeMerger(Merger *merger) {
+	int i;
+
+	for (i = 0; i < merger->k && merger->readers != NULL; i++) {
+		if (merger->readers[i].page != NULL) {
+			closePageFile(&merger->readers[i].fh);
+			free(merger->readers[i].page);
+		}
+	}
+	free(merger->readers);
+	free(merger->losers);
+	merger->readers = NULL;
+	merger->losers = NULL;
+	merger->k = 0;
+}
+
+// merge the first k runs that are left into a new run.
+static RC mergeRuns(SortState *sort, RM_TableData *rel, int k) {
+	Merger merger;
+	SM_FileHandle fh;
+	SortRun *run;
+	char *page, *entry;
+	int i, count = 0, first = sort->firstRun;
+	RC rc;
+
+	if ((run = newRun(sort, rel, &fh)) == NULL) {
+		return RC_WRITE_FAILED;
+	}
+	page = (char *)calloc(1, PAGE_SIZE);
+	entry = (char *)malloc(sort->entrySize);
+	if ((rc = openMerger(sort, &merger, sort->runs + first, k)) == RC_OK) {
+		while (rc == RC_OK && nextMerged(sort, &merger, entry) != NULL) {
+			rc = writeEntry(sort, run, &fh, page, &count, entry, 0);
+		}
+		if (rc == RC_OK) {
+			rc = writeEntry(sort, run, &fh, page, &count, NULL, 1);
+		}
+	}
+	closeMerger(&merger);
+	closePageFile(&fh);
+	free(page);
+	free(entry);
+
+	for (i = first; i < first + k; i++) {
+		dropRun(&sort->runs[i]);
+	}
+	sort->firstRun += k;
+	return rc;
+}
+
+/**
+ * start reading a table in the order of some of its attributes, the first
+ * one first. Records are collected into runs of memory bytes (SORT_MEMORY
+ * when 0), each sorted in memory: by radix sort if the key has up to 8
+ * bytes, like one int, else by pattern-defeating quicksort. If the table
+ * does not fit into one run, the runs are written to temporary page files
+ * and merged with a tree of losers, up to memory / PAGE_SIZE runs at once;
+ * more runs than that are merged in several passes. Records with equal
+ * keys come in no particular order. The table must not be changed during
+ * the sort.
+ * @param  sort       RM_SortHandle
+ * @param  rel        RM_TableData
+ * @param  attrList   the attributes to sort on.
+ * @param  descending for every attribute whether it is sorted from the
+ *                    largest value, NULL to sort all from the smallest.
+ * @param  numAttrs   number of attributes.
+ * @param  memory     bytes of a run, 0 for SORT_MEMORY.
+ * @return            RC_OK | RC_RM_NO_SUCH_ATTR | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+ */
+RC startSort (RM_SortHandle *sort, RM_TableData *rel, int *attrList, bool *descending, int numAttrs,
+		size_t memory) {
+	Schema *schema = rel->schema;
+	RM_ScanHandle sc;
+	SortState *state;
+	Record *record;
+	size_t perRecord;
+	int i, fanIn;
+	RC rc = RC_OK;
+
+	sort->mgmtData = NULL;
+	if (numAttrs < 1) {
+		THROW(RC_RM_NO_SUCH_ATTR, "a sort needs an attribute");
+	}
+	for (i = 0; i < numAttrs; i++) {
+		if (attrList[i] < 0 || attrList[i] >= schema->numAttr) {
+			THROW(RC_RM_NO_SUCH_ATTR, "sort attribute does not exist");
+		}
+	}
+
+	state = (SortState *)calloc(1, sizeof(SortState));
+	state->schema = schema;
+	state->numKeys = numAttrs;
+	state->attrs = (int *)malloc(sizeof(int) * numAttrs);
+	memcpy(state->attrs, attrList, sizeof(int) * numAttrs);
+	if (descending != NULL) {
+		state->descending = (bool *)malloc(sizeof(bool) * numAttrs);
+		memcpy(state->descending, descending, sizeof(bool) * numAttrs);
+	}
+	for (i = 0; i < numAttrs; i++) {
+		state->keyLen += keySize(schema, attrList[i]);
+	}
+	state->recordSize = getRecordSize(schema);
+	state->entrySize = (state->keyLen + sizeof(RID) + state->recordSize + 7) / 8 * 8;
+	state->memory = (memory > 0) ? memory : SORT_MEMORY;
+	state->lastKey = (char *)malloc(state->keyLen);
+	sort->rel = rel;
+	sort->mgmtData = state;
+
+	if (state->entrySize > PAGE_SIZE - (int)sizeof(int)) {
+		closeSort(sort);
+		THROW(RC_WRITE_FAILED, "the sort key and record do not fit on a page");
+	}
+
+	// a record takes its entry and two items, radix sort needs the second
+	perRecord = state->entrySize + 2 * sizeof(SortItem);
+	state->capacity = (int)(state->memory / perRecord);
+	if (state->capacity > getNumTuples(rel) + 1) {
+		state->capacity = getNumTuples(rel) + 1;
+	}
+	if (state->capacity < 16) {
+		state->capacity = 16;
+	}
+	state->entries = (char *)malloc((size_t)state->capacity * state->entrySize);
+	state->items = (SortItem *)malloc(sizeof(SortItem) * state->capacity);
+	state->scratch = (SortItem *)malloc(sizeof(SortItem) * state->capacity);
+
+	if ((rc = startScan(rel, &sc, NULL)) != RC_OK) {
+		closeSort(sort);
+		return rc;
+	}
+	createRecordInArena(&record, schema, getScanArena(&sc));
+	while (rc == RC_OK && next(&sc, record) == RC_OK) {
+		char *entry;
+
+		if (state->numItems == state->capacity) {
+			sortItems(state);
+			rc = writeRun(state, rel);
+		}
+		entry = state->entries + (size_t)state->numItems * state->entrySize;
+		sortKey(state, record->data, (unsigned char *)entry);
+		memcpy(entry + state->keyLen, &record->id, sizeof(RID));
+		memcpy(entry + state->keyLen + sizeof(RID), record->data, state->recordSize);
+		state->items[state->numItems].prefix = keyPrefix((unsigned char *)entry, state->keyLen);
+		state->items[state->numItems].entry = entry;
+		state->numItems++;
+	}
+	closeScan(&sc);
+	if (rc == RC_OK) {
+		sortItems(state);
+	}
+
+	// a table that fits into one run is returned from memory
+	if (rc != RC_OK || state->numRuns == 0) {
+		if (rc != RC_OK) {
+			closeSort(sort);
+		}
+		return rc;
+	}
+
+	if ((rc = writeRun(state, rel)) == RC_OK) {
+		free(state->entries);
+		free(state->items);
+		free(state->scratch);
+		state->entries = NULL;
+		state->items = NULL;
+		state->scratch = NULL;
+
+		fanIn = (int)(state->memory / PAGE_SIZE);
+		fanIn = (fanIn < 2) ? 2 : (fanIn > SORT_MAX_FAN_IN) ? SORT_MAX_FAN_IN : fanIn;
+		while (rc == RC_OK && state->numRuns - state->firstRun > fanIn) {
+			rc = mergeRuns(state, rel, fanIn);
+		}
+	}
+	if (rc == RC_OK && (rc = openMerger(state, &state->merger, state->runs + state->firstRun,
+			state->numRuns - state->firstRun)) == RC_OK) {
+		state->merging = 1;
+	}
+	if (rc != RC_OK) {
+		closeSort(sort);
+	}
+	return rc;
+}
+
+/**
+ * the next record in the order of the sort.
+ * @param  sort   RM_SortHandle
+ * @param  record receives the record, made by createRecord.
+ * @return        RC_OK | RC_RM_NO_MORE_TUPLES
+ */
+RC nextSorted (RM_SortHandle *sort, Record *record) {
+	SortState *state = (SortState *)sort->mgmtData;
+	char *entry;
+
+	if (state->merging) {
+		entry = (state->merger.k > 0) ? state->merger.readers[state->merger.losers[0]].entry : NULL;
+		if (entry == NULL) {
+			return RC_RM_NO_MORE_TUPLES;
+		}
+		memcpy(state->lastKey, entry, state->keyLen);
+		memcpy(&record->id, entry + state->keyLen, sizeof(RID));
+		memcpy(record->data, entry + state->keyLen + sizeof(RID), state->recordSize);
+		advanceReader(&state->merger.readers[state->merger.losers[0]], state->entrySize);
+		adjustMerger(&state->merger, state->merger.losers[0]);
+		return RC_OK;
+	}
+
+	if (state->next == state->numItems) {
+		return RC_RM_NO_MORE_TUPLES;
+	}
+	entry = state->items[state->next++].entry;
+	memcpy(state->lastKey, entry, state->keyLen);
+	memcpy(&record->id, entry + state->keyLen, sizeof(RID));
+	memcpy(record->data, entry + state->keyLen + sizeof(RID), state->recordSize);
+	return RC_OK;
+}
+
+/**
+ * end a sort, deleting its temporary files.
+ * @param  sort RM_SortHandle
+ * @return      RC_OK
+ */
+RC closeSort (RM_SortHandle *sort) {
+	SortState *state = (SortState *)sort->mgmtData;
+	int i;
+
+	if (state == NULL) {
+		return RC_OK;
+	}
+	closeMerger(&state->merger);
+	for (i = 0; i < state->numRuns; i++) {
+		dropRun(&state->runs[i]);
+	}
+	free(state->runs);
+	free(state->entries);
+	free(state->items);
+	free(state->scratch);
+	free(state->attrs);
+	free(state->descending);
+	free(state->lastKey);
+	free(state);
+	sort->mgmtData = NULL;
+	return RC_OK;
+}
+
+/**
+ * the sort key of the record returned last by nextSorted. Keys of two
+ * records compare by memcmp like the records in the order of the sort.
+ * @param  sort   RM_SortHandle
+ * @param  keyLen receives the bytes of the key.
+ * @return        the key, valid until the next call of nextSorted.
+ */
+char *getSortKey (RM_SortHandle *sort, int *keyLen) {
+	SortState *state = (SortState *)sort->mgmtData;
+
+	*keyLen = state->keyLen;
+	return state->lastKey;
+}
+
+/**
+ * the number of runs a sort wrote, with those of the merge passes.
+ * @param  sort RM_SortHandle
+ * @return      0 if the table was sorted in memory.
+ */
+int getSortRuns (RM_SortHandle *sort) {
+	return ((SortState *)sort->mgmtData)->numRuns;
+}
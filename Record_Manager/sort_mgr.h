@@ -0,0 +1,32 @@
+#ifndef SORT_MGR_H
+#define SORT_MGR_H
+
+#include <stddef.h>
+
+#include "dberror.h"
+#include "tables.h"
+
+// memory of a sort when none is given, a table that does not fit is
+// sorted in runs that are merged
+#define SORT_MEMORY (64 << 20)
+
+// Bookkeeping for sorts
+typedef struct RM_SortHandle
+{
+  RM_TableData *rel;
+  void *mgmtData;
+} RM_SortHandle;
+
+// temporary files of sorts and joins
+extern RC setTempDirectory (char *dir);
+extern char *tempFileName (char *table, char *kind);
+
+// reading a table in the order of some of its attributes
+extern RC startSort (RM_SortHandle *sort, RM_TableData *rel, int *attrList, bool *descending, int numAttrs,
+		     size_t memory);
+extern RC nextSorted (RM_SortHandle *sort, Record *record);
+extern RC closeSort (RM_SortHandle *sort);
+extern char *getSortKey (RM_SortHandle *sort, int *keyLen);
+extern int getSortRuns (RM_SortHandle *sort);
+
+#endif // SORT_MGR_H
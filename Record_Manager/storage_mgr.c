@@ -4,10 +4,12 @@
 #include <fcntl.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
 #include <sys/stat.h>
 
 #include "storage_mgr.h"
 #include "dberror.h"
+#include "lz_codec.h"
 #include "test_helper.h"
 
 #define TOTAL_PAGES 1000 //Define Page Size to be 1000
@@ -16,6 +18,261 @@
 SM_FileHandle *fHandle;
 SM_PageHandle memPage;
 
+// a compressed page file starts with a header of PAGE_SIZE bytes holding
+// COMPRESSED_MAGIC, the number of pages and the offset of the page-offset
+// map. The pages follow in extents of their own, compressed by lzCompress
+// or, when that does not make them smaller, as they are, and the map, the
+// offset of every extent and then its length, follows the last extent. A
+// page never written has length 0 and is read as zero bytes. The extents
+// and the map the header points to are never written over, so the file can
+// be read as it was when the map was stored until the header points to a
+// new one.
+#define COMPRESSED_MAGIC "\177LZPAGE"
+#define COMPRESSED_MAGIC_SIZE 8
+#define COMPRESSED_PAGES_OFFSET 8
+#define COMPRESSED_MAP_OFFSET 16
+#define COMPRESSED_HEADER_SIZE 24
+
+// pages compressPageFile compresses before it writes them at once.
+#define COMPRESS_CHUNK_PAGES 64
+
+// the page-offset map of a compressed page file, shared by all open handles
+// of the file so that they see each other's writes. A written page gets a
+// new extent at the end of the file, or takes its extent again if it fits
+// there and the stored map does not know it; the map is written at the end
+// of the file when a handle is closed after a change.
+typedef struct PageMap {
+	char *fileName;
+	int refs;
+	int numPages;
+	int capacity;
+	long long *offsets;
+	int *lengths;
+	long long dataEnd;	// end of the last extent or the stored map
+	long long storedEnd;	// end of the stored map, the extents after it are not in it
+	int dirty;
+	struct PageMap *next;
+} PageMap;
+
+// the maps of the open compressed page files, all guarded by pageMapLock.
+static PageMap *pageMaps = NULL;
+static pthread_mutex_t pageMapLock = PTHREAD_MUTEX_INITIALIZER;
+
+// make room for numPages pages in a map, new pages are not written yet.
+static void growPageMap(PageMap *map, int numPages) {
+	if (numPages > map->capacity) {
+		int capacity = (map->capacity * 2 > numPages) ? map->capacity * 2 : numPages;
+		map->offsets = (long long *)realloc(map->offsets, sizeof(long long) * capacity);
+		map->lengths = (int *)realloc(map->lengths, sizeof(int) * capacity);
+		memset(map->lengths + map->capacity, 0, sizeof(int) * (capacity - map->capacity));
+		memset(map->offsets + map->capacity, 0, sizeof(long long) * (capacity - map->capacity));
+		map->capacity = capacity;
+	}
+	if (numPages > map->numPages) {
+		map->numPages = numPages;
+	}
+}
+
+static void freePageMap(PageMap *map) {
+	free(map->fileName);
+	free(map->offsets);
+	free(map->lengths);
+	free(map);
+}
+
+// take a map out of the list of open files, if it is still in it.
+static void unlinkPageMap(PageMap *map) {
+	PageMap **link;
+
+	for (link = &pageMaps; *link != NULL; link = &(*link)->next) {
+		if (*link == map) {
+			*link = map->next;
+			return;
+		}
+	}
+}
+
+static PageMap *findPageMap(char *fileName) {
+	PageMap *map;
+
+	for (map = pageMaps; map != NULL; map = map->next) {
+		if (strcmp(map->fileName, fileName) == 0) {
+			return map;
+		}
+	}
+	return NULL;
+}
+
+// read the header and the map of a compressed page file, NULL if it is not one.
+static PageMap *loadPageMap(int fd, char *fileName) {
+	char header[COMPRESSED_HEADER_SIZE];
+	long long mapOffset;
+	PageMap *map;
+	int numPages;
+
+	if (pread(fd, header, COMPRESSED_HEADER_SIZE, 0) != COMPRESSED_HEADER_SIZE
+			|| memcmp(header, COMPRESSED_MAGIC, COMPRESSED_MAGIC_SIZE) != 0) {
+		return NULL;
+	}
+	memcpy(&numPages, header + COMPRESSED_PAGES_OFFSET, sizeof(int));
+	memcpy(&mapOffset, header + COMPRESSED_MAP_OFFSET, sizeof(long long));
+
+	map = (PageMap *)calloc(1, sizeof(PageMap));
+	growPageMap(map, numPages);
+	if (numPages > 0
+			&& (pread(fd, map->offsets, sizeof(long long) * numPages, mapOffset) != (ssize_t)(sizeof(long long) * numPages)
+			|| pread(fd, map->lengths, sizeof(int) * numPages, mapOffset + sizeof(long long) * numPages)
+				!= (ssize_t)(sizeof(int) * numPages))) {
+		freePageMap(map);
+		return NULL;
+	}
+	map->fileName = strdup(fileName);
+	map->dataEnd = mapOffset + (sizeof(long long) + sizeof(int)) * numPages;
+	map->storedEnd = map->dataEnd;
+	return map;
+}
+
+// write the map after the last extent, then the header pointing to it once
+// the extents and the map are on disk. The old map is left where it is.
+static RC storePageMap(int fd, PageMap *map) {
+	char header[COMPRESSED_HEADER_SIZE];
+	size_t offsetsSize = sizeof(long long) * map->numPages, lengthsSize = sizeof(int) * map->numPages;
+
+	memcpy(header, COMPRESSED_MAGIC, COMPRESSED_MAGIC_SIZE);
+	memcpy(header + COMPRESSED_PAGES_OFFSET, &map->numPages, sizeof(int));
+	memset(header + COMPRESSED_PAGES_OFFSET + sizeof(int), 0, sizeof(int));
+	memcpy(header + COMPRESSED_MAP_OFFSET, &map->dataEnd, sizeof(long long));
+
+	if (pwrite(fd, map->offsets, offsetsSize, map->dataEnd) != (ssize_t)offsetsSize
+			|| pwrite(fd, map->lengths, lengthsSize, map->dataEnd + offsetsSize) != (ssize_t)lengthsSize
+			|| fdatasync(fd) != 0
+			|| pwrite(fd, header, COMPRESSED_HEADER_SIZE, 0) != COMPRESSED_HEADER_SIZE
+			|| ftruncate(fd, map->dataEnd + offsetsSize + lengthsSize) != 0) {
+		return RC_WRITE_FAILED;
+	}
+	map->dataEnd += offsetsSize + lengthsSize;
+	map->storedEnd = map->dataEnd;
+	map->dirty = 0;
+	return RC_OK;
+}
+
+// compress a page into its extent, which is the page itself if it does not
+// get smaller. Returns the length of the extent.
+static int compressExtent(char *page, char *extent) {
+	int length = lzCompress(page, PAGE_SIZE, extent, PAGE_SIZE - 1);
+
+	if (length < 0) {
+		memcpy(extent, page, PAGE_SIZE);
+		return PAGE_SIZE;
+	}
+	return length;
+}
+
+// read a page of a compressed page file.
+static RC readCompressedBlock(int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
+	PageMap *map = fHandle->pageMap;
+	char extent[PAGE_SIZE];
+	long long offset;
+	int length;
+
+	pthread_mutex_lock(&pageMapLock);
+	if (pageNum < 0 || pageNum >= map->numPages) {
+		pthread_mutex_unlock(&pageMapLock);
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	offset = map->offsets[pageNum];
+	length = map->lengths[pageNum];
+	pthread_mutex_unlock(&pageMapLock);
+
+	if (length == 0) {
+		memset(memPage, 0, PAGE_SIZE);
+		return RC_OK;
+	}
+	if (pread(fHandle->mgmtInfo, (length == PAGE_SIZE) ? memPage : extent, length, offset) != length) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	if (length != PAGE_SIZE && lzDecompress(extent, length, memPage, PAGE_SIZE) != PAGE_SIZE) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	return RC_OK;
+}
+
+// write consecutive pages of a compressed page file. The pages are
+// compressed before the map is locked, the ones that get new extents are
+// appended with a single write. An extent of the stored map is never
+// written over, so a reader of the file or a crash finds the pages as they
+// were when the map was stored.
+static RC writeCompressedBlocks(int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPages) {
+	PageMap *map = fHandle->pageMap;
+	char *extents = (char *)malloc((size_t)numPages * PAGE_SIZE);
+	int *lengths = (int *)malloc(sizeof(int) * numPages);
+	size_t appended = 0;
+	RC rc = RC_OK;
+	int i;
+
+	for (i = 0; i < numPages; i++) {
+		lengths[i] = compressExtent(memPages + (size_t)i * PAGE_SIZE, extents + (size_t)i * PAGE_SIZE);
+	}
+
+	pthread_mutex_lock(&pageMapLock);
+	if (startPage < 0 || startPage > map->numPages) {
+		rc = RC_READ_NON_EXISTING_PAGE;
+	}
+	else {
+		growPageMap(map, startPage + numPages);
+	}
+
+	// a page that fits into an extent written since the map was stored is
+	// written there, the extents of the others are moved together at the
+	// front
+	for (i = 0; i < numPages && rc == RC_OK; i++) {
+		int pageNum = startPage + i;
+
+		if (lengths[i] <= map->lengths[pageNum] && map->offsets[pageNum] >= map->storedEnd) {
+			if (pwrite(fHandle->mgmtInfo, extents + (size_t)i * PAGE_SIZE, lengths[i], map->offsets[pageNum]) != lengths[i]) {
+				rc = RC_WRITE_FAILED;
+			}
+			map->lengths[pageNum] = lengths[i];
+			lengths[i] = 0;
+		}
+		else {
+			memmove(extents + appended, extents + (size_t)i * PAGE_SIZE, lengths[i]);
+			appended += lengths[i];
+		}
+	}
+	if (rc == RC_OK && appended > 0 && pwrite(fHandle->mgmtInfo, extents, appended, map->dataEnd) != (ssize_t)appended) {
+		rc = RC_WRITE_FAILED;
+	}
+	for (i = 0; i < numPages && rc == RC_OK; i++) {
+		if (lengths[i] > 0) {
+			map->offsets[startPage + i] = map->dataEnd;
+			map->lengths[startPage + i] = lengths[i];
+			map->dataEnd += lengths[i];
+		}
+	}
+	if (rc == RC_OK) {
+		map->dirty = 1;
+		fHandle->totalNumPages = map->numPages;
+	}
+	pthread_mutex_unlock(&pageMapLock);
+
+	free(extents);
+	free(lengths);
+	return rc;
+}
+
+// forget the map of a file that is created again or removed; handles still
+// open on it keep it until they are closed.
+static void forgetPageMap(char *fileName) {
+	PageMap *map;
+
+	pthread_mutex_lock(&pageMapLock);
+	if ((map = findPageMap(fileName)) != NULL) {
+		unlinkPageMap(map);
+	}
+	pthread_mutex_unlock(&pageMapLock);
+}
+
 
 /* Method that initializes the Storage Manager */
 void initStorageManager (void) {
@@ -43,6 +300,7 @@ RC createPageFile (char *fileName) {
 
 	// generate a new file descriptor.
 	int fd = creat(fileName, mode);
+	forgetPageMap(fileName);
 
 	// fd is a non-negative integer if the file descriptor is generated successfully.
 	if (fd < 0) {
@@ -104,6 +362,30 @@ RC openPageFile (char *fileName, SM_FileHandle *fHandle) {
 	fHandle->fileName = fileName;
 	fHandle->totalNumPages = fsize/PAGE_SIZE;
 	fHandle->curPagePos = 0;
+	fHandle->pageMap = NULL;
+
+	// a compressed page file shares its page-offset map with the other
+	// handles open on it.
+	char magic[COMPRESSED_MAGIC_SIZE];
+	if (pread(fd, magic, COMPRESSED_MAGIC_SIZE, 0) == COMPRESSED_MAGIC_SIZE
+			&& memcmp(magic, COMPRESSED_MAGIC, COMPRESSED_MAGIC_SIZE) == 0) {
+		pthread_mutex_lock(&pageMapLock);
+		PageMap *map = findPageMap(fileName);
+		if (map == NULL && (map = loadPageMap(fd, fileName)) != NULL) {
+			map->next = pageMaps;
+			pageMaps = map;
+		}
+		if (map != NULL) {
+			map->refs++;
+			fHandle->pageMap = map;
+			fHandle->totalNumPages = map->numPages;
+		}
+		pthread_mutex_unlock(&pageMapLock);
+		if (map == NULL) {
+			close(fd);
+			return RC_FILE_NOT_FOUND;
+		}
+	}
 
 
 	// printf("%d\n", fHandle->totalNumPages);
@@ -114,9 +396,10 @@ RC openPageFile (char *fileName, SM_FileHandle *fHandle) {
 ******************************************************************************************************************
 **
 **      Method Name :closePageFile
-**      Description: Close a page file
+**      Description: Close a page file. The page-offset map of a compressed page file changed through the handle
+**                   is written first.
 **      Input Parameters :An existing file handle
-**      Return Value : RC_OK | RC_FILE_NOT_FOUND
+**      Return Value : RC_OK | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
 **
 ******************************************************************************************************************
 */
@@ -125,9 +408,26 @@ RC closePageFile (SM_FileHandle *fHandle) {
 	// access file descriptor by page file handle.
 	int fd = (int)fHandle->mgmtInfo;
 
+	// the map of a compressed page file is written after a change, and
+	// released by the last handle.
+	PageMap *map = fHandle->pageMap;
+	RC rc = RC_OK;
+	if (map != NULL) {
+		pthread_mutex_lock(&pageMapLock);
+		if (map->dirty) {
+			rc = storePageMap(fd, map);
+		}
+		if (--map->refs == 0) {
+			unlinkPageMap(map);
+			freePageMap(map);
+		}
+		pthread_mutex_unlock(&pageMapLock);
+		fHandle->pageMap = NULL;
+	}
+
 	// close function returns 0 if the file descriptor is closed.
 	if (close(fd) == 0) {
-		return RC_OK;
+		return rc;
 	}
 	// otherwise, return error code.
 	return RC_FILE_NOT_FOUND;
@@ -144,6 +444,7 @@ RC closePageFile (SM_FileHandle *fHandle) {
 */
 RC destroyPageFile (char *fileName) {
 	// destroy file.
+	forgetPageMap(fileName);
 	int r = remove(fileName);
 	if (r == 0) {
 		return RC_OK;
@@ -153,6 +454,80 @@ RC destroyPageFile (char *fileName) {
 /*
 ******************************************************************************************************************
 **
+**      Method Name :compressPageFile
+**      Description: Rewrites a page file with every page compressed in an extent of its own and a page-offset map,
+**                   for tables that are mostly read. The file is opened and used as before: readBlock decompresses
+**                   the pages, so the buffer pool keeps them decompressed, and written pages are compressed again.
+**                   A compressed page file is rewritten without the extents its pages have left behind. The
+**                   file must not be open.
+**      Input Parameters : filename
+**      Return Value : RC_OK | RC_FILE_NOT_FOUND | RC_WRITE_FAILED
+**
+******************************************************************************************************************
+*/
+RC compressPageFile (char *fileName) {
+	SM_FileHandle in;
+	RC rc;
+
+	if ((rc = openPageFile(fileName, &in)) != RC_OK) {
+		return rc;
+	}
+
+	// the pages are written to a new file that replaces the old one.
+	char *tempName = (char *)malloc(strlen(fileName) + 4);
+	sprintf(tempName, "%s.lz", fileName);
+	int fd = open(tempName, O_RDWR | O_CREAT | O_TRUNC, S_IRWXU);
+	char *pages = (char *)malloc((size_t)COMPRESS_CHUNK_PAGES * PAGE_SIZE);
+	char *extents = (char *)malloc((size_t)COMPRESS_CHUNK_PAGES * PAGE_SIZE);
+	PageMap map;
+	int i, j, chunk;
+
+	memset(&map, 0, sizeof(PageMap));
+	growPageMap(&map, in.totalNumPages);
+	map.dataEnd = PAGE_SIZE;
+	if (fd < 0 || (in.pageMap != NULL && in.pageMap->refs > 1)) {
+		rc = RC_WRITE_FAILED;
+	}
+
+	for (i = 0; i < in.totalNumPages && rc == RC_OK; i += chunk) {
+		size_t length = 0;
+
+		chunk = (in.totalNumPages - i < COMPRESS_CHUNK_PAGES) ? in.totalNumPages - i : COMPRESS_CHUNK_PAGES;
+		for (j = 0; j < chunk && rc == RC_OK; j++) {
+			rc = readBlock(i + j, &in, pages + (size_t)j * PAGE_SIZE);
+			map.offsets[i + j] = map.dataEnd + length;
+			map.lengths[i + j] = compressExtent(pages + (size_t)j * PAGE_SIZE, extents + length);
+			length += map.lengths[i + j];
+		}
+		if (rc == RC_OK && pwrite(fd, extents, length, map.dataEnd) != (ssize_t)length) {
+			rc = RC_WRITE_FAILED;
+		}
+		map.dataEnd += length;
+	}
+	if (rc == RC_OK) {
+		rc = storePageMap(fd, &map);
+	}
+
+	closePageFile(&in);
+	if (fd >= 0) {
+		close(fd);
+	}
+	if (rc == RC_OK && rename(tempName, fileName) != 0) {
+		rc = RC_WRITE_FAILED;
+	}
+	if (rc != RC_OK) {
+		remove(tempName);
+	}
+	free(map.offsets);
+	free(map.lengths);
+	free(pages);
+	free(extents);
+	free(tempName);
+	return rc;
+}
+/*
+******************************************************************************************************************
+**
 **      Method Name :readBlock
 **      Description: The method reads the "pageNum"th block from a file and stores its content in the memory pointed to by the memPage page handle.
 **      Input Parameters : An Integer "pageNum", An existing file handle and a Page handle
@@ -162,9 +537,18 @@ RC destroyPageFile (char *fileName) {
 */
 RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	int md = (int)fHandle->mgmtInfo;
-	// if pageNum is greater than total number of pages in the file, return error.
+	if (fHandle->pageMap != NULL) {
+		return readCompressedBlock(pageNum, fHandle, memPage);
+	}
+
+	// if pageNum is greater than total number of pages in the file, return
+	// error. Another handle may have appended pages since this one was
+	// opened; the handle is left as it is, threads may share it for reading.
 	if (pageNum > (fHandle->totalNumPages)) {
-		return RC_READ_NON_EXISTING_PAGE;
+		struct stat st;
+		if (fstat(md, &st) != 0 || pageNum >= st.st_size / PAGE_SIZE) {
+			return RC_READ_NON_EXISTING_PAGE;
+		}
 	}
 
 	// define offset used for finding and manipulating the particular page.
@@ -175,7 +559,7 @@ RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	//
 	// detail of this function can be found here:
 	// http://pubs.opengroup.org/onlinepubs/009695399/functions/read.html
-	if (pread(md, memPage, PAGE_SIZE, offset) > 0 ) {
+	if (pread(md, memPage, PAGE_SIZE, offset) == PAGE_SIZE) {
 		return RC_OK;
 	}
 	else {
@@ -207,6 +591,9 @@ int getBlockPos (SM_FileHandle *fHandle) {
 */
 RC readFirstBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	int md = (int)fHandle->mgmtInfo;
+	if (fHandle->pageMap != NULL) {
+		return readBlock(0, fHandle, memPage);
+	}
 
 	if (pread(md, memPage, PAGE_SIZE, 0) > 0) {
 		return RC_OK;
@@ -230,6 +617,9 @@ RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	if (fHandle->curPagePos == 0) {
 		return RC_READ_NON_EXISTING_PAGE;
 	}
+	if (fHandle->pageMap != NULL) {
+		return readBlock(fHandle->curPagePos - 1, fHandle, memPage);
+	}
 
 	off_t offset = (fHandle->curPagePos - 1) * PAGE_SIZE;
 
@@ -252,6 +642,9 @@ RC readPreviousBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 RC readCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	off_t offset = fHandle->curPagePos * PAGE_SIZE;
 	int md = (int)fHandle->mgmtInfo;
+	if (fHandle->pageMap != NULL) {
+		return readBlock(fHandle->curPagePos, fHandle, memPage);
+	}
 	if (pread(md, memPage, PAGE_SIZE, offset) < 0) {
 		return RC_READ_NON_EXISTING_PAGE;
 	}
@@ -272,6 +665,9 @@ RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	if (fHandle->curPagePos == fHandle->totalNumPages) {
 		return RC_READ_NON_EXISTING_PAGE;
 	}
+	if (fHandle->pageMap != NULL) {
+		return readBlock(fHandle->curPagePos + 1, fHandle, memPage);
+	}
 	off_t offset = (fHandle->curPagePos + 1) * PAGE_SIZE;
 
 	if (pread(md, memPage, PAGE_SIZE, offset) < 0) {
@@ -293,6 +689,9 @@ RC readNextBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	int md = (int)fHandle->mgmtInfo;
 	off_t offset = fHandle->totalNumPages * PAGE_SIZE;
+	if (fHandle->pageMap != NULL) {
+		return readBlock(fHandle->totalNumPages - 1, fHandle, memPage);
+	}
 	if (pread(md, memPage, PAGE_SIZE, offset) < 0) {
 		return RC_READ_NON_EXISTING_PAGE;
 	}
@@ -310,6 +709,9 @@ RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 */
 RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	int md = (int)fHandle->mgmtInfo;
+	if (fHandle->pageMap != NULL) {
+		return writeCompressedBlocks(pageNum, 1, fHandle, memPage);
+	}
 	if (pageNum > fHandle->totalNumPages) {
 		return RC_READ_NON_EXISTING_PAGE;
 	}
@@ -336,6 +738,9 @@ RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage) {
 RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 	int md = (int)fHandle->mgmtInfo;
 	off_t offset = (off_t)fHandle->curPagePos * PAGE_SIZE;
+	if (fHandle->pageMap != NULL) {
+		return writeCompressedBlocks(fHandle->curPagePos, 1, fHandle, memPage);
+	}
 	if (pwrite(md, memPage, PAGE_SIZE, offset) < 0) {
 		return RC_WRITE_FAILED;
 	}
@@ -344,6 +749,40 @@ RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage) {
 /*
 ******************************************************************************************************************
 **
+**      Method Name : writeBlocks
+**      Description: The method writes "numPages" consecutive pages starting at "startPage" with a single write. The
+**                   pages may extend the file as long as they start at or before its current end.
+**      Input Parameters : An Integer "startPage", An Integer "numPages", An existing file handle and a buffer of
+**                         numPages * PAGE_SIZE bytes
+**      Return Value : RC_OK | RC_READ_NON_EXISTING_PAGE | RC_WRITE_FAILED
+**
+******************************************************************************************************************
+*/
+RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPages) {
+	int md = (int)fHandle->mgmtInfo;
+	if (fHandle->pageMap != NULL) {
+		return writeCompressedBlocks(startPage, numPages, fHandle, memPages);
+	}
+	if (startPage > fHandle->totalNumPages) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	off_t offset = (off_t)startPage * PAGE_SIZE;
+	size_t length = (size_t)numPages * PAGE_SIZE;
+
+	if (pwrite(md, memPages, length, offset) != (ssize_t)length) {
+		return RC_WRITE_FAILED;
+	}
+
+	// pages written past the old end of file are now part of it.
+	if (startPage + numPages > fHandle->totalNumPages) {
+		fHandle->totalNumPages = startPage + numPages;
+	}
+	return RC_OK;
+}
+/*
+******************************************************************************************************************
+**
 **      Method Name : appendEmptyBlock
 **      Description: Increase the number of pages in the file by one. The new last page is filled with zero bytes.
 **      Input Parameters :  An existing file handle
@@ -359,7 +798,14 @@ RC appendEmptyBlock (SM_FileHandle *fHandle) {
 
 	off_t offset = (fHandle->totalNumPages) * PAGE_SIZE;
 
-	if(pwrite(md, memPage, PAGE_SIZE, offset) < 0) {
+	if (fHandle->pageMap != NULL) {
+		RC rc = writeCompressedBlocks(fHandle->totalNumPages, 1, fHandle, data);
+		if (rc == RC_OK) {
+			fHandle->curPagePos += 1;
+		}
+		return rc;
+	}
+	if(pwrite(md, data, PAGE_SIZE, offset) < 0) {
 		return RC_WRITE_FAILED;
 	}
 	else {
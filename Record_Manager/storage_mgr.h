@@ -11,6 +11,7 @@ typedef struct SM_FileHandle {
   int totalNumPages;
   int curPagePos;
   int mgmtInfo;
+  struct PageMap *pageMap;	// where the pages of a compressed page file are, NULL for a plain one
 } SM_FileHandle;
 
 typedef char* SM_PageHandle;
@@ -24,6 +25,7 @@ extern RC createPageFile (char *fileName);
 extern RC openPageFile (char *fileName, SM_FileHandle *fHandle);
 extern RC closePageFile (SM_FileHandle *fHandle);
 extern RC destroyPageFile (char *fileName);
+extern RC compressPageFile (char *fileName);
 
 /* reading blocks from disc */
 extern RC readBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
@@ -37,6 +39,7 @@ extern RC readLastBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 /* writing blocks to a page file */
 extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
+extern RC writeBlocks (int startPage, int numPages, SM_FileHandle *fHandle, SM_PageHandle memPages);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
 
@@ -44,8 +44,21 @@ typedef struct Schema
   int *typeLength;
   int *keyAttrs;
   int keySize;
+  int *attrOffsets;   // byte offset of each attribute in Record->data
+  int *attrSizes;     // byte size of each attribute
+  int recordSize;     // size of Record->data, padded for alignment
 } Schema;
 
+// how the records of a table are laid out in its data pages: whole records
+// one after the other, PAX, one minipage per attribute with its values of
+// every slot of the page, or PAX with the minipages of every page encoded
+// (see column_codec.h).
+typedef enum TableLayout {
+  LAYOUT_ROW = 0,
+  LAYOUT_PAX = 1,
+  LAYOUT_COMPRESSED = 2
+} TableLayout;
+
 // TableData: Management Structure for a Record Manager to handle one relation
 typedef struct RM_TableData
 {
@@ -66,7 +79,14 @@ typedef struct Table_Header {
 	// int *offsets;
 	// int maxRecords;
 	List *tombstone;
+	unsigned char *deletedSlots;	// bit per slot of the records in the tombstone
+	int deletedSlotsSize;		// bytes of deletedSlots
   bool keyCheck;
+	struct KeyIndex *keyIndex;	// primary key index, NULL until it is needed
+	struct HashHandle *keyHash;	// hash index made by createKeyHash, or NULL
+	struct TableStats *stats;	// statistics made by analyzeTable, or NULL
+	struct ZoneMap *zones;		// zone map made by buildZoneMap, or NULL
+	TableLayout layout;		// layout of the data pages
 } Table_Header;
 
 
@@ -1,6 +1,20 @@
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <glob.h>
 #include "dberror.h"
 #include "expr.h"
+#include "join_mgr.h"
+#include "sort_mgr.h"
+#include "agg_mgr.h"
+#include "column_codec.h"
+#include "lz_codec.h"
+#include "buffer_mgr.h"
+#include "storage_mgr.h"
 #include "record_mgr.h"
 #include "tables.h"
 #include "test_helper.h"
@@ -52,6 +66,27 @@
 static void testCreateAndReloadTombstoneList (void);
 static void testInsertIntoTombstoneList(void);
 static void testPrimaryKeyCheck(void);
+static void testBulkLoad(void);
+static void testBatchedOperations(void);
+static void testDeletedRecordsKept(void);
+static void testTypedAttrAccessors(void);
+static void testScanArena(void);
+static void testProjectedScan(void);
+static void testParallelScan(void);
+static void testScanPageReads(void);
+static void testCompositeKeyIndex(void);
+static void testGetRecordByKey(void);
+static void testSharedScan(void);
+static void testTableStats(void);
+static void testZoneMap(void);
+static void testHashJoin(void);
+static void testExternalSort(void);
+static void testMergeJoin(void);
+static void testAggregate(void);
+static void testTopK(void);
+static void testPaxLayout(void);
+static void testCompressedLayout(void);
+static void testCompressedPageFile(void);
 
 // struct for test records
 typedef struct TestRecord {
@@ -60,10 +95,35 @@ typedef struct TestRecord {
   int c;
 } TestRecord;
 
+// per thread results of a parallel scan
+#define TEST_SCAN_THREADS 4
+typedef struct ParallelResult {
+  Schema *schema;
+  int found[TEST_SCAN_THREADS];
+  long sum[TEST_SCAN_THREADS];
+} ParallelResult;
+
+// one thread of a test of shared scans
+typedef struct SharedScanThread {
+  RM_TableData *table;
+  Schema *schema;
+  int c;
+  int found;
+  RC rc;
+} SharedScanThread;
+
 // helper methods
 Record *testRecord(Schema *schema, int a, char *b, int c);
 Schema *testSchema (void);
 Record *fromTestRecord (Schema *schema, TestRecord in);
+static void countParallel(int thread, Record *record, void *context);
+static void *sharedScanThread(void *arg);
+static int countJoin(RM_TableData *build, int buildAttr, RM_TableData *probe, int probeAttr, size_t memory,
+		int *partitions, long *checksum);
+static int countSorted(RM_TableData *rel, int *attrList, bool *descending, int numAttrs, size_t memory,
+		int *runs, long *checksum);
+static int countMergeJoin(RM_TableData *left, int leftAttr, RM_TableData *right, int rightAttr, size_t memory,
+		long *checksum);
 
 char *testName;
 
@@ -72,6 +132,27 @@ int main(int argc, char const *argv[]) {
 	testCreateAndReloadTombstoneList();
 	testInsertIntoTombstoneList();
 	testPrimaryKeyCheck();
+	testBulkLoad();
+	testBatchedOperations();
+	testDeletedRecordsKept();
+	testTypedAttrAccessors();
+	testScanArena();
+	testProjectedScan();
+	testParallelScan();
+	testScanPageReads();
+	testCompositeKeyIndex();
+	testGetRecordByKey();
+	testSharedScan();
+	testTableStats();
+	testZoneMap();
+	testHashJoin();
+	testExternalSort();
+	testMergeJoin();
+	testAggregate();
+	testTopK();
+	testPaxLayout();
+	testCompressedLayout();
+	testCompressedPageFile();
 	return 0;
 }
 
@@ -370,6 +451,2452 @@ void testPrimaryKeyCheck(void) {
 	}
 }
 
+void testBulkLoad(void) {
+	testName = "test bulk loading records across pages and inserting after it";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	TestRecord inserts[] = {
+		{1, "aaaa", 3},
+		{2, "bbbb", 2},
+		{3, "cccc", 1},
+		{4, "dddd", 3},
+		{5, "eeee", 5},
+		{6, "ffff", 1},
+		{7, "gggg", 3},
+		{8, "hhhh", 3},
+		{9, "iiii", 2},
+		{10, "jjjj", 5},
+	};
+	int numFirst = 10, numRecords = 5000, i;
+	TestRecord realInserts[5000];
+	Record **records;
+	Record *r;
+	Schema *schema;
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_b",schema));
+	TEST_CHECK(openTable(table, "test_table_b"));
+
+	for(i = 0; i < numRecords; i++)
+		{
+			realInserts[i] = inserts[i%10];
+			realInserts[i].a = i;
+			records[i] = fromTestRecord(schema, realInserts[i]);
+		}
+
+	// load a few records first so the second load continues a partial page.
+	TEST_CHECK(bulkLoad(table, records, numFirst));
+	TEST_CHECK(bulkLoad(table, records + numFirst, numRecords - numFirst));
+	ASSERT_EQUALS_INT(numRecords, getNumTuples(table), "all records are counted");
+	ASSERT_EQUALS_INT(1, records[0]->id.page, "first record on first data page");
+	ASSERT_EQUALS_INT(numFirst, records[numFirst]->id.slot, "second load continues the page");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_b"));
+	ASSERT_EQUALS_INT(numRecords, getNumTuples(table), "record count is persisted");
+
+	createRecord(&r, schema);
+	for(i = 0; i < numRecords; i++)
+		{
+			TEST_CHECK(getRecord(table, records[i]->id, r));
+			ASSERT_EQUALS_RECORDS(records[i], r, schema, "compare records");
+		}
+
+	// a regular insert goes to the slot after the last loaded record.
+	Record *last = records[numRecords - 1];
+	r = fromTestRecord(schema, inserts[0]);
+	TEST_CHECK(insertRecord(table, r));
+	ASSERT_TRUE(r->id.page > last->id.page || r->id.slot == last->id.slot + 1, "insert after bulk load");
+	ASSERT_EQUALS_INT(numRecords + 1, getNumTuples(table), "insert after bulk load is counted");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_b"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+void testBatchedOperations(void) {
+	testName = "test inserting, deleting and updating batches of records";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 1000, numDeletes = 100, numUpdates = 200, i;
+	Record **records, **newRecords, **updates;
+	RID *deletes;
+	Record *r;
+	Schema *schema;
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	newRecords = (Record **) malloc(sizeof(Record *) * numDeletes);
+	updates = (Record **) malloc(sizeof(Record *) * numUpdates);
+	deletes = (RID *) malloc(sizeof(RID) * numDeletes);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_m",schema));
+	TEST_CHECK(openTable(table, "test_table_m"));
+
+	// insert a batch spanning several pages.
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 10);
+	TEST_CHECK(insertRecords(table, records, numRecords));
+	ASSERT_EQUALS_INT(numRecords, getNumTuples(table), "batch insert is counted");
+	ASSERT_TRUE(records[numRecords - 1]->id.page > 1, "batch spans several pages");
+
+	// delete every tenth record.
+	for(i = 0; i < numDeletes; i++)
+		deletes[i] = records[i * 10]->id;
+	TEST_CHECK(deleteRecords(table, deletes, numDeletes));
+	ASSERT_EQUALS_INT(numRecords - numDeletes, getNumTuples(table), "batch delete is counted");
+	for(i = 0; i < numDeletes; i++)
+		ASSERT_EQUALS_INT(RC_TUPLE_NOT_FOUND, getRecord(table, deletes[i], records[0]), "record has been deleted");
+
+	// a new batch reuses the deleted slots.
+	for(i = 0; i < numDeletes; i++)
+		newRecords[i] = testRecord(schema, numRecords + i, "bbbb", 7);
+	TEST_CHECK(insertRecords(table, newRecords, numDeletes));
+	ASSERT_EQUALS_INT(numRecords, getNumTuples(table), "deleted slots are reused");
+	for(i = 0; i < numDeletes; i++)
+		ASSERT_EQUALS_INT(deletes[numDeletes - 1 - i].slot, newRecords[i]->id.slot, "record placed in a deleted slot");
+
+	// update records spread over all pages.
+	for(i = 0; i < numUpdates; i++)
+		{
+			updates[i] = testRecord(schema, i * 5 + 1, "cccc", 9);
+			updates[i]->id = records[i * 5 + 1]->id;
+		}
+	TEST_CHECK(updateRecords(table, updates, numUpdates));
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_m"));
+
+	createRecord(&r, schema);
+	for(i = 0; i < numUpdates; i++)
+		{
+			TEST_CHECK(getRecord(table, updates[i]->id, r));
+			ASSERT_EQUALS_RECORDS(updates[i], r, schema, "compare updated records");
+		}
+	for(i = 0; i < numDeletes; i++)
+		{
+			TEST_CHECK(getRecord(table, newRecords[i]->id, r));
+			ASSERT_EQUALS_RECORDS(newRecords[i], r, schema, "compare reinserted records");
+		}
+	TEST_CHECK(getRecord(table, records[numRecords - 1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[numRecords - 1], r, schema, "compare untouched record");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_m"));
+	TEST_CHECK(shutdownRecordManager());
+
+	free(records);
+	free(newRecords);
+	free(updates);
+	free(deletes);
+	free(table);
+	TEST_DONE();
+}
+
+void testDeletedRecordsKept(void) {
+	testName = "test a tombstone list longer than page 0";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 5000, numDeletes = 2000, numFound, i;
+	Record **records, *r;
+	RID *deletes, again[2];
+	Schema *schema;
+	RM_ScanHandle sc;
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	deletes = (RID *) malloc(sizeof(RID) * numDeletes);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_m",schema));
+	TEST_CHECK(openTable(table, "test_table_m"));
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 10);
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+
+	for(i = 0; i < numDeletes; i++)
+		deletes[i] = records[i * 2]->id;
+	TEST_CHECK(deleteRecords(table, deletes, numDeletes));
+
+	// ids deleted already or twice in a batch delete nothing.
+	again[0] = records[1]->id;
+	again[1] = records[0]->id;
+	ASSERT_EQUALS_INT(RC_TUPLE_NOT_FOUND, deleteRecords(table, again, 2), "a deleted record in a batch");
+	again[1] = records[1]->id;
+	ASSERT_EQUALS_INT(RC_TUPLE_NOT_FOUND, deleteRecords(table, again, 2), "a record twice in a batch");
+	ASSERT_EQUALS_INT(RC_TUPLE_NOT_FOUND, deleteRecord(table, records[2]->id), "a deleted record");
+	ASSERT_EQUALS_INT(numRecords - numDeletes, getNumTuples(table), "refused deletes are not counted");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_m"));
+
+	// the deleted records do not come back.
+	createRecord(&r, schema);
+	TEST_CHECK(startScan(table, &sc, NULL));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++)
+		;
+	TEST_CHECK(closeScan(&sc));
+	ASSERT_EQUALS_INT(numRecords - numDeletes, getNumTuples(table), "records after opening the table");
+	ASSERT_EQUALS_INT(getNumTuples(table), numFound, "a scan after opening the table");
+	ASSERT_EQUALS_INT(RC_TUPLE_NOT_FOUND, getRecord(table, deletes[numDeletes - 1], r), "the last deleted record");
+	TEST_CHECK(getRecord(table, records[numRecords - 1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[numRecords - 1], r, schema, "compare untouched record");
+
+	// records reuse the deleted slots and the list gets short again.
+	TEST_CHECK(insertRecords(table, records + 1, numDeletes - 10));
+	TEST_CHECK(getRecord(table, records[1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[1], r, schema, "compare record in a reused slot");
+	TEST_CHECK(deleteRecord(table, records[1]->id));
+	TEST_CHECK(closeTable(table));
+	ASSERT_TRUE(access("test_table_m.tombstone", F_OK) != 0, "a short list fits into page 0");
+	TEST_CHECK(openTable(table, "test_table_m"));
+	ASSERT_EQUALS_INT(numRecords - 11, getNumTuples(table), "records after reusing the slots");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_m"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(r);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeSchema(schema);
+	free(records);
+	free(deletes);
+	free(table);
+	TEST_DONE();
+}
+
+void testTypedAttrAccessors(void) {
+	testName = "test reading attributes without allocating";
+	Schema *schema = testSchema();
+	Record *r = testRecord(schema, 7, "abcd", 42);
+	Value value;
+	Value *result;
+	Expr *sel, *left, *right;
+	char *s;
+	int i;
+	float f;
+
+	TEST_CHECK(getIntAttr(r, schema, 0, &i));
+	ASSERT_EQUALS_INT(7, i, "int attribute");
+	TEST_CHECK(getIntAttr(r, schema, 2, &i));
+	ASSERT_EQUALS_INT(42, i, "second int attribute");
+	TEST_CHECK(getStringAttrRef(r, schema, 1, &s));
+	ASSERT_EQUALS_STRING("abcd", s, "string attribute is a terminated reference");
+	ASSERT_TRUE(s == r->data + schema->attrOffsets[1], "string attribute points into the record");
+	ASSERT_TRUE(getFloatAttr(r, schema, 0, &f) == RC_RM_ATTR_WRONG_DATATYPE, "wrong datatype is rejected");
+	ASSERT_TRUE(getStringAttrRef(r, schema, 0, &s) == RC_RM_ATTR_WRONG_DATATYPE, "wrong datatype is rejected");
+
+	TEST_CHECK(getAttrInto(r, schema, 1, &value));
+	ASSERT_TRUE(value.dt == DT_STRING, "value datatype");
+	ASSERT_EQUALS_STRING("abcd", value.v.stringV, "value into caller storage");
+
+	// evaluating into caller storage and through evalExpr agree.
+	MAKE_CONS(left, stringToValue("sabcd"));
+	MAKE_ATTRREF(right, 1);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(evalExprInto(r, schema, sel, &value));
+	ASSERT_TRUE(value.dt == DT_BOOL && value.v.boolV, "evalExprInto matches string attribute");
+	TEST_CHECK(evalExpr(r, schema, sel, &result));
+	ASSERT_TRUE(result->dt == DT_BOOL && result->v.boolV, "evalExpr matches string attribute");
+	freeVal(result);
+
+	freeExpr(sel);
+	freeRecord(r);
+	freeSchema(schema);
+	TEST_DONE();
+}
+
+void testScanArena(void) {
+	testName = "test scans with records and values from the scan arena";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 500, numFound = 0, i, rc;
+	Record **records;
+	Record *r;
+	Value **found;
+	Schema *schema;
+	RM_ScanHandle sc;
+	Expr *sel, *left, *right;
+	Arena *arena;
+	char *first;
+
+	// blocks are reused after a reset, bigger allocations get their own block.
+	arena = createArena(64);
+	first = (char *) arenaAlloc(arena, 40);
+	ASSERT_TRUE(arenaAlloc(arena, 1000) != NULL, "allocation bigger than a block");
+	ASSERT_TRUE(arenaAlloc(arena, 40) != NULL, "allocation after a big one");
+	resetArena(arena);
+	ASSERT_TRUE(arenaAlloc(arena, 40) == first, "reset reuses the first block");
+	ASSERT_EQUALS_STRING("abc", arenaStrdup(arena, "abc"), "string copied into the arena");
+	freeArena(arena);
+
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	found = (Value **) malloc(sizeof(Value *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, (i % 2) ? "odd" : "even", i % 5);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_n",schema));
+	TEST_CHECK(openTable(table, "test_table_n"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+
+	MAKE_CONS(left, stringToValue("i2"));
+	MAKE_ATTRREF(right, 2);
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+
+	// the record and the collected values all live in the scan arena.
+	TEST_CHECK(startScan(table, &sc, sel));
+	TEST_CHECK(createRecordInArena(&r, schema, getScanArena(&sc)));
+	while((rc = next(&sc, r)) == RC_OK)
+		TEST_CHECK(getAttrInArena(r, schema, 1, &found[numFound++], getScanArena(&sc)));
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last page");
+	ASSERT_EQUALS_INT(numRecords / 5, numFound, "every page is scanned");
+	for(i = 0; i < numFound; i++)
+		ASSERT_EQUALS_STRING(((5 * i + 2) % 2) ? "odd" : "even", found[i]->v.stringV, "values stay valid until closeScan");
+	TEST_CHECK(closeScan(&sc));
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_n"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeExpr(sel);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeSchema(schema);
+	free(records);
+	free(found);
+	free(table);
+	TEST_DONE();
+}
+
+void testProjectedScan(void) {
+	testName = "test scans returning some attributes";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 500, numFound = 0, i, rc, c;
+	int attrs[] = {2, 1};
+	int key[] = {0};
+	int wrong[] = {3};
+	Record **records;
+	Record r;
+	Schema *schema, *projection;
+	RM_ScanHandle sc;
+	Expr *sel, *left, *right;
+	char *b;
+
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, (i % 2) ? "odd" : "even", i % 5);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_o",schema));
+	TEST_CHECK(openTable(table, "test_table_o"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+
+	// a < 10 returning c and b, the condition reads an attribute that is not returned
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i10"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+
+	TEST_CHECK(startScanProjected(table, &sc, sel, attrs, 2));
+	projection = getScanSchema(&sc);
+	ASSERT_EQUALS_INT(2, projection->numAttr, "two attributes are returned");
+	ASSERT_EQUALS_INT(DT_INT, projection->dataTypes[0], "c comes first");
+	ASSERT_EQUALS_STRING("b", projection->attrNames[1], "b comes second");
+	ASSERT_EQUALS_INT(0, projection->keySize, "the key a is not returned");
+	ASSERT_TRUE(getRecordSize(projection) < getRecordSize(schema), "returned records are narrower");
+
+	r.data = NULL;
+	while((rc = next(&sc, &r)) == RC_OK)
+		{
+			TEST_CHECK(getIntAttr(&r, projection, 0, &c));
+			TEST_CHECK(getStringAttrRef(&r, projection, 1, &b));
+			ASSERT_EQUALS_INT(numFound % 5, c, "c of the projected record");
+			ASSERT_EQUALS_STRING((numFound % 2) ? "odd" : "even", b, "b of the projected record");
+			numFound++;
+		}
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last page");
+	ASSERT_EQUALS_INT(10, numFound, "all matching records are returned");
+	TEST_CHECK(closeScan(&sc));
+
+	// a projection with the key keeps it, attributes have to exist
+	TEST_CHECK(startScanProjected(table, &sc, NULL, key, 1));
+	ASSERT_EQUALS_INT(1, getScanSchema(&sc)->keySize, "the key a is returned");
+	TEST_CHECK(closeScan(&sc));
+	ASSERT_EQUALS_INT(RC_RM_NO_SUCH_ATTR, startScanProjected(table, &sc, NULL, wrong, 1), "attribute 3 does not exist");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_o"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeExpr(sel);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeSchema(schema);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+void testParallelScan(void) {
+	testName = "test scans split across threads";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 20000, numDeleted = 10, expected = 0, found, i, t;
+	long expectedSum = 0, sum;
+	Record **records;
+	Schema *schema;
+	ParallelResult result;
+	Expr *sel, *left, *right, *low, *high;
+
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 5);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_p",schema));
+	TEST_CHECK(openTable(table, "test_table_p"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	for(i = 0; i < numDeleted; i++)
+		TEST_CHECK(deleteRecord(table, records[i]->id));
+
+	// c < 2 over the pages of several morsels, deleted records are skipped
+	MAKE_ATTRREF(left, 2);
+	MAKE_CONS(right, stringToValue("i2"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	for(i = numDeleted; i < numRecords; i++)
+		if (i % 5 < 2)
+			{
+				expected++;
+				expectedSum += i;
+			}
+
+	memset(&result, 0, sizeof(ParallelResult));
+	result.schema = schema;
+	TEST_CHECK(startParallelScan(table, sel, TEST_SCAN_THREADS, countParallel, &result));
+	for(t = 0, found = 0, sum = 0; t < TEST_SCAN_THREADS; t++)
+		{
+			found += result.found[t];
+			sum += result.sum[t];
+		}
+	ASSERT_EQUALS_INT(expected, found, "every matching record is passed once");
+	ASSERT_TRUE(sum == expectedSum, "the matching records are passed");
+	freeExpr(sel);
+
+	// no condition on one thread
+	memset(&result, 0, sizeof(ParallelResult));
+	result.schema = schema;
+	TEST_CHECK(startParallelScan(table, NULL, 1, countParallel, &result));
+	ASSERT_EQUALS_INT(numRecords - numDeleted, result.found[0], "one thread passes every record");
+
+	// a < 3 AND a > 5 matches nothing
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i3"));
+	MAKE_BINOP_EXPR(low, left, right, OP_COMP_SMALLER);
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i5"));
+	MAKE_BINOP_EXPR(high, left, right, OP_COMP_GREATER);
+	MAKE_BINOP_EXPR(sel, low, high, OP_BOOL_AND);
+	memset(&result, 0, sizeof(ParallelResult));
+	result.schema = schema;
+	TEST_CHECK(startParallelScan(table, sel, TEST_SCAN_THREADS, countParallel, &result));
+	for(t = 0, found = 0; t < TEST_SCAN_THREADS; t++)
+		found += result.found[t];
+	ASSERT_EQUALS_INT(0, found, "an empty range passes no record");
+	freeExpr(sel);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_p"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeSchema(schema);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+void testScanPageReads(void) {
+	testName = "test scans reading every page once";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 100000, numFound, numPages, i, rc, a;
+	Record **records;
+	Record *r;
+	Schema *schema;
+	RM_ScanHandle sc;
+	Expr *sel, *left, *right;
+
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 10);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_q",schema));
+	TEST_CHECK(openTable(table, "test_table_q"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	numPages = ((Table_Header *)table->mgmtData)->pageCount;
+	ASSERT_TRUE(numPages > 300, "the table spans hundreds of pages");
+
+	// every record in order, the page of a record is read once for all its slots
+	TEST_CHECK(createRecord(&r, schema));
+	TEST_CHECK(startScan(table, &sc, NULL));
+	for(numFound = 0; (rc = next(&sc, r)) == RC_OK; numFound++)
+		{
+			TEST_CHECK(getIntAttr(r, schema, 0, &a));
+			if (a != numFound)
+				break;
+		}
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, rc, "scan ends after the last page");
+	ASSERT_EQUALS_INT(numRecords, numFound, "every record is returned in order");
+	ASSERT_EQUALS_INT(numPages, getScanPageReads(&sc), "every page is read once");
+	TEST_CHECK(closeScan(&sc));
+
+	// a condition matching a tenth of the records reads the same pages
+	MAKE_ATTRREF(left, 2);
+	MAKE_CONS(right, stringToValue("i1"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startScan(table, &sc, sel));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++);
+	ASSERT_EQUALS_INT(numRecords / 10, numFound, "every matching record is returned");
+	ASSERT_EQUALS_INT(numPages, getScanPageReads(&sc), "every page is read once with a condition");
+	TEST_CHECK(closeScan(&sc));
+	freeExpr(sel);
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_q"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeSchema(schema);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+void testCompositeKeyIndex(void) {
+	testName = "test primary key checks on a composite key through the key index";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	Record *records[2], *updates[2];
+	Record *r;
+	Schema *schema;
+	Config *con = (Config *)malloc(sizeof(Config));
+	RID first, second;
+	int a, rc, i;
+
+	// key on (a, b)
+	schema = testSchema();
+	schema->keyAttrs = (int *) realloc(schema->keyAttrs, sizeof(int) * 2);
+	schema->keyAttrs[1] = 1;
+	schema->keySize = 2;
+
+	con->primaryKeyCheck = true;
+	TEST_CHECK(initRecordManager(con));
+	TEST_CHECK(createTable("test_table_k",schema));
+	TEST_CHECK(openTable(table, "test_table_k"));
+	ASSERT_EQUALS_INT(2, table->schema->keySize, "the composite key is stored with the table");
+
+	// only the whole key has to be unique
+	r = testRecord(schema, 1, "aaaa", 1);
+	TEST_CHECK(insertRecord(table, r));
+	first = r->id;
+	freeRecord(r);
+	r = testRecord(schema, 1, "bbbb", 2);
+	TEST_CHECK(insertRecord(table, r));
+	second = r->id;
+	freeRecord(r);
+	r = testRecord(schema, 2, "aaaa", 3);
+	TEST_CHECK(insertRecord(table, r));
+	freeRecord(r);
+	r = testRecord(schema, 1, "aaaa", 4);
+	rc = insertRecord(table, r);
+	ASSERT_EQUALS_INT(RC_DUPLICATED_PRIMARYKEY, rc, "duplicated composite key is detected");
+	freeRecord(r);
+
+	// a deleted key can be inserted again
+	TEST_CHECK(deleteRecord(table, first));
+	r = testRecord(schema, 1, "aaaa", 5);
+	TEST_CHECK(insertRecord(table, r));
+	first = r->id;
+	freeRecord(r);
+
+	// an update may not take the key of another record, but may keep its own
+	r = testRecord(schema, 1, "aaaa", 6);
+	r->id = second;
+	rc = updateRecord(table, r);
+	ASSERT_EQUALS_INT(RC_DUPLICATED_PRIMARYKEY, rc, "update to a duplicated key is detected");
+	freeRecord(r);
+	r = testRecord(schema, 3, "cccc", 7);
+	r->id = second;
+	TEST_CHECK(updateRecord(table, r));
+	freeRecord(r);
+	r = testRecord(schema, 3, "cccc", 8);
+	r->id = second;
+	TEST_CHECK(updateRecord(table, r));
+	freeRecord(r);
+	r = testRecord(schema, 1, "bbbb", 9);
+	TEST_CHECK(insertRecord(table, r));
+	freeRecord(r);
+
+	// the index is rebuilt when the table is opened again
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_k"));
+	r = testRecord(schema, 3, "cccc", 10);
+	rc = insertRecord(table, r);
+	ASSERT_EQUALS_INT(RC_DUPLICATED_PRIMARYKEY, rc, "keys are found after reopening");
+	freeRecord(r);
+
+	// batches are checked against the table and against themselves
+	records[0] = testRecord(schema, 5, "eeee", 11);
+	records[1] = testRecord(schema, 5, "eeee", 12);
+	rc = insertRecords(table, records, 2);
+	ASSERT_EQUALS_INT(RC_DUPLICATED_PRIMARYKEY, rc, "duplicated key within a batch is detected");
+	freeRecord(records[1]);
+	records[1] = testRecord(schema, 6, "ffff", 13);
+	TEST_CHECK(insertRecords(table, records, 2));
+
+	// records of a batch may swap their keys
+	updates[0] = testRecord(schema, 6, "ffff", 14);
+	updates[0]->id = records[0]->id;
+	updates[1] = testRecord(schema, 5, "eeee", 15);
+	updates[1]->id = records[1]->id;
+	TEST_CHECK(updateRecords(table, updates, 2));
+
+	// a batch with a duplicated key changes nothing
+	TEST_CHECK(setAttr(updates[0], schema, 2, stringToValue("i16")));
+	freeRecord(updates[1]);
+	updates[1] = testRecord(schema, 2, "aaaa", 17);
+	updates[1]->id = first;
+	rc = updateRecords(table, updates, 2);
+	ASSERT_EQUALS_INT(RC_DUPLICATED_PRIMARYKEY, rc, "batched update to a duplicated key is detected");
+	TEST_CHECK(createRecord(&r, schema));
+	TEST_CHECK(getRecord(table, records[0]->id, r));
+	TEST_CHECK(getIntAttr(r, schema, 2, &a));
+	ASSERT_EQUALS_INT(14, a, "a refused batch leaves its records unchanged");
+	freeRecord(r);
+	r = testRecord(schema, 6, "ffff", 18);
+	rc = insertRecord(table, r);
+	ASSERT_EQUALS_INT(RC_DUPLICATED_PRIMARYKEY, rc, "a refused batch leaves the keys unchanged");
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_k"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < 2; i++)
+		{
+			freeRecord(records[i]);
+			freeRecord(updates[i]);
+		}
+	freeSchema(schema);
+	free(con);
+	free(table);
+	TEST_DONE();
+}
+
+void testGetRecordByKey(void) {
+	testName = "test getting records by their primary key";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	Record *r, *found;
+	Schema *schema;
+	Config *con = (Config *)malloc(sizeof(Config));
+	Value key[2];
+	RID id, deleted;
+	int a, c, rc, i;
+
+	schema = testSchema();
+	con->primaryKeyCheck = false;
+	TEST_CHECK(initRecordManager(con));
+	TEST_CHECK(createTable("test_table_l_whose_long_name_makes_the_table_information_longer",schema));
+	TEST_CHECK(openTable(table, "test_table_l_whose_long_name_makes_the_table_information_longer"));
+	for(i = 0; i < 1000; i++)
+		{
+			r = testRecord(schema, i, "aaaa", i * 2);
+			TEST_CHECK(insertRecord(table, r));
+			freeRecord(r);
+		}
+	TEST_CHECK(createRecord(&found, schema));
+
+	// without an index the table is scanned
+	key[0].dt = DT_INT;
+	key[0].v.intV = 700;
+	TEST_CHECK(getRecordByKey(table, key, found));
+	TEST_CHECK(getIntAttr(found, schema, 2, &c));
+	ASSERT_EQUALS_INT(1400, c, "a key is found by a scan");
+	key[0].v.intV = 1000;
+	rc = getRecordByKey(table, key, found);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "a missing key is not found by a scan");
+	key[0].dt = DT_FLOAT;
+	rc = getRecordByKey(table, key, found);
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, rc, "the key has the type of the key attribute");
+	key[0].dt = DT_INT;
+
+	// the hash index finds every key
+	TEST_CHECK(createKeyHash(table));
+	for(i = 0, rc = RC_OK; i < 1000 && rc == RC_OK; i++)
+		{
+			key[0].v.intV = i;
+			rc = getRecordByKey(table, key, found);
+			if (rc == RC_OK && (getIntAttr(found, schema, 0, &a), a != i))
+				rc = RC_IM_KEY_NOT_FOUND;
+		}
+	ASSERT_EQUALS_INT(RC_OK, rc, "every key is found through the hash index");
+
+	// inserts, updates and deletes keep the hash index up to date
+	r = testRecord(schema, 2000, "bbbb", 1);
+	TEST_CHECK(insertRecord(table, r));
+	id = r->id;
+	TEST_CHECK(setAttr(r, schema, 0, stringToValue("i3000")));
+	TEST_CHECK(updateRecord(table, r));
+	freeRecord(r);
+	key[0].v.intV = 2000;
+	rc = getRecordByKey(table, key, found);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "an updated key is gone");
+	key[0].v.intV = 3000;
+	TEST_CHECK(getRecordByKey(table, key, found));
+	ASSERT_TRUE(found->id.page == id.page && found->id.slot == id.slot, "the new key is found");
+	key[0].v.intV = 5;
+	TEST_CHECK(getRecordByKey(table, key, found));
+	deleted = found->id;
+	TEST_CHECK(deleteRecord(table, deleted));
+	rc = getRecordByKey(table, key, found);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "a deleted key is gone");
+
+	// the index is opened with the table and deleted with it, the deleted
+	// record stays deleted behind the longer table information
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_l_whose_long_name_makes_the_table_information_longer"));
+	rc = getRecord(table, deleted, found);
+	ASSERT_EQUALS_INT(RC_TUPLE_NOT_FOUND, rc, "the tombstone list is kept after reopening");
+	key[0].v.intV = 3000;
+	TEST_CHECK(getRecordByKey(table, key, found));
+	ASSERT_TRUE(found->id.page == id.page && found->id.slot == id.slot, "keys are found after reopening");
+	key[0].v.intV = 999;
+	TEST_CHECK(getRecordByKey(table, key, found));
+	TEST_CHECK(getIntAttr(found, schema, 2, &c));
+	ASSERT_EQUALS_INT(1998, c, "the record of the key is read");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_l_whose_long_name_makes_the_table_information_longer"));
+	ASSERT_TRUE(access("test_table_l_whose_long_name_makes_the_table_information_longer.hash", F_OK) != 0, "the index file is deleted with the table");
+	freeSchema(schema);
+
+	// a composite key is found by a scan and through the key index, but has
+	// no hash index
+	schema = testSchema();
+	schema->keyAttrs = (int *) realloc(schema->keyAttrs, sizeof(int) * 2);
+	schema->keyAttrs[1] = 1;
+	schema->keySize = 2;
+	TEST_CHECK(createTable("test_table_m",schema));
+	TEST_CHECK(openTable(table, "test_table_m"));
+	r = testRecord(schema, 1, "aaaa", 1);
+	TEST_CHECK(insertRecord(table, r));
+	freeRecord(r);
+	r = testRecord(schema, 1, "bbbb", 2);
+	TEST_CHECK(insertRecord(table, r));
+	freeRecord(r);
+	key[0].v.intV = 1;
+	key[1].dt = DT_STRING;
+	key[1].v.stringV = "bbbbbb";
+	TEST_CHECK(getRecordByKey(table, key, found));
+	TEST_CHECK(getIntAttr(found, schema, 2, &c));
+	ASSERT_EQUALS_INT(2, c, "a composite key is found by a scan, strings are cut like stored keys");
+	rc = createKeyHash(table);
+	ASSERT_EQUALS_INT(RC_IM_COMPOSITE_KEY, rc, "a hash index needs a key of one attribute");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(shutdownRecordManager());
+
+	con->primaryKeyCheck = true;
+	TEST_CHECK(initRecordManager(con));
+	TEST_CHECK(openTable(table, "test_table_m"));
+	key[1].v.stringV = "aaaa";
+	TEST_CHECK(getRecordByKey(table, key, found));
+	TEST_CHECK(getIntAttr(found, schema, 2, &c));
+	ASSERT_EQUALS_INT(1, c, "a composite key is found through the key index");
+	key[0].v.intV = 2;
+	rc = getRecordByKey(table, key, found);
+	ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "a missing composite key is not found");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_m"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeRecord(found);
+	freeSchema(schema);
+	free(con);
+	free(table);
+	TEST_DONE();
+}
+
+void testSharedScan(void) {
+	testName = "test scans sharing one pass over a table";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 100000, numPages, joinPage = 0, numA, numB, wrong, reads, i, t, a, c;
+	Record **records;
+	Record *r;
+	Schema *schema;
+	RM_ScanHandle scanA, scanB;
+	RC rcA, rcB;
+	Expr *sel, *left, *right;
+	char *seen;
+	SharedScanThread threads[TEST_SCAN_THREADS];
+	pthread_t ids[TEST_SCAN_THREADS];
+
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 10);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_s",schema));
+	TEST_CHECK(openTable(table, "test_table_s"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	numPages = ((Table_Header *)table->mgmtData)->pageCount;
+
+	// B joins A halfway, both return their records once, B wraps around to
+	// the pages it missed
+	TEST_CHECK(createRecord(&r, schema));
+	seen = (char *) calloc(numRecords, 1);
+	TEST_CHECK(startSharedScan(table, &scanA, NULL));
+	for(numA = 0; numA < numRecords / 2 && next(&scanA, r) == RC_OK; numA++)
+		seen[numA] = 1;
+
+	MAKE_ATTRREF(left, 2);
+	MAKE_CONS(right, stringToValue("i1"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startSharedScan(table, &scanB, sel));
+	// B matches a tenth of the records and takes one for ten of A, so both
+	// go through the pages at the same pace
+	for(numB = 0, wrong = 0, rcA = rcB = RC_OK; rcA == RC_OK || rcB == RC_OK; )
+		{
+			if (rcA == RC_OK && (rcA = next(&scanA, r)) == RC_OK)
+				{
+					TEST_CHECK(getIntAttr(r, schema, 0, &a));
+					seen[a]++;
+					numA++;
+				}
+			if (rcB == RC_OK && (rcA != RC_OK || numA % 10 == 0) && (rcB = next(&scanB, r)) == RC_OK)
+				{
+					TEST_CHECK(getIntAttr(r, schema, 2, &c));
+					wrong += (c != 0);
+					if (numB++ == 0)
+						joinPage = r->id.page;
+				}
+		}
+	for(i = 0; i < numRecords && seen[i] == 1; i++);
+	ASSERT_EQUALS_INT(numRecords, numA, "A returns every record");
+	ASSERT_EQUALS_INT(numRecords, i, "A returns every record once");
+	ASSERT_EQUALS_INT(numRecords / 10, numB, "B returns every match once");
+	ASSERT_EQUALS_INT(0, wrong, "B returns only its own matches");
+	ASSERT_TRUE(joinPage > 1, "B joins at the page A has reached");
+	reads = getScanPageReads(&scanA) + getScanPageReads(&scanB);
+	ASSERT_TRUE(reads >= numPages && reads <= numPages + joinPage - 1,
+			"the pages from the join on are read once by both scans");
+	ASSERT_TRUE(getScanPageReads(&scanB) < numPages, "B reads fewer pages than a scan of its own");
+	TEST_CHECK(closeScan(&scanA));
+	TEST_CHECK(closeScan(&scanB));
+	freeExpr(sel);
+
+	// once every shared scan is closed the next one starts at the first page
+	TEST_CHECK(startSharedScan(table, &scanA, NULL));
+	TEST_CHECK(next(&scanA, r));
+	TEST_CHECK(getIntAttr(r, schema, 0, &a));
+	ASSERT_EQUALS_INT(0, a, "a new pass starts at the first record");
+	TEST_CHECK(closeScan(&scanA));
+
+	// threads with conditions of their own
+	for(t = 0; t < TEST_SCAN_THREADS; t++)
+		{
+			threads[t].table = table;
+			threads[t].schema = schema;
+			threads[t].c = t + 1;
+			threads[t].found = 0;
+			threads[t].rc = RC_OK;
+			ASSERT_TRUE(pthread_create(&ids[t], NULL, sharedScanThread, &threads[t]) == 0, "thread started");
+		}
+	for(t = 0; t < TEST_SCAN_THREADS; t++)
+		{
+			pthread_join(ids[t], NULL);
+			ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, threads[t].rc, "the thread scans to the end");
+			ASSERT_EQUALS_INT(numRecords / 10 * (t + 1), threads[t].found, "the thread returns its matches");
+		}
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_s"));
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeRecord(r);
+	freeSchema(schema);
+	free(seen);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+void testTableStats(void) {
+	testName = "test statistics of analyzeTable";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 100000, numDeleted = 100, numPages, i, rc;
+	char b[5];
+	Record **records;
+	Schema *schema;
+	TableStats *stats;
+	Value value;
+	double fraction, bound;
+
+	// a is unique, b takes 1000 values and c 10
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		{
+			sprintf(b, "%04d", i % 1000);
+			records[i] = testRecord(schema, i, b, i % 10);
+		}
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_t",schema));
+	TEST_CHECK(openTable(table, "test_table_t"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	for(i = 0; i < numDeleted; i++)
+		TEST_CHECK(deleteRecord(table, records[i]->id));
+	numPages = ((Table_Header *)table->mgmtData)->pageCount;
+
+	ASSERT_TRUE(getTableStats(table) == NULL, "no statistics before the table is analyzed");
+	value.dt = DT_INT;
+	value.v.intV = 5;
+	rc = estimateSelectivity(table, 2, OP_COMP_SMALLER, &value, &fraction);
+	ASSERT_EQUALS_INT(RC_RM_NO_STATS, rc, "no estimate before the table is analyzed");
+
+	// every page
+	TEST_CHECK(analyzeTable(table, 1.0));
+	stats = getTableStats(table);
+	ASSERT_EQUALS_INT(numRecords - numDeleted, stats->numTuples, "the records are counted");
+	ASSERT_EQUALS_INT(numPages, stats->sampledPages, "every page is read");
+	ASSERT_EQUALS_INT(numRecords - numDeleted, stats->sampledTuples, "deleted records are skipped");
+	ASSERT_TRUE(stats->attrs[0].distinct > 0.95 * numRecords && stats->attrs[0].distinct < 1.05 * numRecords,
+			"distinct values of a unique attribute");
+	ASSERT_TRUE(stats->attrs[1].distinct > 950 && stats->attrs[1].distinct < 1050, "distinct strings");
+	ASSERT_TRUE(stats->attrs[2].distinct > 9.5 && stats->attrs[2].distinct < 10.5, "few distinct values");
+	ASSERT_EQUALS_INT(numDeleted, stats->attrs[0].bounds[0].v.intV, "the first bound is the smallest value");
+	ASSERT_EQUALS_INT(numRecords - 1, stats->attrs[0].bounds[stats->attrs[0].numBounds - 1].v.intV,
+			"the last bound is the largest value");
+	ASSERT_TRUE(strcmp(stats->attrs[1].bounds[0].v.stringV, "0000") == 0, "string bounds");
+
+	TEST_CHECK(estimateSelectivity(table, 2, OP_COMP_SMALLER, &value, &fraction));
+	ASSERT_TRUE(fraction > 0.45 && fraction < 0.55, "c < 5 holds for half of the records");
+	TEST_CHECK(estimateSelectivity(table, 2, OP_COMP_EQUAL, &value, &fraction));
+	ASSERT_TRUE(fraction > 0.08 && fraction < 0.12, "c = 5 holds for a tenth of the records");
+	value.v.intV = numRecords / 4;
+	TEST_CHECK(estimateSelectivity(table, 0, OP_COMP_GE, &value, &fraction));
+	ASSERT_TRUE(fraction > 0.72 && fraction < 0.78, "a >= n / 4 holds for three quarters of the records");
+	value.v.intV = numRecords;
+	TEST_CHECK(estimateSelectivity(table, 0, OP_COMP_EQUAL, &value, &fraction));
+	ASSERT_TRUE(fraction == 0, "a value beyond the largest one matches nothing");
+	value.dt = DT_STRING;
+	value.v.stringV = "0500";
+	TEST_CHECK(estimateSelectivity(table, 1, OP_COMP_SMALLER, &value, &fraction));
+	ASSERT_TRUE(fraction > 0.4 && fraction < 0.6, "b < '0500' holds for half of the records");
+	rc = estimateSelectivity(table, 0, OP_COMP_SMALLER, &value, &fraction);
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, rc, "a value of another datatype");
+
+	// a tenth of the pages, the distinct values are scaled up to the table
+	TEST_CHECK(analyzeTable(table, 0.1));
+	stats = getTableStats(table);
+	ASSERT_EQUALS_INT((numPages + 9) / 10, stats->sampledPages, "a tenth of the pages is read");
+	ASSERT_TRUE(stats->attrs[0].distinct > 0.8 * numRecords && stats->attrs[0].distinct < 1.2 * numRecords,
+			"distinct values of a unique attribute from a sample");
+	ASSERT_TRUE(stats->attrs[1].distinct > 900 && stats->attrs[1].distinct < 1100, "distinct strings from a sample");
+	ASSERT_TRUE(stats->attrs[2].distinct > 9.5 && stats->attrs[2].distinct < 10.5, "few distinct values from a sample");
+
+	// the statistics are kept with the table and deleted with it
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_t"));
+	stats = getTableStats(table);
+	ASSERT_TRUE(stats != NULL && stats->sampledPages == (numPages + 9) / 10, "statistics are loaded with the table");
+	ASSERT_TRUE(strcmp(stats->attrs[1].bounds[stats->attrs[1].numBounds - 1].v.stringV, "0999") <= 0,
+			"string bounds are loaded");
+	value.dt = DT_INT;
+	value.v.intV = 5;
+	TEST_CHECK(estimateSelectivity(table, 2, OP_COMP_SMALLER, &value, &fraction));
+	ASSERT_TRUE(fraction > 0.45 && fraction < 0.55, "estimates from loaded statistics");
+
+	// a single page holds no string twice; the estimate stays within a
+	// factor sqrt(n / r) of the 1000 strings instead of growing to n
+	TEST_CHECK(analyzeTable(table, 0.001));
+	stats = getTableStats(table);
+	bound = sqrt((double) stats->numTuples / stats->sampledTuples);
+	ASSERT_EQUALS_INT(1, stats->sampledPages, "one page is read");
+	ASSERT_TRUE(stats->attrs[0].distinct == stats->numTuples, "a key has a distinct value per record");
+	ASSERT_TRUE(stats->attrs[1].distinct > 1000 / bound && stats->attrs[1].distinct < 1000 * bound,
+			"distinct strings of one page within the error bound");
+	ASSERT_TRUE(stats->attrs[2].distinct > 9.5 && stats->attrs[2].distinct < 10.5, "few distinct values of one page");
+
+	// a hundredth of the pages sees strings repeat
+	TEST_CHECK(analyzeTable(table, 0.01));
+	stats = getTableStats(table);
+	ASSERT_TRUE(stats->attrs[1].distinct > 1000 / 1.5 && stats->attrs[1].distinct < 1000 * 1.5,
+			"distinct strings of a few pages");
+	ASSERT_TRUE(stats->attrs[2].distinct > 9.5 && stats->attrs[2].distinct < 10.5, "few distinct values of a few pages");
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_t"));
+	ASSERT_TRUE(access("test_table_t.stats", F_OK) != 0, "the statistics are deleted with the table");
+	TEST_CHECK(shutdownRecordManager());
+
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeSchema(schema);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+void testZoneMap(void) {
+	testName = "test scans skipping pages by a zone map";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *other = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 100000, numFound, numPages, i, rc, t;
+	int zoneAttrs[] = {0, 2}, stringAttr[] = {1}, missingAttr[] = {3};
+	Record **records;
+	Record *r;
+	Schema *schema;
+	RM_ScanHandle sc;
+	Expr *range, *negative, *left, *right, *low, *high;
+	ParallelResult result;
+	SM_FileHandle fh;
+	char page[PAGE_SIZE];
+
+	// a grows with the insertion order, c repeats on every page
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		records[i] = testRecord(schema, i, "aaaa", i % 10);
+
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_z",schema));
+	TEST_CHECK(openTable(table, "test_table_z"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	numPages = ((Table_Header *)table->mgmtData)->pageCount;
+
+	rc = buildZoneMap(table, stringAttr, 1);
+	ASSERT_EQUALS_INT(RC_RM_ATTR_WRONG_DATATYPE, rc, "no zone map of a string attribute");
+	rc = buildZoneMap(table, missingAttr, 1);
+	ASSERT_EQUALS_INT(RC_RM_NO_SUCH_ATTR, rc, "no zone map of a missing attribute");
+	TEST_CHECK(buildZoneMap(table, zoneAttrs, 2));
+
+	// 50000 <= a <= 50999 is on a few pages
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(low, stringToValue("i50000"));
+	MAKE_CONS(high, stringToValue("i50999"));
+	MAKE_BETWEEN_EXPR(range, left, low, high);
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i0"));
+	MAKE_BINOP_EXPR(negative, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(createRecord(&r, schema));
+	TEST_CHECK(startScan(table, &sc, range));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++);
+	ASSERT_EQUALS_INT(1000, numFound, "every record in the range is returned");
+	ASSERT_TRUE(getScanPageReads(&sc) <= 1000 / ((Table_Header *)table->mgmtData)->recordsPerPage + 2,
+			"only the pages of the range are read");
+	TEST_CHECK(closeScan(&sc));
+
+	memset(&result, 0, sizeof(ParallelResult));
+	result.schema = schema;
+	TEST_CHECK(startParallelScan(table, range, TEST_SCAN_THREADS, countParallel, &result));
+	for(t = 0, numFound = 0; t < TEST_SCAN_THREADS; t++)
+		numFound += result.found[t];
+	ASSERT_EQUALS_INT(1000, numFound, "a parallel scan skips pages too");
+
+	// c < 5 is on every page
+	MAKE_ATTRREF(left, 2);
+	MAKE_CONS(right, stringToValue("i5"));
+	MAKE_BINOP_EXPR(right, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startScan(table, &sc, right));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++);
+	ASSERT_EQUALS_INT(numRecords / 2, numFound, "every record with c < 5 is returned");
+	ASSERT_EQUALS_INT(numPages, getScanPageReads(&sc), "a value of every page reads every page");
+	TEST_CHECK(closeScan(&sc));
+	freeExpr(right);
+
+	// inserts and updates widen the zones
+	TEST_CHECK(startScan(table, &sc, negative));
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, next(&sc, r), "no negative a yet");
+	ASSERT_EQUALS_INT(0, getScanPageReads(&sc), "no page can have a negative a");
+	TEST_CHECK(closeScan(&sc));
+	freeRecord(r);
+	r = testRecord(schema, -1, "bbbb", 3);
+	TEST_CHECK(insertRecord(table, r));
+	freeRecord(r);
+	r = testRecord(schema, -2, "bbbb", 3);
+	r->id = records[numRecords / 2]->id;
+	TEST_CHECK(updateRecord(table, r));
+	TEST_CHECK(startScan(table, &sc, negative));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++);
+	ASSERT_EQUALS_INT(2, numFound, "the inserted and the updated record are returned");
+	ASSERT_EQUALS_INT(2, getScanPageReads(&sc), "only their pages are read");
+	TEST_CHECK(closeScan(&sc));
+
+	// the zone map is loaded with the table, it is not used while the file
+	// may miss changes of a table open elsewhere
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_z"));
+	TEST_CHECK(startScan(table, &sc, negative));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++);
+	ASSERT_EQUALS_INT(2, numFound, "records from a loaded zone map");
+	ASSERT_EQUALS_INT(2, getScanPageReads(&sc), "pages are skipped after the table is opened again");
+	TEST_CHECK(closeScan(&sc));
+	TEST_CHECK(openPageFile("test_table_z.zones", &fh));
+	TEST_CHECK(readBlock(0, &fh, page));
+	TEST_CHECK(closePageFile(&fh));
+	ASSERT_EQUALS_INT(0, ((int *)page)[0], "the zone map file is not clean while the table is open");
+	TEST_CHECK(openTable(other, "test_table_z"));
+	ASSERT_TRUE(((Table_Header *)other->mgmtData)->zones == NULL, "a zone map that is not clean is dropped");
+	TEST_CHECK(startScan(other, &sc, negative));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++);
+	ASSERT_EQUALS_INT(2, numFound, "records without a zone map");
+	ASSERT_EQUALS_INT(numPages, getScanPageReads(&sc), "every page is read without a zone map");
+	TEST_CHECK(closeScan(&sc));
+	TEST_CHECK(closeTable(other));
+	freeRecord(r);
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_z"));
+	ASSERT_TRUE(access("test_table_z.zones", F_OK) != 0, "the zone map is deleted with the table");
+	TEST_CHECK(shutdownRecordManager());
+
+	freeExpr(range);
+	freeExpr(negative);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	freeSchema(schema);
+	free(records);
+	free(table);
+	free(other);
+	TEST_DONE();
+}
+
+void testHashJoin(void) {
+	testName = "test hash joins in memory and in partitions";
+	RM_TableData *left = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *right = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *small = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numLeft = 10000, numRight = 30000, numSmall = 50, i, rc, partitions, found;
+	long checksum, expectedSum = 0;
+	char b[5];
+	Record **records;
+	Schema *schema;
+	RM_JoinHandle join;
+	glob_t files;
+
+	// left.a is unique and left.b takes 100 values, right.a matches left.a
+	// up to 10000, small.b matches half of the values of left.b
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRight);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_jl",schema));
+	TEST_CHECK(openTable(left, "test_table_jl"));
+	for(i = 0; i < numLeft; i++)
+		{
+			sprintf(b, "%04d", i % 100);
+			records[i] = testRecord(schema, i, b, i % 10);
+		}
+	TEST_CHECK(bulkLoad(left, records, numLeft));
+	for(i = 0; i < numLeft; i++)
+		freeRecord(records[i]);
+
+	TEST_CHECK(createTable("test_table_jr",schema));
+	TEST_CHECK(openTable(right, "test_table_jr"));
+	for(i = 0; i < numRight; i++)
+		{
+			records[i] = testRecord(schema, i % 12000, "rrrr", i);
+			if (i % 12000 < numLeft)
+				expectedSum += (long) (i % 12000) * i;
+		}
+	TEST_CHECK(bulkLoad(right, records, numRight));
+	for(i = 0; i < numRight; i++)
+		freeRecord(records[i]);
+
+	TEST_CHECK(createTable("test_table_js",schema));
+	TEST_CHECK(openTable(small, "test_table_js"));
+	for(i = 0; i < numSmall; i++)
+		{
+			sprintf(b, "%04d", i * 2);
+			records[i] = testRecord(schema, i, b, i);
+		}
+	TEST_CHECK(bulkLoad(small, records, numSmall));
+	for(i = 0; i < numSmall; i++)
+		freeRecord(records[i]);
+
+	rc = startHashJoin(&join, left, 0, right, 1, 0);
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, rc, "no join of an int and a string");
+	rc = startHashJoin(&join, left, 3, right, 0, 0);
+	ASSERT_EQUALS_INT(RC_RM_NO_SUCH_ATTR, rc, "no join on a missing attribute");
+
+	// every record of right with a match, once, with the matching record of left
+	found = countJoin(left, 0, right, 0, 0, &partitions, &checksum);
+	ASSERT_EQUALS_INT(26000, found, "every matching pair is returned in memory");
+	ASSERT_EQUALS_INT(0, partitions, "the hash table fits into memory");
+	ASSERT_TRUE(checksum == expectedSum, "the pairs have equal keys");
+
+	found = countJoin(left, 0, right, 0, 64 * 1024, &partitions, &checksum);
+	ASSERT_EQUALS_INT(26000, found, "every matching pair is returned from partitions");
+	ASSERT_TRUE(partitions > 1, "the join is split into partitions");
+	ASSERT_TRUE(checksum == expectedSum, "the pairs of partitions have equal keys");
+	glob("test_table_jl.join*", 0, NULL, &files);
+	ASSERT_EQUALS_INT(0, (int) files.gl_pathc, "the partition files are deleted");
+	globfree(&files);
+
+	// 100 records of left for each of the 50 strings of small
+	found = countJoin(left, 1, small, 1, 0, &partitions, &checksum);
+	ASSERT_EQUALS_INT(5000, found, "keys held by many records of the build table");
+	found = countJoin(left, 1, small, 1, 16 * 1024, &partitions, &checksum);
+	ASSERT_EQUALS_INT(5000, found, "keys held by many records in partitions");
+	found = countJoin(small, 1, left, 1, 0, &partitions, &checksum);
+	ASSERT_EQUALS_INT(5000, found, "keys held by many records of the probe table");
+
+	// a join can be closed before its end
+	TEST_CHECK(startHashJoin(&join, left, 0, right, 0, 64 * 1024));
+	TEST_CHECK(closeJoin(&join));
+	glob("test_table_jl.join*", 0, NULL, &files);
+	ASSERT_EQUALS_INT(0, (int) files.gl_pathc, "the partition files are deleted by closeJoin");
+	globfree(&files);
+
+	TEST_CHECK(closeTable(left));
+	TEST_CHECK(closeTable(right));
+	TEST_CHECK(closeTable(small));
+	TEST_CHECK(deleteTable("test_table_jl"));
+	TEST_CHECK(deleteTable("test_table_jr"));
+	TEST_CHECK(deleteTable("test_table_js"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(left);
+	free(right);
+	free(small);
+	TEST_DONE();
+}
+
+void testExternalSort(void) {
+	testName = "test sorting tables in memory and in runs";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 20000, i, rc, runs, found;
+	int byA[] = { 0 }, byBA[] = { 1, 0 }, byMissing[] = { 3 };
+	bool down[] = { TRUE }, upDown[] = { FALSE, TRUE };
+	long checksum, expectedSum = 0;
+	char b[5];
+	Record **records;
+	Schema *schema;
+	RM_SortHandle sort;
+	glob_t files;
+
+	// a is a permutation of -10000 to 9999, b takes 50 values
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_sort",schema));
+	TEST_CHECK(openTable(table, "test_table_sort"));
+	for(i = 0; i < numRecords; i++)
+		{
+			sprintf(b, "%04d", i % 50);
+			records[i] = testRecord(schema, (int) ((long) i * 7919 % numRecords) - 10000, b, i);
+			expectedSum += i;
+		}
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+
+	rc = startSort(&sort, table, byMissing, NULL, 1, 0);
+	ASSERT_EQUALS_INT(RC_RM_NO_SUCH_ATTR, rc, "no sort on a missing attribute");
+
+	found = countSorted(table, byA, NULL, 1, 0, &runs, &checksum);
+	ASSERT_EQUALS_INT(numRecords, found, "every record in order from memory");
+	ASSERT_EQUALS_INT(0, runs, "the table fits into memory");
+	ASSERT_TRUE(checksum == expectedSum, "the records are returned whole");
+
+	found = countSorted(table, byA, down, 1, 0, &runs, &checksum);
+	ASSERT_EQUALS_INT(numRecords, found, "every record in descending order");
+
+	// a run of 64KB holds about a thousand records, more than 16 runs are
+	// merged in two passes
+	found = countSorted(table, byA, NULL, 1, 64 * 1024, &runs, &checksum);
+	ASSERT_EQUALS_INT(numRecords, found, "every record in order from runs");
+	ASSERT_TRUE(runs > 16, "the runs are merged in more than one pass");
+	ASSERT_TRUE(checksum == expectedSum, "the records of runs are returned whole");
+	glob("test_table_sort.sort*", 0, NULL, &files);
+	ASSERT_EQUALS_INT(0, (int) files.gl_pathc, "the run files are deleted");
+	globfree(&files);
+
+	found = countSorted(table, byBA, upDown, 2, 64 * 1024, &runs, &checksum);
+	ASSERT_EQUALS_INT(numRecords, found, "every record in order of b, then a descending");
+	ASSERT_TRUE(runs > 0, "the runs of a composite key are merged");
+
+	// runs in a temporary directory
+	rc = setTempDirectory("test_no_such_dir");
+	ASSERT_EQUALS_INT(RC_FILE_NOT_FOUND, rc, "no temporary directory that does not exist");
+	mkdir("test_sort_tmp", 0755);
+	TEST_CHECK(setTempDirectory("test_sort_tmp"));
+	TEST_CHECK(startSort(&sort, table, byA, NULL, 1, 64 * 1024));
+	glob("test_sort_tmp/test_table_sort.sort*", 0, NULL, &files);
+	ASSERT_TRUE(files.gl_pathc > 0, "the runs are in the temporary directory");
+	globfree(&files);
+	TEST_CHECK(closeSort(&sort));
+	glob("test_sort_tmp/*", 0, NULL, &files);
+	ASSERT_EQUALS_INT(0, (int) files.gl_pathc, "the runs are deleted by closeSort");
+	globfree(&files);
+	TEST_CHECK(setTempDirectory(NULL));
+	rmdir("test_sort_tmp");
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_sort"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+void testMergeJoin(void) {
+	testName = "test sort-merge joins";
+	RM_TableData *left = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *right = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *small = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numLeft = 10000, numRight = 30000, numSmall = 50, i, rc, found;
+	long checksum, expectedSum = 0;
+	char b[5];
+	Record **records;
+	Schema *schema;
+	RM_JoinHandle join;
+	glob_t files;
+
+	// the tables of testHashJoin, left is loaded backwards
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRight);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_ml",schema));
+	TEST_CHECK(openTable(left, "test_table_ml"));
+	for(i = 0; i < numLeft; i++)
+		{
+			sprintf(b, "%04d", i % 100);
+			records[i] = testRecord(schema, numLeft - 1 - i, b, i % 10);
+		}
+	TEST_CHECK(bulkLoad(left, records, numLeft));
+	for(i = 0; i < numLeft; i++)
+		freeRecord(records[i]);
+
+	TEST_CHECK(createTable("test_table_mr",schema));
+	TEST_CHECK(openTable(right, "test_table_mr"));
+	for(i = 0; i < numRight; i++)
+		{
+			records[i] = testRecord(schema, i % 12000, "rrrr", i);
+			if (i % 12000 < numLeft)
+				expectedSum += (long) (i % 12000) * i;
+		}
+	TEST_CHECK(bulkLoad(right, records, numRight));
+	for(i = 0; i < numRight; i++)
+		freeRecord(records[i]);
+
+	TEST_CHECK(createTable("test_table_ms",schema));
+	TEST_CHECK(openTable(small, "test_table_ms"));
+	for(i = 0; i < numSmall; i++)
+		{
+			sprintf(b, "%04d", i * 2);
+			records[i] = testRecord(schema, i, b, i);
+		}
+	TEST_CHECK(bulkLoad(small, records, numSmall));
+	for(i = 0; i < numSmall; i++)
+		freeRecord(records[i]);
+
+	rc = startMergeJoin(&join, left, 0, right, 1, 0);
+	ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, rc, "no join of an int and a string");
+
+	found = countMergeJoin(left, 0, right, 0, 0, &checksum);
+	ASSERT_EQUALS_INT(26000, found, "every matching pair in order of the key");
+	ASSERT_TRUE(checksum == expectedSum, "the pairs have equal keys");
+	found = countMergeJoin(right, 0, left, 0, 0, &checksum);
+	ASSERT_EQUALS_INT(26000, found, "every matching pair with duplicates on the left");
+
+	found = countMergeJoin(left, 0, right, 0, 128 * 1024, &checksum);
+	ASSERT_EQUALS_INT(26000, found, "every matching pair from sorted runs");
+	ASSERT_TRUE(checksum == expectedSum, "the pairs of runs have equal keys");
+	glob("test_table_m*.sort*", 0, NULL, &files);
+	ASSERT_EQUALS_INT(0, (int) files.gl_pathc, "the run files are deleted");
+	globfree(&files);
+
+	// 100 records of left for each of the 50 strings of small
+	found = countMergeJoin(left, 1, small, 1, 0, &checksum);
+	ASSERT_EQUALS_INT(5000, found, "keys held by many records of the left table");
+	found = countMergeJoin(small, 1, left, 1, 64 * 1024, &checksum);
+	ASSERT_EQUALS_INT(5000, found, "keys held by many records of the right table");
+
+	TEST_CHECK(startMergeJoin(&join, left, 0, right, 0, 64 * 1024));
+	ASSERT_EQUALS_INT(0, getJoinPartitions(&join), "a merge join has no partitions");
+	TEST_CHECK(closeJoin(&join));
+	glob("test_table_m*.sort*", 0, NULL, &files);
+	ASSERT_EQUALS_INT(0, (int) files.gl_pathc, "the run files are deleted by closeJoin");
+	globfree(&files);
+
+	TEST_CHECK(closeTable(left));
+	TEST_CHECK(closeTable(right));
+	TEST_CHECK(closeTable(small));
+	TEST_CHECK(deleteTable("test_table_ml"));
+	TEST_CHECK(deleteTable("test_table_mr"));
+	TEST_CHECK(deleteTable("test_table_ms"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(left);
+	free(right);
+	free(small);
+	TEST_DONE();
+}
+
+void testAggregate(void) {
+	testName = "test aggregations with and without GROUP BY";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 10000, groupByA[] = { 0 }, groupByB[] = { 1 }, groupByC[] = { 2 }, i, rc, t, numFound, wrong;
+	int count[7] = { 0 }, minC[7], maxC[7], a, c, n;
+	long sum[7] = { 0 }, total = 0;
+	float avg;
+	char b[5], *s;
+	Aggregate aggs[] = { { AGG_COUNT, 0 }, { AGG_SUM, 0 }, { AGG_MIN, 2 }, { AGG_MAX, 2 }, { AGG_AVG, 0 } };
+	Aggregate strings[] = { { AGG_MIN, 1 }, { AGG_MAX, 1 } };
+	Aggregate wrongType[] = { { AGG_SUM, 1 } };
+	Aggregate missing[] = { { AGG_MAX, 3 } };
+	Record **records, *r;
+	Schema *schema;
+	RM_AggHandle agg;
+	Expr *left, *right, *sel, *none;
+
+	// b takes 7 values, c goes from -5 to 4, records with a % 100 == 0
+	// are deleted
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_agg",schema));
+	TEST_CHECK(openTable(table, "test_table_agg"));
+	for(i = 0; i < 7; i++)
+		{
+			minC[i] = 100;
+			maxC[i] = -100;
+		}
+	for(i = 0; i < numRecords; i++)
+		{
+			sprintf(b, "%04d", i % 7);
+			records[i] = testRecord(schema, i, b, i % 10 - 5);
+			if (i % 100 == 0)
+				continue;
+			count[i % 7]++;
+			sum[i % 7] += i;
+			total += i;
+			minC[i % 7] = (i % 10 - 5 < minC[i % 7]) ? i % 10 - 5 : minC[i % 7];
+			maxC[i % 7] = (i % 10 - 5 > maxC[i % 7]) ? i % 10 - 5 : maxC[i % 7];
+		}
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	TEST_CHECK(startAggregate(&agg, table, NULL, NULL, 0, aggs, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&r, agg.schema));
+	TEST_CHECK(nextAggregate(&agg, r));
+	getIntAttr(r, agg.schema, 0, &n);
+	ASSERT_EQUALS_INT(numRecords, n, "every record is counted before the deletes");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+	for(i = 0; i < numRecords; i += 100)
+		TEST_CHECK(deleteRecord(table, records[i]->id));
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+
+	rc = startAggregate(&agg, table, NULL, NULL, 0, wrongType, 1, 1);
+	ASSERT_EQUALS_INT(RC_RM_ATTR_WRONG_DATATYPE, rc, "no sum of strings");
+	rc = startAggregate(&agg, table, NULL, NULL, 0, missing, 1, 1);
+	ASSERT_EQUALS_INT(RC_RM_NO_SUCH_ATTR, rc, "no aggregate of a missing attribute");
+
+	// the whole table as one group, by pages of columns
+	for(t = 1; t <= TEST_SCAN_THREADS; t += TEST_SCAN_THREADS - 1)
+		{
+			TEST_CHECK(startAggregate(&agg, table, NULL, NULL, 0, aggs, 5, t));
+			ASSERT_EQUALS_STRING("sum(a)", agg.schema->attrNames[1], "results are named after their aggregate");
+			ASSERT_EQUALS_INT(DT_FLOAT, agg.schema->dataTypes[4], "an average is a float");
+			TEST_CHECK(createRecord(&r, agg.schema));
+			TEST_CHECK(nextAggregate(&agg, r));
+			getIntAttr(r, agg.schema, 0, &n);
+			ASSERT_EQUALS_INT(numRecords - 100, n, "every record is counted once");
+			getIntAttr(r, agg.schema, 1, &a);
+			ASSERT_TRUE(a == total, "the sum of every record");
+			getIntAttr(r, agg.schema, 2, &c);
+			ASSERT_EQUALS_INT(-5, c, "the smallest value");
+			getIntAttr(r, agg.schema, 3, &c);
+			ASSERT_EQUALS_INT(4, c, "the largest value");
+			getFloatAttr(r, agg.schema, 4, &avg);
+			ASSERT_TRUE(fabs(avg - (double) total / (numRecords - 100)) < 0.01, "the average of every record");
+			ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, nextAggregate(&agg, r), "one result without GROUP BY");
+			freeRecord(r);
+			TEST_CHECK(closeAggregate(&agg));
+		}
+
+	TEST_CHECK(startAggregate(&agg, table, NULL, NULL, 0, strings, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&r, agg.schema));
+	TEST_CHECK(nextAggregate(&agg, r));
+	getStringAttrRef(r, agg.schema, 0, &s);
+	ASSERT_EQUALS_STRING("0000", s, "the smallest string");
+	getStringAttrRef(r, agg.schema, 1, &s);
+	ASSERT_EQUALS_STRING("0006", s, "the largest string");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+
+	// grouped by b, in the hash tables of the threads
+	for(t = 1; t <= TEST_SCAN_THREADS; t += TEST_SCAN_THREADS - 1)
+		{
+			TEST_CHECK(startAggregate(&agg, table, NULL, groupByB, 1, aggs, 5, t));
+			ASSERT_EQUALS_INT(7, getAggregateGroups(&agg), "a result for every group");
+			TEST_CHECK(createRecord(&r, agg.schema));
+			for(numFound = 0, wrong = 0; nextAggregate(&agg, r) == RC_OK; numFound++)
+				{
+					int g;
+
+					getStringAttrRef(r, agg.schema, 0, &s);
+					g = atoi(s);
+					getIntAttr(r, agg.schema, 1, &n);
+					getIntAttr(r, agg.schema, 2, &a);
+					wrong += (n != count[g] || a != sum[g]);
+					getIntAttr(r, agg.schema, 3, &c);
+					wrong += (c != minC[g]);
+					getIntAttr(r, agg.schema, 4, &c);
+					wrong += (c != maxC[g]);
+					getFloatAttr(r, agg.schema, 5, &avg);
+					wrong += (fabs(avg - (double) sum[g] / count[g]) > 0.01);
+				}
+			ASSERT_EQUALS_INT(7, numFound, "every group is returned once");
+			ASSERT_EQUALS_INT(0, wrong, "the aggregates of every group");
+			freeRecord(r);
+			TEST_CHECK(closeAggregate(&agg));
+		}
+
+	// grouped by the unique a, the hash tables grow and are merged
+	TEST_CHECK(startAggregate(&agg, table, NULL, groupByA, 1, aggs, 2, TEST_SCAN_THREADS));
+	ASSERT_EQUALS_INT(numRecords - 100, getAggregateGroups(&agg), "a group for every value");
+	TEST_CHECK(createRecord(&r, agg.schema));
+	for(numFound = 0, wrong = 0; nextAggregate(&agg, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, agg.schema, 0, &a);
+			getIntAttr(r, agg.schema, 1, &n);
+			getIntAttr(r, agg.schema, 2, &c);
+			wrong += (n != 1 || c != a);
+		}
+	ASSERT_EQUALS_INT(numRecords - 100, numFound, "every group of many is returned once");
+	ASSERT_EQUALS_INT(0, wrong, "the aggregates of many groups");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+
+	// a < 1000 grouped by c, 99 or 100 records a group
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i1000"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startAggregate(&agg, table, sel, groupByC, 1, aggs, 1, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&r, agg.schema));
+	for(numFound = 0, n = 0; nextAggregate(&agg, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, agg.schema, 1, &c);
+			n += c;
+		}
+	ASSERT_EQUALS_INT(10, numFound, "a result for every group of the condition");
+	ASSERT_EQUALS_INT(990, n, "only records of the condition are counted");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+	freeExpr(sel);
+
+	// no record matches
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i-1"));
+	MAKE_BINOP_EXPR(none, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startAggregate(&agg, table, none, NULL, 0, aggs, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&r, agg.schema));
+	TEST_CHECK(nextAggregate(&agg, r));
+	getIntAttr(r, agg.schema, 0, &n);
+	ASSERT_EQUALS_INT(0, n, "a count of 0 without GROUP BY");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+	TEST_CHECK(startAggregate(&agg, table, none, groupByB, 1, aggs, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&r, agg.schema));
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, nextAggregate(&agg, r), "no groups without records");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+	freeExpr(none);
+
+	// sums beyond the range of an int are refused, other groups are not
+	for(i = 0; i < 3; i++)
+		{
+			r = testRecord(schema, 2000000000, "huge", 0);
+			TEST_CHECK(insertRecord(table, r));
+			freeRecord(r);
+		}
+	TEST_CHECK(startAggregate(&agg, table, NULL, NULL, 0, aggs, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&r, agg.schema));
+	ASSERT_EQUALS_INT(RC_RM_VALUE_OUT_OF_RANGE, nextAggregate(&agg, r), "a sum above INT_MAX");
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, nextAggregate(&agg, r), "one result after a sum above INT_MAX");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+	TEST_CHECK(startAggregate(&agg, table, NULL, groupByB, 1, aggs, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&r, agg.schema));
+	for(numFound = 0, n = 0; (rc = nextAggregate(&agg, r)) != RC_RM_NO_MORE_TUPLES; numFound++)
+		n += (rc == RC_RM_VALUE_OUT_OF_RANGE);
+	ASSERT_EQUALS_INT(8, numFound, "groups after a sum above INT_MAX");
+	ASSERT_EQUALS_INT(1, n, "one group with a sum above INT_MAX");
+	freeRecord(r);
+	TEST_CHECK(closeAggregate(&agg));
+
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_agg"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void testTopK(void) {
+	testName = "test LIMIT and ORDER BY ... LIMIT scans";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 20000, zoneAttrs[] = {0}, i, rc, a, c, lastA, lastC, numFound, wrong;
+	char b[5];
+	Record **records, *r;
+	Schema *schema;
+	RM_ScanHandle sc;
+	Value *value;
+	Expr *left, *right, *sel;
+
+	// a grows with the insertion order, c takes every value from 0 to 999
+	// 20 times, b repeats every 10000 records
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		{
+			sprintf(b, "%04d", i % 10000);
+			records[i] = testRecord(schema, i, b, (i * 7) % 1000);
+		}
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_top",schema));
+	TEST_CHECK(openTable(table, "test_table_top"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	TEST_CHECK(createRecord(&r, schema));
+
+	// a LIMIT scan stops at its last record
+	rc = startScanLimit(table, &sc, NULL, -1);
+	ASSERT_EQUALS_INT(RC_RM_INVALID_LIMIT, rc, "no negative limit");
+	TEST_CHECK(startScanLimit(table, &sc, NULL, 5));
+	for(numFound = 0, wrong = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			wrong += (a != numFound);
+		}
+	ASSERT_EQUALS_INT(5, numFound, "the limit bounds the records returned");
+	ASSERT_EQUALS_INT(0, wrong, "the first records of the table are returned");
+	ASSERT_EQUALS_INT(1, getScanPageReads(&sc), "no page after the last record is read");
+	TEST_CHECK(closeScan(&sc));
+	TEST_CHECK(startScanLimit(table, &sc, NULL, 0));
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, next(&sc, r), "a limit of 0 returns nothing");
+	ASSERT_EQUALS_INT(0, getScanPageReads(&sc), "a limit of 0 reads nothing");
+	TEST_CHECK(closeScan(&sc));
+
+	MAKE_ATTRREF(left, 2);
+	MAKE_CONS(right, stringToValue("i5"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startScanLimit(table, &sc, sel, 1000));
+	for(numFound = 0, wrong = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 2, &c);
+			wrong += (c >= 5);
+		}
+	ASSERT_EQUALS_INT(100, numFound, "a limit above the matches returns every match");
+	ASSERT_EQUALS_INT(0, wrong, "only matches are returned");
+	TEST_CHECK(closeScan(&sc));
+
+	// the largest c come first, equal values in the order of the table
+	rc = startScanTopK(table, &sc, NULL, 3, FALSE, 10);
+	ASSERT_EQUALS_INT(RC_RM_NO_SUCH_ATTR, rc, "no order by a missing attribute");
+	rc = startScanTopK(table, &sc, NULL, 2, FALSE, -1);
+	ASSERT_EQUALS_INT(RC_RM_INVALID_LIMIT, rc, "no negative k");
+	TEST_CHECK(startScanTopK(table, &sc, NULL, 2, TRUE, 30));
+	for(numFound = 0, wrong = 0, lastA = -1, lastC = 1000; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			getIntAttr(r, schema, 2, &c);
+			wrong += (c > lastC || (c == lastC && a < lastA) || c < 998 || (c == 998 && numFound < 20));
+			lastA = a;
+			lastC = c;
+		}
+	ASSERT_EQUALS_INT(30, numFound, "k records are returned");
+	ASSERT_EQUALS_INT(0, wrong, "the records with the largest c in order");
+	TEST_CHECK(closeScan(&sc));
+
+	// strings
+	TEST_CHECK(startScanTopK(table, &sc, NULL, 1, FALSE, 3));
+	for(numFound = 0, wrong = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			wrong += (a != (numFound == 0 ? 0 : numFound == 1 ? 10000 : 1));
+		}
+	ASSERT_EQUALS_INT(3, numFound, "k strings are returned");
+	ASSERT_EQUALS_INT(0, wrong, "the smallest strings in order");
+	TEST_CHECK(closeScan(&sc));
+
+	// with a condition, ordered by an attribute it does not bound
+	TEST_CHECK(startScanTopK(table, &sc, sel, 0, TRUE, 3));
+	for(numFound = 0, wrong = 0, i = numRecords - 1; next(&sc, r) == RC_OK; numFound++, i--)
+		{
+			for(; (i * 7) % 1000 >= 5; i--);
+			getIntAttr(r, schema, 0, &a);
+			wrong += (a != i);
+		}
+	ASSERT_EQUALS_INT(3, numFound, "k matches are returned");
+	ASSERT_EQUALS_INT(0, wrong, "the matches with the largest a");
+	TEST_CHECK(closeScan(&sc));
+
+	// once the heap is full, the zone map skips the pages that cannot beat it
+	TEST_CHECK(buildZoneMap(table, zoneAttrs, 1));
+	TEST_CHECK(startScanTopK(table, &sc, NULL, 0, FALSE, 10));
+	for(numFound = 0, wrong = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			wrong += (a != numFound);
+		}
+	ASSERT_EQUALS_INT(10, numFound, "k records with a zone map");
+	ASSERT_EQUALS_INT(0, wrong, "the smallest a in order");
+	ASSERT_EQUALS_INT(1, getScanPageReads(&sc), "only the page of the smallest a is read");
+	TEST_CHECK(closeScan(&sc));
+	TEST_CHECK(startScanTopK(table, &sc, NULL, 0, TRUE, 10));
+	for(numFound = 0, wrong = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			wrong += (a != numRecords - 1 - numFound);
+		}
+	ASSERT_EQUALS_INT(0, wrong, "the largest a in order");
+	ASSERT_TRUE(getScanPageReads(&sc) <= 2, "the pages with the largest zones are read first");
+	TEST_CHECK(closeScan(&sc));
+	TEST_CHECK(startScanTopK(table, &sc, sel, 0, FALSE, 100));
+	for(numFound = 0, wrong = 0, lastA = -1; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			getIntAttr(r, schema, 2, &c);
+			wrong += (a <= lastA || c >= 5);
+			lastA = a;
+		}
+	ASSERT_EQUALS_INT(100, numFound, "k equal to the number of matches");
+	ASSERT_EQUALS_INT(0, wrong, "every match in order");
+	TEST_CHECK(closeScan(&sc));
+	freeExpr(sel);
+
+	TEST_CHECK(startScanTopK(table, &sc, NULL, 1, TRUE, 1));
+	TEST_CHECK(next(&sc, r));
+	getAttr(r, schema, 1, &value);
+	ASSERT_EQUALS_STRING("9999", value->v.stringV, "the largest string");
+	freeVal(value);
+	ASSERT_EQUALS_INT(RC_RM_NO_MORE_TUPLES, next(&sc, r), "k of 1 returns one record");
+	TEST_CHECK(closeScan(&sc));
+
+	freeRecord(r);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_top"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(table);
+	TEST_DONE();
+}
+
+// ************************************************************
+void testPaxLayout(void) {
+	testName = "test tables with a PAX page layout";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *rows = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 5000, projAttrs[] = {2, 1}, zoneAttrs[] = {0}, byC[] = {2};
+	int i, t, a, c, numFound, wrong, value;
+	long long total;
+	char b[5], page[PAGE_SIZE];
+	Aggregate sum[] = { { AGG_SUM, 0 }, { AGG_COUNT, 0 } };
+	Record **records, *r, *other;
+	RID ids[3];
+	Schema *schema, *projected;
+	RM_ScanHandle sc, rowScan;
+	RM_AggHandle agg;
+	ParallelResult result;
+	SM_FileHandle fh;
+	Expr *left, *right, *sel;
+
+	// the same records in a row table and a PAX table
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		{
+			sprintf(b, "%04d", i % 1000);
+			records[i] = testRecord(schema, i, b, i % 10);
+		}
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTableWithLayout("test_table_pax", schema, LAYOUT_PAX));
+	TEST_CHECK(createTable("test_table_rows", schema));
+	TEST_CHECK(openTable(table, "test_table_pax"));
+	TEST_CHECK(openTable(rows, "test_table_rows"));
+	ASSERT_EQUALS_INT(LAYOUT_PAX, ((Table_Header *)table->mgmtData)->layout, "the table has the PAX layout");
+	ASSERT_EQUALS_INT(LAYOUT_ROW, ((Table_Header *)rows->mgmtData)->layout, "createTable keeps rows");
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	TEST_CHECK(bulkLoad(rows, records, numRecords));
+
+	// the values of a are one after the other in the first minipage
+	TEST_CHECK(openPageFile("test_table_pax", &fh));
+	TEST_CHECK(readBlock(1, &fh, page));
+	TEST_CHECK(closePageFile(&fh));
+	for(i = 0, wrong = 0; i < 10; i++)
+		{
+			memcpy(&a, page + 56 + i * sizeof(int), sizeof(int));
+			wrong += (a != i);
+		}
+	ASSERT_EQUALS_INT(0, wrong, "a minipage holds the values of an attribute");
+
+	// records are read and written whole
+	TEST_CHECK(createRecord(&r, schema));
+	for(i = 0, wrong = 0; i < numRecords; i += 97)
+		{
+			TEST_CHECK(getRecord(table, records[i]->id, r));
+			wrong += memcmp(r->data, records[i]->data, getRecordSize(schema)) != 0;
+		}
+	ASSERT_EQUALS_INT(0, wrong, "getRecord rebuilds the records");
+	other = testRecord(schema, -7, "zzzz", 42);
+	other->id = records[10]->id;
+	TEST_CHECK(updateRecord(table, other));
+	TEST_CHECK(updateRecord(rows, other));
+	TEST_CHECK(getRecord(table, records[10]->id, r));
+	ASSERT_EQUALS_RECORDS(other, r, schema, "an updated record");
+	TEST_CHECK(deleteRecord(table, records[20]->id));
+	TEST_CHECK(deleteRecord(rows, records[20]->id));
+	freeRecord(other);
+	other = testRecord(schema, -8, "yyyy", 43);
+	TEST_CHECK(insertRecords(table, &other, 1));
+	ASSERT_TRUE(other->id.page == records[20]->id.page && other->id.slot == records[20]->id.slot,
+			"a deleted slot is used again");
+	TEST_CHECK(insertRecords(rows, &other, 1));
+	TEST_CHECK(getRecord(table, other->id, r));
+	ASSERT_EQUALS_RECORDS(other, r, schema, "an inserted record");
+	freeRecord(other);
+	for(i = 0; i < 3; i++)
+		ids[i] = records[1000 + i * 1000]->id;
+	TEST_CHECK(deleteRecords(table, ids, 3));
+	TEST_CHECK(deleteRecords(rows, ids, 3));
+
+	// scans return the same records from both layouts
+	MAKE_ATTRREF(left, 2);
+	MAKE_CONS(right, stringToValue("i5"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(createRecord(&other, schema));
+	TEST_CHECK(startScan(table, &sc, sel));
+	TEST_CHECK(startScan(rows, &rowScan, sel));
+	for(numFound = 0, wrong = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			wrong += (next(&rowScan, other) != RC_OK || memcmp(r->data, other->data, getRecordSize(schema)) != 0);
+		}
+	wrong += (next(&rowScan, other) != RC_RM_NO_MORE_TUPLES);
+	ASSERT_EQUALS_INT(numRecords / 2 - 5, numFound, "every match of a PAX table");
+	ASSERT_EQUALS_INT(0, wrong, "the records of the row table");
+	TEST_CHECK(closeScan(&sc));
+	TEST_CHECK(closeScan(&rowScan));
+	freeRecord(other);
+
+	TEST_CHECK(startScanProjected(table, &sc, sel, projAttrs, 2));
+	projected = getScanSchema(&sc);
+	TEST_CHECK(createRecord(&other, projected));
+	for(numFound = 0, wrong = 0; next(&sc, other) == RC_OK; numFound++)
+		{
+			char *s;
+			getIntAttr(other, projected, 0, &c);
+			getStringAttrRef(other, projected, 1, &s);
+			wrong += (c >= 5 || strlen(s) != 4);
+		}
+	ASSERT_EQUALS_INT(numRecords / 2 - 5, numFound, "a projected scan of the minipages");
+	ASSERT_EQUALS_INT(0, wrong, "the projected attributes");
+	TEST_CHECK(closeScan(&sc));
+	freeRecord(other);
+
+	memset(&result, 0, sizeof(ParallelResult));
+	result.schema = schema;
+	TEST_CHECK(startParallelScan(table, sel, TEST_SCAN_THREADS, countParallel, &result));
+	for(t = 0, numFound = 0; t < TEST_SCAN_THREADS; t++)
+		numFound += result.found[t];
+	ASSERT_EQUALS_INT(numRecords / 2 - 5, numFound, "a parallel scan of a PAX table");
+	freeExpr(sel);
+
+	// aggregations go through the minipages
+	for(i = 0, total = 0; i < numRecords; i++)
+		total += (i == 10) ? -7 : (i == 20) ? -8 : (i == 1000 || i == 2000 || i == 3000) ? 0 : i;
+	TEST_CHECK(startAggregate(&agg, table, NULL, NULL, 0, sum, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&other, agg.schema));
+	TEST_CHECK(nextAggregate(&agg, other));
+	getIntAttr(other, agg.schema, 0, &value);
+	ASSERT_EQUALS_INT((int) total, value, "the sum of a PAX table");
+	getIntAttr(other, agg.schema, 1, &value);
+	ASSERT_EQUALS_INT(numRecords - 3, value, "the count of a PAX table");
+	freeRecord(other);
+	TEST_CHECK(closeAggregate(&agg));
+	TEST_CHECK(startAggregate(&agg, table, NULL, byC, 1, sum, 2, TEST_SCAN_THREADS));
+	ASSERT_EQUALS_INT(12, getAggregateGroups(&agg), "groups of a PAX table");
+	TEST_CHECK(closeAggregate(&agg));
+
+	// the layout is stored with the table, zone maps work on it
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_pax"));
+	ASSERT_EQUALS_INT(LAYOUT_PAX, ((Table_Header *)table->mgmtData)->layout, "the layout after opening the table");
+	TEST_CHECK(getRecord(table, records[numRecords - 1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[numRecords - 1], r, schema, "a record after opening the table");
+	TEST_CHECK(buildZoneMap(table, zoneAttrs, 1));
+	TEST_CHECK(startScanTopK(table, &sc, NULL, 0, TRUE, 5));
+	for(numFound = 0, wrong = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			wrong += (a != numRecords - 1 - numFound);
+		}
+	ASSERT_EQUALS_INT(5, numFound, "a top k scan of a PAX table");
+	ASSERT_EQUALS_INT(0, wrong, "the largest a");
+	TEST_CHECK(closeScan(&sc));
+
+	freeRecord(r);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(closeTable(rows));
+	TEST_CHECK(deleteTable("test_table_pax"));
+	TEST_CHECK(deleteTable("test_table_rows"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(table);
+	free(rows);
+	TEST_DONE();
+}
+
+// ************************************************************
+void testCompressedLayout(void) {
+	testName = "test tables with compressed PAX pages";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	RM_TableData *rows = (RM_TableData *) malloc(sizeof(RM_TableData));
+	int numRecords = 20000;
+	int i, t, a, numFound, wrong, value, numSlots, pageReads, decoded;
+	long long total;
+	char b[5], page[PAGE_SIZE];
+	Aggregate sum[] = { { AGG_SUM, 0 }, { AGG_COUNT, 0 } };
+	Record **records, *r, *other, *added[3];
+	RID rowIds[6];
+	Schema *schema;
+	RM_ScanHandle sc, rowScan;
+	RM_AggHandle agg;
+	ParallelResult result;
+	SM_FileHandle fh;
+	Expr *left, *right, *sel;
+
+	// a counts up, b takes 50 values and c changes every 500 records
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		{
+			sprintf(b, "%04d", i % 50);
+			records[i] = testRecord(schema, i, b, i / 500);
+		}
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTableWithLayout("test_table_cpax", schema, LAYOUT_COMPRESSED));
+	TEST_CHECK(createTable("test_table_rows", schema));
+	TEST_CHECK(openTable(table, "test_table_cpax"));
+	TEST_CHECK(openTable(rows, "test_table_rows"));
+	ASSERT_EQUALS_INT(LAYOUT_COMPRESSED, ((Table_Header *)table->mgmtData)->layout, "the table is compressed");
+	// the records keep the ids of the compressed table
+	TEST_CHECK(bulkLoad(rows, records, numRecords));
+	for(i = 0; i < 6; i++)
+		rowIds[i] = records[i]->id;
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	ASSERT_TRUE(((Table_Header *)table->mgmtData)->pageCount * 4 < ((Table_Header *)rows->mgmtData)->pageCount,
+			"compressed pages hold more records");
+
+	// every attribute has the encoding that suits it
+	TEST_CHECK(openPageFile("test_table_cpax", &fh));
+	TEST_CHECK(readBlock(1, &fh, page));
+	TEST_CHECK(closePageFile(&fh));
+	memcpy(&numSlots, page + 52, sizeof(int));
+	ASSERT_TRUE(numSlots > 1000, "a compressed page holds its slots");
+	ASSERT_EQUALS_INT(ENC_FOR, columnEncoding(schema, page + 56, numSlots, 0), "a is stored as offsets");
+	ASSERT_EQUALS_INT(ENC_DICTIONARY, columnEncoding(schema, page + 56, numSlots, 1), "b is stored as codes");
+	ASSERT_EQUALS_INT(ENC_RLE, columnEncoding(schema, page + 56, numSlots, 2), "c is stored as runs");
+
+	TEST_CHECK(createRecord(&r, schema));
+	for(i = 0, wrong = 0; i < numRecords; i += 97)
+		{
+			TEST_CHECK(getRecord(table, records[i]->id, r));
+			wrong += memcmp(r->data, records[i]->data, getRecordSize(schema)) != 0;
+		}
+	ASSERT_EQUALS_INT(0, wrong, "getRecord decodes the records");
+
+	// an update that still fits is written, one that does not is refused
+	other = testRecord(schema, 2, "0049", 0);
+	other->id = records[2]->id;
+	TEST_CHECK(updateRecord(table, other));
+	TEST_CHECK(getRecord(table, records[2]->id, r));
+	ASSERT_EQUALS_RECORDS(other, r, schema, "an updated record");
+	other->id = rowIds[2];
+	TEST_CHECK(updateRecord(rows, other));
+	freeRecord(other);
+	other = testRecord(schema, 1 << 30, "0001", 0);
+	other->id = records[1]->id;
+	ASSERT_EQUALS_INT(RC_RM_PAGE_FULL, updateRecord(table, other), "a page that does not fit the update");
+	TEST_CHECK(getRecord(table, records[1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[1], r, schema, "the record is unchanged");
+	freeRecord(other);
+
+	// deleted slots are not used again, records are appended
+	TEST_CHECK(deleteRecord(table, records[5]->id));
+	TEST_CHECK(deleteRecord(rows, rowIds[5]));
+	other = testRecord(schema, numRecords, "0007", 99);
+	TEST_CHECK(insertRecord(table, other));
+	ASSERT_EQUALS_INT(((Table_Header *)table->mgmtData)->pageCount, other->id.page, "an inserted record is appended");
+	TEST_CHECK(getRecord(table, other->id, r));
+	ASSERT_EQUALS_RECORDS(other, r, schema, "an inserted record");
+	TEST_CHECK(insertRecord(rows, other));
+	freeRecord(other);
+	for(i = 0; i < 3; i++)
+		added[i] = testRecord(schema, numRecords + 1 + i, "0007", 99);
+	TEST_CHECK(insertRecords(table, added, 3));
+	TEST_CHECK(insertRecords(rows, added, 3));
+	for(i = 0; i < 3; i++)
+		freeRecord(added[i]);
+
+	// equality on b compares dictionary codes, both layouts agree; the row
+	// table put a record into the deleted slot, so the sums are compared
+	MAKE_ATTRREF(left, 1);
+	MAKE_CONS(right, stringToValue("s0007"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_EQUAL);
+	TEST_CHECK(createRecord(&other, schema));
+	TEST_CHECK(startScan(table, &sc, sel));
+	TEST_CHECK(startScan(rows, &rowScan, sel));
+	for(numFound = 0, total = 0; next(&sc, r) == RC_OK; numFound++)
+		{
+			getIntAttr(r, schema, 0, &a);
+			total += a;
+		}
+	for(wrong = 0; next(&rowScan, other) == RC_OK; wrong++)
+		{
+			getIntAttr(other, schema, 0, &a);
+			total -= a;
+		}
+	ASSERT_EQUALS_INT(numRecords / 50 + 4, numFound, "every match of a compressed table");
+	ASSERT_EQUALS_INT(numFound, wrong, "the matches of the row table");
+	ASSERT_EQUALS_INT(0, (int) total, "the records of the row table");
+	TEST_CHECK(closeScan(&sc));
+	TEST_CHECK(closeScan(&rowScan));
+	freeRecord(other);
+
+	memset(&result, 0, sizeof(ParallelResult));
+	result.schema = schema;
+	TEST_CHECK(startParallelScan(table, sel, TEST_SCAN_THREADS, countParallel, &result));
+	for(t = 0, numFound = 0; t < TEST_SCAN_THREADS; t++)
+		numFound += result.found[t];
+	ASSERT_EQUALS_INT(numRecords / 50 + 4, numFound, "a parallel scan of a compressed table");
+	freeExpr(sel);
+
+	// pages whose offsets of a are out of range are not decoded
+	MAKE_ATTRREF(left, 0);
+	MAKE_CONS(right, stringToValue("i1000"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startScan(table, &sc, sel));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++)
+		;
+	pageReads = getScanPageReads(&sc);
+	decoded = getScanDecodedPages(&sc);
+	ASSERT_EQUALS_INT(999, numFound, "a range on a compressed table");
+	ASSERT_EQUALS_INT(((Table_Header *)table->mgmtData)->pageCount, pageReads, "every page is read");
+	ASSERT_EQUALS_INT(1, decoded, "only the first page is decoded");
+	TEST_CHECK(closeScan(&sc));
+	freeExpr(sel);
+
+	// aggregations go through the decoded minipages
+	for(i = 0, total = 0; i < numRecords + 4; i++)
+		total += (i == 5) ? 0 : i;
+	TEST_CHECK(startAggregate(&agg, table, NULL, NULL, 0, sum, 2, TEST_SCAN_THREADS));
+	TEST_CHECK(createRecord(&other, agg.schema));
+	TEST_CHECK(nextAggregate(&agg, other));
+	getIntAttr(other, agg.schema, 0, &value);
+	ASSERT_EQUALS_INT((int) total, value, "the sum of a compressed table");
+	getIntAttr(other, agg.schema, 1, &value);
+	ASSERT_EQUALS_INT(numRecords + 3, value, "the count of a compressed table");
+	freeRecord(other);
+	TEST_CHECK(closeAggregate(&agg));
+
+	// the layout is stored with the table
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_cpax"));
+	ASSERT_EQUALS_INT(LAYOUT_COMPRESSED, ((Table_Header *)table->mgmtData)->layout, "the layout after opening the table");
+	TEST_CHECK(getRecord(table, records[numRecords - 1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[numRecords - 1], r, schema, "a record after opening the table");
+
+	freeRecord(r);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(closeTable(rows));
+	TEST_CHECK(deleteTable("test_table_cpax"));
+	TEST_CHECK(deleteTable("test_table_rows"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(table);
+	free(rows);
+	TEST_DONE();
+}
+
+// ************************************************************
+void testCompressedPageFile(void) {
+	testName = "test compressed page files";
+	RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+	BM_BufferPool *bm = MAKE_POOL();
+	BM_PageHandle *h = MAKE_PAGE_HANDLE();
+	int numRecords = 5000;
+	int i, t, numFound, wrong, length;
+	char b[5], page[PAGE_SIZE], extent[LZ_BOUND(PAGE_SIZE)], back[PAGE_SIZE], *pages;
+	Record **records, *r, *other, *added[2];
+	Schema *schema;
+	RM_ScanHandle sc;
+	ParallelResult result;
+	SM_FileHandle fh, copy;
+	FILE *in, *out;
+	RID updated, deleted;
+	struct stat st;
+	off_t plainSize, compressedSize;
+	Expr *left, *right, *sel;
+
+	// blocks come back as they were, random bytes do not get smaller
+	for(i = 0; i < PAGE_SIZE; i++)
+		page[i] = (char) ((i % 300 < 200) ? i % 7 : rand());
+	length = lzCompress(page, PAGE_SIZE, extent, sizeof(extent));
+	ASSERT_TRUE(length > 0 && length < PAGE_SIZE / 2, "a repetitive page is compressed");
+	ASSERT_EQUALS_INT(PAGE_SIZE, lzDecompress(extent, length, back, PAGE_SIZE), "the page is decompressed");
+	ASSERT_TRUE(memcmp(page, back, PAGE_SIZE) == 0, "the decompressed page");
+	ASSERT_EQUALS_INT(-1, lzDecompress(extent, length - 3, back, PAGE_SIZE), "a cut block is refused");
+	ASSERT_EQUALS_INT(-1, lzDecompress(extent, length, back, PAGE_SIZE / 2), "a block too long is refused");
+	for(i = 0; i < PAGE_SIZE; i++)
+		page[i] = (char) rand();
+	ASSERT_EQUALS_INT(-1, lzCompress(page, PAGE_SIZE, extent, PAGE_SIZE - 1), "random bytes do not get smaller");
+
+	// a copy of a file taken while it is written reads the pages of the map
+	// it had when it was opened
+	pages = (char *) malloc(8 * PAGE_SIZE);
+	for(i = 0; i < 8 * PAGE_SIZE; i++)
+		pages[i] = (char) (i % 5 + i / PAGE_SIZE);
+	TEST_CHECK(createPageFile("test_table_lz"));
+	TEST_CHECK(openPageFile("test_table_lz", &fh));
+	TEST_CHECK(writeBlocks(0, 8, &fh, pages));
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(compressPageFile("test_table_lz"));
+	TEST_CHECK(openPageFile("test_table_lz", &fh));
+	TEST_CHECK(writeBlock(3, &fh, page));
+	in = fopen("test_table_lz", "rb");
+	out = fopen("test_table_lz.copy", "wb");
+	while((length = fread(extent, 1, sizeof(extent), in)) > 0)
+		fwrite(extent, 1, length, out);
+	fclose(in);
+	fclose(out);
+	TEST_CHECK(openPageFile("test_table_lz.copy", &copy));
+	for(i = 0, wrong = 0; i < 8; i++)
+		{
+			TEST_CHECK(readBlock(i, &copy, back));
+			wrong += memcmp(back, pages + i * PAGE_SIZE, PAGE_SIZE) != 0;
+		}
+	ASSERT_EQUALS_INT(0, wrong, "the pages of a copy taken during a write");
+	TEST_CHECK(closePageFile(&copy));
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(openPageFile("test_table_lz", &fh));
+	TEST_CHECK(readBlock(3, &fh, back));
+	ASSERT_TRUE(memcmp(back, page, PAGE_SIZE) == 0, "the written page after closing the file");
+	TEST_CHECK(readBlock(4, &fh, back));
+	ASSERT_TRUE(memcmp(back, pages + 4 * PAGE_SIZE, PAGE_SIZE) == 0, "a page not written after closing the file");
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(destroyPageFile("test_table_lz.copy"));
+	TEST_CHECK(destroyPageFile("test_table_lz"));
+	free(pages);
+
+	schema = testSchema();
+	records = (Record **) malloc(sizeof(Record *) * numRecords);
+	for(i = 0; i < numRecords; i++)
+		{
+			sprintf(b, "%04d", i % 100);
+			records[i] = testRecord(schema, i, b, i % 10);
+		}
+	TEST_CHECK(initRecordManager(NULL));
+	TEST_CHECK(createTable("test_table_lz", schema));
+	TEST_CHECK(openTable(table, "test_table_lz"));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	TEST_CHECK(closeTable(table));
+	stat("test_table_lz", &st);
+	plainSize = st.st_size;
+
+	// the compressed file is smaller and read like the plain one
+	TEST_CHECK(compressPageFile("test_table_lz"));
+	stat("test_table_lz", &st);
+	compressedSize = st.st_size;
+	ASSERT_TRUE(compressedSize * 2 < plainSize, "the pages are compressed");
+	TEST_CHECK(openPageFile("test_table_lz", &fh));
+	ASSERT_TRUE(fh.pageMap != NULL, "the file has a page-offset map");
+	ASSERT_EQUALS_INT((int) (plainSize / PAGE_SIZE), fh.totalNumPages, "the pages of the file");
+	TEST_CHECK(readBlock(1, &fh, page));
+	TEST_CHECK(closePageFile(&fh));
+	TEST_CHECK(initBufferPool(bm, "test_table_lz", 3, RS_LRU, NULL));
+	TEST_CHECK(pinPage(bm, h, 1));
+	ASSERT_TRUE(memcmp(h->data, page, PAGE_SIZE) == 0, "the buffer pool keeps the page decompressed");
+	TEST_CHECK(unpinPage(bm, h));
+	TEST_CHECK(shutdownBufferPool(bm));
+
+	TEST_CHECK(openTable(table, "test_table_lz"));
+	TEST_CHECK(createRecord(&r, schema));
+	for(i = 0, wrong = 0; i < numRecords; i += 97)
+		{
+			TEST_CHECK(getRecord(table, records[i]->id, r));
+			wrong += memcmp(r->data, records[i]->data, getRecordSize(schema)) != 0;
+		}
+	ASSERT_EQUALS_INT(0, wrong, "getRecord reads the compressed pages");
+
+	MAKE_ATTRREF(left, 2);
+	MAKE_CONS(right, stringToValue("i5"));
+	MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+	TEST_CHECK(startScan(table, &sc, sel));
+	for(numFound = 0; next(&sc, r) == RC_OK; numFound++)
+		;
+	TEST_CHECK(closeScan(&sc));
+	ASSERT_EQUALS_INT(numRecords / 2, numFound, "a scan of a compressed file");
+	memset(&result, 0, sizeof(ParallelResult));
+	result.schema = schema;
+	TEST_CHECK(startParallelScan(table, sel, TEST_SCAN_THREADS, countParallel, &result));
+	for(t = 0, numFound = 0; t < TEST_SCAN_THREADS; t++)
+		numFound += result.found[t];
+	ASSERT_EQUALS_INT(numRecords / 2, numFound, "a parallel scan of a compressed file");
+	freeExpr(sel);
+
+	// written pages are compressed again, new ones get extents at the end
+	other = testRecord(schema, -1, "zzzz", 7);
+	updated = other->id = records[10]->id;
+	deleted = records[20]->id;
+	TEST_CHECK(updateRecord(table, other));
+	freeRecord(other);
+	for(i = 0; i < 2; i++)
+		added[i] = testRecord(schema, numRecords + i, "yyyy", 3);
+	TEST_CHECK(insertRecords(table, added, 2));
+	TEST_CHECK(deleteRecord(table, deleted));
+	TEST_CHECK(bulkLoad(table, records, numRecords));
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(openTable(table, "test_table_lz"));
+	ASSERT_EQUALS_INT(2 * numRecords + 1, getNumTuples(table), "the records after opening the table");
+	TEST_CHECK(getRecord(table, updated, r));
+	getIntAttr(r, schema, 0, &i);
+	ASSERT_EQUALS_INT(-1, i, "an updated record");
+	ASSERT_EQUALS_INT(RC_TUPLE_NOT_FOUND, getRecord(table, deleted, r), "a deleted record");
+	TEST_CHECK(getRecord(table, added[1]->id, r));
+	ASSERT_EQUALS_RECORDS(added[1], r, schema, "an inserted record");
+	TEST_CHECK(getRecord(table, records[numRecords - 1]->id, r));
+	ASSERT_EQUALS_RECORDS(records[numRecords - 1], r, schema, "a loaded record");
+	TEST_CHECK(closeTable(table));
+
+	// compressing the file again leaves out the old extents
+	stat("test_table_lz", &st);
+	compressedSize = st.st_size;
+	TEST_CHECK(compressPageFile("test_table_lz"));
+	stat("test_table_lz", &st);
+	ASSERT_TRUE(st.st_size <= compressedSize, "the file is compacted");
+	TEST_CHECK(openTable(table, "test_table_lz"));
+	TEST_CHECK(getRecord(table, added[0]->id, r));
+	ASSERT_EQUALS_RECORDS(added[0], r, schema, "a record after compacting");
+
+	// a table created again under the name is plain
+	TEST_CHECK(closeTable(table));
+	TEST_CHECK(deleteTable("test_table_lz"));
+	TEST_CHECK(createTable("test_table_lz", schema));
+	TEST_CHECK(openPageFile("test_table_lz", &fh));
+	ASSERT_TRUE(fh.pageMap == NULL, "a new table is not compressed");
+	TEST_CHECK(closePageFile(&fh));
+
+	freeRecord(r);
+	for(i = 0; i < 2; i++)
+		freeRecord(added[i]);
+	for(i = 0; i < numRecords; i++)
+		freeRecord(records[i]);
+	TEST_CHECK(deleteTable("test_table_lz"));
+	TEST_CHECK(shutdownRecordManager());
+
+	freeSchema(schema);
+	free(records);
+	free(table);
+	free(bm);
+	free(h);
+	TEST_DONE();
+}
+
+void
+countParallel(int thread, Record *record, void *context)
+{
+  ParallelResult *result = (ParallelResult *) context;
+  int a;
+
+  getIntAttr(record, result->schema, 0, &a);
+  result->found[thread]++;
+  result->sum[thread] += a;
+}
+
+int
+countJoin(RM_TableData *build, int buildAttr, RM_TableData *probe, int probeAttr, size_t memory,
+	  int *partitions, long *checksum)
+{
+  RM_JoinHandle join;
+  Record *buildRecord, *probeRecord;
+  int found = 0, a, c;
+
+  *checksum = 0;
+  createRecord(&buildRecord, build->schema);
+  createRecord(&probeRecord, probe->schema);
+  if (startHashJoin(&join, build, buildAttr, probe, probeAttr, memory) != RC_OK)
+    return -1;
+  *partitions = getJoinPartitions(&join);
+  while (nextJoin(&join, buildRecord, probeRecord) == RC_OK)
+    {
+      getIntAttr(buildRecord, build->schema, 0, &a);
+      getIntAttr(probeRecord, probe->schema, 2, &c);
+      *checksum += (long) a * c;
+      found++;
+    }
+  closeJoin(&join);
+  freeRecord(buildRecord);
+  freeRecord(probeRecord);
+  return found;
+}
+
+// compare two records on some attributes of the test schema.
+static int
+compareSortAttrs(Schema *schema, Record *a, Record *b, int *attrList, bool *descending, int numAttrs)
+{
+  int i, c, x, y;
+  char *s, *t;
+
+  for(i = 0; i < numAttrs; i++)
+    {
+      if (schema->dataTypes[attrList[i]] == DT_INT)
+        {
+          getIntAttr(a, schema, attrList[i], &x);
+          getIntAttr(b, schema, attrList[i], &y);
+          c = (x > y) - (x < y);
+        }
+      else
+        {
+          getStringAttrRef(a, schema, attrList[i], &s);
+          getStringAttrRef(b, schema, attrList[i], &t);
+          c = strncmp(s, t, schema->typeLength[attrList[i]]);
+        }
+      if (c != 0)
+        return (descending != NULL && descending[i]) ? -c : c;
+    }
+  return 0;
+}
+
+int
+countSorted(RM_TableData *rel, int *attrList, bool *descending, int numAttrs, size_t memory,
+	    int *runs, long *checksum)
+{
+  RM_SortHandle sort;
+  Record *record, *last;
+  int found = 0, inOrder = 1, c;
+
+  *checksum = 0;
+  createRecord(&record, rel->schema);
+  createRecord(&last, rel->schema);
+  if (startSort(&sort, rel, attrList, descending, numAttrs, memory) != RC_OK)
+    return -1;
+  *runs = getSortRuns(&sort);
+  while (nextSorted(&sort, record) == RC_OK)
+    {
+      if (found > 0 && compareSortAttrs(rel->schema, last, record, attrList, descending, numAttrs) > 0)
+        inOrder = 0;
+      getIntAttr(record, rel->schema, 2, &c);
+      *checksum += c;
+      memcpy(last->data, record->data, getRecordSize(rel->schema));
+      found++;
+    }
+  closeSort(&sort);
+  freeRecord(record);
+  freeRecord(last);
+  return inOrder ? found : -1;
+}
+
+int
+countMergeJoin(RM_TableData *left, int leftAttr, RM_TableData *right, int rightAttr, size_t memory,
+	       long *checksum)
+{
+  RM_JoinHandle join;
+  Record *leftRecord, *rightRecord, *last;
+  int found = 0, inOrder = 1, a, c;
+
+  *checksum = 0;
+  createRecord(&leftRecord, left->schema);
+  createRecord(&rightRecord, right->schema);
+  createRecord(&last, left->schema);
+  if (startMergeJoin(&join, left, leftAttr, right, rightAttr, memory) != RC_OK)
+    return -1;
+  while (nextJoin(&join, leftRecord, rightRecord) == RC_OK)
+    {
+      if (found > 0 && compareSortAttrs(left->schema, last, leftRecord, &leftAttr, NULL, 1) > 0)
+        inOrder = 0;
+      getIntAttr(leftRecord, left->schema, 0, &a);
+      getIntAttr(rightRecord, right->schema, 2, &c);
+      *checksum += (long) a * c;
+      memcpy(last->data, leftRecord->data, getRecordSize(left->schema));
+      found++;
+    }
+  closeJoin(&join);
+  freeRecord(leftRecord);
+  freeRecord(rightRecord);
+  freeRecord(last);
+  return inOrder ? found : -1;
+}
+
+void *
+sharedScanThread(void *arg)
+{
+  SharedScanThread *thread = (SharedScanThread *) arg;
+  RM_ScanHandle sc;
+  Record *r;
+  Expr *sel, *left, *right;
+  Value *c;
+
+  MAKE_ATTRREF(left, 2);
+  MAKE_VALUE(c, DT_INT, thread->c);
+  MAKE_CONS(right, c);
+  MAKE_BINOP_EXPR(sel, left, right, OP_COMP_SMALLER);
+
+  createRecord(&r, thread->schema);
+  if ((thread->rc = startSharedScan(thread->table, &sc, sel)) == RC_OK)
+    {
+      while ((thread->rc = next(&sc, r)) == RC_OK)
+	thread->found++;
+      closeScan(&sc);
+    }
+
+  freeRecord(r);
+  freeExpr(sel);
+  return NULL;
+}
+
 Schema *
 testSchema (void)
 {
@@ -0,0 +1,345 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dberror.h"
+#include "expr.h"
+#include "btree_mgr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+// test methods
+static void testInsertAndFind (void);
+static void testDeleteAndMerge (void);
+static void testRangeScan (void);
+static void testKeyTypes (void);
+
+// helper methods
+static int *permutation (int n, unsigned int seed);
+static RID ridOf (int key);
+
+char *testName;
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  testInsertAndFind();
+  testDeleteAndMerge();
+  testRangeScan();
+  testKeyTypes();
+
+  return 0;
+}
+
+// ************************************************************
+// keys inserted in random order into nodes of 2 keys, enough nodes that the
+// buffer pool replaces pages; the tree is found again after reopening it
+void
+testInsertAndFind (void)
+{
+  BTreeHandle *tree;
+  int numKeys = 5000, i, numEntries, numNodes;
+  int *keys = permutation(numKeys, 7);
+  Value key;
+  RID rid;
+  RC rc;
+
+  testName = "test inserting and finding keys";
+
+  TEST_CHECK(initIndexManager(NULL));
+  TEST_CHECK(createBtree("test_idx_a", DT_INT, 2));
+  TEST_CHECK(openBtree(&tree, "test_idx_a"));
+
+  key.dt = DT_INT;
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = keys[i];
+      TEST_CHECK(insertKey(tree, &key, ridOf(keys[i])));
+    }
+  key.v.intV = keys[0];
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, insertKey(tree, &key, ridOf(0)), "a key is inserted once");
+
+  TEST_CHECK(getNumEntries(tree, &numEntries));
+  TEST_CHECK(getNumNodes(tree, &numNodes));
+  ASSERT_EQUALS_INT(numKeys, numEntries, "every key is an entry");
+  ASSERT_TRUE(numNodes > numKeys / 2, "nodes hold at most 2 keys");
+  TEST_CHECK(closeBtree(tree));
+
+  TEST_CHECK(openBtree(&tree, "test_idx_a"));
+  TEST_CHECK(getNumEntries(tree, &numEntries));
+  ASSERT_EQUALS_INT(numKeys, numEntries, "entries are kept by the index file");
+  for(i = 0, rc = RC_OK; i < numKeys && rc == RC_OK; i++)
+    {
+      key.v.intV = i;
+      rc = findKey(tree, &key, &rid);
+      if (rc == RC_OK && (rid.page != ridOf(i).page || rid.slot != ridOf(i).slot))
+        rc = RC_IM_KEY_NOT_FOUND;
+    }
+  ASSERT_EQUALS_INT(RC_OK, rc, "every key is found with its RID");
+  key.v.intV = numKeys;
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, findKey(tree, &key, &rid), "a key that was not inserted");
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("test_idx_a"));
+  TEST_CHECK(shutdownIndexManager());
+  free(keys);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// deleting keys borrows from and merges nodes until the root is the only
+// node left
+void
+testDeleteAndMerge (void)
+{
+  BTreeHandle *tree;
+  BT_ScanHandle *scan;
+  int numKeys = 2000, i, numEntries, numNodes, numFound;
+  int *keys = permutation(numKeys, 11);
+  int *deletes = permutation(numKeys, 13);
+  Value key;
+  RID rid;
+  RC rc;
+
+  testName = "test deleting keys";
+
+  TEST_CHECK(createBtree("test_idx_b", DT_INT, 3));
+  TEST_CHECK(openBtree(&tree, "test_idx_b"));
+  key.dt = DT_INT;
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = keys[i];
+      TEST_CHECK(insertKey(tree, &key, ridOf(keys[i])));
+    }
+
+  // the odd keys are deleted in random order
+  for(i = 0; i < numKeys; i++)
+    if (deletes[i] % 2)
+      {
+        key.v.intV = deletes[i];
+        TEST_CHECK(deleteKey(tree, &key));
+      }
+  key.v.intV = 1;
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, deleteKey(tree, &key), "a deleted key is gone");
+  TEST_CHECK(getNumEntries(tree, &numEntries));
+  ASSERT_EQUALS_INT(numKeys / 2, numEntries, "half of the keys are left");
+
+  TEST_CHECK(openTreeScan(tree, &scan));
+  for(numFound = 0; (rc = nextEntry(scan, &rid)) == RC_OK; numFound++)
+    if (rid.slot != 2 * numFound)
+      break;
+  TEST_CHECK(closeTreeScan(scan));
+  ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "the even keys are left in order");
+  ASSERT_EQUALS_INT(numKeys / 2, numFound, "every key left is scanned");
+
+  for(i = 0; i < numKeys; i++)
+    if (deletes[i] % 2 == 0)
+      {
+        key.v.intV = deletes[i];
+        TEST_CHECK(deleteKey(tree, &key));
+      }
+  TEST_CHECK(getNumEntries(tree, &numEntries));
+  TEST_CHECK(getNumNodes(tree, &numNodes));
+  ASSERT_EQUALS_INT(0, numEntries, "every key is deleted");
+  ASSERT_EQUALS_INT(1, numNodes, "the root leaf is the only node left");
+
+  // freed nodes are used again
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = keys[i];
+      TEST_CHECK(insertKey(tree, &key, ridOf(keys[i])));
+    }
+  key.v.intV = 1234;
+  TEST_CHECK(findKey(tree, &key, &rid));
+  ASSERT_EQUALS_INT(1234, rid.slot, "a key inserted into freed nodes");
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("test_idx_b"));
+  free(keys);
+  free(deletes);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// range scans follow the links between leaves
+void
+testRangeScan (void)
+{
+  BTreeHandle *tree;
+  BT_ScanHandle *scan;
+  int numKeys = 1000, i, numFound;
+  int *keys = permutation(numKeys, 17);
+  Value key, low, high;
+  RID rid;
+  RC rc;
+
+  testName = "test range scans";
+
+  TEST_CHECK(createBtree("test_idx_c", DT_INT, 4));
+  TEST_CHECK(openBtree(&tree, "test_idx_c"));
+  key.dt = low.dt = high.dt = DT_INT;
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = 2 * keys[i];
+      TEST_CHECK(insertKey(tree, &key, ridOf(2 * keys[i])));
+    }
+
+  // 101 <= key <= 300 starts between two keys and ends on one
+  low.v.intV = 101;
+  high.v.intV = 300;
+  TEST_CHECK(openTreeRangeScan(tree, &low, &high, &scan));
+  for(numFound = 0; (rc = nextEntry(scan, &rid)) == RC_OK; numFound++)
+    if (rid.slot != 102 + 2 * numFound)
+      break;
+  TEST_CHECK(closeTreeScan(scan));
+  ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, rc, "the keys of the range in order");
+  ASSERT_EQUALS_INT(100, numFound, "every key of the range");
+
+  // open ranges and a range without keys
+  low.v.intV = 1990;
+  TEST_CHECK(openTreeRangeScan(tree, &low, NULL, &scan));
+  for(numFound = 0; nextEntry(scan, &rid) == RC_OK; numFound++);
+  TEST_CHECK(closeTreeScan(scan));
+  ASSERT_EQUALS_INT(5, numFound, "the keys from 1990 on");
+
+  high.v.intV = 9;
+  TEST_CHECK(openTreeRangeScan(tree, NULL, &high, &scan));
+  for(numFound = 0; nextEntry(scan, &rid) == RC_OK; numFound++);
+  TEST_CHECK(closeTreeScan(scan));
+  ASSERT_EQUALS_INT(5, numFound, "the keys up to 9");
+
+  low.v.intV = 3001;
+  TEST_CHECK(openTreeRangeScan(tree, &low, NULL, &scan));
+  ASSERT_EQUALS_INT(RC_IM_NO_MORE_ENTRIES, nextEntry(scan, &rid), "no key after the last one");
+  TEST_CHECK(closeTreeScan(scan));
+
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("test_idx_c"));
+  free(keys);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// float, string and bool keys, and the layout of a small tree
+void
+testKeyTypes (void)
+{
+  BTreeHandle *tree;
+  BT_ScanHandle *scan;
+  char *names[] = { "pear", "apple", "plum", "fig", "kiwi", "applesauce" };
+  int i, numFound;
+  DataType keyType;
+  Value *key;
+  RID rid;
+  char *printed;
+  RC rc;
+
+  testName = "test keys of every type";
+
+  // floats in a tree of three levels
+  TEST_CHECK(createBtree("test_idx_d", DT_FLOAT, 2));
+  TEST_CHECK(openBtree(&tree, "test_idx_d"));
+  TEST_CHECK(getKeyType(tree, &keyType));
+  ASSERT_EQUALS_INT(DT_FLOAT, keyType, "the key type is stored");
+  for(i = 0; i < 5; i++)
+    {
+      MAKE_VALUE(key, DT_FLOAT, 2.5f - i);
+      TEST_CHECK(insertKey(tree, key, ridOf(i)));
+      freeVal(key);
+    }
+  printed = printTree(tree);
+  ASSERT_EQUALS_STRING("(7)[3,1.500000,6]\n"
+		       "(3)[1,0.500000,5]\n"
+		       "(1)[1.4,-1.500000,1.3,-0.500000,5]\n"
+		       "(5)[1.2,0.500000,4]\n"
+		       "(6)[4,2.500000,2]\n"
+		       "(4)[1.1,1.500000,2]\n"
+		       "(2)[1.0,2.500000,-1]\n",
+		       printed, "splits of leaves and of the root");
+  free(printed);
+  MAKE_VALUE(key, DT_INT, 1);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, findKey(tree, key, &rid), "keys have the type of the index");
+  freeVal(key);
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("test_idx_d"));
+
+  // strings of up to 5 characters, longer ones are cut
+  TEST_CHECK(createStringBtree("test_idx_e", 5, 3));
+  TEST_CHECK(openBtree(&tree, "test_idx_e"));
+  for(i = 0; i < 5; i++)
+    {
+      MAKE_STRING_VALUE(key, names[i]);
+      TEST_CHECK(insertKey(tree, key, ridOf(i)));
+      freeVal(key);
+    }
+  MAKE_STRING_VALUE(key, names[5]);
+  rc = insertKey(tree, key, ridOf(5));
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, rc, "applesauce is cut to apple");
+  freeVal(key);
+  MAKE_STRING_VALUE(key, "apple");
+  TEST_CHECK(findKey(tree, key, &rid));
+  ASSERT_EQUALS_INT(1, rid.slot, "apple is found");
+  freeVal(key);
+  TEST_CHECK(openTreeScan(tree, &scan));
+  TEST_CHECK(nextEntry(scan, &rid));
+  ASSERT_EQUALS_INT(1, rid.slot, "apple comes first");
+  for(numFound = 1; nextEntry(scan, &rid) == RC_OK; numFound++);
+  ASSERT_EQUALS_INT(2, rid.slot, "plum comes last");
+  ASSERT_EQUALS_INT(5, numFound, "every string is scanned");
+  TEST_CHECK(closeTreeScan(scan));
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("test_idx_e"));
+
+  // bools
+  TEST_CHECK(createBtree("test_idx_f", DT_BOOL, 2));
+  TEST_CHECK(openBtree(&tree, "test_idx_f"));
+  MAKE_VALUE(key, DT_BOOL, 1);
+  TEST_CHECK(insertKey(tree, key, ridOf(1)));
+  key->v.boolV = 0;
+  TEST_CHECK(insertKey(tree, key, ridOf(0)));
+  TEST_CHECK(findKey(tree, key, &rid));
+  ASSERT_EQUALS_INT(0, rid.slot, "false is found");
+  freeVal(key);
+  TEST_CHECK(closeBtree(tree));
+  TEST_CHECK(deleteBtree("test_idx_f"));
+
+  ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, createBtree("test_idx_g", DT_INT, 1000), "1000 int keys do not fit into a page");
+
+  TEST_DONE();
+}
+
+// the numbers 0 to n - 1 in a random order
+int *
+permutation (int n, unsigned int seed)
+{
+  int *result = (int *) malloc(sizeof(int) * n);
+  int i, j, tmp;
+
+  srand(seed);
+  for(i = 0; i < n; i++)
+    result[i] = i;
+  for(i = n - 1; i > 0; i--)
+    {
+      j = rand() % (i + 1);
+      tmp = result[i];
+      result[i] = result[j];
+      result[j] = tmp;
+    }
+  return result;
+}
+
+// the RID stored for a key
+RID
+ridOf (int key)
+{
+  RID rid;
+
+  rid.page = key / 100 + 1;
+  rid.slot = key;
+  return rid;
+}
@@ -29,6 +29,19 @@
 static void testValueSerialize (void);
 static void testOperators (void);
 static void testExpressions (void);
+static void testCompiledExpressions (void);
+static void testBatchExpressions (void);
+static void testRangeOperators (void);
+static void testExprRanges (void);
+static void testShortCircuit (void);
+static void testExprFilter (void);
+
+// helper methods
+static Schema *exprSchema (void);
+static Record *exprRecord (Schema *schema, int a, float b, char *c, bool d);
+static void exprRecords (Schema *schema, Record **records, int numRecords);
+static void checkCompiled (Schema *schema, Record **records, int numRecords, Expr *expr, char *message);
+static void checkOperator (char *left, char *right, RC (*op) (Value *, Value *, Value *), bool expected, char *message);
 
 char *testName;
 
@@ -41,6 +54,12 @@ main (void)
   testValueSerialize();
   testOperators();
   testExpressions();
+  testCompiledExpressions();
+  testBatchExpressions();
+  testRangeOperators();
+  testExprRanges();
+  testShortCircuit();
+  testExprFilter();
 
   return 0;
 }
@@ -123,3 +142,628 @@ testExpressions (void)
 
   TEST_DONE();
 }
+
+// ************************************************************
+void
+testCompiledExpressions (void)
+{
+  Schema *schema = exprSchema();
+  Record *records[6];
+  ExprProgram *program;
+  Expr *op, *l, *r, *terms;
+  int i;
+  testName = "test compiled expressions";
+
+  records[0] = exprRecord(schema, 1, 0.5, "aaaa", TRUE);
+  records[1] = exprRecord(schema, 2, 1.5, "bbbb", FALSE);
+  records[2] = exprRecord(schema, 3, 2.5, "cccc", TRUE);
+  records[3] = exprRecord(schema, 4, 1.5, "aaaa", FALSE);
+  records[4] = exprRecord(schema, 5, 0.5, "dd", TRUE);
+  records[5] = exprRecord(schema, 6, 3.5, "cccc", FALSE);
+
+  // a = 3
+  MAKE_CONS(l, stringToValue("i3"));
+  MAKE_ATTRREF(r, 0);
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_EQUAL);
+  checkCompiled(schema, records, 6, op, "a = 3");
+  freeExpr(op);
+
+  // b < 2.0
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("f2.0"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_SMALLER);
+  checkCompiled(schema, records, 6, op, "b < 2.0");
+  freeExpr(op);
+
+  // c = "cccc" OR NOT (c < "bbbb")
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("scccc"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_EQUAL);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("sbbbb"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_SMALLER);
+  MAKE_UNOP_EXPR(l, op, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(op, terms, l, OP_BOOL_OR);
+  checkCompiled(schema, records, 6, op, "c = cccc OR NOT c < bbbb");
+  freeExpr(op);
+
+  // d AND (a < 5) AND NOT (b = 0.5)
+  MAKE_ATTRREF(l, 3);
+  MAKE_ATTRREF(r, 0);
+  MAKE_CONS(op, stringToValue("i5"));
+  MAKE_BINOP_EXPR(terms, r, op, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(op, l, terms, OP_BOOL_AND);
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("f0.5"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_EQUAL);
+  MAKE_UNOP_EXPR(l, terms, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(terms, op, l, OP_BOOL_AND);
+  checkCompiled(schema, records, 6, terms, "d AND a < 5 AND NOT b = 0.5");
+  freeExpr(terms);
+
+  // expressions that do not type check are rejected by the compiler
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("f1.0"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_EQUAL);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, compileExpr(op, schema, &program), "int = float does not compile");
+  freeExpr(op);
+
+  MAKE_ATTRREF(l, 0);
+  MAKE_ATTRREF(r, 3);
+  MAKE_BINOP_EXPR(op, l, r, OP_BOOL_AND);
+  ASSERT_EQUALS_INT(RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN, compileExpr(op, schema, &program), "int AND bool does not compile");
+  freeExpr(op);
+
+  MAKE_ATTRREF(op, 0);
+  ASSERT_EQUALS_INT(RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN, compileExpr(op, schema, &program), "int result does not compile");
+  freeExpr(op);
+
+  for(i = 0; i < 6; i++)
+    freeRecord(records[i]);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testBatchExpressions (void)
+{
+  Schema *schema = exprSchema();
+  Record *records[300];
+  Expr *op, *l, *r, *terms;
+  int i;
+  testName = "test batch evaluated expressions";
+
+  exprRecords(schema, records, 300);
+
+  // a < 9 AND NOT (b = 1.0)
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i9"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("f1.0"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_EQUAL);
+  MAKE_UNOP_EXPR(l, op, OP_BOOL_NOT);
+  MAKE_BINOP_EXPR(op, terms, l, OP_BOOL_AND);
+  checkCompiled(schema, records, 300, op, "a < 9 AND NOT b = 1.0");
+  freeExpr(op);
+
+  // c < "cccc" OR d = (a = 3)
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("scccc"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_EQUAL);
+  MAKE_ATTRREF(l, 3);
+  MAKE_BINOP_EXPR(r, l, op, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(op, terms, r, OP_BOOL_OR);
+  checkCompiled(schema, records, 300, op, "c < cccc OR d = (a = 3)");
+  freeExpr(op);
+
+  // NOT d
+  MAKE_ATTRREF(l, 3);
+  MAKE_UNOP_EXPR(op, l, OP_BOOL_NOT);
+  checkCompiled(schema, records, 300, op, "NOT d");
+  freeExpr(op);
+
+  for(i = 0; i < 300; i++)
+    freeRecord(records[i]);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testRangeOperators (void)
+{
+  Schema *schema = exprSchema();
+  Record *records[300];
+  Value *values[4];
+  Value *result;
+  ExprProgram *program;
+  Expr *op, *l, *r, *h;
+  int i;
+  testName = "test range, IN and prefix operators";
+  MAKE_VALUE(result, DT_INT, 0);
+
+  checkOperator("i10", "i3", valueGreater, TRUE, "10 > 3");
+  checkOperator("i3", "i3", valueGreater, FALSE, "3 > 3 is false");
+  checkOperator("f2.5", "f2.5", valueSmallerOrEqual, TRUE, "2.5 <= 2.5");
+  checkOperator("sbb", "sab", valueSmallerOrEqual, FALSE, "bb <= ab is false");
+  checkOperator("sbb", "sbb", valueGreaterOrEqual, TRUE, "bb >= bb");
+  checkOperator("sHello World", "sHello", valueHasPrefix, TRUE, "Hello World LIKE Hello%");
+  checkOperator("sHell", "sHello", valueHasPrefix, FALSE, "Hell LIKE Hello% is false");
+
+  values[0] = stringToValue("i5");
+  values[1] = stringToValue("i7");
+  values[2] = stringToValue("i8");
+  TEST_CHECK(valueBetween(values[0], values[0], values[1], result));
+  ASSERT_TRUE(result->v.boolV, "5 BETWEEN 5 AND 7");
+  TEST_CHECK(valueBetween(values[2], values[0], values[1], result));
+  ASSERT_TRUE(!result->v.boolV, "8 BETWEEN 5 AND 7 is false");
+  values[3] = stringToValue("f1.0");
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE,
+		    valueGreater(values[0], values[3], result), "int > float fails");
+  for(i = 0; i < 4; i++)
+    freeVal(values[i]);
+
+  values[0] = stringToValue("i3");
+  values[1] = stringToValue("i-7");
+  values[2] = stringToValue("i3");
+  values[3] = stringToValue("f1.0");
+  ASSERT_TRUE(createValueSet(values, 4) == NULL, "a set of ints and floats is not created");
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(op, l, values, 3);
+  ASSERT_EQUALS_INT(2, op->expr.op->set->numValues, "duplicates are stored once");
+  for(i = 0; i < 4; i++)
+    freeVal(values[i]);
+  values[0] = stringToValue("i-7");
+  values[1] = stringToValue("i4");
+  TEST_CHECK(valueIn(values[0], op->expr.op->set, result));
+  ASSERT_TRUE(result->v.boolV, "-7 IN (3, -7)");
+  TEST_CHECK(valueIn(values[1], op->expr.op->set, result));
+  ASSERT_TRUE(!result->v.boolV, "4 IN (3, -7) is false");
+  freeExpr(op);
+  freeVal(values[0]);
+  freeVal(values[1]);
+
+  // the operators compiled, tuple at a time and in batches
+  exprRecords(schema, records, 300);
+
+  // a > 9, 12 <= a, b >= 1.0, c <= "bbbb"
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i9"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_GREATER);
+  checkCompiled(schema, records, 300, op, "a > 9");
+  freeExpr(op);
+
+  MAKE_CONS(l, stringToValue("i12"));
+  MAKE_ATTRREF(r, 0);
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_LE);
+  checkCompiled(schema, records, 300, op, "12 <= a");
+  freeExpr(op);
+
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("f1.0"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_GE);
+  checkCompiled(schema, records, 300, op, "b >= 1.0");
+  freeExpr(op);
+
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("sbbbb"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_LE);
+  checkCompiled(schema, records, 300, op, "c <= bbbb");
+  freeExpr(op);
+
+  // a BETWEEN 4 AND 11, b BETWEEN 0.5 AND 1.5
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i4"));
+  MAKE_CONS(h, stringToValue("i11"));
+  MAKE_BETWEEN_EXPR(op, l, r, h);
+  checkCompiled(schema, records, 300, op, "a BETWEEN 4 AND 11");
+  freeExpr(op);
+
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("f0.5"));
+  MAKE_CONS(h, stringToValue("f1.5"));
+  MAKE_BETWEEN_EXPR(op, l, r, h);
+  checkCompiled(schema, records, 300, op, "b BETWEEN 0.5 AND 1.5");
+  freeExpr(op);
+
+  // a IN (1, 5, 16), c IN ("dd", "aaaa"), d IN (false), b IN (1.5)
+  values[0] = stringToValue("i1");
+  values[1] = stringToValue("i5");
+  values[2] = stringToValue("i16");
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(op, l, values, 3);
+  checkCompiled(schema, records, 300, op, "a IN (1, 5, 16)");
+  freeExpr(op);
+  for(i = 0; i < 3; i++)
+    freeVal(values[i]);
+
+  values[0] = stringToValue("sdd");
+  values[1] = stringToValue("saaaa");
+  MAKE_ATTRREF(l, 2);
+  MAKE_IN_EXPR(op, l, values, 2);
+  checkCompiled(schema, records, 300, op, "c IN (dd, aaaa)");
+  freeExpr(op);
+  for(i = 0; i < 2; i++)
+    freeVal(values[i]);
+
+  values[0] = stringToValue("bf");
+  MAKE_ATTRREF(l, 3);
+  MAKE_IN_EXPR(op, l, values, 1);
+  checkCompiled(schema, records, 300, op, "d IN (false)");
+  freeExpr(op);
+  freeVal(values[0]);
+
+  values[0] = stringToValue("f1.5");
+  MAKE_ATTRREF(l, 1);
+  MAKE_IN_EXPR(op, l, values, 1);
+  checkCompiled(schema, records, 300, op, "b IN (1.5)");
+  freeExpr(op);
+  freeVal(values[0]);
+
+  // c LIKE 'bb%' OR c LIKE 'd%'
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("sbb"));
+  MAKE_BINOP_EXPR(h, l, r, OP_LIKE_PREFIX);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("sd"));
+  MAKE_BINOP_EXPR(r, l, r, OP_LIKE_PREFIX);
+  MAKE_BINOP_EXPR(op, h, r, OP_BOOL_OR);
+  checkCompiled(schema, records, 300, op, "c LIKE bb% OR c LIKE d%");
+  freeExpr(op);
+
+  // mistyped operands do not compile
+  values[0] = stringToValue("sx");
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(op, l, values, 1);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, compileExpr(op, schema, &program), "int IN (string) does not compile");
+  freeExpr(op);
+  freeVal(values[0]);
+
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i1"));
+  MAKE_BINOP_EXPR(op, l, r, OP_LIKE_PREFIX);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, compileExpr(op, schema, &program), "int LIKE does not compile");
+  freeExpr(op);
+
+  for(i = 0; i < 300; i++)
+    freeRecord(records[i]);
+  freeSchema(schema);
+  free(result);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testExprRanges (void)
+{
+  ExprRange range;
+  Value *values[2];
+  Expr *op, *l, *r, *terms;
+  testName = "test attribute ranges of conditions";
+
+  // a >= 3 AND a < 10 AND 5 < a
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_GE);
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i10"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(terms, terms, op, OP_BOOL_AND);
+  MAKE_CONS(l, stringToValue("i5"));
+  MAKE_ATTRREF(r, 0);
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(terms, terms, op, OP_BOOL_AND);
+
+  TEST_CHECK(getExprRange(terms, 0, &range));
+  ASSERT_TRUE(!range.empty && range.hasLow && range.hasHigh, "a has both bounds");
+  ASSERT_EQUALS_INT(5, range.low.v.intV, "a > 5 is the tighter low bound");
+  ASSERT_EQUALS_INT(0, range.lowInclusive, "5 is excluded");
+  ASSERT_EQUALS_INT(10, range.high.v.intV, "a < 10");
+  ASSERT_EQUALS_INT(0, range.highInclusive, "10 is excluded");
+  TEST_CHECK(getExprRange(terms, 1, &range));
+  ASSERT_TRUE(!range.empty && !range.hasLow && !range.hasHigh, "b is not bounded");
+
+  // ... AND a IN (4, 9) narrows to [5, 9], AND a >= 9.5 is ignored for a
+  // float bound, AND a = 2 makes it empty
+  values[0] = stringToValue("i4");
+  values[1] = stringToValue("i9");
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(op, l, values, 2);
+  MAKE_BINOP_EXPR(terms, terms, op, OP_BOOL_AND);
+  freeVal(values[0]);
+  freeVal(values[1]);
+  TEST_CHECK(getExprRange(terms, 0, &range));
+  ASSERT_EQUALS_INT(9, range.high.v.intV, "IN bounds a to its largest value");
+  ASSERT_EQUALS_INT(1, range.highInclusive, "9 is included");
+
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("f9.5"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_GE);
+  MAKE_BINOP_EXPR(terms, terms, op, OP_BOOL_AND);
+  TEST_CHECK(getExprRange(terms, 0, &range));
+  ASSERT_TRUE(!range.empty && range.low.dt == DT_INT, "a bound of another datatype is ignored");
+
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i2"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(terms, terms, op, OP_BOOL_AND);
+  TEST_CHECK(getExprRange(terms, 0, &range));
+  ASSERT_TRUE(range.empty, "a > 5 AND a = 2 is empty");
+  freeExpr(terms);
+
+  // a BETWEEN 3 AND 3 is one value, OR gives no bound
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i3"));
+  MAKE_CONS(terms, stringToValue("i3"));
+  MAKE_BETWEEN_EXPR(op, l, r, terms);
+  TEST_CHECK(getExprRange(op, 0, &range));
+  ASSERT_TRUE(!range.empty && range.low.v.intV == 3 && range.high.v.intV == 3, "BETWEEN 3 AND 3");
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i7"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(op, op, terms, OP_BOOL_OR);
+  TEST_CHECK(getExprRange(op, 0, &range));
+  ASSERT_TRUE(!range.empty && !range.hasLow && !range.hasHigh, "OR does not bound a");
+  freeExpr(op);
+
+  // c LIKE 'bb%' starts at bb, a IN () is empty
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("sbb"));
+  MAKE_BINOP_EXPR(op, l, r, OP_LIKE_PREFIX);
+  TEST_CHECK(getExprRange(op, 2, &range));
+  ASSERT_EQUALS_STRING("bb", range.low.v.stringV, "LIKE bb% starts at bb");
+  ASSERT_TRUE(range.lowInclusive && !range.hasHigh, "LIKE has no high bound");
+  freeExpr(op);
+
+  MAKE_ATTRREF(l, 0);
+  MAKE_IN_EXPR(op, l, values, 0);
+  TEST_CHECK(getExprRange(op, 0, &range));
+  ASSERT_TRUE(range.empty, "IN () is empty");
+  freeExpr(op);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testShortCircuit (void)
+{
+  Schema *schema = exprSchema();
+  Record *records[300];
+  Value result;
+  Expr *op, *l, *r, *terms;
+  int i;
+  testName = "test short-circuit evaluation of AND and OR";
+
+  // the right side would fail, it is never evaluated
+  MAKE_CONS(l, stringToValue("i1"));
+  MAKE_CONS(r, stringToValue("sx"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_EQUAL);
+  MAKE_CONS(l, stringToValue("bf"));
+  MAKE_BINOP_EXPR(op, l, terms, OP_BOOL_AND);
+  TEST_CHECK(evalExprInto(NULL, NULL, op, &result));
+  ASSERT_TRUE(!result.v.boolV, "false AND (1 = x) is false");
+  op->expr.op->type = OP_BOOL_OR;
+  op->expr.op->args[0]->expr.cons->v.boolV = TRUE;
+  TEST_CHECK(evalExprInto(NULL, NULL, op, &result));
+  ASSERT_TRUE(result.v.boolV, "true OR (1 = x) is true");
+  freeExpr(op);
+
+  // a left side that decides all tuples of a batch skips the right side
+  exprRecords(schema, records, 300);
+
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i100"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_GREATER);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("scccc"));
+  MAKE_BINOP_EXPR(r, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(op, terms, r, OP_BOOL_AND);
+  checkCompiled(schema, records, 300, op, "a > 100 AND c = cccc");
+  op->expr.op->type = OP_BOOL_OR;
+  checkCompiled(schema, records, 300, op, "a > 100 OR c = cccc");
+  op->expr.op->args[0]->expr.op->type = OP_COMP_SMALLER;
+  checkCompiled(schema, records, 300, op, "a < 100 OR c = cccc");
+  op->expr.op->type = OP_BOOL_AND;
+  checkCompiled(schema, records, 300, op, "a < 100 AND c = cccc");
+  freeExpr(op);
+
+  for(i = 0; i < 300; i++)
+    freeRecord(records[i]);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+void
+testExprFilter (void)
+{
+  Schema *schema = exprSchema();
+  int size = getRecordSize(schema);
+  char *tuples = (char *) malloc(size * 300);
+  unsigned char selection[38];
+  Record *records[300];
+  ExprFilter *filter;
+  ExprInstr *last;
+  Value expected;
+  Expr *op, *l, *r, *terms;
+  char *minipages;
+  int i, j, pass;
+  testName = "test filters reordering their terms";
+
+  exprRecords(schema, records, 300);
+  for(i = 0; i < 300; i++)
+    memcpy(tuples + i * size, records[i]->data, size);
+
+  // a < 100 rejects nothing, c = "dd" and b < 1.0 most tuples
+  MAKE_ATTRREF(l, 0);
+  MAKE_CONS(r, stringToValue("i100"));
+  MAKE_BINOP_EXPR(terms, l, r, OP_COMP_SMALLER);
+  MAKE_ATTRREF(l, 2);
+  MAKE_CONS(r, stringToValue("sdd"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_EQUAL);
+  MAKE_BINOP_EXPR(terms, terms, op, OP_BOOL_AND);
+  MAKE_ATTRREF(l, 1);
+  MAKE_CONS(r, stringToValue("f1.0"));
+  MAKE_BINOP_EXPR(op, l, r, OP_COMP_SMALLER);
+  MAKE_BINOP_EXPR(terms, terms, op, OP_BOOL_AND);
+
+  TEST_CHECK(compileFilter(terms, schema, &filter));
+  ASSERT_EQUALS_INT(3, filter->numTerms, "one term per conjunct");
+  filter->reorderTuples = 300;
+
+  for(pass = 0; pass < 5; pass++)
+    {
+      TEST_CHECK(evalFilterBatch(filter, tuples, size, 300, selection));
+      for(i = 0; i < 300; i++)
+	{
+	  TEST_CHECK(evalExprInto(records[i], schema, terms, &expected));
+	  ASSERT_EQUALS_INT(expected.v.boolV != 0, (selection[i / 8] >> (i % 8)) & 1, "filter matches the condition");
+	}
+    }
+  ASSERT_EQUALS_INT(5, filter->numReorders, "reordered after every 300 tuples");
+
+  // the term that rejects nothing goes last
+  last = &filter->terms[2].program->instrs[0];
+  ASSERT_TRUE(last->op == BC_LOAD_INT && last->left == schema->attrOffsets[0], "a < 100 is evaluated last");
+  ASSERT_TRUE(filter->terms[0].passed < filter->terms[0].evaluated, "the first term rejects tuples");
+
+  // the same tuples in minipages, one per attribute
+  minipages = (char *) malloc(size * 300);
+  for(i = 0; i < 300; i++)
+    for(j = 0; j < schema->numAttr; j++)
+      memcpy(minipages + schema->attrOffsets[j] * 300 + i * schema->attrSizes[j],
+	     records[i]->data + schema->attrOffsets[j], schema->attrSizes[j]);
+  TEST_CHECK(evalFilterColumns(filter, minipages, 300, 300, selection));
+  for(i = 0; i < 300; i++)
+    {
+      TEST_CHECK(evalExprInto(records[i], schema, terms, &expected));
+      ASSERT_EQUALS_INT(expected.v.boolV != 0, (selection[i / 8] >> (i % 8)) & 1, "filter matches on minipages");
+    }
+
+  freeExprFilter(filter);
+  freeExpr(terms);
+  for(i = 0; i < 300; i++)
+    freeRecord(records[i]);
+  free(tuples);
+  free(minipages);
+  freeSchema(schema);
+  TEST_DONE();
+}
+
+// ************************************************************
+// apply a comparison operator to two parsed values and free them
+static void
+checkOperator (char *left, char *right, RC (*op) (Value *, Value *, Value *), bool expected, char *message)
+{
+  Value *l = stringToValue(left);
+  Value *r = stringToValue(right);
+  Value result;
+
+  TEST_CHECK(op(l, r, &result));
+  ASSERT_TRUE((result.v.boolV != 0) == (expected != 0), message);
+  freeVal(l);
+  freeVal(r);
+}
+
+// ************************************************************
+// check evalProgram and evalProgramBatch against evalExprInto
+static void
+checkCompiled (Schema *schema, Record **records, int numRecords, Expr *expr, char *message)
+{
+  ExprProgram *program;
+  Value expected;
+  int size = getRecordSize(schema);
+  char *tuples = (char *) malloc(size * numRecords);
+  unsigned char *selection = (unsigned char *) malloc((numRecords + 7) / 8);
+  int result, i;
+
+  TEST_CHECK(compileExpr(expr, schema, &program));
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(evalExprInto(records[i], schema, expr, &expected));
+      TEST_CHECK(evalProgram(program, records[i], &result));
+      ASSERT_EQUALS_INT(expected.v.boolV, result, message);
+      memcpy(tuples + i * size, records[i]->data, size);
+    }
+
+  TEST_CHECK(evalProgramBatch(program, tuples, size, numRecords, selection));
+  for(i = 0; i < numRecords; i++)
+    {
+      TEST_CHECK(evalExprInto(records[i], schema, expr, &expected));
+      ASSERT_EQUALS_INT(expected.v.boolV != 0, (selection[i / 8] >> (i % 8)) & 1, message);
+    }
+  if (numRecords % 8 != 0)
+    ASSERT_EQUALS_INT(0, selection[numRecords / 8] >> (numRecords % 8), "bits after the last tuple are clear");
+
+  freeExprProgram(program);
+  free(selection);
+  free(tuples);
+}
+
+static Schema *
+exprSchema (void)
+{
+  char *names[] = { "a", "b", "c", "d" };
+  DataType dt[] = { DT_INT, DT_FLOAT, DT_STRING, DT_BOOL };
+  int sizes[] = { 0, 0, 4, 0 };
+  char **cpNames = (char **) malloc(sizeof(char*) * 4);
+  DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+  int *cpSizes = (int *) malloc(sizeof(int) * 4);
+  int *cpKeys = (int *) malloc(sizeof(int));
+  int i;
+
+  for(i = 0; i < 4; i++)
+    {
+      cpNames[i] = (char *) malloc(2);
+      strcpy(cpNames[i], names[i]);
+    }
+  memcpy(cpDt, dt, sizeof(DataType) * 4);
+  memcpy(cpSizes, sizes, sizeof(int) * 4);
+  cpKeys[0] = 0;
+
+  return createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+}
+
+// more tuples than one batch, numRecords need not be a multiple of 8
+static void
+exprRecords (Schema *schema, Record **records, int numRecords)
+{
+  char *strings[] = { "aaaa", "bbbb", "cccc", "dd" };
+  int i;
+
+  for(i = 0; i < numRecords; i++)
+    records[i] = exprRecord(schema, i % 17, (i % 5) * 0.5, strings[i % 4], i % 3 == 0);
+}
+
+static Record *
+exprRecord (Schema *schema, int a, float b, char *c, bool d)
+{
+  Record *result;
+  Value *value;
+
+  TEST_CHECK(createRecord(&result, schema));
+
+  MAKE_VALUE(value, DT_INT, a);
+  TEST_CHECK(setAttr(result, schema, 0, value));
+  freeVal(value);
+
+  MAKE_VALUE(value, DT_FLOAT, b);
+  TEST_CHECK(setAttr(result, schema, 1, value));
+  freeVal(value);
+
+  MAKE_STRING_VALUE(value, c);
+  TEST_CHECK(setAttr(result, schema, 2, value));
+  freeVal(value);
+
+  MAKE_VALUE(value, DT_BOOL, d);
+  TEST_CHECK(setAttr(result, schema, 3, value));
+  freeVal(value);
+
+  return result;
+}
@@ -0,0 +1,341 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "dberror.h"
+#include "expr.h"
+#include "hash_mgr.h"
+#include "tables.h"
+#include "test_helper.h"
+
+// test methods
+static void testHashInsertAndFind (void);
+static void testHashDelete (void);
+static void testHashBatchInsert (void);
+static void testHashKeyTypes (void);
+
+// helper methods
+static int *permutation (int n, unsigned int seed);
+static RID ridOf (int key);
+
+char *testName;
+
+// main method
+int
+main (void)
+{
+  testName = "";
+
+  testHashInsertAndFind();
+  testHashDelete();
+  testHashBatchInsert();
+  testHashKeyTypes();
+
+  return 0;
+}
+
+// ************************************************************
+// keys inserted in random order split buckets and double the directory many
+// times; the index is found again after reopening it
+void
+testHashInsertAndFind (void)
+{
+  HashHandle *index;
+  int numKeys = 50000, i, numEntries, numBuckets, globalDepth;
+  int *keys = permutation(numKeys, 7);
+  Value key;
+  RID rid;
+  RC rc;
+
+  testName = "test inserting and finding hash keys";
+
+  TEST_CHECK(createHashIndex("test_idx_h", DT_INT));
+  TEST_CHECK(openHashIndex(&index, "test_idx_h"));
+
+  key.dt = DT_INT;
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = keys[i];
+      TEST_CHECK(insertHashKey(index, &key, ridOf(keys[i])));
+    }
+  key.v.intV = keys[0];
+  rc = insertHashKey(index, &key, ridOf(0));
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, rc, "a key is inserted once");
+
+  TEST_CHECK(getHashNumEntries(index, &numEntries));
+  TEST_CHECK(getHashNumBuckets(index, &numBuckets));
+  TEST_CHECK(getHashGlobalDepth(index, &globalDepth));
+  ASSERT_EQUALS_INT(numKeys, numEntries, "every key is an entry");
+  ASSERT_TRUE(numBuckets > numKeys / 255, "a bucket holds at most a page of keys");
+  ASSERT_TRUE((1 << globalDepth) >= numBuckets, "the directory has an entry for every bucket");
+  TEST_CHECK(closeHashIndex(index));
+
+  TEST_CHECK(openHashIndex(&index, "test_idx_h"));
+  TEST_CHECK(getHashNumEntries(index, &numEntries));
+  ASSERT_EQUALS_INT(numKeys, numEntries, "entries are kept by the index file");
+  for(i = 0, rc = RC_OK; i < numKeys && rc == RC_OK; i++)
+    {
+      key.v.intV = i;
+      rc = findHashKey(index, &key, &rid);
+      if (rc == RC_OK && (rid.page != ridOf(i).page || rid.slot != ridOf(i).slot))
+        rc = RC_IM_KEY_NOT_FOUND;
+    }
+  ASSERT_EQUALS_INT(RC_OK, rc, "every key is found with its RID");
+  key.v.intV = numKeys;
+  rc = findHashKey(index, &key, &rid);
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "a key that was not inserted");
+
+  // the directory grows again after it was read back
+  for(i = numKeys; i < 2 * numKeys; i++)
+    {
+      key.v.intV = i;
+      TEST_CHECK(insertHashKey(index, &key, ridOf(i)));
+    }
+  TEST_CHECK(closeHashIndex(index));
+  TEST_CHECK(openHashIndex(&index, "test_idx_h"));
+  for(i = 0, rc = RC_OK; i < 2 * numKeys && rc == RC_OK; i++)
+    {
+      key.v.intV = i;
+      rc = findHashKey(index, &key, &rid);
+    }
+  ASSERT_EQUALS_INT(RC_OK, rc, "keys are found after the directory moved");
+
+  TEST_CHECK(closeHashIndex(index));
+  TEST_CHECK(deleteHashIndex("test_idx_h"));
+  free(keys);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// deleted keys are gone and can be inserted again
+void
+testHashDelete (void)
+{
+  HashHandle *index;
+  int numKeys = 5000, i, numEntries, numFound;
+  int *keys = permutation(numKeys, 11);
+  Value key;
+  RID rid;
+  RC rc;
+
+  testName = "test deleting hash keys";
+
+  TEST_CHECK(createHashIndex("test_idx_i", DT_INT));
+  TEST_CHECK(openHashIndex(&index, "test_idx_i"));
+  key.dt = DT_INT;
+  for(i = 0; i < numKeys; i++)
+    {
+      key.v.intV = keys[i];
+      TEST_CHECK(insertHashKey(index, &key, ridOf(keys[i])));
+    }
+
+  // the odd keys are deleted in random order
+  for(i = 0; i < numKeys; i++)
+    if (keys[i] % 2)
+      {
+        key.v.intV = keys[i];
+        TEST_CHECK(deleteHashKey(index, &key));
+      }
+  key.v.intV = 1;
+  rc = deleteHashKey(index, &key);
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "a deleted key is gone");
+  TEST_CHECK(getHashNumEntries(index, &numEntries));
+  ASSERT_EQUALS_INT(numKeys / 2, numEntries, "half of the keys are left");
+
+  for(i = 0, numFound = 0; i < numKeys; i++)
+    {
+      key.v.intV = i;
+      if (findHashKey(index, &key, &rid) == RC_OK && rid.slot == i)
+        numFound++;
+    }
+  ASSERT_EQUALS_INT(numKeys / 2, numFound, "the even keys are left");
+
+  for(i = 1; i < numKeys; i += 2)
+    {
+      key.v.intV = i;
+      TEST_CHECK(insertHashKey(index, &key, ridOf(i)));
+    }
+  TEST_CHECK(getHashNumEntries(index, &numEntries));
+  ASSERT_EQUALS_INT(numKeys, numEntries, "deleted keys are inserted again");
+
+  TEST_CHECK(closeHashIndex(index));
+  TEST_CHECK(deleteHashIndex("test_idx_i"));
+  free(keys);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// keys inserted in batches, existing keys are skipped
+void
+testHashBatchInsert (void)
+{
+  HashHandle *index;
+  int numKeys = 20000, batchSize = 5000, i, j, numEntries;
+  int *keys = permutation(numKeys, 13);
+  Value *batch = (Value *) malloc(sizeof(Value) * batchSize);
+  RID *rids = (RID *) malloc(sizeof(RID) * batchSize);
+  Value key;
+  RID rid;
+  RC rc;
+
+  testName = "test inserting hash keys in batches";
+
+  TEST_CHECK(createHashIndex("test_idx_n", DT_INT));
+  TEST_CHECK(openHashIndex(&index, "test_idx_n"));
+  for(i = 0; i < numKeys; i += batchSize)
+    {
+      for(j = 0; j < batchSize; j++)
+        {
+          batch[j].dt = DT_INT;
+          batch[j].v.intV = keys[i + j];
+          rids[j] = ridOf(keys[i + j]);
+        }
+      TEST_CHECK(insertHashKeys(index, batch, rids, batchSize));
+    }
+
+  // a batch with a key that exists and one that does not
+  batch[0].v.intV = keys[0];
+  rids[0] = ridOf(0);
+  batch[1].v.intV = numKeys;
+  rids[1] = ridOf(numKeys);
+  rc = insertHashKeys(index, batch, rids, 2);
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, rc, "an existing key is reported");
+  TEST_CHECK(getHashNumEntries(index, &numEntries));
+  ASSERT_EQUALS_INT(numKeys + 1, numEntries, "the other keys of the batch are inserted");
+
+  key.dt = DT_INT;
+  for(i = 0, rc = RC_OK; i <= numKeys && rc == RC_OK; i++)
+    {
+      key.v.intV = i;
+      rc = findHashKey(index, &key, &rid);
+      if (rc == RC_OK && (rid.page != ridOf(i).page || rid.slot != ridOf(i).slot))
+        rc = RC_IM_KEY_NOT_FOUND;
+    }
+  ASSERT_EQUALS_INT(RC_OK, rc, "every key is found with its RID");
+
+  batch[0].dt = DT_FLOAT;
+  rc = insertHashKeys(index, batch, rids, 2);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, rc, "keys have the type of the index");
+
+  TEST_CHECK(closeHashIndex(index));
+  TEST_CHECK(deleteHashIndex("test_idx_n"));
+  free(keys);
+  free(batch);
+  free(rids);
+
+  TEST_DONE();
+}
+
+// ************************************************************
+// float, string and bool keys
+void
+testHashKeyTypes (void)
+{
+  HashHandle *index;
+  char *names[] = {"pear", "apple", "plum", "fig", "kiwi", "applesauce"};
+  Value *key;
+  RID rid;
+  RC rc;
+  int i;
+
+  testName = "test hash keys of every type";
+
+  // floats, 0.0 and -0.0 are the same key
+  TEST_CHECK(createHashIndex("test_idx_j", DT_FLOAT));
+  TEST_CHECK(openHashIndex(&index, "test_idx_j"));
+  for(i = 0; i < 5; i++)
+    {
+      MAKE_VALUE(key, DT_FLOAT, 2.5f - i);
+      TEST_CHECK(insertHashKey(index, key, ridOf(i)));
+      freeVal(key);
+    }
+  MAKE_VALUE(key, DT_FLOAT, 0.0f);
+  TEST_CHECK(insertHashKey(index, key, ridOf(5)));
+  key->v.floatV = -0.0f;
+  rc = insertHashKey(index, key, ridOf(6));
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, rc, "-0.0 is 0.0");
+  key->v.floatV = -1.5f;
+  TEST_CHECK(findHashKey(index, key, &rid));
+  ASSERT_EQUALS_INT(4, rid.slot, "-1.5 is found");
+  freeVal(key);
+  MAKE_VALUE(key, DT_INT, 1);
+  rc = findHashKey(index, key, &rid);
+  ASSERT_EQUALS_INT(RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE, rc, "keys have the type of the index");
+  freeVal(key);
+  TEST_CHECK(closeHashIndex(index));
+  TEST_CHECK(deleteHashIndex("test_idx_j"));
+
+  // strings of up to 5 characters, longer ones are cut
+  TEST_CHECK(createStringHashIndex("test_idx_k", 5));
+  TEST_CHECK(openHashIndex(&index, "test_idx_k"));
+  for(i = 0; i < 5; i++)
+    {
+      MAKE_STRING_VALUE(key, names[i]);
+      TEST_CHECK(insertHashKey(index, key, ridOf(i)));
+      freeVal(key);
+    }
+  MAKE_STRING_VALUE(key, names[5]);
+  rc = insertHashKey(index, key, ridOf(5));
+  ASSERT_EQUALS_INT(RC_IM_KEY_ALREADY_EXISTS, rc, "applesauce is cut to apple");
+  freeVal(key);
+  MAKE_STRING_VALUE(key, "fig");
+  TEST_CHECK(findHashKey(index, key, &rid));
+  ASSERT_EQUALS_INT(3, rid.slot, "fig is found");
+  freeVal(key);
+  MAKE_STRING_VALUE(key, "figs");
+  rc = findHashKey(index, key, &rid);
+  ASSERT_EQUALS_INT(RC_IM_KEY_NOT_FOUND, rc, "figs is another key");
+  freeVal(key);
+  TEST_CHECK(closeHashIndex(index));
+  TEST_CHECK(deleteHashIndex("test_idx_k"));
+
+  // bools
+  TEST_CHECK(createHashIndex("test_idx_l", DT_BOOL));
+  TEST_CHECK(openHashIndex(&index, "test_idx_l"));
+  MAKE_VALUE(key, DT_BOOL, 1);
+  TEST_CHECK(insertHashKey(index, key, ridOf(1)));
+  key->v.boolV = 0;
+  TEST_CHECK(insertHashKey(index, key, ridOf(0)));
+  TEST_CHECK(findHashKey(index, key, &rid));
+  ASSERT_EQUALS_INT(0, rid.slot, "false is found");
+  freeVal(key);
+  TEST_CHECK(closeHashIndex(index));
+  TEST_CHECK(deleteHashIndex("test_idx_l"));
+
+  rc = createStringHashIndex("test_idx_m", 4000);
+  ASSERT_EQUALS_INT(RC_IM_N_TO_LAGE, rc, "two keys of 4000 characters do not fit into a bucket");
+
+  TEST_DONE();
+}
+
+// the numbers 0 to n - 1 in a random order
+int *
+permutation (int n, unsigned int seed)
+{
+  int *result = (int *) malloc(sizeof(int) * n);
+  int i, j, tmp;
+
+  srand(seed);
+  for(i = 0; i < n; i++)
+    result[i] = i;
+  for(i = n - 1; i > 0; i--)
+    {
+      j = rand() % (i + 1);
+      tmp = result[i];
+      result[i] = result[j];
+      result[j] = tmp;
+    }
+  return result;
+}
+
+// the RID stored for a key
+RID
+ridOf (int key)
+{
+  RID rid;
+
+  rid.page = key / 100 + 1;
+  rid.slot = key;
+  return rid;
+}
@@ -0,0 +1,244 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "storage_mgr.h"
+#include "zone_map.h"
+
+// zones per page of the zone map file, the zones of page 1 of the table
+// start on page 1 of the file, after the header on page 0.
+#define ZONES_PER_BLOCK (PAGE_SIZE / sizeof(Zone))
+
+static const Zone emptyZone = { HUGE_VAL, -HUGE_VAL };
+
+// make room for the zones of the pages up to pageNum, new pages have no
+// values yet.
+static RC growZoneMap(ZoneMap *map, int pageNum) {
+	int i;
+
+	if (pageNum > map->capacity) {
+		int capacity = map->capacity > 0 ? map->capacity : 64;
+		Zone *zones;
+
+		while (capacity < pageNum) {
+			capacity *= 2;
+		}
+		if ((zones = (Zone *)realloc(map->zones, sizeof(Zone) * capacity * map->numAttrs)) == NULL)
+			return RC_WRITE_FAILED;
+		map->zones = zones;
+		map->capacity = capacity;
+	}
+	for (i = map->numPages * map->numAttrs; i < pageNum * map->numAttrs; i++) {
+		map->zones[i] = emptyZone;
+	}
+	if (pageNum > map->numPages) {
+		map->numPages = pageNum;
+	}
+	return RC_OK;
+}
+
+/**
+ * create a zone map of some int and float attributes, no page has values.
+ * @param  numAttrs number of attributes.
+ * @param  attrs    the attributes in the table schema.
+ * @return          the zone map, or NULL if out of memory.
+ */
+ZoneMap *createZoneMap(int numAttrs, int *attrs) {
+	ZoneMap *map;
+
+	if ((map = (ZoneMap *)malloc(sizeof(ZoneMap))) == NULL)
+		return NULL;
+
+	map->numAttrs = numAttrs;
+	map->attrs = (int *)malloc(sizeof(int) * (numAttrs > 0 ? numAttrs : 1));
+	map->numPages = 0;
+	map->capacity = 0;
+	map->zones = NULL;
+	if (map->attrs == NULL) {
+		freeZoneMap(map);
+		return NULL;
+	}
+	memcpy(map->attrs, attrs, sizeof(int) * numAttrs);
+	return map;
+}
+
+/**
+ * widen the zones of a page to the values of a record written to it.
+ * @param  map     the zone map.
+ * @param  schema  schema of the table.
+ * @param  pageNum page of the record.
+ * @param  data    the record.
+ * @return         RC_OK | RC_WRITE_FAILED
+ */
+RC zoneMapAdd(ZoneMap *map, Schema *schema, int pageNum, char *data) {
+	Zone *zones;
+	double value;
+	int i;
+
+	if (pageNum > map->numPages && growZoneMap(map, pageNum) != RC_OK)
+		return RC_WRITE_FAILED;
+
+	zones = map->zones + (pageNum - 1) * map->numAttrs;
+	for (i = 0; i < map->numAttrs; i++) {
+		int attr = map->attrs[i];
+
+		if (schema->dataTypes[attr] == DT_INT) {
+			int v;
+			memcpy(&v, data + schema->attrOffsets[attr], sizeof(int));
+			value = v;
+		}
+		else {
+			float v;
+			memcpy(&v, data + schema->attrOffsets[attr], sizeof(float));
+			value = v;
+		}
+		if (value < zones[i].low)
+			zones[i].low = value;
+		if (value > zones[i].high)
+			zones[i].high = value;
+	}
+	return RC_OK;
+}
+
+/**
+ * tell whether a page may hold a record inside the bounds of every
+ * attribute. A page without values matches nothing.
+ * @param  map     the zone map.
+ * @param  pageNum the page.
+ * @param  bounds  bounds of every attribute of the map, in its order.
+ * @return         0 if no record of the page is inside the bounds.
+ */
+int zoneMapMayMatch(ZoneMap *map, int pageNum, ZoneBounds *bounds) {
+	int i;
+
+	for (i = 0; i < map->numAttrs; i++) {
+		const Zone *zone = (pageNum <= map->numPages) ? &map->zones[(pageNum - 1) * map->numAttrs + i] : &emptyZone;
+
+		if (zone->low > zone->high)
+			return 0;
+		if (bounds[i].hasLow && (zone->high < bounds[i].low
+				|| (zone->high == bounds[i].low && !bounds[i].lowInclusive)))
+			return 0;
+		if (bounds[i].hasHigh && (zone->low > bounds[i].high
+				|| (zone->low == bounds[i].high && !bounds[i].highInclusive)))
+			return 0;
+	}
+	return 1;
+}
+
+/**
+ * write a zone map to a page file. A map stored while its table is open is
+ * not clean, loadZoneMap ignores it: the table may change after it.
+ * @param  map      the zone map.
+ * @param  fileName the file, created if it does not exist.
+ * @param  clean    whether the map holds every change of its table.
+ * @return          RC_OK | RC_WRITE_FAILED | error of the storage manager
+ */
+RC storeZoneMap(ZoneMap *map, char *fileName, int clean) {
+	int numBlocks = (int)((map->numPages * map->numAttrs + ZONES_PER_BLOCK - 1) / ZONES_PER_BLOCK);
+	SM_FileHandle fh;
+	char *pages;
+	int *header;
+	RC rc;
+
+	if (3 + map->numAttrs > PAGE_SIZE / (int)sizeof(int))
+		return RC_WRITE_FAILED;
+	if (access(fileName, F_OK) != 0 && (rc = createPageFile(fileName)) != RC_OK)
+		return rc;
+	if ((rc = openPageFile(fileName, &fh)) != RC_OK)
+		return rc;
+	if ((pages = (char *)calloc(numBlocks + 1, PAGE_SIZE)) == NULL) {
+		closePageFile(&fh);
+		return RC_WRITE_FAILED;
+	}
+
+	header = (int *)pages;
+	header[0] = clean;
+	header[1] = map->numAttrs;
+	header[2] = map->numPages;
+	memcpy(header + 3, map->attrs, sizeof(int) * map->numAttrs);
+	if (map->numPages > 0) {
+		memcpy(pages + PAGE_SIZE, map->zones, sizeof(Zone) * map->numPages * map->numAttrs);
+	}
+
+	if ((rc = ensureCapacity(numBlocks + 1, &fh)) == RC_OK) {
+		rc = writeBlocks(0, numBlocks + 1, &fh, pages);
+	}
+	closePageFile(&fh);
+	free(pages);
+	return rc;
+}
+
+// read the zones of an open zone map file, NULL if the map is not clean.
+static ZoneMap *readZoneMap(SM_FileHandle *fh, char *page) {
+	ZoneMap *map;
+	int header[3];
+	int i, numBlocks;
+
+	if (readBlock(0, fh, page) != RC_OK)
+		return NULL;
+	memcpy(header, page, sizeof(header));
+	numBlocks = (int)(((long)header[2] * header[1] + ZONES_PER_BLOCK - 1) / ZONES_PER_BLOCK);
+	if (!header[0] || header[1] < 1 || 3 + header[1] > PAGE_SIZE / (int)sizeof(int)
+			|| header[2] < 0 || numBlocks + 1 > fh->totalNumPages)
+		return NULL;
+	if ((map = createZoneMap(header[1], (int *)page + 3)) == NULL)
+		return NULL;
+	if (header[2] > 0 && growZoneMap(map, header[2]) != RC_OK) {
+		freeZoneMap(map);
+		return NULL;
+	}
+
+	for (i = 0; i < numBlocks; i++) {
+		size_t first = (size_t)i * ZONES_PER_BLOCK;
+		size_t count = (size_t)map->numPages * map->numAttrs - first;
+
+		if (count > ZONES_PER_BLOCK)
+			count = ZONES_PER_BLOCK;
+		if (readBlock(i + 1, fh, page) != RC_OK) {
+			freeZoneMap(map);
+			return NULL;
+		}
+		memcpy(map->zones + first, page, sizeof(Zone) * count);
+	}
+	return map;
+}
+
+/**
+ * read a zone map written by storeZoneMap and mark its file as not clean
+ * until it is stored again.
+ * @param  fileName the file.
+ * @return          the zone map, or NULL if there is no clean one.
+ */
+ZoneMap *loadZoneMap(char *fileName) {
+	SM_FileHandle fh;
+	ZoneMap *map;
+	char *page;
+
+	if (access(fileName, F_OK) != 0 || openPageFile(fileName, &fh) != RC_OK)
+		return NULL;
+	page = (char *)malloc(PAGE_SIZE);
+
+	// the table may change from now on
+	if ((map = readZoneMap(&fh, page)) != NULL && readBlock(0, &fh, page) == RC_OK) {
+		((int *)page)[0] = 0;
+		writeBlock(0, &fh, page);
+	}
+
+	closePageFile(&fh);
+	free(page);
+	return map;
+}
+
+/**
+ * free a zone map.
+ * @param map the zone map, may be NULL.
+ */
+void freeZoneMap(ZoneMap *map) {
+	if (map == NULL)
+		return;
+	free(map->attrs);
+	free(map->zones);
+	free(map);
+}
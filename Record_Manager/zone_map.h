@@ -0,0 +1,42 @@
+#ifndef __ZONE_MAP_H__
+#define __ZONE_MAP_H__
+
+#include "dberror.h"
+#include "tables.h"
+
+// the smallest and largest value of an attribute on a data page. A page
+// without values has low > high.
+typedef struct Zone {
+	double low;
+	double high;
+} Zone;
+
+// zones of some int and float attributes for every data page of a table.
+// A zone only grows: values deleted or updated away stay inside it, so it
+// may be wider than the values of its page but never narrower.
+typedef struct ZoneMap {
+	int numAttrs;
+	int *attrs;		// the attributes in the table schema
+	int numPages;		// pages 1 to numPages have zones
+	int capacity;
+	Zone *zones;		// numAttrs zones per page, page p from (p - 1) * numAttrs on
+} ZoneMap;
+
+// the values of an attribute a scan can match.
+typedef struct ZoneBounds {
+	int hasLow;
+	int lowInclusive;
+	double low;
+	int hasHigh;
+	int highInclusive;
+	double high;
+} ZoneBounds;
+
+
+ZoneMap *createZoneMap(int numAttrs, int *attrs);
+RC zoneMapAdd(ZoneMap *map, Schema *schema, int pageNum, char *data);
+int zoneMapMayMatch(ZoneMap *map, int pageNum, ZoneBounds *bounds);
+RC storeZoneMap(ZoneMap *map, char *fileName, int clean);
+ZoneMap *loadZoneMap(char *fileName);
+void freeZoneMap(ZoneMap *map);
+#endif